@@ -38,6 +38,7 @@ limitations under the License.
 #include "../Src/OVR_SensorFusion.h"
 #include "../Src/OVR_Profile.h"
 #include "../Src/Util/Util_LatencyTest.h"
+#include "../Src/Util/Util_Render_Distortion.h"
 #include "../Src/Util/Util_Render_Stereo.h"
 
 #endif
@@ -0,0 +1,120 @@
+/************************************************************************************
+
+Filename    :   OVR_LatencyHistogram.cpp
+Content     :   Fixed precision histogram of latencies with percentile queries
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_LatencyHistogram.h"
+#include "OVR_Alg.h"
+
+#include <math.h>
+
+namespace OVR {
+
+//-----------------------------------------------------------------------------------
+// ***** LatencyHistogram
+
+void LatencyHistogram::Reset()
+{
+    Count    = 0;
+    MinValue = UINT_MAX;
+    MaxValue = 0;
+    Sum      = 0;
+    memset(Buckets, 0, sizeof(Buckets));
+}
+
+void LatencyHistogram::Record(UInt32 microS)
+{
+    Count++;
+    MinValue = Alg::Min(MinValue, microS);
+    MaxValue = Alg::Max(MaxValue, microS);
+    Sum     += microS;
+    Buckets[bucketIndex(microS)]++;
+}
+
+UInt32 LatencyHistogram::GetPercentile(float percent) const
+{
+    if (Count == 0)
+    {
+        return 0;
+    }
+
+    UInt32 rank = (UInt32) ceil(Alg::Clamp(percent, 0.0f, 100.0f) * 0.01 * Count);
+    rank = Alg::Clamp(rank, (UInt32) 1, Count);
+
+    UInt32 seen = 0;
+    for (UInt32 i = 0; i < BucketCount; i++)
+    {
+        seen += Buckets[i];
+        if (seen >= rank)
+        {
+            return Alg::Min(bucketUpperValue(i), MaxValue);
+        }
+    }
+    return MaxValue;
+}
+
+bool LatencyHistogram::GetStats(LatencyStats* stats) const
+{
+    stats->Count      = Count;
+    stats->MinMilliS  = 0.001f * GetMin();
+    stats->MeanMilliS = 0.001f * GetMean();
+    stats->P50MilliS  = 0.001f * GetPercentile(50.0f);
+    stats->P90MilliS  = 0.001f * GetPercentile(90.0f);
+    stats->P99MilliS  = 0.001f * GetPercentile(99.0f);
+    stats->MaxMilliS  = 0.001f * GetMax();
+    return Count > 0;
+}
+
+// Values below 2*SubBucketCount map to themselves. Above that, a value is shifted right
+// until it fits in [SubBucketCount, 2*SubBucketCount); each shift count owns the next
+// SubBucketCount buckets.
+UInt32 LatencyHistogram::bucketIndex(UInt32 value)
+{
+    value = Alg::Min(value, (UInt32) (1 << MaxValueBits) - 1);
+    if (value < 2 * SubBucketCount)
+    {
+        return value;
+    }
+
+    UInt32 shift = 1;
+    while ((value >> shift) >= 2 * SubBucketCount)
+    {
+        shift++;
+    }
+    return (shift + 1) * SubBucketCount + (value >> shift) - SubBucketCount;
+}
+
+UInt32 LatencyHistogram::bucketUpperValue(UInt32 index)
+{
+    if (index < 2 * SubBucketCount)
+    {
+        return index;
+    }
+
+    UInt32 shift = index / SubBucketCount - 1;
+    UInt32 sub   = index % SubBucketCount + SubBucketCount;
+    return ((sub + 1) << shift) - 1;
+}
+
+} // OVR
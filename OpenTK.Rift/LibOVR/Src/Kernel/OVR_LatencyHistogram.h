@@ -0,0 +1,97 @@
+/************************************************************************************
+
+PublicHeader:   OVR
+Filename    :   OVR_LatencyHistogram.h
+Content     :   Fixed precision histogram of latencies with percentile queries
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_LatencyHistogram_h
+#define OVR_LatencyHistogram_h
+
+#include "OVR_Types.h"
+
+namespace OVR {
+
+// Summary of a latency histogram, in milliseconds.
+struct LatencyStats
+{
+    UInt32  Count;
+    float   MinMilliS;
+    float   MeanMilliS;
+    float   P50MilliS;
+    float   P90MilliS;
+    float   P99MilliS;
+    float   MaxMilliS;
+};
+
+
+//-----------------------------------------------------------------------------------
+// ***** LatencyHistogram
+//
+// LatencyHistogram records latencies in microseconds with a fixed relative precision, in
+// the manner of an HDR histogram: values below 256 get a bucket each, and every power of two
+// above that is split into 128 buckets, so any recorded value is known to within 0.8%.
+// Values of 2^24 microseconds (16.7 seconds) and above share the last bucket. Minimum,
+// maximum and mean are exact. Recording does not allocate.
+
+class LatencyHistogram
+{
+public:
+    enum
+    {
+        SubBucketBits  = 7,
+        SubBucketCount = 1 << SubBucketBits,
+        MaxValueBits   = 24,
+        BucketCount    = (MaxValueBits - SubBucketBits + 1) * SubBucketCount
+    };
+
+    LatencyHistogram() { Reset(); }
+
+    void    Reset();
+    void    Record(UInt32 microS);
+
+    UInt32  GetCount() const    { return Count; }
+    UInt32  GetMin() const      { return Count ? MinValue : 0; }
+    UInt32  GetMax() const      { return MaxValue; }
+    float   GetMean() const     { return Count ? (float)((double)Sum / Count) : 0.0f; }
+
+    // Returns the value at or below which the given percentage of the samples lie; this
+    // is the upper edge of the bucket holding that sample, clamped to the exact maximum.
+    UInt32  GetPercentile(float percent) const;
+
+    // Fills in the summary; returns false if nothing was recorded.
+    bool    GetStats(LatencyStats* stats) const;
+
+private:
+    static UInt32 bucketIndex(UInt32 value);
+    static UInt32 bucketUpperValue(UInt32 index);
+
+    UInt32  Count;
+    UInt32  MinValue, MaxValue;
+    UInt64  Sum;
+    UInt32  Buckets[BucketCount];
+};
+
+} // OVR
+
+#endif
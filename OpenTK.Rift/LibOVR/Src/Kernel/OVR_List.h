@@ -42,6 +42,11 @@ namespace OVR {
 // {
 //     . . .
 // };
+//
+// The root node of a List is a bare ListNode, which the links nevertheless point to as
+// if it were an element. Links are therefore always followed through ListNode: writing
+// the root through the element type would let optimizing compilers assume, under strict
+// aliasing, that the root is left unchanged.
 
 template<class T>
 struct ListNode
@@ -55,44 +60,47 @@ struct ListNode
         void* pVoidNext;
     };
 
+    // The node part of an element, or the root node behind a list's null element.
+    static ListNode* Node(T* p) { return p; }
+
     void    RemoveNode()
     {
-        pPrev->pNext = pNext;
-        pNext->pPrev = pPrev;
+        Node(pPrev)->pNext = pNext;
+        Node(pNext)->pPrev = pPrev;
     }
 
     // Removes us from the list and inserts pnew there instead.
     void    ReplaceNodeWith(T* pnew)
     {
-        pPrev->pNext = pnew;
-        pNext->pPrev = pnew;
-        pnew->pPrev = pPrev;
-        pnew->pNext = pNext;
+        Node(pPrev)->pNext = pnew;
+        Node(pNext)->pPrev = pnew;
+        Node(pnew)->pPrev  = pPrev;
+        Node(pnew)->pNext  = pNext;
     }
        
     // Inserts the argument linked list node after us in the list.
     void    InsertNodeAfter(T* p)
     {
-        p->pPrev          = pNext->pPrev; // this
-        p->pNext          = pNext;
-        pNext->pPrev      = p;
-        pNext             = p;
+        Node(p)->pPrev     = Node(pNext)->pPrev; // this
+        Node(p)->pNext     = pNext;
+        Node(pNext)->pPrev = p;
+        pNext              = p;
     }
     // Inserts the argument linked list node before us in the list.
     void    InsertNodeBefore(T* p)
     {
-        p->pNext          = pNext->pPrev; // this
-        p->pPrev          = pPrev;
-        pPrev->pNext      = p;
-        pPrev             = p;
+        Node(p)->pNext     = Node(pNext)->pPrev; // this
+        Node(p)->pPrev     = pPrev;
+        Node(pPrev)->pNext = p;
+        pPrev              = p;
     }
 
     void    Alloc_MoveTo(ListNode<T>* pdest)
     {
         pdest->pNext = pNext;
         pdest->pPrev = pPrev;
-        pPrev->pNext = (T*)pdest;
-        pNext->pPrev = (T*)pdest;
+        Node(pPrev)->pNext = (T*)pdest;
+        Node(pNext)->pPrev = (T*)pdest;
     }
 };
 
@@ -152,9 +160,7 @@ public:
           ValueType* GetLast ()       { return (ValueType*)Root.pPrev; }
 
     // Determine if list is empty (i.e.) points to itself.
-    // Go through void* access to avoid issues with strict-aliasing optimizing out the
-    // access after RemoveNode(), etc.
-    bool IsEmpty()                   const { return Root.pVoidNext == (const T*)(const B*)&Root; }
+    bool IsEmpty()                   const { return Root.pNext == (const T*)(const B*)&Root; }
     bool IsFirst(const ValueType* p) const { return p == Root.pNext; }
     bool IsLast (const ValueType* p) const { return p == Root.pPrev; }
     bool IsNull (const ValueType* p) const { return p == (const T*)(const B*)&Root; }
@@ -166,24 +172,24 @@ public:
 
     void PushFront(ValueType* p)
     {
-        p->pNext          =  Root.pNext;
-        p->pPrev          = (ValueType*)&Root;
-        Root.pNext->pPrev =  p;
-        Root.pNext        =  p;
+        Node(p)->pNext          =  Root.pNext;
+        Node(p)->pPrev          = (ValueType*)&Root;
+        Node(Root.pNext)->pPrev =  p;
+        Root.pNext              =  p;
     }
 
     void PushBack(ValueType* p)
     {
-        p->pPrev          =  Root.pPrev;
-        p->pNext          = (ValueType*)&Root;
-        Root.pPrev->pNext =  p;
-        Root.pPrev        =  p;
+        Node(p)->pPrev          =  Root.pPrev;
+        Node(p)->pNext          = (ValueType*)&Root;
+        Node(Root.pPrev)->pNext =  p;
+        Root.pPrev              =  p;
     }
 
     static void Remove(ValueType* p)
     {
-        p->pPrev->pNext = p->pNext;
-        p->pNext->pPrev = p->pPrev;
+        Node(p->pPrev)->pNext = p->pNext;
+        Node(p->pNext)->pPrev = p->pPrev;
     }
 
     void BringToFront(ValueType* p)
@@ -207,10 +213,10 @@ public:
             ValueType* pfirst = src.GetFirst();
             ValueType* plast  = src.GetLast();
             src.Clear();
-            plast->pNext   = Root.pNext;
-            pfirst->pPrev  = (ValueType*)&Root;
-            Root.pNext->pPrev = plast;
-            Root.pNext        = pfirst;
+            Node(plast)->pNext      = Root.pNext;
+            Node(pfirst)->pPrev     = (ValueType*)&Root;
+            Node(Root.pNext)->pPrev = plast;
+            Root.pNext              = pfirst;
         }
     }
 
@@ -221,10 +227,10 @@ public:
             ValueType* pfirst = src.GetFirst();
             ValueType* plast  = src.GetLast();
             src.Clear();
-            plast->pNext   = (ValueType*)&Root;
-            pfirst->pPrev  = Root.pPrev;
-            Root.pPrev->pNext = pfirst;
-            Root.pPrev        = plast;
+            Node(plast)->pNext      = (ValueType*)&Root;
+            Node(pfirst)->pPrev     = Root.pPrev;
+            Node(Root.pPrev)->pNext = pfirst;
+            Root.pPrev              = plast;
         }
     }
 
@@ -237,13 +243,13 @@ public:
             ValueType *plast = src.Root.pPrev;
 
             // Remove list remainder from source.
-            pfirst->pPrev->pNext = (ValueType*)&src.Root;
-            src.Root.pPrev      = pfirst->pPrev;
+            Node(pfirst->pPrev)->pNext = (ValueType*)&src.Root;
+            src.Root.pPrev             = pfirst->pPrev;
             // Add the rest of the items to list.
-            plast->pNext      = Root.pNext;
-            pfirst->pPrev     = (ValueType*)&Root;
-            Root.pNext->pPrev = plast;
-            Root.pNext        = pfirst;
+            Node(plast)->pNext      = Root.pNext;
+            Node(pfirst)->pPrev     = (ValueType*)&Root;
+            Node(Root.pNext)->pPrev = plast;
+            Root.pNext              = pfirst;
         }
     }
 
@@ -254,17 +260,17 @@ public:
         if (src.GetFirst() != ptail)
         {
             ValueType *pfirst = src.Root.pNext;
-            ValueType *plast  = ptail->pPrev;
+            ValueType *plast  = Node(ptail)->pPrev;
 
             // Remove list remainder from source.
-            ptail->pPrev      = (ValueType*)&src.Root;
-            src.Root.pNext    = ptail;            
+            Node(ptail)->pPrev = (ValueType*)&src.Root;
+            src.Root.pNext     = ptail;            
 
             // Add the rest of the items to list.
-            plast->pNext      = Root.pNext;
-            pfirst->pPrev     = (ValueType*)&Root;
-            Root.pNext->pPrev = plast;
-            Root.pNext        = pfirst;
+            Node(plast)->pNext      = Root.pNext;
+            Node(pfirst)->pPrev     = (ValueType*)&Root;
+            Node(Root.pNext)->pPrev = plast;
+            Root.pNext              = pfirst;
         }
     }
 
@@ -275,16 +281,16 @@ public:
     {
         if (pfirst != pend)
         {
-            ValueType *plast = pend->pPrev;
+            ValueType *plast = Node(pend)->pPrev;
 
             // Remove list remainder from source.
-            pfirst->pPrev->pNext = pend;
-            pend->pPrev          = pfirst->pPrev;
+            Node(pfirst->pPrev)->pNext = pend;
+            Node(pend)->pPrev          = pfirst->pPrev;
             // Add the rest of the items to list.
-            plast->pNext      = Root.pNext;
-            pfirst->pPrev     = (ValueType*)&Root;
-            Root.pNext->pPrev = plast;
-            Root.pNext        = pfirst;
+            Node(plast)->pNext      = Root.pNext;
+            Node(pfirst)->pPrev     = (ValueType*)&Root;
+            Node(Root.pNext)->pPrev = plast;
+            Root.pNext              = pfirst;
         }
     }
 
@@ -298,8 +304,8 @@ public:
             pdest->Root.pNext = Root.pNext;
             pdest->Root.pPrev = Root.pPrev;
 
-            Root.pNext->pPrev = (ValueType*)&pdest->Root;
-            Root.pPrev->pNext = (ValueType*)&pdest->Root;
+            Node(Root.pNext)->pPrev = (ValueType*)&pdest->Root;
+            Node(Root.pPrev)->pNext = (ValueType*)&pdest->Root;
         }        
     }
 
@@ -309,6 +315,9 @@ private:
     List(const List<T>&);
     const List<T>& operator = (const List<T>&);
 
+    // Links are followed through the node, which may be the root, see ListNode.
+    static ListNode<B>* Node(B* p) { return p; }
+
     ListNode<B> Root;
 };
 
@@ -508,12 +508,20 @@ public:
         M[3][0] = 0;   M[3][1] = 0;   M[3][2] = 0;   M[3][3] = 1;
     }
 
+    // Writes the elements separated by spaces, each with the fewest digits that read back
+    // as the same float.
     void ToString(char* dest, UPInt destsize)
     {
         UPInt pos = 0;
         for (int r=0; r<4; r++)
             for (int c=0; c<4; c++)
-                pos += OVR_sprintf(dest+pos, destsize-pos, "%g ", M[r][c]);
+            {
+                if (pos + 1 >= destsize)
+                    return;
+                pos += OVR_ftoa(M[r][c], dest+pos, destsize-pos-1);
+                dest[pos++] = ' ';
+                dest[pos]   = 0;
+            }
     }
 
     static Matrix4f FromString(const char* src)
@@ -522,11 +530,9 @@ public:
         for (int r=0; r<4; r++)
             for (int c=0; c<4; c++)
             {
-                result.M[r][c] = (float)atof(src);
-                while (src && *src != ' ')
-                    src++;
-                while (src && *src == ' ')
-                    src++;
+                char* end;
+                result.M[r][c] = OVR_strtof(src, &end);
+                src = end;
             }
         return result;
     }
@@ -975,6 +981,110 @@ public:
 };
 
 
+//-------------------------------------------------------------------------------------
+// ***** Matrix3f
+//
+// Matrix3f is a 3x3 row-major matrix, used where only a linear map or a second
+// moment of 3D data is needed (for example a covariance matrix).
+
+class Matrix3f
+{
+public:
+    float M[3][3];
+
+    enum NoInitType { NoInit };
+
+    // Construct with no memory initialization.
+    Matrix3f(NoInitType) { }
+
+    // By default, we construct identity matrix.
+    Matrix3f()
+    {
+        SetIdentity();
+    }
+
+    Matrix3f(float m11, float m12, float m13,
+             float m21, float m22, float m23,
+             float m31, float m32, float m33)
+    {
+        M[0][0] = m11; M[0][1] = m12; M[0][2] = m13;
+        M[1][0] = m21; M[1][1] = m22; M[1][2] = m23;
+        M[2][0] = m31; M[2][1] = m32; M[2][2] = m33;
+    }
+
+    void SetIdentity()
+    {
+        M[0][0] = M[1][1] = M[2][2] = 1;
+        M[0][1] = M[0][2] = M[1][0] = 0;
+        M[1][2] = M[2][0] = M[2][1] = 0;
+    }
+
+    void SetZero()
+    {
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                M[i][j] = 0;
+    }
+
+    Matrix3f operator+ (const Matrix3f& b) const
+    {
+        Matrix3f result(*this);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                result.M[i][j] += b.M[i][j];
+        return result;
+    }
+
+    Matrix3f operator- (const Matrix3f& b) const
+    {
+        Matrix3f result(*this);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                result.M[i][j] -= b.M[i][j];
+        return result;
+    }
+
+    Matrix3f operator* (const Matrix3f& b) const
+    {
+        Matrix3f result(NoInit);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                result.M[i][j] = M[i][0] * b.M[0][j] + M[i][1] * b.M[1][j] + M[i][2] * b.M[2][j];
+        return result;
+    }
+
+    Matrix3f operator* (float s) const
+    {
+        Matrix3f result(*this);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                result.M[i][j] *= s;
+        return result;
+    }
+
+    Vector3f Transform(const Vector3f& v) const
+    {
+        return Vector3f(M[0][0] * v.x + M[0][1] * v.y + M[0][2] * v.z,
+                        M[1][0] * v.x + M[1][1] * v.y + M[1][2] * v.z,
+                        M[2][0] * v.x + M[2][1] * v.y + M[2][2] * v.z);
+    }
+
+    Matrix3f Transposed() const
+    {
+        return Matrix3f(M[0][0], M[1][0], M[2][0],
+                        M[0][1], M[1][1], M[2][1],
+                        M[0][2], M[1][2], M[2][2]);
+    }
+
+    float Determinant() const
+    {
+        return M[0][0] * (M[1][1] * M[2][2] - M[1][2] * M[2][1])
+             - M[0][1] * (M[1][0] * M[2][2] - M[1][2] * M[2][0])
+             + M[0][2] * (M[1][0] * M[2][1] - M[1][1] * M[2][0]);
+    }
+};
+
+
 //-------------------------------------------------------------------------------------//
 // **************************************** Quat **************************************//
 //
@@ -1109,7 +1219,24 @@ public:
         GetAxisAngle(&v, &a);
         return Quat(v, a * p);
     }
-    
+
+    // Spherical linear interpolation between this (s = 0) and other (s = 1) along the
+    // shorter arc. Both quaternions are expected to be normalized.
+    Quat Slerp(const Quat& other, T s) const
+    {
+        T    d = x * other.x + y * other.y + z * other.z + w * other.w;
+        Quat b = (d < T(0)) ? other * T(-1) : other;
+        d = fabs(d);
+
+        // Nearly parallel; the arc is indistinguishable from the chord
+        if (d > T(0.9995))
+            return (*this + (b - *this) * s).Normalized();
+
+        T theta = acos(d);
+        T sinInv = T(1) / sin(theta);
+        return *this * (sin((T(1) - s) * theta) * sinInv) + b * (sin(s * theta) * sinInv);
+    }
+
     // Rotate transforms vector in a manner that matches Matrix rotations (counter-clockwise,
     // assuming negative direction of the axis). Standard formula: q(t) * V * q(t)^-1. 
     Vector3<T> Rotate(const Vector3<T>& v) const
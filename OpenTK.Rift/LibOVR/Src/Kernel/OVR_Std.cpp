@@ -29,6 +29,8 @@ limitations under the License.
 
 // localeconv() call in OVR_strtod()
 #include <locale.h>
+// FLT_EVAL_METHOD, for the fast path of OVR_strtod()
+#include <float.h>
 
 namespace OVR {
 
@@ -192,17 +194,16 @@ int OVR_CDECL OVR_wcsicmp(const wchar_t* a, const wchar_t* b)
 #endif
 }
 
-// This function is not inline because of dependency on <locale.h>
-double OVR_CDECL OVR_strtod(const char* string, char** tailptr)
+// Replaces the decimal point with that of the locale, for the C library conversions;
+// returns string or buffer.
+static const char* localeDecimalPoint(const char* string, char* buffer, UPInt size)
 {
 #if !defined(OVR_OS_ANDROID)
     const char s = *localeconv()->decimal_point;
 
     if (s != '.')
     {
-        char buffer[347 + 1];
-
-        OVR_strcpy(buffer, sizeof(buffer), string);
+        OVR_strcpy(buffer, size, string);
 
         for (char* c = buffer; *c != '\0'; ++c)
         {
@@ -212,12 +213,1297 @@ double OVR_CDECL OVR_strtod(const char* string, char** tailptr)
                 break;
             }
         }
-
-        return strtod(buffer, tailptr);
+        return buffer;
     }
 #endif
 
-    return strtod(string, tailptr);
+    OVR_UNUSED2(buffer, size);
+    return string;
+}
+
+// These functions are not inline because of dependency on <locale.h>
+static double strtodLocale(const char* string, char** tailptr)
+{
+    char buffer[347 + 1];
+    return strtod(localeDecimalPoint(string, buffer, sizeof(buffer)), tailptr);
+}
+
+static float strtofLocale(const char* string, char** tailptr)
+{
+#if defined(OVR_CC_MSVC) && (OVR_CC_MSVC < 1800)
+    // No strtof before Visual Studio 2013; rounding to double first can differ from
+    // rounding straight to float in the last bit.
+    return (float)strtodLocale(string, tailptr);
+#else
+    char buffer[347 + 1];
+    return strtof(localeDecimalPoint(string, buffer, sizeof(buffer)), tailptr);
+#endif
+}
+
+//-----------------------------------------------------------------------------------
+// ***** Decimal Conversion
+
+// OVR_strtod and OVR_strtof use the Eisel-Lemire algorithm, which finds the correctly
+// rounded value from one or two 64-bit multiplications by a truncated power of ten. The
+// few inputs it can't decide, and those it doesn't handle (more than 19 significant
+// digits that matter, hexadecimal, infinity and NaN), are passed to strtod or strtof.
+//
+// OVR_dtoa and OVR_ftoa use the Schubfach algorithm, which like Ryu finds the shortest
+// digits that convert back to the same value, with the nearest chosen when there are
+// several; it only needs the same table of powers of ten.
+
+#define OVR_UINT64(hi, lo)  (((UInt64)(hi) << 32) | (UInt64)(lo))
+
+// Normalized 128-bit significands of 10^q for q in [PowerTableMin, PowerTableMax],
+// truncated; each entry is {high 64 bits, low 64 bits}.
+static const int    PowerTableMin = -342;
+static const int    PowerTableMax = 324;
+static const UInt64 PowerTable[PowerTableMax - PowerTableMin + 1][2] =
+{
+    { OVR_UINT64(0xeef453d6, 0x923bd65a), OVR_UINT64(0x113faa29, 0x06a13b3f) },
+    { OVR_UINT64(0x9558b466, 0x1b6565f8), OVR_UINT64(0x4ac7ca59, 0xa424c507) },
+    { OVR_UINT64(0xbaaee17f, 0xa23ebf76), OVR_UINT64(0x5d79bcf0, 0x0d2df649) },
+    { OVR_UINT64(0xe95a99df, 0x8ace6f53), OVR_UINT64(0xf4d82c2c, 0x107973dc) },
+    { OVR_UINT64(0x91d8a02b, 0xb6c10594), OVR_UINT64(0x79071b9b, 0x8a4be869) },
+    { OVR_UINT64(0xb64ec836, 0xa47146f9), OVR_UINT64(0x9748e282, 0x6cdee284) },
+    { OVR_UINT64(0xe3e27a44, 0x4d8d98b7), OVR_UINT64(0xfd1b1b23, 0x08169b25) },
+    { OVR_UINT64(0x8e6d8c6a, 0xb0787f72), OVR_UINT64(0xfe30f0f5, 0xe50e20f7) },
+    { OVR_UINT64(0xb208ef85, 0x5c969f4f), OVR_UINT64(0xbdbd2d33, 0x5e51a935) },
+    { OVR_UINT64(0xde8b2b66, 0xb3bc4723), OVR_UINT64(0xad2c7880, 0x35e61382) },
+    { OVR_UINT64(0x8b16fb20, 0x3055ac76), OVR_UINT64(0x4c3bcb50, 0x21afcc31) },
+    { OVR_UINT64(0xaddcb9e8, 0x3c6b1793), OVR_UINT64(0xdf4abe24, 0x2a1bbf3d) },
+    { OVR_UINT64(0xd953e862, 0x4b85dd78), OVR_UINT64(0xd71d6dad, 0x34a2af0d) },
+    { OVR_UINT64(0x87d4713d, 0x6f33aa6b), OVR_UINT64(0x8672648c, 0x40e5ad68) },
+    { OVR_UINT64(0xa9c98d8c, 0xcb009506), OVR_UINT64(0x680efdaf, 0x511f18c2) },
+    { OVR_UINT64(0xd43bf0ef, 0xfdc0ba48), OVR_UINT64(0x0212bd1b, 0x2566def2) },
+    { OVR_UINT64(0x84a57695, 0xfe98746d), OVR_UINT64(0x014bb630, 0xf7604b57) },
+    { OVR_UINT64(0xa5ced43b, 0x7e3e9188), OVR_UINT64(0x419ea3bd, 0x35385e2d) },
+    { OVR_UINT64(0xcf42894a, 0x5dce35ea), OVR_UINT64(0x52064cac, 0x828675b9) },
+    { OVR_UINT64(0x818995ce, 0x7aa0e1b2), OVR_UINT64(0x7343efeb, 0xd1940993) },
+    { OVR_UINT64(0xa1ebfb42, 0x19491a1f), OVR_UINT64(0x1014ebe6, 0xc5f90bf8) },
+    { OVR_UINT64(0xca66fa12, 0x9f9b60a6), OVR_UINT64(0xd41a26e0, 0x77774ef6) },
+    { OVR_UINT64(0xfd00b897, 0x478238d0), OVR_UINT64(0x8920b098, 0x955522b4) },
+    { OVR_UINT64(0x9e20735e, 0x8cb16382), OVR_UINT64(0x55b46e5f, 0x5d5535b0) },
+    { OVR_UINT64(0xc5a89036, 0x2fddbc62), OVR_UINT64(0xeb2189f7, 0x34aa831d) },
+    { OVR_UINT64(0xf712b443, 0xbbd52b7b), OVR_UINT64(0xa5e9ec75, 0x01d523e4) },
+    { OVR_UINT64(0x9a6bb0aa, 0x55653b2d), OVR_UINT64(0x47b233c9, 0x2125366e) },
+    { OVR_UINT64(0xc1069cd4, 0xeabe89f8), OVR_UINT64(0x999ec0bb, 0x696e840a) },
+    { OVR_UINT64(0xf148440a, 0x256e2c76), OVR_UINT64(0xc00670ea, 0x43ca250d) },
+    { OVR_UINT64(0x96cd2a86, 0x5764dbca), OVR_UINT64(0x38040692, 0x6a5e5728) },
+    { OVR_UINT64(0xbc807527, 0xed3e12bc), OVR_UINT64(0xc6050837, 0x04f5ecf2) },
+    { OVR_UINT64(0xeba09271, 0xe88d976b), OVR_UINT64(0xf7864a44, 0xc633682e) },
+    { OVR_UINT64(0x93445b87, 0x31587ea3), OVR_UINT64(0x7ab3ee6a, 0xfbe0211d) },
+    { OVR_UINT64(0xb8157268, 0xfdae9e4c), OVR_UINT64(0x5960ea05, 0xbad82964) },
+    { OVR_UINT64(0xe61acf03, 0x3d1a45df), OVR_UINT64(0x6fb92487, 0x298e33bd) },
+    { OVR_UINT64(0x8fd0c162, 0x06306bab), OVR_UINT64(0xa5d3b6d4, 0x79f8e056) },
+    { OVR_UINT64(0xb3c4f1ba, 0x87bc8696), OVR_UINT64(0x8f48a489, 0x9877186c) },
+    { OVR_UINT64(0xe0b62e29, 0x29aba83c), OVR_UINT64(0x331acdab, 0xfe94de87) },
+    { OVR_UINT64(0x8c71dcd9, 0xba0b4925), OVR_UINT64(0x9ff0c08b, 0x7f1d0b14) },
+    { OVR_UINT64(0xaf8e5410, 0x288e1b6f), OVR_UINT64(0x07ecf0ae, 0x5ee44dd9) },
+    { OVR_UINT64(0xdb71e914, 0x32b1a24a), OVR_UINT64(0xc9e82cd9, 0xf69d6150) },
+    { OVR_UINT64(0x892731ac, 0x9faf056e), OVR_UINT64(0xbe311c08, 0x3a225cd2) },
+    { OVR_UINT64(0xab70fe17, 0xc79ac6ca), OVR_UINT64(0x6dbd630a, 0x48aaf406) },
+    { OVR_UINT64(0xd64d3d9d, 0xb981787d), OVR_UINT64(0x092cbbcc, 0xdad5b108) },
+    { OVR_UINT64(0x85f04682, 0x93f0eb4e), OVR_UINT64(0x25bbf560, 0x08c58ea5) },
+    { OVR_UINT64(0xa76c5823, 0x38ed2621), OVR_UINT64(0xaf2af2b8, 0x0af6f24e) },
+    { OVR_UINT64(0xd1476e2c, 0x07286faa), OVR_UINT64(0x1af5af66, 0x0db4aee1) },
+    { OVR_UINT64(0x82cca4db, 0x847945ca), OVR_UINT64(0x50d98d9f, 0xc890ed4d) },
+    { OVR_UINT64(0xa37fce12, 0x6597973c), OVR_UINT64(0xe50ff107, 0xbab528a0) },
+    { OVR_UINT64(0xcc5fc196, 0xfefd7d0c), OVR_UINT64(0x1e53ed49, 0xa96272c8) },
+    { OVR_UINT64(0xff77b1fc, 0xbebcdc4f), OVR_UINT64(0x25e8e89c, 0x13bb0f7a) },
+    { OVR_UINT64(0x9faacf3d, 0xf73609b1), OVR_UINT64(0x77b19161, 0x8c54e9ac) },
+    { OVR_UINT64(0xc795830d, 0x75038c1d), OVR_UINT64(0xd59df5b9, 0xef6a2417) },
+    { OVR_UINT64(0xf97ae3d0, 0xd2446f25), OVR_UINT64(0x4b057328, 0x6b44ad1d) },
+    { OVR_UINT64(0x9becce62, 0x836ac577), OVR_UINT64(0x4ee367f9, 0x430aec32) },
+    { OVR_UINT64(0xc2e801fb, 0x244576d5), OVR_UINT64(0x229c41f7, 0x93cda73f) },
+    { OVR_UINT64(0xf3a20279, 0xed56d48a), OVR_UINT64(0x6b435275, 0x78c1110f) },
+    { OVR_UINT64(0x9845418c, 0x345644d6), OVR_UINT64(0x830a1389, 0x6b78aaa9) },
+    { OVR_UINT64(0xbe5691ef, 0x416bd60c), OVR_UINT64(0x23cc986b, 0xc656d553) },
+    { OVR_UINT64(0xedec366b, 0x11c6cb8f), OVR_UINT64(0x2cbfbe86, 0xb7ec8aa8) },
+    { OVR_UINT64(0x94b3a202, 0xeb1c3f39), OVR_UINT64(0x7bf7d714, 0x32f3d6a9) },
+    { OVR_UINT64(0xb9e08a83, 0xa5e34f07), OVR_UINT64(0xdaf5ccd9, 0x3fb0cc53) },
+    { OVR_UINT64(0xe858ad24, 0x8f5c22c9), OVR_UINT64(0xd1b3400f, 0x8f9cff68) },
+    { OVR_UINT64(0x91376c36, 0xd99995be), OVR_UINT64(0x23100809, 0xb9c21fa1) },
+    { OVR_UINT64(0xb5854744, 0x8ffffb2d), OVR_UINT64(0xabd40a0c, 0x2832a78a) },
+    { OVR_UINT64(0xe2e69915, 0xb3fff9f9), OVR_UINT64(0x16c90c8f, 0x323f516c) },
+    { OVR_UINT64(0x8dd01fad, 0x907ffc3b), OVR_UINT64(0xae3da7d9, 0x7f6792e3) },
+    { OVR_UINT64(0xb1442798, 0xf49ffb4a), OVR_UINT64(0x99cd11cf, 0xdf41779c) },
+    { OVR_UINT64(0xdd95317f, 0x31c7fa1d), OVR_UINT64(0x40405643, 0xd711d583) },
+    { OVR_UINT64(0x8a7d3eef, 0x7f1cfc52), OVR_UINT64(0x482835ea, 0x666b2572) },
+    { OVR_UINT64(0xad1c8eab, 0x5ee43b66), OVR_UINT64(0xda324365, 0x0005eecf) },
+    { OVR_UINT64(0xd863b256, 0x369d4a40), OVR_UINT64(0x90bed43e, 0x40076a82) },
+    { OVR_UINT64(0x873e4f75, 0xe2224e68), OVR_UINT64(0x5a7744a6, 0xe804a291) },
+    { OVR_UINT64(0xa90de353, 0x5aaae202), OVR_UINT64(0x711515d0, 0xa205cb36) },
+    { OVR_UINT64(0xd3515c28, 0x31559a83), OVR_UINT64(0x0d5a5b44, 0xca873e03) },
+    { OVR_UINT64(0x8412d999, 0x1ed58091), OVR_UINT64(0xe858790a, 0xfe9486c2) },
+    { OVR_UINT64(0xa5178fff, 0x668ae0b6), OVR_UINT64(0x626e974d, 0xbe39a872) },
+    { OVR_UINT64(0xce5d73ff, 0x402d98e3), OVR_UINT64(0xfb0a3d21, 0x2dc8128f) },
+    { OVR_UINT64(0x80fa687f, 0x881c7f8e), OVR_UINT64(0x7ce66634, 0xbc9d0b99) },
+    { OVR_UINT64(0xa139029f, 0x6a239f72), OVR_UINT64(0x1c1fffc1, 0xebc44e80) },
+    { OVR_UINT64(0xc9874347, 0x44ac874e), OVR_UINT64(0xa327ffb2, 0x66b56220) },
+    { OVR_UINT64(0xfbe91419, 0x15d7a922), OVR_UINT64(0x4bf1ff9f, 0x0062baa8) },
+    { OVR_UINT64(0x9d71ac8f, 0xada6c9b5), OVR_UINT64(0x6f773fc3, 0x603db4a9) },
+    { OVR_UINT64(0xc4ce17b3, 0x99107c22), OVR_UINT64(0xcb550fb4, 0x384d21d3) },
+    { OVR_UINT64(0xf6019da0, 0x7f549b2b), OVR_UINT64(0x7e2a53a1, 0x46606a48) },
+    { OVR_UINT64(0x99c10284, 0x4f94e0fb), OVR_UINT64(0x2eda7444, 0xcbfc426d) },
+    { OVR_UINT64(0xc0314325, 0x637a1939), OVR_UINT64(0xfa911155, 0xfefb5308) },
+    { OVR_UINT64(0xf03d93ee, 0xbc589f88), OVR_UINT64(0x793555ab, 0x7eba27ca) },
+    { OVR_UINT64(0x96267c75, 0x35b763b5), OVR_UINT64(0x4bc1558b, 0x2f3458de) },
+    { OVR_UINT64(0xbbb01b92, 0x83253ca2), OVR_UINT64(0x9eb1aaed, 0xfb016f16) },
+    { OVR_UINT64(0xea9c2277, 0x23ee8bcb), OVR_UINT64(0x465e15a9, 0x79c1cadc) },
+    { OVR_UINT64(0x92a1958a, 0x7675175f), OVR_UINT64(0x0bfacd89, 0xec191ec9) },
+    { OVR_UINT64(0xb749faed, 0x14125d36), OVR_UINT64(0xcef980ec, 0x671f667b) },
+    { OVR_UINT64(0xe51c79a8, 0x5916f484), OVR_UINT64(0x82b7e127, 0x80e7401a) },
+    { OVR_UINT64(0x8f31cc09, 0x37ae58d2), OVR_UINT64(0xd1b2ecb8, 0xb0908810) },
+    { OVR_UINT64(0xb2fe3f0b, 0x8599ef07), OVR_UINT64(0x861fa7e6, 0xdcb4aa15) },
+    { OVR_UINT64(0xdfbdcece, 0x67006ac9), OVR_UINT64(0x67a791e0, 0x93e1d49a) },
+    { OVR_UINT64(0x8bd6a141, 0x006042bd), OVR_UINT64(0xe0c8bb2c, 0x5c6d24e0) },
+    { OVR_UINT64(0xaecc4991, 0x4078536d), OVR_UINT64(0x58fae9f7, 0x73886e18) },
+    { OVR_UINT64(0xda7f5bf5, 0x90966848), OVR_UINT64(0xaf39a475, 0x506a899e) },
+    { OVR_UINT64(0x888f9979, 0x7a5e012d), OVR_UINT64(0x6d8406c9, 0x52429603) },
+    { OVR_UINT64(0xaab37fd7, 0xd8f58178), OVR_UINT64(0xc8e5087b, 0xa6d33b83) },
+    { OVR_UINT64(0xd5605fcd, 0xcf32e1d6), OVR_UINT64(0xfb1e4a9a, 0x90880a64) },
+    { OVR_UINT64(0x855c3be0, 0xa17fcd26), OVR_UINT64(0x5cf2eea0, 0x9a55067f) },
+    { OVR_UINT64(0xa6b34ad8, 0xc9dfc06f), OVR_UINT64(0xf42faa48, 0xc0ea481e) },
+    { OVR_UINT64(0xd0601d8e, 0xfc57b08b), OVR_UINT64(0xf13b94da, 0xf124da26) },
+    { OVR_UINT64(0x823c1279, 0x5db6ce57), OVR_UINT64(0x76c53d08, 0xd6b70858) },
+    { OVR_UINT64(0xa2cb1717, 0xb52481ed), OVR_UINT64(0x54768c4b, 0x0c64ca6e) },
+    { OVR_UINT64(0xcb7ddcdd, 0xa26da268), OVR_UINT64(0xa9942f5d, 0xcf7dfd09) },
+    { OVR_UINT64(0xfe5d5415, 0x0b090b02), OVR_UINT64(0xd3f93b35, 0x435d7c4c) },
+    { OVR_UINT64(0x9efa548d, 0x26e5a6e1), OVR_UINT64(0xc47bc501, 0x4a1a6daf) },
+    { OVR_UINT64(0xc6b8e9b0, 0x709f109a), OVR_UINT64(0x359ab641, 0x9ca1091b) },
+    { OVR_UINT64(0xf867241c, 0x8cc6d4c0), OVR_UINT64(0xc30163d2, 0x03c94b62) },
+    { OVR_UINT64(0x9b407691, 0xd7fc44f8), OVR_UINT64(0x79e0de63, 0x425dcf1d) },
+    { OVR_UINT64(0xc2109436, 0x4dfb5636), OVR_UINT64(0x985915fc, 0x12f542e4) },
+    { OVR_UINT64(0xf294b943, 0xe17a2bc4), OVR_UINT64(0x3e6f5b7b, 0x17b2939d) },
+    { OVR_UINT64(0x979cf3ca, 0x6cec5b5a), OVR_UINT64(0xa705992c, 0xeecf9c42) },
+    { OVR_UINT64(0xbd8430bd, 0x08277231), OVR_UINT64(0x50c6ff78, 0x2a838353) },
+    { OVR_UINT64(0xece53cec, 0x4a314ebd), OVR_UINT64(0xa4f8bf56, 0x35246428) },
+    { OVR_UINT64(0x940f4613, 0xae5ed136), OVR_UINT64(0x871b7795, 0xe136be99) },
+    { OVR_UINT64(0xb9131798, 0x99f68584), OVR_UINT64(0x28e2557b, 0x59846e3f) },
+    { OVR_UINT64(0xe757dd7e, 0xc07426e5), OVR_UINT64(0x331aeada, 0x2fe589cf) },
+    { OVR_UINT64(0x9096ea6f, 0x3848984f), OVR_UINT64(0x3ff0d2c8, 0x5def7621) },
+    { OVR_UINT64(0xb4bca50b, 0x065abe63), OVR_UINT64(0x0fed077a, 0x756b53a9) },
+    { OVR_UINT64(0xe1ebce4d, 0xc7f16dfb), OVR_UINT64(0xd3e84959, 0x12c62894) },
+    { OVR_UINT64(0x8d3360f0, 0x9cf6e4bd), OVR_UINT64(0x64712dd7, 0xabbbd95c) },
+    { OVR_UINT64(0xb080392c, 0xc4349dec), OVR_UINT64(0xbd8d794d, 0x96aacfb3) },
+    { OVR_UINT64(0xdca04777, 0xf541c567), OVR_UINT64(0xecf0d7a0, 0xfc5583a0) },
+    { OVR_UINT64(0x89e42caa, 0xf9491b60), OVR_UINT64(0xf41686c4, 0x9db57244) },
+    { OVR_UINT64(0xac5d37d5, 0xb79b6239), OVR_UINT64(0x311c2875, 0xc522ced5) },
+    { OVR_UINT64(0xd77485cb, 0x25823ac7), OVR_UINT64(0x7d633293, 0x366b828b) },
+    { OVR_UINT64(0x86a8d39e, 0xf77164bc), OVR_UINT64(0xae5dff9c, 0x02033197) },
+    { OVR_UINT64(0xa8530886, 0xb54dbdeb), OVR_UINT64(0xd9f57f83, 0x0283fdfc) },
+    { OVR_UINT64(0xd267caa8, 0x62a12d66), OVR_UINT64(0xd072df63, 0xc324fd7b) },
+    { OVR_UINT64(0x8380dea9, 0x3da4bc60), OVR_UINT64(0x4247cb9e, 0x59f71e6d) },
+    { OVR_UINT64(0xa4611653, 0x8d0deb78), OVR_UINT64(0x52d9be85, 0xf074e608) },
+    { OVR_UINT64(0xcd795be8, 0x70516656), OVR_UINT64(0x67902e27, 0x6c921f8b) },
+    { OVR_UINT64(0x806bd971, 0x4632dff6), OVR_UINT64(0x00ba1cd8, 0xa3db53b6) },
+    { OVR_UINT64(0xa086cfcd, 0x97bf97f3), OVR_UINT64(0x80e8a40e, 0xccd228a4) },
+    { OVR_UINT64(0xc8a883c0, 0xfdaf7df0), OVR_UINT64(0x6122cd12, 0x8006b2cd) },
+    { OVR_UINT64(0xfad2a4b1, 0x3d1b5d6c), OVR_UINT64(0x796b8057, 0x20085f81) },
+    { OVR_UINT64(0x9cc3a6ee, 0xc6311a63), OVR_UINT64(0xcbe33036, 0x74053bb0) },
+    { OVR_UINT64(0xc3f490aa, 0x77bd60fc), OVR_UINT64(0xbedbfc44, 0x11068a9c) },
+    { OVR_UINT64(0xf4f1b4d5, 0x15acb93b), OVR_UINT64(0xee92fb55, 0x15482d44) },
+    { OVR_UINT64(0x99171105, 0x2d8bf3c5), OVR_UINT64(0x751bdd15, 0x2d4d1c4a) },
+    { OVR_UINT64(0xbf5cd546, 0x78eef0b6), OVR_UINT64(0xd262d45a, 0x78a0635d) },
+    { OVR_UINT64(0xef340a98, 0x172aace4), OVR_UINT64(0x86fb8971, 0x16c87c34) },
+    { OVR_UINT64(0x9580869f, 0x0e7aac0e), OVR_UINT64(0xd45d35e6, 0xae3d4da0) },
+    { OVR_UINT64(0xbae0a846, 0xd2195712), OVR_UINT64(0x89748360, 0x59cca109) },
+    { OVR_UINT64(0xe998d258, 0x869facd7), OVR_UINT64(0x2bd1a438, 0x703fc94b) },
+    { OVR_UINT64(0x91ff8377, 0x5423cc06), OVR_UINT64(0x7b6306a3, 0x4627ddcf) },
+    { OVR_UINT64(0xb67f6455, 0x292cbf08), OVR_UINT64(0x1a3bc84c, 0x17b1d542) },
+    { OVR_UINT64(0xe41f3d6a, 0x7377eeca), OVR_UINT64(0x20caba5f, 0x1d9e4a93) },
+    { OVR_UINT64(0x8e938662, 0x882af53e), OVR_UINT64(0x547eb47b, 0x7282ee9c) },
+    { OVR_UINT64(0xb23867fb, 0x2a35b28d), OVR_UINT64(0xe99e619a, 0x4f23aa43) },
+    { OVR_UINT64(0xdec681f9, 0xf4c31f31), OVR_UINT64(0x6405fa00, 0xe2ec94d4) },
+    { OVR_UINT64(0x8b3c113c, 0x38f9f37e), OVR_UINT64(0xde83bc40, 0x8dd3dd04) },
+    { OVR_UINT64(0xae0b158b, 0x4738705e), OVR_UINT64(0x9624ab50, 0xb148d445) },
+    { OVR_UINT64(0xd98ddaee, 0x19068c76), OVR_UINT64(0x3badd624, 0xdd9b0957) },
+    { OVR_UINT64(0x87f8a8d4, 0xcfa417c9), OVR_UINT64(0xe54ca5d7, 0x0a80e5d6) },
+    { OVR_UINT64(0xa9f6d30a, 0x038d1dbc), OVR_UINT64(0x5e9fcf4c, 0xcd211f4c) },
+    { OVR_UINT64(0xd47487cc, 0x8470652b), OVR_UINT64(0x7647c320, 0x0069671f) },
+    { OVR_UINT64(0x84c8d4df, 0xd2c63f3b), OVR_UINT64(0x29ecd9f4, 0x0041e073) },
+    { OVR_UINT64(0xa5fb0a17, 0xc777cf09), OVR_UINT64(0xf4681071, 0x00525890) },
+    { OVR_UINT64(0xcf79cc9d, 0xb955c2cc), OVR_UINT64(0x7182148d, 0x4066eeb4) },
+    { OVR_UINT64(0x81ac1fe2, 0x93d599bf), OVR_UINT64(0xc6f14cd8, 0x48405530) },
+    { OVR_UINT64(0xa21727db, 0x38cb002f), OVR_UINT64(0xb8ada00e, 0x5a506a7c) },
+    { OVR_UINT64(0xca9cf1d2, 0x06fdc03b), OVR_UINT64(0xa6d90811, 0xf0e4851c) },
+    { OVR_UINT64(0xfd442e46, 0x88bd304a), OVR_UINT64(0x908f4a16, 0x6d1da663) },
+    { OVR_UINT64(0x9e4a9cec, 0x15763e2e), OVR_UINT64(0x9a598e4e, 0x043287fe) },
+    { OVR_UINT64(0xc5dd4427, 0x1ad3cdba), OVR_UINT64(0x40eff1e1, 0x853f29fd) },
+    { OVR_UINT64(0xf7549530, 0xe188c128), OVR_UINT64(0xd12bee59, 0xe68ef47c) },
+    { OVR_UINT64(0x9a94dd3e, 0x8cf578b9), OVR_UINT64(0x82bb74f8, 0x301958ce) },
+    { OVR_UINT64(0xc13a148e, 0x3032d6e7), OVR_UINT64(0xe36a5236, 0x3c1faf01) },
+    { OVR_UINT64(0xf18899b1, 0xbc3f8ca1), OVR_UINT64(0xdc44e6c3, 0xcb279ac1) },
+    { OVR_UINT64(0x96f5600f, 0x15a7b7e5), OVR_UINT64(0x29ab103a, 0x5ef8c0b9) },
+    { OVR_UINT64(0xbcb2b812, 0xdb11a5de), OVR_UINT64(0x7415d448, 0xf6b6f0e7) },
+    { OVR_UINT64(0xebdf6617, 0x91d60f56), OVR_UINT64(0x111b495b, 0x3464ad21) },
+    { OVR_UINT64(0x936b9fce, 0xbb25c995), OVR_UINT64(0xcab10dd9, 0x00beec34) },
+    { OVR_UINT64(0xb84687c2, 0x69ef3bfb), OVR_UINT64(0x3d5d514f, 0x40eea742) },
+    { OVR_UINT64(0xe65829b3, 0x046b0afa), OVR_UINT64(0x0cb4a5a3, 0x112a5112) },
+    { OVR_UINT64(0x8ff71a0f, 0xe2c2e6dc), OVR_UINT64(0x47f0e785, 0xeaba72ab) },
+    { OVR_UINT64(0xb3f4e093, 0xdb73a093), OVR_UINT64(0x59ed2167, 0x65690f56) },
+    { OVR_UINT64(0xe0f218b8, 0xd25088b8), OVR_UINT64(0x306869c1, 0x3ec3532c) },
+    { OVR_UINT64(0x8c974f73, 0x83725573), OVR_UINT64(0x1e414218, 0xc73a13fb) },
+    { OVR_UINT64(0xafbd2350, 0x644eeacf), OVR_UINT64(0xe5d1929e, 0xf90898fa) },
+    { OVR_UINT64(0xdbac6c24, 0x7d62a583), OVR_UINT64(0xdf45f746, 0xb74abf39) },
+    { OVR_UINT64(0x894bc396, 0xce5da772), OVR_UINT64(0x6b8bba8c, 0x328eb783) },
+    { OVR_UINT64(0xab9eb47c, 0x81f5114f), OVR_UINT64(0x066ea92f, 0x3f326564) },
+    { OVR_UINT64(0xd686619b, 0xa27255a2), OVR_UINT64(0xc80a537b, 0x0efefebd) },
+    { OVR_UINT64(0x8613fd01, 0x45877585), OVR_UINT64(0xbd06742c, 0xe95f5f36) },
+    { OVR_UINT64(0xa798fc41, 0x96e952e7), OVR_UINT64(0x2c481138, 0x23b73704) },
+    { OVR_UINT64(0xd17f3b51, 0xfca3a7a0), OVR_UINT64(0xf75a1586, 0x2ca504c5) },
+    { OVR_UINT64(0x82ef8513, 0x3de648c4), OVR_UINT64(0x9a984d73, 0xdbe722fb) },
+    { OVR_UINT64(0xa3ab6658, 0x0d5fdaf5), OVR_UINT64(0xc13e60d0, 0xd2e0ebba) },
+    { OVR_UINT64(0xcc963fee, 0x10b7d1b3), OVR_UINT64(0x318df905, 0x079926a8) },
+    { OVR_UINT64(0xffbbcfe9, 0x94e5c61f), OVR_UINT64(0xfdf17746, 0x497f7052) },
+    { OVR_UINT64(0x9fd561f1, 0xfd0f9bd3), OVR_UINT64(0xfeb6ea8b, 0xedefa633) },
+    { OVR_UINT64(0xc7caba6e, 0x7c5382c8), OVR_UINT64(0xfe64a52e, 0xe96b8fc0) },
+    { OVR_UINT64(0xf9bd690a, 0x1b68637b), OVR_UINT64(0x3dfdce7a, 0xa3c673b0) },
+    { OVR_UINT64(0x9c1661a6, 0x51213e2d), OVR_UINT64(0x06bea10c, 0xa65c084e) },
+    { OVR_UINT64(0xc31bfa0f, 0xe5698db8), OVR_UINT64(0x486e494f, 0xcff30a62) },
+    { OVR_UINT64(0xf3e2f893, 0xdec3f126), OVR_UINT64(0x5a89dba3, 0xc3efccfa) },
+    { OVR_UINT64(0x986ddb5c, 0x6b3a76b7), OVR_UINT64(0xf8962946, 0x5a75e01c) },
+    { OVR_UINT64(0xbe895233, 0x86091465), OVR_UINT64(0xf6bbb397, 0xf1135823) },
+    { OVR_UINT64(0xee2ba6c0, 0x678b597f), OVR_UINT64(0x746aa07d, 0xed582e2c) },
+    { OVR_UINT64(0x94db4838, 0x40b717ef), OVR_UINT64(0xa8c2a44e, 0xb4571cdc) },
+    { OVR_UINT64(0xba121a46, 0x50e4ddeb), OVR_UINT64(0x92f34d62, 0x616ce413) },
+    { OVR_UINT64(0xe896a0d7, 0xe51e1566), OVR_UINT64(0x77b020ba, 0xf9c81d17) },
+    { OVR_UINT64(0x915e2486, 0xef32cd60), OVR_UINT64(0x0ace1474, 0xdc1d122e) },
+    { OVR_UINT64(0xb5b5ada8, 0xaaff80b8), OVR_UINT64(0x0d819992, 0x132456ba) },
+    { OVR_UINT64(0xe3231912, 0xd5bf60e6), OVR_UINT64(0x10e1fff6, 0x97ed6c69) },
+    { OVR_UINT64(0x8df5efab, 0xc5979c8f), OVR_UINT64(0xca8d3ffa, 0x1ef463c1) },
+    { OVR_UINT64(0xb1736b96, 0xb6fd83b3), OVR_UINT64(0xbd308ff8, 0xa6b17cb2) },
+    { OVR_UINT64(0xddd0467c, 0x64bce4a0), OVR_UINT64(0xac7cb3f6, 0xd05ddbde) },
+    { OVR_UINT64(0x8aa22c0d, 0xbef60ee4), OVR_UINT64(0x6bcdf07a, 0x423aa96b) },
+    { OVR_UINT64(0xad4ab711, 0x2eb3929d), OVR_UINT64(0x86c16c98, 0xd2c953c6) },
+    { OVR_UINT64(0xd89d64d5, 0x7a607744), OVR_UINT64(0xe871c7bf, 0x077ba8b7) },
+    { OVR_UINT64(0x87625f05, 0x6c7c4a8b), OVR_UINT64(0x11471cd7, 0x64ad4972) },
+    { OVR_UINT64(0xa93af6c6, 0xc79b5d2d), OVR_UINT64(0xd598e40d, 0x3dd89bcf) },
+    { OVR_UINT64(0xd389b478, 0x79823479), OVR_UINT64(0x4aff1d10, 0x8d4ec2c3) },
+    { OVR_UINT64(0x843610cb, 0x4bf160cb), OVR_UINT64(0xcedf722a, 0x585139ba) },
+    { OVR_UINT64(0xa54394fe, 0x1eedb8fe), OVR_UINT64(0xc2974eb4, 0xee658828) },
+    { OVR_UINT64(0xce947a3d, 0xa6a9273e), OVR_UINT64(0x733d2262, 0x29feea32) },
+    { OVR_UINT64(0x811ccc66, 0x8829b887), OVR_UINT64(0x0806357d, 0x5a3f525f) },
+    { OVR_UINT64(0xa163ff80, 0x2a3426a8), OVR_UINT64(0xca07c2dc, 0xb0cf26f7) },
+    { OVR_UINT64(0xc9bcff60, 0x34c13052), OVR_UINT64(0xfc89b393, 0xdd02f0b5) },
+    { OVR_UINT64(0xfc2c3f38, 0x41f17c67), OVR_UINT64(0xbbac2078, 0xd443ace2) },
+    { OVR_UINT64(0x9d9ba783, 0x2936edc0), OVR_UINT64(0xd54b944b, 0x84aa4c0d) },
+    { OVR_UINT64(0xc5029163, 0xf384a931), OVR_UINT64(0x0a9e795e, 0x65d4df11) },
+    { OVR_UINT64(0xf64335bc, 0xf065d37d), OVR_UINT64(0x4d4617b5, 0xff4a16d5) },
+    { OVR_UINT64(0x99ea0196, 0x163fa42e), OVR_UINT64(0x504bced1, 0xbf8e4e45) },
+    { OVR_UINT64(0xc06481fb, 0x9bcf8d39), OVR_UINT64(0xe45ec286, 0x2f71e1d6) },
+    { OVR_UINT64(0xf07da27a, 0x82c37088), OVR_UINT64(0x5d767327, 0xbb4e5a4c) },
+    { OVR_UINT64(0x964e858c, 0x91ba2655), OVR_UINT64(0x3a6a07f8, 0xd510f86f) },
+    { OVR_UINT64(0xbbe226ef, 0xb628afea), OVR_UINT64(0x890489f7, 0x0a55368b) },
+    { OVR_UINT64(0xeadab0ab, 0xa3b2dbe5), OVR_UINT64(0x2b45ac74, 0xccea842e) },
+    { OVR_UINT64(0x92c8ae6b, 0x464fc96f), OVR_UINT64(0x3b0b8bc9, 0x0012929d) },
+    { OVR_UINT64(0xb77ada06, 0x17e3bbcb), OVR_UINT64(0x09ce6ebb, 0x40173744) },
+    { OVR_UINT64(0xe5599087, 0x9ddcaabd), OVR_UINT64(0xcc420a6a, 0x101d0515) },
+    { OVR_UINT64(0x8f57fa54, 0xc2a9eab6), OVR_UINT64(0x9fa94682, 0x4a12232d) },
+    { OVR_UINT64(0xb32df8e9, 0xf3546564), OVR_UINT64(0x47939822, 0xdc96abf9) },
+    { OVR_UINT64(0xdff97724, 0x70297ebd), OVR_UINT64(0x59787e2b, 0x93bc56f7) },
+    { OVR_UINT64(0x8bfbea76, 0xc619ef36), OVR_UINT64(0x57eb4edb, 0x3c55b65a) },
+    { OVR_UINT64(0xaefae514, 0x77a06b03), OVR_UINT64(0xede62292, 0x0b6b23f1) },
+    { OVR_UINT64(0xdab99e59, 0x958885c4), OVR_UINT64(0xe95fab36, 0x8e45eced) },
+    { OVR_UINT64(0x88b402f7, 0xfd75539b), OVR_UINT64(0x11dbcb02, 0x18ebb414) },
+    { OVR_UINT64(0xaae103b5, 0xfcd2a881), OVR_UINT64(0xd652bdc2, 0x9f26a119) },
+    { OVR_UINT64(0xd59944a3, 0x7c0752a2), OVR_UINT64(0x4be76d33, 0x46f0495f) },
+    { OVR_UINT64(0x857fcae6, 0x2d8493a5), OVR_UINT64(0x6f70a440, 0x0c562ddb) },
+    { OVR_UINT64(0xa6dfbd9f, 0xb8e5b88e), OVR_UINT64(0xcb4ccd50, 0x0f6bb952) },
+    { OVR_UINT64(0xd097ad07, 0xa71f26b2), OVR_UINT64(0x7e2000a4, 0x1346a7a7) },
+    { OVR_UINT64(0x825ecc24, 0xc873782f), OVR_UINT64(0x8ed40066, 0x8c0c28c8) },
+    { OVR_UINT64(0xa2f67f2d, 0xfa90563b), OVR_UINT64(0x72890080, 0x2f0f32fa) },
+    { OVR_UINT64(0xcbb41ef9, 0x79346bca), OVR_UINT64(0x4f2b40a0, 0x3ad2ffb9) },
+    { OVR_UINT64(0xfea126b7, 0xd78186bc), OVR_UINT64(0xe2f610c8, 0x4987bfa8) },
+    { OVR_UINT64(0x9f24b832, 0xe6b0f436), OVR_UINT64(0x0dd9ca7d, 0x2df4d7c9) },
+    { OVR_UINT64(0xc6ede63f, 0xa05d3143), OVR_UINT64(0x91503d1c, 0x79720dbb) },
+    { OVR_UINT64(0xf8a95fcf, 0x88747d94), OVR_UINT64(0x75a44c63, 0x97ce912a) },
+    { OVR_UINT64(0x9b69dbe1, 0xb548ce7c), OVR_UINT64(0xc986afbe, 0x3ee11aba) },
+    { OVR_UINT64(0xc24452da, 0x229b021b), OVR_UINT64(0xfbe85bad, 0xce996168) },
+    { OVR_UINT64(0xf2d56790, 0xab41c2a2), OVR_UINT64(0xfae27299, 0x423fb9c3) },
+    { OVR_UINT64(0x97c560ba, 0x6b0919a5), OVR_UINT64(0xdccd879f, 0xc967d41a) },
+    { OVR_UINT64(0xbdb6b8e9, 0x05cb600f), OVR_UINT64(0x5400e987, 0xbbc1c920) },
+    { OVR_UINT64(0xed246723, 0x473e3813), OVR_UINT64(0x290123e9, 0xaab23b68) },
+    { OVR_UINT64(0x9436c076, 0x0c86e30b), OVR_UINT64(0xf9a0b672, 0x0aaf6521) },
+    { OVR_UINT64(0xb9447093, 0x8fa89bce), OVR_UINT64(0xf808e40e, 0x8d5b3e69) },
+    { OVR_UINT64(0xe7958cb8, 0x7392c2c2), OVR_UINT64(0xb60b1d12, 0x30b20e04) },
+    { OVR_UINT64(0x90bd77f3, 0x483bb9b9), OVR_UINT64(0xb1c6f22b, 0x5e6f48c2) },
+    { OVR_UINT64(0xb4ecd5f0, 0x1a4aa828), OVR_UINT64(0x1e38aeb6, 0x360b1af3) },
+    { OVR_UINT64(0xe2280b6c, 0x20dd5232), OVR_UINT64(0x25c6da63, 0xc38de1b0) },
+    { OVR_UINT64(0x8d590723, 0x948a535f), OVR_UINT64(0x579c487e, 0x5a38ad0e) },
+    { OVR_UINT64(0xb0af48ec, 0x79ace837), OVR_UINT64(0x2d835a9d, 0xf0c6d851) },
+    { OVR_UINT64(0xdcdb1b27, 0x98182244), OVR_UINT64(0xf8e43145, 0x6cf88e65) },
+    { OVR_UINT64(0x8a08f0f8, 0xbf0f156b), OVR_UINT64(0x1b8e9ecb, 0x641b58ff) },
+    { OVR_UINT64(0xac8b2d36, 0xeed2dac5), OVR_UINT64(0xe272467e, 0x3d222f3f) },
+    { OVR_UINT64(0xd7adf884, 0xaa879177), OVR_UINT64(0x5b0ed81d, 0xcc6abb0f) },
+    { OVR_UINT64(0x86ccbb52, 0xea94baea), OVR_UINT64(0x98e94712, 0x9fc2b4e9) },
+    { OVR_UINT64(0xa87fea27, 0xa539e9a5), OVR_UINT64(0x3f2398d7, 0x47b36224) },
+    { OVR_UINT64(0xd29fe4b1, 0x8e88640e), OVR_UINT64(0x8eec7f0d, 0x19a03aad) },
+    { OVR_UINT64(0x83a3eeee, 0xf9153e89), OVR_UINT64(0x1953cf68, 0x300424ac) },
+    { OVR_UINT64(0xa48ceaaa, 0xb75a8e2b), OVR_UINT64(0x5fa8c342, 0x3c052dd7) },
+    { OVR_UINT64(0xcdb02555, 0x653131b6), OVR_UINT64(0x3792f412, 0xcb06794d) },
+    { OVR_UINT64(0x808e1755, 0x5f3ebf11), OVR_UINT64(0xe2bbd88b, 0xbee40bd0) },
+    { OVR_UINT64(0xa0b19d2a, 0xb70e6ed6), OVR_UINT64(0x5b6aceae, 0xae9d0ec4) },
+    { OVR_UINT64(0xc8de0475, 0x64d20a8b), OVR_UINT64(0xf245825a, 0x5a445275) },
+    { OVR_UINT64(0xfb158592, 0xbe068d2e), OVR_UINT64(0xeed6e2f0, 0xf0d56712) },
+    { OVR_UINT64(0x9ced737b, 0xb6c4183d), OVR_UINT64(0x55464dd6, 0x9685606b) },
+    { OVR_UINT64(0xc428d05a, 0xa4751e4c), OVR_UINT64(0xaa97e14c, 0x3c26b886) },
+    { OVR_UINT64(0xf5330471, 0x4d9265df), OVR_UINT64(0xd53dd99f, 0x4b3066a8) },
+    { OVR_UINT64(0x993fe2c6, 0xd07b7fab), OVR_UINT64(0xe546a803, 0x8efe4029) },
+    { OVR_UINT64(0xbf8fdb78, 0x849a5f96), OVR_UINT64(0xde985204, 0x72bdd033) },
+    { OVR_UINT64(0xef73d256, 0xa5c0f77c), OVR_UINT64(0x963e6685, 0x8f6d4440) },
+    { OVR_UINT64(0x95a86376, 0x27989aad), OVR_UINT64(0xdde70013, 0x79a44aa8) },
+    { OVR_UINT64(0xbb127c53, 0xb17ec159), OVR_UINT64(0x5560c018, 0x580d5d52) },
+    { OVR_UINT64(0xe9d71b68, 0x9dde71af), OVR_UINT64(0xaab8f01e, 0x6e10b4a6) },
+    { OVR_UINT64(0x92267121, 0x62ab070d), OVR_UINT64(0xcab39613, 0x04ca70e8) },
+    { OVR_UINT64(0xb6b00d69, 0xbb55c8d1), OVR_UINT64(0x3d607b97, 0xc5fd0d22) },
+    { OVR_UINT64(0xe45c10c4, 0x2a2b3b05), OVR_UINT64(0x8cb89a7d, 0xb77c506a) },
+    { OVR_UINT64(0x8eb98a7a, 0x9a5b04e3), OVR_UINT64(0x77f3608e, 0x92adb242) },
+    { OVR_UINT64(0xb267ed19, 0x40f1c61c), OVR_UINT64(0x55f038b2, 0x37591ed3) },
+    { OVR_UINT64(0xdf01e85f, 0x912e37a3), OVR_UINT64(0x6b6c46de, 0xc52f6688) },
+    { OVR_UINT64(0x8b61313b, 0xbabce2c6), OVR_UINT64(0x2323ac4b, 0x3b3da015) },
+    { OVR_UINT64(0xae397d8a, 0xa96c1b77), OVR_UINT64(0xabec975e, 0x0a0d081a) },
+    { OVR_UINT64(0xd9c7dced, 0x53c72255), OVR_UINT64(0x96e7bd35, 0x8c904a21) },
+    { OVR_UINT64(0x881cea14, 0x545c7575), OVR_UINT64(0x7e50d641, 0x77da2e54) },
+    { OVR_UINT64(0xaa242499, 0x697392d2), OVR_UINT64(0xdde50bd1, 0xd5d0b9e9) },
+    { OVR_UINT64(0xd4ad2dbf, 0xc3d07787), OVR_UINT64(0x955e4ec6, 0x4b44e864) },
+    { OVR_UINT64(0x84ec3c97, 0xda624ab4), OVR_UINT64(0xbd5af13b, 0xef0b113e) },
+    { OVR_UINT64(0xa6274bbd, 0xd0fadd61), OVR_UINT64(0xecb1ad8a, 0xeacdd58e) },
+    { OVR_UINT64(0xcfb11ead, 0x453994ba), OVR_UINT64(0x67de18ed, 0xa5814af2) },
+    { OVR_UINT64(0x81ceb32c, 0x4b43fcf4), OVR_UINT64(0x80eacf94, 0x8770ced7) },
+    { OVR_UINT64(0xa2425ff7, 0x5e14fc31), OVR_UINT64(0xa1258379, 0xa94d028d) },
+    { OVR_UINT64(0xcad2f7f5, 0x359a3b3e), OVR_UINT64(0x096ee458, 0x13a04330) },
+    { OVR_UINT64(0xfd87b5f2, 0x8300ca0d), OVR_UINT64(0x8bca9d6e, 0x188853fc) },
+    { OVR_UINT64(0x9e74d1b7, 0x91e07e48), OVR_UINT64(0x775ea264, 0xcf55347d) },
+    { OVR_UINT64(0xc6120625, 0x76589dda), OVR_UINT64(0x95364afe, 0x032a819d) },
+    { OVR_UINT64(0xf79687ae, 0xd3eec551), OVR_UINT64(0x3a83ddbd, 0x83f52204) },
+    { OVR_UINT64(0x9abe14cd, 0x44753b52), OVR_UINT64(0xc4926a96, 0x72793542) },
+    { OVR_UINT64(0xc16d9a00, 0x95928a27), OVR_UINT64(0x75b7053c, 0x0f178293) },
+    { OVR_UINT64(0xf1c90080, 0xbaf72cb1), OVR_UINT64(0x5324c68b, 0x12dd6338) },
+    { OVR_UINT64(0x971da050, 0x74da7bee), OVR_UINT64(0xd3f6fc16, 0xebca5e03) },
+    { OVR_UINT64(0xbce50864, 0x92111aea), OVR_UINT64(0x88f4bb1c, 0xa6bcf584) },
+    { OVR_UINT64(0xec1e4a7d, 0xb69561a5), OVR_UINT64(0x2b31e9e3, 0xd06c32e5) },
+    { OVR_UINT64(0x9392ee8e, 0x921d5d07), OVR_UINT64(0x3aff322e, 0x62439fcf) },
+    { OVR_UINT64(0xb877aa32, 0x36a4b449), OVR_UINT64(0x09befeb9, 0xfad487c2) },
+    { OVR_UINT64(0xe69594be, 0xc44de15b), OVR_UINT64(0x4c2ebe68, 0x7989a9b3) },
+    { OVR_UINT64(0x901d7cf7, 0x3ab0acd9), OVR_UINT64(0x0f9d3701, 0x4bf60a10) },
+    { OVR_UINT64(0xb424dc35, 0x095cd80f), OVR_UINT64(0x538484c1, 0x9ef38c94) },
+    { OVR_UINT64(0xe12e1342, 0x4bb40e13), OVR_UINT64(0x2865a5f2, 0x06b06fb9) },
+    { OVR_UINT64(0x8cbccc09, 0x6f5088cb), OVR_UINT64(0xf93f87b7, 0x442e45d3) },
+    { OVR_UINT64(0xafebff0b, 0xcb24aafe), OVR_UINT64(0xf78f69a5, 0x1539d748) },
+    { OVR_UINT64(0xdbe6fece, 0xbdedd5be), OVR_UINT64(0xb573440e, 0x5a884d1b) },
+    { OVR_UINT64(0x89705f41, 0x36b4a597), OVR_UINT64(0x31680a88, 0xf8953030) },
+    { OVR_UINT64(0xabcc7711, 0x8461cefc), OVR_UINT64(0xfdc20d2b, 0x36ba7c3d) },
+    { OVR_UINT64(0xd6bf94d5, 0xe57a42bc), OVR_UINT64(0x3d329076, 0x04691b4c) },
+    { OVR_UINT64(0x8637bd05, 0xaf6c69b5), OVR_UINT64(0xa63f9a49, 0xc2c1b10f) },
+    { OVR_UINT64(0xa7c5ac47, 0x1b478423), OVR_UINT64(0x0fcf80dc, 0x33721d53) },
+    { OVR_UINT64(0xd1b71758, 0xe219652b), OVR_UINT64(0xd3c36113, 0x404ea4a8) },
+    { OVR_UINT64(0x83126e97, 0x8d4fdf3b), OVR_UINT64(0x645a1cac, 0x083126e9) },
+    { OVR_UINT64(0xa3d70a3d, 0x70a3d70a), OVR_UINT64(0x3d70a3d7, 0x0a3d70a3) },
+    { OVR_UINT64(0xcccccccc, 0xcccccccc), OVR_UINT64(0xcccccccc, 0xcccccccc) },
+    { OVR_UINT64(0x80000000, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xa0000000, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xc8000000, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xfa000000, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0x9c400000, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xc3500000, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xf4240000, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0x98968000, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xbebc2000, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xee6b2800, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0x9502f900, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xba43b740, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xe8d4a510, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0x9184e72a, 0x00000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xb5e620f4, 0x80000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xe35fa931, 0xa0000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0x8e1bc9bf, 0x04000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xb1a2bc2e, 0xc5000000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xde0b6b3a, 0x76400000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0x8ac72304, 0x89e80000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xad78ebc5, 0xac620000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xd8d726b7, 0x177a8000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0x87867832, 0x6eac9000), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xa968163f, 0x0a57b400), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xd3c21bce, 0xcceda100), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0x84595161, 0x401484a0), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xa56fa5b9, 0x9019a5c8), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0xcecb8f27, 0xf4200f3a), OVR_UINT64(0x00000000, 0x00000000) },
+    { OVR_UINT64(0x813f3978, 0xf8940984), OVR_UINT64(0x40000000, 0x00000000) },
+    { OVR_UINT64(0xa18f07d7, 0x36b90be5), OVR_UINT64(0x50000000, 0x00000000) },
+    { OVR_UINT64(0xc9f2c9cd, 0x04674ede), OVR_UINT64(0xa4000000, 0x00000000) },
+    { OVR_UINT64(0xfc6f7c40, 0x45812296), OVR_UINT64(0x4d000000, 0x00000000) },
+    { OVR_UINT64(0x9dc5ada8, 0x2b70b59d), OVR_UINT64(0xf0200000, 0x00000000) },
+    { OVR_UINT64(0xc5371912, 0x364ce305), OVR_UINT64(0x6c280000, 0x00000000) },
+    { OVR_UINT64(0xf684df56, 0xc3e01bc6), OVR_UINT64(0xc7320000, 0x00000000) },
+    { OVR_UINT64(0x9a130b96, 0x3a6c115c), OVR_UINT64(0x3c7f4000, 0x00000000) },
+    { OVR_UINT64(0xc097ce7b, 0xc90715b3), OVR_UINT64(0x4b9f1000, 0x00000000) },
+    { OVR_UINT64(0xf0bdc21a, 0xbb48db20), OVR_UINT64(0x1e86d400, 0x00000000) },
+    { OVR_UINT64(0x96769950, 0xb50d88f4), OVR_UINT64(0x13144480, 0x00000000) },
+    { OVR_UINT64(0xbc143fa4, 0xe250eb31), OVR_UINT64(0x17d955a0, 0x00000000) },
+    { OVR_UINT64(0xeb194f8e, 0x1ae525fd), OVR_UINT64(0x5dcfab08, 0x00000000) },
+    { OVR_UINT64(0x92efd1b8, 0xd0cf37be), OVR_UINT64(0x5aa1cae5, 0x00000000) },
+    { OVR_UINT64(0xb7abc627, 0x050305ad), OVR_UINT64(0xf14a3d9e, 0x40000000) },
+    { OVR_UINT64(0xe596b7b0, 0xc643c719), OVR_UINT64(0x6d9ccd05, 0xd0000000) },
+    { OVR_UINT64(0x8f7e32ce, 0x7bea5c6f), OVR_UINT64(0xe4820023, 0xa2000000) },
+    { OVR_UINT64(0xb35dbf82, 0x1ae4f38b), OVR_UINT64(0xdda2802c, 0x8a800000) },
+    { OVR_UINT64(0xe0352f62, 0xa19e306e), OVR_UINT64(0xd50b2037, 0xad200000) },
+    { OVR_UINT64(0x8c213d9d, 0xa502de45), OVR_UINT64(0x4526f422, 0xcc340000) },
+    { OVR_UINT64(0xaf298d05, 0x0e4395d6), OVR_UINT64(0x9670b12b, 0x7f410000) },
+    { OVR_UINT64(0xdaf3f046, 0x51d47b4c), OVR_UINT64(0x3c0cdd76, 0x5f114000) },
+    { OVR_UINT64(0x88d8762b, 0xf324cd0f), OVR_UINT64(0xa5880a69, 0xfb6ac800) },
+    { OVR_UINT64(0xab0e93b6, 0xefee0053), OVR_UINT64(0x8eea0d04, 0x7a457a00) },
+    { OVR_UINT64(0xd5d238a4, 0xabe98068), OVR_UINT64(0x72a49045, 0x98d6d880) },
+    { OVR_UINT64(0x85a36366, 0xeb71f041), OVR_UINT64(0x47a6da2b, 0x7f864750) },
+    { OVR_UINT64(0xa70c3c40, 0xa64e6c51), OVR_UINT64(0x999090b6, 0x5f67d924) },
+    { OVR_UINT64(0xd0cf4b50, 0xcfe20765), OVR_UINT64(0xfff4b4e3, 0xf741cf6d) },
+    { OVR_UINT64(0x82818f12, 0x81ed449f), OVR_UINT64(0xbff8f10e, 0x7a8921a4) },
+    { OVR_UINT64(0xa321f2d7, 0x226895c7), OVR_UINT64(0xaff72d52, 0x192b6a0d) },
+    { OVR_UINT64(0xcbea6f8c, 0xeb02bb39), OVR_UINT64(0x9bf4f8a6, 0x9f764490) },
+    { OVR_UINT64(0xfee50b70, 0x25c36a08), OVR_UINT64(0x02f236d0, 0x4753d5b4) },
+    { OVR_UINT64(0x9f4f2726, 0x179a2245), OVR_UINT64(0x01d76242, 0x2c946590) },
+    { OVR_UINT64(0xc722f0ef, 0x9d80aad6), OVR_UINT64(0x424d3ad2, 0xb7b97ef5) },
+    { OVR_UINT64(0xf8ebad2b, 0x84e0d58b), OVR_UINT64(0xd2e08987, 0x65a7deb2) },
+    { OVR_UINT64(0x9b934c3b, 0x330c8577), OVR_UINT64(0x63cc55f4, 0x9f88eb2f) },
+    { OVR_UINT64(0xc2781f49, 0xffcfa6d5), OVR_UINT64(0x3cbf6b71, 0xc76b25fb) },
+    { OVR_UINT64(0xf316271c, 0x7fc3908a), OVR_UINT64(0x8bef464e, 0x3945ef7a) },
+    { OVR_UINT64(0x97edd871, 0xcfda3a56), OVR_UINT64(0x97758bf0, 0xe3cbb5ac) },
+    { OVR_UINT64(0xbde94e8e, 0x43d0c8ec), OVR_UINT64(0x3d52eeed, 0x1cbea317) },
+    { OVR_UINT64(0xed63a231, 0xd4c4fb27), OVR_UINT64(0x4ca7aaa8, 0x63ee4bdd) },
+    { OVR_UINT64(0x945e455f, 0x24fb1cf8), OVR_UINT64(0x8fe8caa9, 0x3e74ef6a) },
+    { OVR_UINT64(0xb975d6b6, 0xee39e436), OVR_UINT64(0xb3e2fd53, 0x8e122b44) },
+    { OVR_UINT64(0xe7d34c64, 0xa9c85d44), OVR_UINT64(0x60dbbca8, 0x7196b616) },
+    { OVR_UINT64(0x90e40fbe, 0xea1d3a4a), OVR_UINT64(0xbc8955e9, 0x46fe31cd) },
+    { OVR_UINT64(0xb51d13ae, 0xa4a488dd), OVR_UINT64(0x6babab63, 0x98bdbe41) },
+    { OVR_UINT64(0xe264589a, 0x4dcdab14), OVR_UINT64(0xc696963c, 0x7eed2dd1) },
+    { OVR_UINT64(0x8d7eb760, 0x70a08aec), OVR_UINT64(0xfc1e1de5, 0xcf543ca2) },
+    { OVR_UINT64(0xb0de6538, 0x8cc8ada8), OVR_UINT64(0x3b25a55f, 0x43294bcb) },
+    { OVR_UINT64(0xdd15fe86, 0xaffad912), OVR_UINT64(0x49ef0eb7, 0x13f39ebe) },
+    { OVR_UINT64(0x8a2dbf14, 0x2dfcc7ab), OVR_UINT64(0x6e356932, 0x6c784337) },
+    { OVR_UINT64(0xacb92ed9, 0x397bf996), OVR_UINT64(0x49c2c37f, 0x07965404) },
+    { OVR_UINT64(0xd7e77a8f, 0x87daf7fb), OVR_UINT64(0xdc33745e, 0xc97be906) },
+    { OVR_UINT64(0x86f0ac99, 0xb4e8dafd), OVR_UINT64(0x69a028bb, 0x3ded71a3) },
+    { OVR_UINT64(0xa8acd7c0, 0x222311bc), OVR_UINT64(0xc40832ea, 0x0d68ce0c) },
+    { OVR_UINT64(0xd2d80db0, 0x2aabd62b), OVR_UINT64(0xf50a3fa4, 0x90c30190) },
+    { OVR_UINT64(0x83c7088e, 0x1aab65db), OVR_UINT64(0x792667c6, 0xda79e0fa) },
+    { OVR_UINT64(0xa4b8cab1, 0xa1563f52), OVR_UINT64(0x577001b8, 0x91185938) },
+    { OVR_UINT64(0xcde6fd5e, 0x09abcf26), OVR_UINT64(0xed4c0226, 0xb55e6f86) },
+    { OVR_UINT64(0x80b05e5a, 0xc60b6178), OVR_UINT64(0x544f8158, 0x315b05b4) },
+    { OVR_UINT64(0xa0dc75f1, 0x778e39d6), OVR_UINT64(0x696361ae, 0x3db1c721) },
+    { OVR_UINT64(0xc913936d, 0xd571c84c), OVR_UINT64(0x03bc3a19, 0xcd1e38e9) },
+    { OVR_UINT64(0xfb587849, 0x4ace3a5f), OVR_UINT64(0x04ab48a0, 0x4065c723) },
+    { OVR_UINT64(0x9d174b2d, 0xcec0e47b), OVR_UINT64(0x62eb0d64, 0x283f9c76) },
+    { OVR_UINT64(0xc45d1df9, 0x42711d9a), OVR_UINT64(0x3ba5d0bd, 0x324f8394) },
+    { OVR_UINT64(0xf5746577, 0x930d6500), OVR_UINT64(0xca8f44ec, 0x7ee36479) },
+    { OVR_UINT64(0x9968bf6a, 0xbbe85f20), OVR_UINT64(0x7e998b13, 0xcf4e1ecb) },
+    { OVR_UINT64(0xbfc2ef45, 0x6ae276e8), OVR_UINT64(0x9e3fedd8, 0xc321a67e) },
+    { OVR_UINT64(0xefb3ab16, 0xc59b14a2), OVR_UINT64(0xc5cfe94e, 0xf3ea101e) },
+    { OVR_UINT64(0x95d04aee, 0x3b80ece5), OVR_UINT64(0xbba1f1d1, 0x58724a12) },
+    { OVR_UINT64(0xbb445da9, 0xca61281f), OVR_UINT64(0x2a8a6e45, 0xae8edc97) },
+    { OVR_UINT64(0xea157514, 0x3cf97226), OVR_UINT64(0xf52d09d7, 0x1a3293bd) },
+    { OVR_UINT64(0x924d692c, 0xa61be758), OVR_UINT64(0x593c2626, 0x705f9c56) },
+    { OVR_UINT64(0xb6e0c377, 0xcfa2e12e), OVR_UINT64(0x6f8b2fb0, 0x0c77836c) },
+    { OVR_UINT64(0xe498f455, 0xc38b997a), OVR_UINT64(0x0b6dfb9c, 0x0f956447) },
+    { OVR_UINT64(0x8edf98b5, 0x9a373fec), OVR_UINT64(0x4724bd41, 0x89bd5eac) },
+    { OVR_UINT64(0xb2977ee3, 0x00c50fe7), OVR_UINT64(0x58edec91, 0xec2cb657) },
+    { OVR_UINT64(0xdf3d5e9b, 0xc0f653e1), OVR_UINT64(0x2f2967b6, 0x6737e3ed) },
+    { OVR_UINT64(0x8b865b21, 0x5899f46c), OVR_UINT64(0xbd79e0d2, 0x0082ee74) },
+    { OVR_UINT64(0xae67f1e9, 0xaec07187), OVR_UINT64(0xecd85906, 0x80a3aa11) },
+    { OVR_UINT64(0xda01ee64, 0x1a708de9), OVR_UINT64(0xe80e6f48, 0x20cc9495) },
+    { OVR_UINT64(0x884134fe, 0x908658b2), OVR_UINT64(0x3109058d, 0x147fdcdd) },
+    { OVR_UINT64(0xaa51823e, 0x34a7eede), OVR_UINT64(0xbd4b46f0, 0x599fd415) },
+    { OVR_UINT64(0xd4e5e2cd, 0xc1d1ea96), OVR_UINT64(0x6c9e18ac, 0x7007c91a) },
+    { OVR_UINT64(0x850fadc0, 0x9923329e), OVR_UINT64(0x03e2cf6b, 0xc604ddb0) },
+    { OVR_UINT64(0xa6539930, 0xbf6bff45), OVR_UINT64(0x84db8346, 0xb786151c) },
+    { OVR_UINT64(0xcfe87f7c, 0xef46ff16), OVR_UINT64(0xe6126418, 0x65679a63) },
+    { OVR_UINT64(0x81f14fae, 0x158c5f6e), OVR_UINT64(0x4fcb7e8f, 0x3f60c07e) },
+    { OVR_UINT64(0xa26da399, 0x9aef7749), OVR_UINT64(0xe3be5e33, 0x0f38f09d) },
+    { OVR_UINT64(0xcb090c80, 0x01ab551c), OVR_UINT64(0x5cadf5bf, 0xd3072cc5) },
+    { OVR_UINT64(0xfdcb4fa0, 0x02162a63), OVR_UINT64(0x73d9732f, 0xc7c8f7f6) },
+    { OVR_UINT64(0x9e9f11c4, 0x014dda7e), OVR_UINT64(0x2867e7fd, 0xdcdd9afa) },
+    { OVR_UINT64(0xc646d635, 0x01a1511d), OVR_UINT64(0xb281e1fd, 0x541501b8) },
+    { OVR_UINT64(0xf7d88bc2, 0x4209a565), OVR_UINT64(0x1f225a7c, 0xa91a4226) },
+    { OVR_UINT64(0x9ae75759, 0x6946075f), OVR_UINT64(0x3375788d, 0xe9b06958) },
+    { OVR_UINT64(0xc1a12d2f, 0xc3978937), OVR_UINT64(0x0052d6b1, 0x641c83ae) },
+    { OVR_UINT64(0xf209787b, 0xb47d6b84), OVR_UINT64(0xc0678c5d, 0xbd23a49a) },
+    { OVR_UINT64(0x9745eb4d, 0x50ce6332), OVR_UINT64(0xf840b7ba, 0x963646e0) },
+    { OVR_UINT64(0xbd176620, 0xa501fbff), OVR_UINT64(0xb650e5a9, 0x3bc3d898) },
+    { OVR_UINT64(0xec5d3fa8, 0xce427aff), OVR_UINT64(0xa3e51f13, 0x8ab4cebe) },
+    { OVR_UINT64(0x93ba47c9, 0x80e98cdf), OVR_UINT64(0xc66f336c, 0x36b10137) },
+    { OVR_UINT64(0xb8a8d9bb, 0xe123f017), OVR_UINT64(0xb80b0047, 0x445d4184) },
+    { OVR_UINT64(0xe6d3102a, 0xd96cec1d), OVR_UINT64(0xa60dc059, 0x157491e5) },
+    { OVR_UINT64(0x9043ea1a, 0xc7e41392), OVR_UINT64(0x87c89837, 0xad68db2f) },
+    { OVR_UINT64(0xb454e4a1, 0x79dd1877), OVR_UINT64(0x29babe45, 0x98c311fb) },
+    { OVR_UINT64(0xe16a1dc9, 0xd8545e94), OVR_UINT64(0xf4296dd6, 0xfef3d67a) },
+    { OVR_UINT64(0x8ce2529e, 0x2734bb1d), OVR_UINT64(0x1899e4a6, 0x5f58660c) },
+    { OVR_UINT64(0xb01ae745, 0xb101e9e4), OVR_UINT64(0x5ec05dcf, 0xf72e7f8f) },
+    { OVR_UINT64(0xdc21a117, 0x1d42645d), OVR_UINT64(0x76707543, 0xf4fa1f73) },
+    { OVR_UINT64(0x899504ae, 0x72497eba), OVR_UINT64(0x6a06494a, 0x791c53a8) },
+    { OVR_UINT64(0xabfa45da, 0x0edbde69), OVR_UINT64(0x0487db9d, 0x17636892) },
+    { OVR_UINT64(0xd6f8d750, 0x9292d603), OVR_UINT64(0x45a9d284, 0x5d3c42b6) },
+    { OVR_UINT64(0x865b8692, 0x5b9bc5c2), OVR_UINT64(0x0b8a2392, 0xba45a9b2) },
+    { OVR_UINT64(0xa7f26836, 0xf282b732), OVR_UINT64(0x8e6cac77, 0x68d7141e) },
+    { OVR_UINT64(0xd1ef0244, 0xaf2364ff), OVR_UINT64(0x3207d795, 0x430cd926) },
+    { OVR_UINT64(0x8335616a, 0xed761f1f), OVR_UINT64(0x7f44e6bd, 0x49e807b8) },
+    { OVR_UINT64(0xa402b9c5, 0xa8d3a6e7), OVR_UINT64(0x5f16206c, 0x9c6209a6) },
+    { OVR_UINT64(0xcd036837, 0x130890a1), OVR_UINT64(0x36dba887, 0xc37a8c0f) },
+    { OVR_UINT64(0x80222122, 0x6be55a64), OVR_UINT64(0xc2494954, 0xda2c9789) },
+    { OVR_UINT64(0xa02aa96b, 0x06deb0fd), OVR_UINT64(0xf2db9baa, 0x10b7bd6c) },
+    { OVR_UINT64(0xc83553c5, 0xc8965d3d), OVR_UINT64(0x6f928294, 0x94e5acc7) },
+    { OVR_UINT64(0xfa42a8b7, 0x3abbf48c), OVR_UINT64(0xcb772339, 0xba1f17f9) },
+    { OVR_UINT64(0x9c69a972, 0x84b578d7), OVR_UINT64(0xff2a7604, 0x14536efb) },
+    { OVR_UINT64(0xc38413cf, 0x25e2d70d), OVR_UINT64(0xfef51385, 0x19684aba) },
+    { OVR_UINT64(0xf46518c2, 0xef5b8cd1), OVR_UINT64(0x7eb25866, 0x5fc25d69) },
+    { OVR_UINT64(0x98bf2f79, 0xd5993802), OVR_UINT64(0xef2f773f, 0xfbd97a61) },
+    { OVR_UINT64(0xbeeefb58, 0x4aff8603), OVR_UINT64(0xaafb550f, 0xfacfd8fa) },
+    { OVR_UINT64(0xeeaaba2e, 0x5dbf6784), OVR_UINT64(0x95ba2a53, 0xf983cf38) },
+    { OVR_UINT64(0x952ab45c, 0xfa97a0b2), OVR_UINT64(0xdd945a74, 0x7bf26183) },
+    { OVR_UINT64(0xba756174, 0x393d88df), OVR_UINT64(0x94f97111, 0x9aeef9e4) },
+    { OVR_UINT64(0xe912b9d1, 0x478ceb17), OVR_UINT64(0x7a37cd56, 0x01aab85d) },
+    { OVR_UINT64(0x91abb422, 0xccb812ee), OVR_UINT64(0xac62e055, 0xc10ab33a) },
+    { OVR_UINT64(0xb616a12b, 0x7fe617aa), OVR_UINT64(0x577b986b, 0x314d6009) },
+    { OVR_UINT64(0xe39c4976, 0x5fdf9d94), OVR_UINT64(0xed5a7e85, 0xfda0b80b) },
+    { OVR_UINT64(0x8e41ade9, 0xfbebc27d), OVR_UINT64(0x14588f13, 0xbe847307) },
+    { OVR_UINT64(0xb1d21964, 0x7ae6b31c), OVR_UINT64(0x596eb2d8, 0xae258fc8) },
+    { OVR_UINT64(0xde469fbd, 0x99a05fe3), OVR_UINT64(0x6fca5f8e, 0xd9aef3bb) },
+    { OVR_UINT64(0x8aec23d6, 0x80043bee), OVR_UINT64(0x25de7bb9, 0x480d5854) },
+    { OVR_UINT64(0xada72ccc, 0x20054ae9), OVR_UINT64(0xaf561aa7, 0x9a10ae6a) },
+    { OVR_UINT64(0xd910f7ff, 0x28069da4), OVR_UINT64(0x1b2ba151, 0x8094da04) },
+    { OVR_UINT64(0x87aa9aff, 0x79042286), OVR_UINT64(0x90fb44d2, 0xf05d0842) },
+    { OVR_UINT64(0xa99541bf, 0x57452b28), OVR_UINT64(0x353a1607, 0xac744a53) },
+    { OVR_UINT64(0xd3fa922f, 0x2d1675f2), OVR_UINT64(0x42889b89, 0x97915ce8) },
+    { OVR_UINT64(0x847c9b5d, 0x7c2e09b7), OVR_UINT64(0x69956135, 0xfebada11) },
+    { OVR_UINT64(0xa59bc234, 0xdb398c25), OVR_UINT64(0x43fab983, 0x7e699095) },
+    { OVR_UINT64(0xcf02b2c2, 0x1207ef2e), OVR_UINT64(0x94f967e4, 0x5e03f4bb) },
+    { OVR_UINT64(0x8161afb9, 0x4b44f57d), OVR_UINT64(0x1d1be0ee, 0xbac278f5) },
+    { OVR_UINT64(0xa1ba1ba7, 0x9e1632dc), OVR_UINT64(0x6462d92a, 0x69731732) },
+    { OVR_UINT64(0xca28a291, 0x859bbf93), OVR_UINT64(0x7d7b8f75, 0x03cfdcfe) },
+    { OVR_UINT64(0xfcb2cb35, 0xe702af78), OVR_UINT64(0x5cda7352, 0x44c3d43e) },
+    { OVR_UINT64(0x9defbf01, 0xb061adab), OVR_UINT64(0x3a088813, 0x6afa64a7) },
+    { OVR_UINT64(0xc56baec2, 0x1c7a1916), OVR_UINT64(0x088aaa18, 0x45b8fdd0) },
+    { OVR_UINT64(0xf6c69a72, 0xa3989f5b), OVR_UINT64(0x8aad549e, 0x57273d45) },
+    { OVR_UINT64(0x9a3c2087, 0xa63f6399), OVR_UINT64(0x36ac54e2, 0xf678864b) },
+    { OVR_UINT64(0xc0cb28a9, 0x8fcf3c7f), OVR_UINT64(0x84576a1b, 0xb416a7dd) },
+    { OVR_UINT64(0xf0fdf2d3, 0xf3c30b9f), OVR_UINT64(0x656d44a2, 0xa11c51d5) },
+    { OVR_UINT64(0x969eb7c4, 0x7859e743), OVR_UINT64(0x9f644ae5, 0xa4b1b325) },
+    { OVR_UINT64(0xbc4665b5, 0x96706114), OVR_UINT64(0x873d5d9f, 0x0dde1fee) },
+    { OVR_UINT64(0xeb57ff22, 0xfc0c7959), OVR_UINT64(0xa90cb506, 0xd155a7ea) },
+    { OVR_UINT64(0x9316ff75, 0xdd87cbd8), OVR_UINT64(0x09a7f124, 0x42d588f2) },
+    { OVR_UINT64(0xb7dcbf53, 0x54e9bece), OVR_UINT64(0x0c11ed6d, 0x538aeb2f) },
+    { OVR_UINT64(0xe5d3ef28, 0x2a242e81), OVR_UINT64(0x8f1668c8, 0xa86da5fa) },
+    { OVR_UINT64(0x8fa47579, 0x1a569d10), OVR_UINT64(0xf96e017d, 0x694487bc) },
+    { OVR_UINT64(0xb38d92d7, 0x60ec4455), OVR_UINT64(0x37c981dc, 0xc395a9ac) },
+    { OVR_UINT64(0xe070f78d, 0x3927556a), OVR_UINT64(0x85bbe253, 0xf47b1417) },
+    { OVR_UINT64(0x8c469ab8, 0x43b89562), OVR_UINT64(0x93956d74, 0x78ccec8e) },
+    { OVR_UINT64(0xaf584166, 0x54a6babb), OVR_UINT64(0x387ac8d1, 0x970027b2) },
+    { OVR_UINT64(0xdb2e51bf, 0xe9d0696a), OVR_UINT64(0x06997b05, 0xfcc0319e) },
+    { OVR_UINT64(0x88fcf317, 0xf22241e2), OVR_UINT64(0x441fece3, 0xbdf81f03) },
+    { OVR_UINT64(0xab3c2fdd, 0xeeaad25a), OVR_UINT64(0xd527e81c, 0xad7626c3) },
+    { OVR_UINT64(0xd60b3bd5, 0x6a5586f1), OVR_UINT64(0x8a71e223, 0xd8d3b074) },
+    { OVR_UINT64(0x85c70565, 0x62757456), OVR_UINT64(0xf6872d56, 0x67844e49) },
+    { OVR_UINT64(0xa738c6be, 0xbb12d16c), OVR_UINT64(0xb428f8ac, 0x016561db) },
+    { OVR_UINT64(0xd106f86e, 0x69d785c7), OVR_UINT64(0xe13336d7, 0x01beba52) },
+    { OVR_UINT64(0x82a45b45, 0x0226b39c), OVR_UINT64(0xecc00246, 0x61173473) },
+    { OVR_UINT64(0xa34d7216, 0x42b06084), OVR_UINT64(0x27f002d7, 0xf95d0190) },
+    { OVR_UINT64(0xcc20ce9b, 0xd35c78a5), OVR_UINT64(0x31ec038d, 0xf7b441f4) },
+    { OVR_UINT64(0xff290242, 0xc83396ce), OVR_UINT64(0x7e670471, 0x75a15271) },
+    { OVR_UINT64(0x9f79a169, 0xbd203e41), OVR_UINT64(0x0f0062c6, 0xe984d386) },
+    { OVR_UINT64(0xc75809c4, 0x2c684dd1), OVR_UINT64(0x52c07b78, 0xa3e60868) },
+    { OVR_UINT64(0xf92e0c35, 0x37826145), OVR_UINT64(0xa7709a56, 0xccdf8a82) },
+    { OVR_UINT64(0x9bbcc7a1, 0x42b17ccb), OVR_UINT64(0x88a66076, 0x400bb691) },
+    { OVR_UINT64(0xc2abf989, 0x935ddbfe), OVR_UINT64(0x6acff893, 0xd00ea435) },
+    { OVR_UINT64(0xf356f7eb, 0xf83552fe), OVR_UINT64(0x0583f6b8, 0xc4124d43) },
+    { OVR_UINT64(0x98165af3, 0x7b2153de), OVR_UINT64(0xc3727a33, 0x7a8b704a) },
+    { OVR_UINT64(0xbe1bf1b0, 0x59e9a8d6), OVR_UINT64(0x744f18c0, 0x592e4c5c) },
+    { OVR_UINT64(0xeda2ee1c, 0x7064130c), OVR_UINT64(0x1162def0, 0x6f79df73) },
+    { OVR_UINT64(0x9485d4d1, 0xc63e8be7), OVR_UINT64(0x8addcb56, 0x45ac2ba8) },
+    { OVR_UINT64(0xb9a74a06, 0x37ce2ee1), OVR_UINT64(0x6d953e2b, 0xd7173692) },
+    { OVR_UINT64(0xe8111c87, 0xc5c1ba99), OVR_UINT64(0xc8fa8db6, 0xccdd0437) },
+    { OVR_UINT64(0x910ab1d4, 0xdb9914a0), OVR_UINT64(0x1d9c9892, 0x400a22a2) },
+    { OVR_UINT64(0xb54d5e4a, 0x127f59c8), OVR_UINT64(0x2503beb6, 0xd00cab4b) },
+    { OVR_UINT64(0xe2a0b5dc, 0x971f303a), OVR_UINT64(0x2e44ae64, 0x840fd61d) },
+    { OVR_UINT64(0x8da471a9, 0xde737e24), OVR_UINT64(0x5ceaecfe, 0xd289e5d2) },
+    { OVR_UINT64(0xb10d8e14, 0x56105dad), OVR_UINT64(0x7425a83e, 0x872c5f47) },
+    { OVR_UINT64(0xdd50f199, 0x6b947518), OVR_UINT64(0xd12f124e, 0x28f77719) },
+    { OVR_UINT64(0x8a5296ff, 0xe33cc92f), OVR_UINT64(0x82bd6b70, 0xd99aaa6f) },
+    { OVR_UINT64(0xace73cbf, 0xdc0bfb7b), OVR_UINT64(0x636cc64d, 0x1001550b) },
+    { OVR_UINT64(0xd8210bef, 0xd30efa5a), OVR_UINT64(0x3c47f7e0, 0x5401aa4e) },
+    { OVR_UINT64(0x8714a775, 0xe3e95c78), OVR_UINT64(0x65acfaec, 0x34810a71) },
+    { OVR_UINT64(0xa8d9d153, 0x5ce3b396), OVR_UINT64(0x7f1839a7, 0x41a14d0d) },
+    { OVR_UINT64(0xd31045a8, 0x341ca07c), OVR_UINT64(0x1ede4811, 0x1209a050) },
+    { OVR_UINT64(0x83ea2b89, 0x2091e44d), OVR_UINT64(0x934aed0a, 0xab460432) },
+    { OVR_UINT64(0xa4e4b66b, 0x68b65d60), OVR_UINT64(0xf81da84d, 0x5617853f) },
+    { OVR_UINT64(0xce1de406, 0x42e3f4b9), OVR_UINT64(0x36251260, 0xab9d668e) },
+    { OVR_UINT64(0x80d2ae83, 0xe9ce78f3), OVR_UINT64(0xc1d72b7c, 0x6b426019) },
+    { OVR_UINT64(0xa1075a24, 0xe4421730), OVR_UINT64(0xb24cf65b, 0x8612f81f) },
+    { OVR_UINT64(0xc94930ae, 0x1d529cfc), OVR_UINT64(0xdee033f2, 0x6797b627) },
+    { OVR_UINT64(0xfb9b7cd9, 0xa4a7443c), OVR_UINT64(0x169840ef, 0x017da3b1) },
+    { OVR_UINT64(0x9d412e08, 0x06e88aa5), OVR_UINT64(0x8e1f2895, 0x60ee864e) },
+    { OVR_UINT64(0xc491798a, 0x08a2ad4e), OVR_UINT64(0xf1a6f2ba, 0xb92a27e2) },
+    { OVR_UINT64(0xf5b5d7ec, 0x8acb58a2), OVR_UINT64(0xae10af69, 0x6774b1db) },
+    { OVR_UINT64(0x9991a6f3, 0xd6bf1765), OVR_UINT64(0xacca6da1, 0xe0a8ef29) },
+    { OVR_UINT64(0xbff610b0, 0xcc6edd3f), OVR_UINT64(0x17fd090a, 0x58d32af3) },
+    { OVR_UINT64(0xeff394dc, 0xff8a948e), OVR_UINT64(0xddfc4b4c, 0xef07f5b0) },
+    { OVR_UINT64(0x95f83d0a, 0x1fb69cd9), OVR_UINT64(0x4abdaf10, 0x1564f98e) },
+    { OVR_UINT64(0xbb764c4c, 0xa7a4440f), OVR_UINT64(0x9d6d1ad4, 0x1abe37f1) },
+    { OVR_UINT64(0xea53df5f, 0xd18d5513), OVR_UINT64(0x84c86189, 0x216dc5ed) },
+    { OVR_UINT64(0x92746b9b, 0xe2f8552c), OVR_UINT64(0x32fd3cf5, 0xb4e49bb4) },
+    { OVR_UINT64(0xb7118682, 0xdbb66a77), OVR_UINT64(0x3fbc8c33, 0x221dc2a1) },
+    { OVR_UINT64(0xe4d5e823, 0x92a40515), OVR_UINT64(0x0fabaf3f, 0xeaa5334a) },
+    { OVR_UINT64(0x8f05b116, 0x3ba6832d), OVR_UINT64(0x29cb4d87, 0xf2a7400e) },
+    { OVR_UINT64(0xb2c71d5b, 0xca9023f8), OVR_UINT64(0x743e20e9, 0xef511012) },
+    { OVR_UINT64(0xdf78e4b2, 0xbd342cf6), OVR_UINT64(0x914da924, 0x6b255416) },
+    { OVR_UINT64(0x8bab8eef, 0xb6409c1a), OVR_UINT64(0x1ad089b6, 0xc2f7548e) },
+    { OVR_UINT64(0xae9672ab, 0xa3d0c320), OVR_UINT64(0xa184ac24, 0x73b529b1) },
+    { OVR_UINT64(0xda3c0f56, 0x8cc4f3e8), OVR_UINT64(0xc9e5d72d, 0x90a2741e) },
+    { OVR_UINT64(0x88658996, 0x17fb1871), OVR_UINT64(0x7e2fa67c, 0x7a658892) },
+    { OVR_UINT64(0xaa7eebfb, 0x9df9de8d), OVR_UINT64(0xddbb901b, 0x98feeab7) },
+    { OVR_UINT64(0xd51ea6fa, 0x85785631), OVR_UINT64(0x552a7422, 0x7f3ea565) },
+    { OVR_UINT64(0x8533285c, 0x936b35de), OVR_UINT64(0xd53a8895, 0x8f87275f) },
+    { OVR_UINT64(0xa67ff273, 0xb8460356), OVR_UINT64(0x8a892aba, 0xf368f137) },
+    { OVR_UINT64(0xd01fef10, 0xa657842c), OVR_UINT64(0x2d2b7569, 0xb0432d85) },
+    { OVR_UINT64(0x8213f56a, 0x67f6b29b), OVR_UINT64(0x9c3b2962, 0x0e29fc73) },
+    { OVR_UINT64(0xa298f2c5, 0x01f45f42), OVR_UINT64(0x8349f3ba, 0x91b47b8f) },
+    { OVR_UINT64(0xcb3f2f76, 0x42717713), OVR_UINT64(0x241c70a9, 0x36219a73) },
+    { OVR_UINT64(0xfe0efb53, 0xd30dd4d7), OVR_UINT64(0xed238cd3, 0x83aa0110) },
+    { OVR_UINT64(0x9ec95d14, 0x63e8a506), OVR_UINT64(0xf4363804, 0x324a40aa) },
+    { OVR_UINT64(0xc67bb459, 0x7ce2ce48), OVR_UINT64(0xb143c605, 0x3edcd0d5) },
+    { OVR_UINT64(0xf81aa16f, 0xdc1b81da), OVR_UINT64(0xdd94b786, 0x8e94050a) },
+    { OVR_UINT64(0x9b10a4e5, 0xe9913128), OVR_UINT64(0xca7cf2b4, 0x191c8326) },
+    { OVR_UINT64(0xc1d4ce1f, 0x63f57d72), OVR_UINT64(0xfd1c2f61, 0x1f63a3f0) },
+    { OVR_UINT64(0xf24a01a7, 0x3cf2dccf), OVR_UINT64(0xbc633b39, 0x673c8cec) },
+    { OVR_UINT64(0x976e4108, 0x8617ca01), OVR_UINT64(0xd5be0503, 0xe085d813) },
+    { OVR_UINT64(0xbd49d14a, 0xa79dbc82), OVR_UINT64(0x4b2d8644, 0xd8a74e18) },
+    { OVR_UINT64(0xec9c459d, 0x51852ba2), OVR_UINT64(0xddf8e7d6, 0x0ed1219e) },
+    { OVR_UINT64(0x93e1ab82, 0x52f33b45), OVR_UINT64(0xcabb90e5, 0xc942b503) },
+    { OVR_UINT64(0xb8da1662, 0xe7b00a17), OVR_UINT64(0x3d6a751f, 0x3b936243) },
+    { OVR_UINT64(0xe7109bfb, 0xa19c0c9d), OVR_UINT64(0x0cc51267, 0x0a783ad4) },
+    { OVR_UINT64(0x906a617d, 0x450187e2), OVR_UINT64(0x27fb2b80, 0x668b24c5) },
+    { OVR_UINT64(0xb484f9dc, 0x9641e9da), OVR_UINT64(0xb1f9f660, 0x802dedf6) },
+    { OVR_UINT64(0xe1a63853, 0xbbd26451), OVR_UINT64(0x5e7873f8, 0xa0396973) },
+    { OVR_UINT64(0x8d07e334, 0x55637eb2), OVR_UINT64(0xdb0b487b, 0x6423e1e8) },
+    { OVR_UINT64(0xb049dc01, 0x6abc5e5f), OVR_UINT64(0x91ce1a9a, 0x3d2cda62) },
+    { OVR_UINT64(0xdc5c5301, 0xc56b75f7), OVR_UINT64(0x7641a140, 0xcc7810fb) },
+    { OVR_UINT64(0x89b9b3e1, 0x1b6329ba), OVR_UINT64(0xa9e904c8, 0x7fcb0a9d) },
+    { OVR_UINT64(0xac2820d9, 0x623bf429), OVR_UINT64(0x546345fa, 0x9fbdcd44) },
+    { OVR_UINT64(0xd732290f, 0xbacaf133), OVR_UINT64(0xa97c1779, 0x47ad4095) },
+    { OVR_UINT64(0x867f59a9, 0xd4bed6c0), OVR_UINT64(0x49ed8eab, 0xcccc485d) },
+    { OVR_UINT64(0xa81f3014, 0x49ee8c70), OVR_UINT64(0x5c68f256, 0xbfff5a74) },
+    { OVR_UINT64(0xd226fc19, 0x5c6a2f8c), OVR_UINT64(0x73832eec, 0x6fff3111) },
+    { OVR_UINT64(0x83585d8f, 0xd9c25db7), OVR_UINT64(0xc831fd53, 0xc5ff7eab) },
+    { OVR_UINT64(0xa42e74f3, 0xd032f525), OVR_UINT64(0xba3e7ca8, 0xb77f5e55) },
+    { OVR_UINT64(0xcd3a1230, 0xc43fb26f), OVR_UINT64(0x28ce1bd2, 0xe55f35eb) },
+    { OVR_UINT64(0x80444b5e, 0x7aa7cf85), OVR_UINT64(0x7980d163, 0xcf5b81b3) },
+    { OVR_UINT64(0xa0555e36, 0x1951c366), OVR_UINT64(0xd7e105bc, 0xc332621f) },
+    { OVR_UINT64(0xc86ab5c3, 0x9fa63440), OVR_UINT64(0x8dd9472b, 0xf3fefaa7) },
+    { OVR_UINT64(0xfa856334, 0x878fc150), OVR_UINT64(0xb14f98f6, 0xf0feb951) },
+    { OVR_UINT64(0x9c935e00, 0xd4b9d8d2), OVR_UINT64(0x6ed1bf9a, 0x569f33d3) },
+    { OVR_UINT64(0xc3b83581, 0x09e84f07), OVR_UINT64(0x0a862f80, 0xec4700c8) },
+    { OVR_UINT64(0xf4a642e1, 0x4c6262c8), OVR_UINT64(0xcd27bb61, 0x2758c0fa) },
+    { OVR_UINT64(0x98e7e9cc, 0xcfbd7dbd), OVR_UINT64(0x8038d51c, 0xb897789c) },
+    { OVR_UINT64(0xbf21e440, 0x03acdd2c), OVR_UINT64(0xe0470a63, 0xe6bd56c3) },
+    { OVR_UINT64(0xeeea5d50, 0x04981478), OVR_UINT64(0x1858ccfc, 0xe06cac74) },
+    { OVR_UINT64(0x95527a52, 0x02df0ccb), OVR_UINT64(0x0f37801e, 0x0c43ebc8) },
+    { OVR_UINT64(0xbaa718e6, 0x8396cffd), OVR_UINT64(0xd3056025, 0x8f54e6ba) },
+    { OVR_UINT64(0xe950df20, 0x247c83fd), OVR_UINT64(0x47c6b82e, 0xf32a2069) },
+    { OVR_UINT64(0x91d28b74, 0x16cdd27e), OVR_UINT64(0x4cdc331d, 0x57fa5441) },
+    { OVR_UINT64(0xb6472e51, 0x1c81471d), OVR_UINT64(0xe0133fe4, 0xadf8e952) },
+    { OVR_UINT64(0xe3d8f9e5, 0x63a198e5), OVR_UINT64(0x58180fdd, 0xd97723a6) },
+    { OVR_UINT64(0x8e679c2f, 0x5e44ff8f), OVR_UINT64(0x570f09ea, 0xa7ea7648) },
+    { OVR_UINT64(0xb201833b, 0x35d63f73), OVR_UINT64(0x2cd2cc65, 0x51e513da) },
+    { OVR_UINT64(0xde81e40a, 0x034bcf4f), OVR_UINT64(0xf8077f7e, 0xa65e58d1) },
+    { OVR_UINT64(0x8b112e86, 0x420f6191), OVR_UINT64(0xfb04afaf, 0x27faf782) },
+    { OVR_UINT64(0xadd57a27, 0xd29339f6), OVR_UINT64(0x79c5db9a, 0xf1f9b563) },
+    { OVR_UINT64(0xd94ad8b1, 0xc7380874), OVR_UINT64(0x18375281, 0xae7822bc) },
+    { OVR_UINT64(0x87cec76f, 0x1c830548), OVR_UINT64(0x8f229391, 0x0d0b15b5) },
+    { OVR_UINT64(0xa9c2794a, 0xe3a3c69a), OVR_UINT64(0xb2eb3875, 0x504ddb22) },
+    { OVR_UINT64(0xd433179d, 0x9c8cb841), OVR_UINT64(0x5fa60692, 0xa46151eb) },
+    { OVR_UINT64(0x849feec2, 0x81d7f328), OVR_UINT64(0xdbc7c41b, 0xa6bcd333) },
+    { OVR_UINT64(0xa5c7ea73, 0x224deff3), OVR_UINT64(0x12b9b522, 0x906c0800) },
+    { OVR_UINT64(0xcf39e50f, 0xeae16bef), OVR_UINT64(0xd768226b, 0x34870a00) },
+    { OVR_UINT64(0x81842f29, 0xf2cce375), OVR_UINT64(0xe6a11583, 0x00d46640) },
+    { OVR_UINT64(0xa1e53af4, 0x6f801c53), OVR_UINT64(0x60495ae3, 0xc1097fd0) },
+    { OVR_UINT64(0xca5e89b1, 0x8b602368), OVR_UINT64(0x385bb19c, 0xb14bdfc4) },
+    { OVR_UINT64(0xfcf62c1d, 0xee382c42), OVR_UINT64(0x46729e03, 0xdd9ed7b5) },
+    { OVR_UINT64(0x9e19db92, 0xb4e31ba9), OVR_UINT64(0x6c07a2c2, 0x6a8346d1) },
+};
+
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD != 0)
+    #define OVR_FAST_EXACT_DOUBLE   0
+#else
+    #define OVR_FAST_EXACT_DOUBLE   1
+#endif
+
+// Exactly representable powers of ten, for the fast path of OVR_strtod.
+static const double ExactPowers[23] =
+{
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Returns the low 64 bits of a * b, and the high 64 bits in *hi.
+static inline UInt64 multiply128(UInt64 a, UInt64 b, UInt64* hi)
+{
+#if defined(OVR_CC_GNU) && defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 UInt128;
+    UInt128 p = (UInt128)a * b;
+    *hi = (UInt64)(p >> 64);
+    return (UInt64)p;
+#else
+    UInt64 aLo = (UInt32)a, aHi = a >> 32;
+    UInt64 bLo = (UInt32)b, bHi = b >> 32;
+    UInt64 ll  = aLo * bLo, lh = aLo * bHi;
+    UInt64 hl  = aHi * bLo, hh = aHi * bHi;
+    UInt64 mid = (ll >> 32) + (UInt32)lh + (UInt32)hl;
+    *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return (mid << 32) | (UInt32)ll;
+#endif
+}
+
+static inline int countLeadingZeros(UInt64 x)
+{
+#if defined(OVR_CC_GNU)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    if ((x >> 32) == 0) { n += 32; x <<= 32; }
+    if ((x >> 48) == 0) { n += 16; x <<= 16; }
+    if ((x >> 56) == 0) { n += 8;  x <<= 8;  }
+    if ((x >> 60) == 0) { n += 4;  x <<= 4;  }
+    if ((x >> 62) == 0) { n += 2;  x <<= 2;  }
+    if ((x >> 63) == 0) { n += 1; }
+    return n;
+#endif
+}
+
+// Bit layout of a binary floating point type, for EiselLemire.
+struct FloatFormat
+{
+    int     MantissaBits;   // Explicit bits of the significand.
+    int     ExponentBias;
+    int     MaxExponent;    // Biased exponent of infinity.
+};
+
+static const FloatFormat DoubleFormat = { 52, 1023, 0x7FF };
+static const FloatFormat FloatFormat32 = { 23, 127, 0xFF };
+
+// Computes the bits of the correctly rounded mantissa * 10^exponent, without the sign.
+// Returns false when that can't be decided this way, which includes results that are
+// subnormal or overflow.
+static bool eiselLemire(UInt64 mantissa, int exponent, const FloatFormat& format, UInt64* bits)
+{
+    if (mantissa == 0)
+    {
+        *bits = 0;
+        return true;
+    }
+    if (exponent < PowerTableMin || exponent > PowerTableMax)
+        return false;
+
+    int    lz = countLeadingZeros(mantissa);
+    UInt64 w  = mantissa << lz;
+    UInt64 resultExponent = (UInt64)(((217706 * exponent) >> 16) + 64 + format.ExponentBias - lz);
+
+    const UInt64* power = PowerTable[exponent - PowerTableMin];
+    int    shift = 64 - format.MantissaBits - 3;
+    UInt64 mask  = ((UInt64)1 << shift) - 1;
+    UInt64 hi, lo = multiply128(w, power[0], &hi);
+
+    // The truncated power may be too small; widen it if that could matter.
+    if ((hi & mask) == mask && lo + w < w)
+    {
+        UInt64 hi2, lo2 = multiply128(w, power[1], &hi2);
+        UInt64 mergedHi = hi, mergedLo = lo + hi2;
+        if (mergedLo < lo)
+            mergedHi++;
+        if ((mergedHi & mask) == mask && mergedLo + 1 == 0 && lo2 + w < w)
+            return false;
+        hi = mergedHi;
+        lo = mergedLo;
+    }
+
+    // Keep two bits more than the significand, for rounding.
+    UInt64 msb   = hi >> 63;
+    UInt64 value = hi >> (msb + shift);
+    resultExponent -= 1 ^ msb;
+
+    // An exact halfway case can't be told from one just below it.
+    if (lo == 0 && (hi & mask) == 0 && (value & 3) == 1)
+        return false;
+
+    value += value & 1;
+    value >>= 1;
+    if (value >> (format.MantissaBits + 1))
+    {
+        value >>= 1;
+        resultExponent++;
+    }
+
+    if (resultExponent - 1 >= (UInt64)(format.MaxExponent - 1))
+        return false;
+
+    *bits = (resultExponent << format.MantissaBits) |
+            (value & (((UInt64)1 << format.MantissaBits) - 1));
+    return true;
+}
+
+// A decimal number as read by scanDecimal.
+struct DecimalText
+{
+    UInt64  Mantissa;       // The first 19 significant digits.
+    int     Exponent;       // Power of ten that Mantissa is scaled by.
+    bool    Negative;
+    bool    Truncated;      // Set if non-zero digits after the first 19 were dropped.
+};
+
+// Reads a decimal number the way strtod does: leading white space, an optional sign,
+// digits with an optional decimal point, and an optional exponent. Returns the end of
+// the number, or null if there is none or the number is hexadecimal.
+static const char* scanDecimal(const char* str, DecimalText* number)
+{
+    UInt64  mantissa  = 0;
+    int     digits    = 0;
+    int     exponent  = 0;
+    bool    truncated = false;
+    bool    anyDigits = false;
+
+    while (isspace((unsigned char)*str))
+        str++;
+
+    number->Negative = (*str == '-');
+    if (*str == '-' || *str == '+')
+        str++;
+
+    if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+        return 0;
+
+    for (; *str >= '0' && *str <= '9'; str++)
+    {
+        anyDigits = true;
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*str - '0');
+            digits  += (mantissa != 0);
+        }
+        else
+        {
+            exponent++;
+            truncated |= (*str != '0');
+        }
+    }
+
+    if (*str == '.')
+    {
+        const char* p = str + 1;
+        for (; *p >= '0' && *p <= '9'; p++)
+        {
+            anyDigits = true;
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits  += (mantissa != 0);
+                exponent--;
+            }
+            else
+            {
+                truncated |= (*p != '0');
+            }
+        }
+        if (anyDigits)
+            str = p;
+    }
+
+    if (!anyDigits)
+        return 0;
+
+    if (*str == 'e' || *str == 'E')
+    {
+        const char* p = str + 1;
+        bool negativeExponent = (*p == '-');
+        if (*p == '-' || *p == '+')
+            p++;
+
+        if (*p >= '0' && *p <= '9')
+        {
+            int value = 0;
+            for (; *p >= '0' && *p <= '9'; p++)
+            {
+                if (value < 100000)
+                    value = value * 10 + (*p - '0');
+            }
+            exponent += negativeExponent ? -value : value;
+            str = p;
+        }
+    }
+
+    number->Mantissa  = mantissa;
+    number->Exponent  = exponent;
+    number->Truncated = truncated;
+    return str;
+}
+
+// Converts a scanned number; returns false if it has to be left to strtod.
+static bool decimalToBits(const DecimalText& number, const FloatFormat& format, UInt64* bits)
+{
+    if (!eiselLemire(number.Mantissa, number.Exponent, format, bits))
+        return false;
+
+    // The dropped digits make the number larger than Mantissa, but smaller than
+    // Mantissa + 1; if both round the same way, so does the number.
+    if (number.Truncated)
+    {
+        UInt64 upperBits;
+        if (!eiselLemire(number.Mantissa + 1, number.Exponent, format, &upperBits) ||
+            upperBits != *bits)
+            return false;
+    }
+    return true;
+}
+
+double OVR_CDECL OVR_strtod(const char* string, char** tailptr)
+{
+    DecimalText number;
+    const char* end = scanDecimal(string, &number);
+
+    if (end)
+    {
+        double value;
+        UInt64 bits;
+
+        // Both operands are exact, so a single rounding gives the correct result; that
+        // doesn't hold if the arithmetic is done at a higher precision.
+        if (OVR_FAST_EXACT_DOUBLE && !number.Truncated && number.Mantissa <= ((UInt64)1 << 53) &&
+            number.Exponent >= -22 && number.Exponent <= 22)
+        {
+            value = (double)(SInt64)number.Mantissa;
+            if (number.Exponent < 0)
+                value /= ExactPowers[-number.Exponent];
+            else
+                value *= ExactPowers[number.Exponent];
+        }
+        else if (decimalToBits(number, DoubleFormat, &bits))
+        {
+            memcpy(&value, &bits, sizeof(value));
+        }
+        else
+        {
+            return strtodLocale(string, tailptr);
+        }
+
+        if (tailptr)
+            *tailptr = (char*)end;
+        return number.Negative ? -value : value;
+    }
+
+    return strtodLocale(string, tailptr);
+}
+
+float OVR_CDECL OVR_strtof(const char* string, char** tailptr)
+{
+    DecimalText number;
+    const char* end = scanDecimal(string, &number);
+    UInt64      bits;
+
+    if (end && decimalToBits(number, FloatFormat32, &bits))
+    {
+        UInt32 bits32 = (UInt32)bits;
+        float  value;
+        memcpy(&value, &bits32, sizeof(value));
+
+        if (tailptr)
+            *tailptr = (char*)end;
+        return number.Negative ? -value : value;
+    }
+
+    return strtofLocale(string, tailptr);
+}
+
+
+static inline int floorLog2Pow10(int e)                 { return (e * 1741647) >> 19; }
+static inline int floorLog10Pow2(int e)                 { return (e * 1262611) >> 22; }
+static inline int floorLog10ThreeQuartersPow2(int e)    { return (e * 1262611 - 524031) >> 22; }
+
+// Schubfach multiplies by g = floor(10^k * 2^(127 - floorLog2Pow10(k))) + 1.
+static inline UInt64 roundToOdd(const UInt64* power, UInt64 cp)
+{
+    UInt64 gLo = power[1] + 1;
+    UInt64 gHi = power[0] + (gLo == 0);
+
+    UInt64 x1, y1;
+    multiply128(gLo, cp, &x1);
+    UInt64 y0 = multiply128(gHi, cp, &y1);
+    UInt64 z  = y0 + x1;
+    y1 += (z < y0);
+    return y1 | (z > 1);
+}
+
+// The 64-bit g for floats is the high half of the 128-bit one.
+static inline UInt32 roundToOdd32(const UInt64* power, UInt32 cp)
+{
+    UInt64 g   = power[0] + 1;
+    UInt64 b01 = (g & 0xFFFFFFFF) * cp;
+    UInt64 b11 = (g >> 32) * cp;
+    UInt64 hi  = b11 + (b01 >> 32);
+    return (UInt32)(hi >> 32) | ((UInt32)hi > 1);
+}
+
+// Finds the shortest digits * 10^exponent that rounds to the double with the given
+// significand and biased exponent bits.
+static void doubleToDecimal(UInt64 ieeeSignificand, int ieeeExponent, UInt64* digits, int* exponent)
+{
+    UInt64 c;
+    int    q;
+    if (ieeeExponent != 0)
+    {
+        c = ieeeSignificand | ((UInt64)1 << 52);
+        q = ieeeExponent - 1075;
+
+        // Small integers are their own shortest representation.
+        if (q <= 0 && -q < 53 && (c & (((UInt64)1 << -q) - 1)) == 0)
+        {
+            *digits   = c >> -q;
+            *exponent = 0;
+            return;
+        }
+    }
+    else
+    {
+        c = ieeeSignificand;
+        q = 1 - 1075;
+    }
+
+    bool   isEven        = (c & 1) == 0;
+    bool   lowerIsCloser = (ieeeSignificand == 0 && ieeeExponent > 1);
+    UInt64 cbl           = 4 * c - 2 + lowerIsCloser;
+    UInt64 cb            = 4 * c;
+    UInt64 cbr           = 4 * c + 2;
+
+    int k = lowerIsCloser ? floorLog10ThreeQuartersPow2(q) : floorLog10Pow2(q);
+    int h = q + floorLog2Pow10(-k) + 1;
+    const UInt64* power = PowerTable[-k - PowerTableMin];
+
+    UInt64 vbl   = roundToOdd(power, cbl << h);
+    UInt64 vb    = roundToOdd(power, cb << h);
+    UInt64 vbr   = roundToOdd(power, cbr << h);
+    UInt64 lower = vbl + !isEven;
+    UInt64 upper = vbr - !isEven;
+    UInt64 s     = vb / 4;
+
+    if (s >= 10)
+    {
+        UInt64 sp       = s / 10;
+        bool   upInside = lower <= 40 * sp;
+        bool   wpInside = 40 * sp + 40 <= upper;
+        if (upInside != wpInside)
+        {
+            *digits   = sp + wpInside;
+            *exponent = k + 1;
+            return;
+        }
+    }
+
+    bool uInside = lower <= 4 * s;
+    bool wInside = 4 * s + 4 <= upper;
+    if (uInside != wInside)
+    {
+        *digits   = s + wInside;
+        *exponent = k;
+        return;
+    }
+
+    UInt64 mid     = 4 * s + 2;
+    bool   roundUp = vb > mid || (vb == mid && (s & 1) != 0);
+    *digits   = s + roundUp;
+    *exponent = k;
+}
+
+// The float version of doubleToDecimal.
+static void floatToDecimal(UInt32 ieeeSignificand, int ieeeExponent, UInt64* digits, int* exponent)
+{
+    UInt32 c;
+    int    q;
+    if (ieeeExponent != 0)
+    {
+        c = ieeeSignificand | (1u << 23);
+        q = ieeeExponent - 150;
+
+        if (q <= 0 && -q < 24 && (c & ((1u << -q) - 1)) == 0)
+        {
+            *digits   = c >> -q;
+            *exponent = 0;
+            return;
+        }
+    }
+    else
+    {
+        c = ieeeSignificand;
+        q = 1 - 150;
+    }
+
+    bool   isEven        = (c & 1) == 0;
+    bool   lowerIsCloser = (ieeeSignificand == 0 && ieeeExponent > 1);
+    UInt32 cbl           = 4 * c - 2 + lowerIsCloser;
+    UInt32 cb            = 4 * c;
+    UInt32 cbr           = 4 * c + 2;
+
+    int k = lowerIsCloser ? floorLog10ThreeQuartersPow2(q) : floorLog10Pow2(q);
+    int h = q + floorLog2Pow10(-k) + 1;
+    const UInt64* power = PowerTable[-k - PowerTableMin];
+
+    UInt32 vbl   = roundToOdd32(power, cbl << h);
+    UInt32 vb    = roundToOdd32(power, cb << h);
+    UInt32 vbr   = roundToOdd32(power, cbr << h);
+    UInt32 lower = vbl + !isEven;
+    UInt32 upper = vbr - !isEven;
+    UInt32 s     = vb / 4;
+
+    if (s >= 10)
+    {
+        UInt32 sp       = s / 10;
+        bool   upInside = lower <= 40 * sp;
+        bool   wpInside = 40 * sp + 40 <= upper;
+        if (upInside != wpInside)
+        {
+            *digits   = sp + wpInside;
+            *exponent = k + 1;
+            return;
+        }
+    }
+
+    bool uInside = lower <= 4 * s;
+    bool wInside = 4 * s + 4 <= upper;
+    if (uInside != wInside)
+    {
+        *digits   = s + wInside;
+        *exponent = k;
+        return;
+    }
+
+    UInt32 mid     = 4 * s + 2;
+    bool   roundUp = vb > mid || (vb == mid && (s & 1) != 0);
+    *digits   = s + roundUp;
+    *exponent = k;
+}
+
+// Writes digits * 10^exponent to buffer, which must hold 32 characters, in fixed
+// notation if the decimal point is within 21 digits of the start and 6 of the end,
+// and in scientific notation otherwise. Returns the length.
+static UPInt formatDecimal(char* buffer, bool negative, UInt64 digits, int exponent)
+{
+    char   text[20];
+    int    count = 0;
+    char*  out   = buffer;
+
+    while (digits % 10 == 0)
+    {
+        digits /= 10;
+        exponent++;
+    }
+    for (UInt64 d = digits; d; d /= 10)
+        count++;
+    for (int i = count - 1; i >= 0; i--, digits /= 10)
+        text[i] = (char)('0' + digits % 10);
+
+    if (negative)
+        *out++ = '-';
+
+    int point = count + exponent;
+    if (exponent >= 0 && point <= 21)
+    {
+        memcpy(out, text, count);
+        out += count;
+        for (int i = 0; i < exponent; i++)
+            *out++ = '0';
+    }
+    else if (point > 0 && point <= 21)
+    {
+        memcpy(out, text, point);
+        out += point;
+        *out++ = '.';
+        memcpy(out, text + point, count - point);
+        out += count - point;
+    }
+    else if (point > -6 && point <= 0)
+    {
+        *out++ = '0';
+        *out++ = '.';
+        for (int i = 0; i < -point; i++)
+            *out++ = '0';
+        memcpy(out, text, count);
+        out += count;
+    }
+    else
+    {
+        *out++ = text[0];
+        if (count > 1)
+        {
+            *out++ = '.';
+            memcpy(out, text + 1, count - 1);
+            out += count - 1;
+        }
+        *out++ = 'e';
+        *out++ = (point - 1 < 0) ? '-' : '+';
+        out += OVR_sprintf(out, 8, "%d", (point - 1 < 0) ? 1 - point : point - 1);
+    }
+
+    *out = 0;
+    return out - buffer;
+}
+
+static UPInt copyNumber(const char* buffer, UPInt length, char* dest, UPInt destsize)
+{
+    if (destsize == 0)
+        return 0;
+    if (length > destsize - 1)
+        length = destsize - 1;
+    memcpy(dest, buffer, length);
+    dest[length] = 0;
+    return length;
+}
+
+UPInt OVR_CDECL OVR_dtoa(double value, char* dest, UPInt destsize)
+{
+    char   buffer[32];
+    UInt64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    bool   negative    = (bits >> 63) != 0;
+    UInt64 significand = bits & (((UInt64)1 << 52) - 1);
+    int    exponent    = (int)(bits >> 52) & 0x7FF;
+
+    if (exponent == 0x7FF)
+        return copyNumber(significand ? "nan" : (negative ? "-inf" : "inf"),
+                          significand ? 3 : (negative ? 4 : 3), dest, destsize);
+    if (exponent == 0 && significand == 0)
+        return copyNumber(negative ? "-0" : "0", negative ? 2 : 1, dest, destsize);
+
+    UInt64 digits;
+    int    digitsExponent;
+    doubleToDecimal(significand, exponent, &digits, &digitsExponent);
+    return copyNumber(buffer, formatDecimal(buffer, negative, digits, digitsExponent), dest, destsize);
+}
+
+UPInt OVR_CDECL OVR_ftoa(float value, char* dest, UPInt destsize)
+{
+    char   buffer[32];
+    UInt32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    bool   negative    = (bits >> 31) != 0;
+    UInt32 significand = bits & ((1u << 23) - 1);
+    int    exponent    = (int)(bits >> 23) & 0xFF;
+
+    if (exponent == 0xFF)
+        return copyNumber(significand ? "nan" : (negative ? "-inf" : "inf"),
+                          significand ? 3 : (negative ? 4 : 3), dest, destsize);
+    if (exponent == 0 && significand == 0)
+        return copyNumber(negative ? "-0" : "0", negative ? 2 : 1, dest, destsize);
+
+    UInt64 digits;
+    int    digitsExponent;
+    floatToDecimal(significand, exponent, &digits, &digitsExponent);
+    return copyNumber(buffer, formatDecimal(buffer, negative, digits, digitsExponent), dest, destsize);
 }
 
 
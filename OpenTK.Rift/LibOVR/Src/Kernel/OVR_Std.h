@@ -222,7 +222,13 @@ inline char* OVR_CDECL OVR_strrchr(char* str, char c)
 }
 
 
+// Decimal conversions that don't depend on the locale. OVR_strtod and OVR_strtof return
+// the correctly rounded value; OVR_dtoa and OVR_ftoa write the shortest text that reads
+// back as the same value, truncated to destsize, and return its length.
 double OVR_CDECL OVR_strtod(const char* string, char** tailptr);
+float  OVR_CDECL OVR_strtof(const char* string, char** tailptr);
+UPInt  OVR_CDECL OVR_dtoa(double value, char* dest, UPInt destsize);
+UPInt  OVR_CDECL OVR_ftoa(float value, char* dest, UPInt destsize);
 
 inline long OVR_CDECL OVR_strtol(const char* string, char** tailptr, int radix)
 {
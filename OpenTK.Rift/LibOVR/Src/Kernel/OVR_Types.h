@@ -458,6 +458,10 @@ namespace BaseTypes
 
 #define OVR_ENABLE_THREADS
 //
+// Records the latency of each stage of the sensor input
+// pipeline into histograms, see OVR_LatencyTrace.h
+//# define OVR_ENABLE_LATENCY_TRACE
+//
 // Prevents OVR from defining new within
 // type macros, so developers can override
 // new using the #define new new(...) trick
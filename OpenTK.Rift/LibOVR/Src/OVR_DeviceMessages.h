@@ -93,7 +93,7 @@ class MessageBodyFrame : public Message
 {
 public:
     MessageBodyFrame(DeviceBase* dev)
-        : Message(Message_BodyFrame, dev), Temperature(0.0f), TimeDelta(0.0f)
+        : Message(Message_BodyFrame, dev), Temperature(0.0f), TimeDelta(0.0f), AbsoluteTimeSeconds(0.0)
     {
     }
 
@@ -102,6 +102,9 @@ public:
     Vector3f MagneticField;  // Magnetic field strength in Gauss.
     float    Temperature;    // Temperature reading on sensor surface, in degrees Celsius.
     float    TimeDelta;      // Time passed since last Body Frame, in seconds.
+    // Time the sample was taken on the Timer::GetSeconds clock, or 0 if unknown; replay
+    // tools set it so that time based queries follow the recording.
+    double   AbsoluteTimeSeconds;
 };
 
 // Sent when we receive a device status changes (e.g.:
@@ -0,0 +1,190 @@
+/************************************************************************************
+
+Filename    :   OVR_FrameTiming.cpp
+Content     :   Estimates display timing from the frame history of an application
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "OVR_FrameTiming.h"
+#include "Kernel/OVR_Alg.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** FrameTiming
+
+FrameTiming::FrameTiming(float refreshRate)
+  : RefreshPeriod(1.0f / refreshRate), PhotonDelay(-1.0f)
+{
+    OVR_ASSERT(refreshRate > 0);
+    Reset();
+}
+
+void FrameTiming::Reset()
+{
+    BeginCount   = 0;
+    NextPresent  = 0;
+    PresentCount = 0;
+    VsyncTime    = 0;
+    Latency      = RefreshPeriod;
+    RenderTime   = 0;
+    PresentTime  = 0;
+    PhotonTime   = 0;
+}
+
+double FrameTiming::BeginFrame(double time)
+{
+    FrameRecord& frame = Frames[BeginCount % HistorySize];
+    frame.BeginTime = time;
+    frame.EndTime   = 0;
+    BeginCount++;
+
+    if (PresentCount == 0)
+    {
+        // Nothing known yet; assume the frame makes the next refresh
+        PresentTime = time + RefreshPeriod;
+    }
+    else
+    {
+        // Snap the expected present to the vsync grid, but never before the frame starts
+        double n = floor((time + Latency - VsyncTime) / RefreshPeriod + 0.5);
+        PresentTime = VsyncTime + n * RefreshPeriod;
+        while (PresentTime <= time)
+            PresentTime += RefreshPeriod;
+    }
+
+    PhotonTime = PresentTime + ((PhotonDelay < 0) ? 0.5f * RefreshPeriod : PhotonDelay);
+    return PhotonTime;
+}
+
+void FrameTiming::EndFrame(double time)
+{
+    if (BeginCount > 0)
+        Frames[(BeginCount - 1) % HistorySize].EndTime = time;
+}
+
+void FrameTiming::Present(double time)
+{
+    // Frames that were never presented fall out of the window
+    if (BeginCount - NextPresent > HistorySize)
+        NextPresent = BeginCount - HistorySize;
+    if (NextPresent == BeginCount)
+        return;
+
+    const FrameRecord& frame = Frames[NextPresent % HistorySize];
+    NextPresent++;
+
+    int slot = PresentCount % HistorySize;
+    Presents[slot]    = time;
+    Latencies[slot]   = time - frame.BeginTime;
+    RenderTimes[slot] = (frame.EndTime > 0) ? (float)(frame.EndTime - frame.BeginTime) : 0.0f;
+    PresentCount++;
+
+    updateEstimates();
+}
+
+double FrameTiming::median(double* values, int count)
+{
+    OVR_ASSERT(count > 0);
+    Alg::InsertionSortSliced(values, 0, count, Alg::OperatorLess<double>::Compare);
+    return values[count / 2];
+}
+
+void FrameTiming::updateEstimates()
+{
+    const double maxVsyncDeviation = 0.1;   // Fraction of the period a present may be off the grid
+
+    int    count  = (int)Alg::Min(PresentCount, (UInt32)HistorySize);
+    if (count == 0)
+        return;
+    UInt32 oldest = PresentCount - count;
+    double last   = Presents[(PresentCount - 1) % HistorySize];
+    double values[HistorySize];
+    double offsets[HistorySize];
+
+    if (PresentCount >= MinPresents)
+    {
+        // Intervals between presents, divided by the number of refreshes they span so
+        // that missed frames still measure the period
+        int n = 0;
+        for (int i = 1; i < count; i++)
+        {
+            double d = Presents[(oldest + i) % HistorySize] - Presents[(oldest + i - 1) % HistorySize];
+            double k = floor(d / RefreshPeriod + 0.5);
+            if (k >= 1)
+                values[n++] = d / k;
+        }
+        if (n > 0)
+            RefreshPeriod = (float)median(values, n);
+    }
+
+    // Offsets of the presents from a vsync grid through the last one; the median is
+    // robust against late or misreported presents
+    for (int i = 0; i < count; i++)
+    {
+        double p = Presents[(oldest + i) % HistorySize];
+        values[i]  = floor((p - last) / RefreshPeriod + 0.5);   // Index of the nearest vsync
+        offsets[i] = p - last - values[i] * RefreshPeriod;
+    }
+    double sorted[HistorySize];
+    memcpy(sorted, offsets, count * sizeof(double));
+    double offset = median(sorted, count);
+    VsyncTime = last + offset;
+
+    if (PresentCount >= MinPresents)
+    {
+        // Least squares fit of the grid through the presents close to it, which pins
+        // both the period and the phase down much further than the intervals do
+        double sk = 0, sp = 0, skk = 0, skp = 0;
+        int    inliers = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (fabs(offsets[i] - offset) > maxVsyncDeviation * RefreshPeriod)
+                continue;
+            double k = values[i];
+            double p = offsets[i] + k * RefreshPeriod;   // Relative to last
+            sk += k; sp += p; skk += k * k; skp += k * p;
+            inliers++;
+        }
+        double det = inliers * skk - sk * sk;
+        if (inliers >= MinPresents && det > 0)
+        {
+            double period = (inliers * skp - sk * sp) / det;
+            RefreshPeriod = (float)period;
+            VsyncTime     = last + (sp - period * sk) / inliers;
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+        values[i] = Latencies[(oldest + i) % HistorySize];
+    Latency = median(values, count);
+
+    for (int i = 0; i < count; i++)
+        values[i] = RenderTimes[(oldest + i) % HistorySize];
+    RenderTime = (float)median(values, count);
+}
+
+
+} // namespace OVR
@@ -0,0 +1,131 @@
+/************************************************************************************
+
+PublicHeader:   OVR.h
+Filename    :   OVR_FrameTiming.h
+Content     :   Estimates display timing from the frame history of an application
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_FrameTiming_h
+#define OVR_FrameTiming_h
+
+#include "Kernel/OVR_Allocator.h"
+
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** FrameTiming
+
+// FrameTiming derives the time at which a frame will reach the eyes from the timing of
+// the frames before it, so that the prediction horizon follows the actual latency of
+// the render pipeline instead of a hand tuned PredictionDT.
+//
+// The application reports, on the Timer::GetSeconds clock, when it starts work on each
+// frame (BeginFrame), when it submits it (EndFrame) and when its buffer swap completed
+// on the vertical blank (Present). Presents are matched to frames in order, so frames
+// may be pipelined. From a rolling window of recent frames, robust (median based)
+// estimates are kept of the refresh period, the vsync phase and the number of refresh
+// periods between the start of a frame and its present. All calls are expected from
+// the render thread.
+//
+// Orientations for the frame are predicted to its absolute photon time, passed to
+// SensorFusion::GetPredictedOrientationAt, so that queries made late in the frame,
+// from newer sensor samples, still target the same instant.
+class FrameTiming : public NewOverrideBase
+{
+public:
+    enum
+    {
+        HistorySize = 32
+    };
+
+    // refreshRate is the initial guess, until enough presents have been reported.
+    FrameTiming(float refreshRate = 60.0f);
+
+    // Starts a new frame; returns its predicted photon time.
+    double      BeginFrame(double time);
+    void        EndFrame(double time);
+    // Reports the completed buffer swap of the oldest frame not yet presented.
+    void        Present(double time);
+
+    // Forgets the history, e.g. after the display mode changed.
+    void        Reset();
+
+
+    // *** Estimates
+
+    // Photon time of the frame started by the last BeginFrame: when the middle of its
+    // scanout is lit, unless SetPhotonDelay overrides the offset from the vsync.
+    double      GetPhotonTime() const               { return PhotonTime; }
+    // Time of the vsync that frame is predicted to be presented on.
+    double      GetPresentTime() const              { return PresentTime; }
+
+    float       GetRefreshPeriod() const            { return RefreshPeriod; }
+    // Refresh periods from the start of a frame to its present.
+    float       GetPipelineDepth() const            { return (float)(Latency / RefreshPeriod); }
+    // Median time spent from BeginFrame to EndFrame.
+    float       GetRenderTime() const               { return RenderTime; }
+    // True once enough frames were presented for the estimates to be measured.
+    bool        IsMeasured() const                  { return PresentCount >= MinPresents; }
+
+    // Seconds from the vsync to the photons that matter; negative selects half of the
+    // refresh period, i.e. the middle of a top to bottom scanout.
+    void        SetPhotonDelay(float delay)         { PhotonDelay = delay; }
+    float       GetPhotonDelay() const              { return PhotonDelay; }
+
+private:
+    enum
+    {
+        MinPresents = 4
+    };
+
+    struct FrameRecord
+    {
+        double  BeginTime;
+        double  EndTime;
+    };
+
+    void        updateEstimates();
+    static double median(double* values, int count);
+
+    FrameRecord Frames[HistorySize];
+    UInt32      BeginCount;         // Frames started
+    UInt32      NextPresent;        // Index of the oldest frame not yet presented
+    UInt32      PresentCount;       // Presents recorded
+    double      Presents[HistorySize];
+    double      Latencies[HistorySize];
+    float       RenderTimes[HistorySize];
+
+    float       RefreshPeriod;
+    double      VsyncTime;          // A vsync on the estimated grid
+    double      Latency;            // Median BeginFrame to present
+    float       RenderTime;
+    float       PhotonDelay;
+
+    double      PresentTime;
+    double      PhotonTime;
+};
+
+
+} // namespace OVR
+
+#endif
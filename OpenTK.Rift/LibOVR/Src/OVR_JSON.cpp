@@ -59,52 +59,11 @@ limitations under the License.
 #include "OVR_JSON.h"
 #include "Kernel/OVR_SysFile.h"
 #include "Kernel/OVR_Log.h"
+#include "Kernel/OVR_Alg.h"
 
 namespace OVR {
 
 
-//-----------------------------------------------------------------------------
-// Create a new copy of a string
-static char* JSON_strdup(const char* str)
-{
-    UPInt len  = OVR_strlen(str) + 1;
-    char* copy = (char*)OVR_ALLOC(len);
-    if (!copy)
-        return 0;
-    memcpy(copy, str, len);
-    return copy;
-}
-
-
-//-----------------------------------------------------------------------------
-// Render the number from the given item into a string.
-static char* PrintNumber(double d)
-{
-	char *str;
-	//double d=item->valuedouble;
-    int valueint = (int)d;
-	if (fabs(((double)valueint)-d)<=DBL_EPSILON && d<=INT_MAX && d>=INT_MIN)
-	{
-		str=(char*)OVR_ALLOC(21);	// 2^64+1 can be represented in 21 chars.
-		if (str)
-            OVR_sprintf(str, 21, "%d", valueint);
-	}
-	else
-	{
-		str=(char*)OVR_ALLOC(64);	// This is a nice tradeoff.
-		if (str)
-		{
-			if (fabs(floor(d)-d)<=DBL_EPSILON && fabs(d)<1.0e60)
-                OVR_sprintf(str, 64, "%.0f", d);
-			else if (fabs(d)<1.0e-6 || fabs(d)>1.0e9)
-                OVR_sprintf(str, 64, "%e", d);
-			else
-                OVR_sprintf(str, 64, "%f", d);
-		}
-	}
-	return str;
-}
-
 // Parse the input text into an un-escaped cstring, and populate item.
 static const unsigned char firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
 
@@ -136,62 +95,61 @@ JSON::~JSON()
 }
 
 //-----------------------------------------------------------------------------
-// Parse the input text to generate a number, and populate the result into item
+// Parse the input text to generate a number, shared by JSON and JSONDocument.
 // Returns the text position after the parsed number
-const char* JSON::parseNumber(const char *num)
+static const char* ParseNumberText(const char* num, double* value)
 {
-    const char* num_start = num;
-    double      n=0, sign=1, scale=0;
-    int         subscale     = 0,
-                signsubscale = 1;
+    const char* start = num;
 
-	// Could use sscanf for this?
+    // Find the end of the number by the JSON grammar, which strtod may not agree with
+    // for malformed numbers such as "1.e5".
 	if (*num=='-') 
-        sign=-1,num++;	// Has sign?
-	if (*num=='0')
-        num++;			// is zero
-	
-    if (*num>='1' && *num<='9')	
-    {
-        do
-        {   
-            n=(n*10.0)+(*num++ -'0');
-        }
-        while (*num>='0' && *num<='9');	// Number?
-    }
-
+        num++;
+	while (*num>='0' && *num<='9')
+        num++;
 	if (*num=='.' && num[1]>='0' && num[1]<='9')
     {
         num++;
-        do
-        {
-            n=(n*10.0)+(*num++ -'0');
-            scale--;
-        }
-        while (*num>='0' && *num<='9');  // Fractional part?
+        while (*num>='0' && *num<='9')
+            num++;
     }
-
-	if (*num=='e' || *num=='E')		// Exponent?
+	if (*num=='e' || *num=='E')
 	{
         num++;
-        if (*num=='+')
+        if (*num=='+' || *num=='-')
             num++;
-        else if (*num=='-')
-        {
-            signsubscale=-1;
-            num++;		// With sign?
-        }
-
 		while (*num>='0' && *num<='9')
-            subscale=(subscale*10)+(*num++ - '0');	// Number?
+            num++;
 	}
 
-    // Number = +/- number.fraction * 10^+/- exponent
-	n = sign*n*pow(10.0,(scale+subscale*signsubscale));
+    char* end = 0;
+    *value = OVR_strtod(start, &end);
+    if (end != num)
+    {
+        // Convert just the text that was matched.
+        UPInt length = num - start;
+        char  buffer[64];
+        char* text = (length < sizeof(buffer)) ? buffer : (char*)OVR_ALLOC(length + 1);
+        memcpy(text, start, length);
+        text[length] = 0;
+        *value = OVR_strtod(text, 0);
+        if (text != buffer)
+            OVR_FREE(text);
+    }
+	return num;
+}
+
+//-----------------------------------------------------------------------------
+// Parse the input text to generate a number, and populate the result into item
+// Returns the text position after the parsed number
+const char* JSON::parseNumber(const char *num)
+{
+    const char* num_start = num;
+
+    num = ParseNumberText(num, &dValue);
 
     // Assign parsed value.
 	Type   = JSON_Number;
-    dValue = n;
     Value.AssignString(num_start, num - num_start);
     
 	return num;
@@ -223,34 +181,15 @@ const char* ParseHex(unsigned* val, unsigned digits, const char* str)
 }
 
 //-----------------------------------------------------------------------------
-// Parses the input text into a string item and returns the text position after
-// the parsed string
-const char* JSON::parseString(const char* str, const char** perror)
+// Un-escapes the string that starts after the opening quote at ptr into out, and
+// returns the text position after the closing quote. The output is never longer
+// than the input, so out may point at ptr to decode the string in place.
+static const char* UnescapeString(const char* ptr, char* out)
 {
-	const char* ptr = str+1;
     const char* p;
-    char*       ptr2;
-    char*       out;
-    int         len=0;
+    char*       ptr2 = out;
+    int         len;
     unsigned    uc, uc2;
-	
-    if (*str!='\"')
-    {
-        return AssignError(perror, "Syntax Error: Missing quote");
-    }
-	
-	while (*ptr!='\"' && *ptr && ++len)
-    {   
-        if (*ptr++ == '\\') ptr++;	// Skip escaped quotes.
-    }
-	
-    // This is how long we need for the string, roughly.
-	out=(char*)OVR_ALLOC(len+1);
-	if (!out)
-        return 0;
-	
-	ptr = str+1;
-    ptr2= out;
 
 	while (*ptr!='\"' && *ptr)
 	{
@@ -261,6 +200,9 @@ const char* JSON::parseString(const char* str, const char** perror)
 		else
 		{
 			ptr++;
+			if (!*ptr)
+                break;	// Backslash at the end of the text.
+
 			switch (*ptr)
 			{
 				case 'b': *ptr2++ = '\b';	break;
@@ -325,77 +267,48 @@ const char* JSON::parseString(const char* str, const char** perror)
 		}
 	}
 
-	*ptr2 = 0;
+    // Check for the quote first, as an in place terminator may overwrite it.
 	if (*ptr=='\"')
-        ptr++;
-	
-    // Make a copy of the string 
-    Value=out;
-    OVR_FREE(out);
-	Type=JSON_String;
-
+    {
+        *ptr2 = 0;
+        return ptr+1;
+    }
+	*ptr2 = 0;
 	return ptr;
 }
 
 //-----------------------------------------------------------------------------
-// Render the string provided to an escaped version that can be printed.
-char* PrintString(const char* str)
+// Parses the input text into a string item and returns the text position after
+// the parsed string
+const char* JSON::parseString(const char* str, const char** perror)
 {
-	const char *ptr;
-    char *ptr2,*out;
-    int len=0;
-    unsigned char token;
+	const char* ptr = str+1;
+    char*       out;
+    int         len=0;
 	
-	if (!str)
-        return JSON_strdup("");
-	ptr=str;
-    
-    token=*ptr;
-    while (token && ++len)\
+    if (*str!='\"')
     {
-        if (strchr("\"\\\b\f\n\r\t",token))
-            len++;
-        else if (token<32) 
-            len+=5;
-        ptr++;
-        token=*ptr;
+        return AssignError(perror, "Syntax Error: Missing quote");
+    }
+	
+	while (*ptr!='\"' && *ptr && ++len)
+    {   
+        if (*ptr++ == '\\') ptr++;	// Skip escaped quotes.
     }
 	
-	int buff_size = len+3;
-    out=(char*)OVR_ALLOC(buff_size);
+    // This is how long we need for the string, roughly.
+	out=(char*)OVR_ALLOC(len+1);
 	if (!out)
         return 0;
+	
+	ptr = UnescapeString(str+1, out);
 
-	ptr2 = out;
-    ptr  = str;
-	*ptr2++ = '\"';
+    // Make a copy of the string 
+    Value=out;
+    OVR_FREE(out);
+	Type=JSON_String;
 
-	while (*ptr)
-	{
-		if ((unsigned char)*ptr>31 && *ptr!='\"' && *ptr!='\\') 
-            *ptr2++=*ptr++;
-		else
-		{
-			*ptr2++='\\';
-			switch (token=*ptr++)
-			{
-				case '\\':	*ptr2++='\\';	break;
-				case '\"':	*ptr2++='\"';	break;
-				case '\b':	*ptr2++='b';	break;
-				case '\f':	*ptr2++='f';	break;
-				case '\n':	*ptr2++='n';	break;
-				case '\r':	*ptr2++='r';	break;
-				case '\t':	*ptr2++='t';	break;
-				default: 
-                    OVR_sprintf(ptr2, buff_size - (ptr2-out), "u%04x",token);
-                    ptr2+=5;
-                    break;	// Escape and print.
-			}
-		}
-	}
-	*ptr2++='\"';
-    *ptr2++=0;
-	return out;
+	return ptr;
 }
 
 //-----------------------------------------------------------------------------
@@ -480,31 +393,6 @@ const char* JSON::parseValue(const char* buff, const char** perror)
     return AssignError(perror, "Syntax Error: Invalid syntax");
 }
 
-
-//-----------------------------------------------------------------------------
-// Render a value to text. 
-char* JSON::PrintValue(int depth, bool fmt)
-{
-	char *out=0;
-
-    switch (Type)
-	{
-        case JSON_Null:	    out = JSON_strdup("null");	break;
-        case JSON_Bool:
-            if (dValue == 0)
-                out = JSON_strdup("false");
-            else
-                out = JSON_strdup("true");
-            break;
-        case JSON_Number:	out = PrintNumber(dValue); break;
-        case JSON_String:	out = PrintString(Value); break;
-        case JSON_Array:	out = PrintArray(depth, fmt); break;
-        case JSON_Object:	out = PrintObject(depth, fmt); break;
-        case JSON_None: OVR_ASSERT_LOG(false, ("Bad JSON type.")); break;
-	}
-	return out;
-}
-
 //-----------------------------------------------------------------------------
 // Build an array object from input text and returns the text position after
 // the parsed array
@@ -550,90 +438,6 @@ const char* JSON::parseArray(const char* buff, const char** perror)
     return AssignError(perror, "Syntax Error: Missing ending bracket");
 }
 
-//-----------------------------------------------------------------------------
-// Render an array to text.  The returned text must be freed
-char* JSON::PrintArray(int depth, bool fmt)
-{
-	char **entries;
-	char * out = 0,*ptr,*ret;
-    SPInt  len = 5;
-	
-    bool fail = false;
-	
-	// How many entries in the array? 
-    int numentries = GetItemCount();
-	if (!numentries)
-	{
-		out=(char*)OVR_ALLOC(3);
-		if (out)
-            OVR_strcpy(out, 3, "[]");
-		return out;
-	}
-	// Allocate an array to hold the values for each
-	entries=(char**)OVR_ALLOC(numentries*sizeof(char*));
-	if (!entries)
-        return 0;
-	memset(entries,0,numentries*sizeof(char*));
-
-	//// Retrieve all the results:
-    JSON* child = Children.GetFirst();
-    for (int i=0; i<numentries; i++)
-	{
-		//JSON* child = Children[i];
-        ret=child->PrintValue(depth+1, fmt);
-		entries[i]=ret;
-		if (ret)
-            len+=OVR_strlen(ret)+2+(fmt?1:0);
-        else
-        {
-            fail = true;
-            break;
-        }
-        child = Children.GetNext(child);
-	}
-	
-	// If we didn't fail, try to malloc the output string 
-	if (!fail)
-        out=(char*)OVR_ALLOC(len);
-	// If that fails, we fail. 
-	if (!out)
-        fail = true;
-
-	// Handle failure.
-	if (fail)
-	{
-		for (int i=0; i<numentries; i++) 
-        {
-            if (entries[i])
-                OVR_FREE(entries[i]);
-        }
-		OVR_FREE(entries);
-		return 0;
-	}
-	
-	// Compose the output array.
-	*out='[';
-	ptr=out+1;
-    *ptr=0;
-	for (int i=0; i<numentries; i++)
-	{
-		OVR_strcpy(ptr, len - (ptr-out), entries[i]);
-        ptr+=OVR_strlen(entries[i]);
-		if (i!=numentries-1)
-        {
-            *ptr++=',';
-            if (fmt)
-                *ptr++=' ';
-            *ptr=0;
-        }
-		OVR_FREE(entries[i]);
-	}
-	OVR_FREE(entries);
-	*ptr++=']';
-    *ptr++=0;
-	return out;	
-}
-
 //-----------------------------------------------------------------------------
 // Build an object from the supplied text and returns the text position after
 // the parsed object
@@ -699,148 +503,6 @@ const char* JSON::parseObject(const char* buff, const char** perror)
     return AssignError(perror, "Syntax Error: Missing closing brace");
 }
 
-//-----------------------------------------------------------------------------
-// Render an object to text.  The returned string must be freed
-char* JSON::PrintObject(int depth, bool fmt)
-{
-	char** entries = 0, **names = 0;
-	char*  out = 0;
-    char*  ptr, *ret, *str;
-    SPInt  len = 7, i = 0, j;
-    bool   fail = false;
-	
-    // Count the number of entries.
-    int numentries = GetItemCount();
-    
-	// Explicitly handle empty object case
-	if (numentries == 0)
-	{
-		out=(char*)OVR_ALLOC(fmt?depth+3:3);
-		if (!out)
-            return 0;
-		ptr=out;
-        *ptr++='{';
-		
-        if (fmt)
-        {
-            *ptr++='\n';
-            for (i=0;i<depth-1;i++)
-                *ptr++='\t';
-        }
-		*ptr++='}';
-        *ptr++=0;
-		return out;
-	}
-	// Allocate space for the names and the objects
-	entries=(char**)OVR_ALLOC(numentries*sizeof(char*));
-	if (!entries)
-        return 0;
-	names=(char**)OVR_ALLOC(numentries*sizeof(char*));
-	
-    if (!names)
-    {
-        OVR_FREE(entries);
-        return 0;
-    }
-	memset(entries,0,sizeof(char*)*numentries);
-	memset(names,0,sizeof(char*)*numentries);
-
-	// Collect all the results into our arrays:
-    depth++;
-    if (fmt)
-        len+=depth;
-
-    JSON* child = Children.GetFirst();
-    while (!Children.IsNull(child))
-	{
-		names[i]     = str = PrintString(child->Name);
-		entries[i++] = ret = child->PrintValue(depth, fmt);
-
-		if (str && ret)
-        {
-            len += OVR_strlen(ret)+OVR_strlen(str)+2+(fmt?2+depth:0);
-        }
-        else
-        {
-            fail = true;
-            break;
-        }
-		
-        child = Children.GetNext(child);
-	}
-	
-	// Try to allocate the output string
-	if (!fail)
-        out=(char*)OVR_ALLOC(len);
-	if (!out)
-        fail=true;
-
-	// Handle failure
-	if (fail)
-	{
-		for (i=0;i<numentries;i++)
-        {
-            if (names[i])
-                OVR_FREE(names[i]);
-            
-            if (entries[i])
-                OVR_FREE(entries[i]);}
-		
-        OVR_FREE(names);
-        OVR_FREE(entries);
-		return 0;
-	}
-	
-	// Compose the output:
-	*out = '{';
-    ptr  = out+1;
-    if (fmt)
-        *ptr++='\n';
-    *ptr = 0;
-	
-    for (i=0; i<numentries; i++)
-	{
-		if (fmt)
-        {
-            for (j=0; j<depth; j++)
-                *ptr++ = '\t';
-        }
-		OVR_strcpy(ptr, len - (ptr-out), names[i]);
-        ptr   += OVR_strlen(names[i]);
-		*ptr++ =':';
-        
-        if (fmt)
-            *ptr++='\t';
-		
-        OVR_strcpy(ptr, len - (ptr-out), entries[i]);
-        ptr+=OVR_strlen(entries[i]);
-		
-        if (i!=numentries-1)
-            *ptr++ = ',';
-		
-        if (fmt)
-            *ptr++ = '\n';
-        *ptr = 0;
-		
-        OVR_FREE(names[i]);
-        OVR_FREE(entries[i]);
-	}
-	
-	OVR_FREE(names);
-    OVR_FREE(entries);
-	
-    if (fmt)
-    {
-        for (i=0;i<depth-1;i++)
-            *ptr++='\t';
-    }
-	*ptr++='}';
-    *ptr++=0;
-	
-    return out;	
-}
-
-
 
 // Returns the number of child items in the object
 // Counts the number of items in the object.
@@ -1023,20 +685,71 @@ JSON* JSON::Load(const char* path, const char** perror)
         return NULL;
     }
 
-    int    len   = f.GetLength();
-    UByte* buff  = (UByte*)OVR_ALLOC(len);
-    int    bytes = f.Read(buff, len);
+    JSONReader reader(&f);
+    JSON* json = JSON::Read(&reader, perror);
     f.Close();
+    return json;
+}
+
+//-----------------------------------------------------------------------------
+// Builds a JSON object tree from the tokens of the next value of the reader.
+// The returned object must be Released after use.
+JSON* JSON::Read(JSONReader* reader, const char** perror)
+{
+    ArrayPOD<JSON*> parents;
+    JSON*           root = 0;
+    String          name;
+
+    if (perror)
+        *perror = 0;
 
-    if (bytes == 0 || bytes != len)
+    while (true)
     {
-        OVR_FREE(buff);
-        return NULL;
-    }
+        JSON*     item  = 0;
+        JSONToken token = reader->Next();
 
-    JSON* json = JSON::Parse((char*)buff, perror);
-    OVR_FREE(buff);
-    return json;
+        switch (token)
+        {
+            case JSONToken_Name:        name = reader->GetString(); continue;
+            case JSONToken_BeginObject: item = CreateObject(); break;
+            case JSONToken_BeginArray:  item = CreateArray(); break;
+            case JSONToken_Null:        item = CreateNull(); break;
+            case JSONToken_String:      item = CreateString(reader->GetString()); break;
+
+            case JSONToken_Bool:
+            case JSONToken_Number:
+                // Keep the text of the value, as parseValue does.
+                item = createHelper(token == JSONToken_Bool ? JSON_Bool : JSON_Number,
+                                    reader->GetNumber(), reader->GetString());
+                break;
+
+            case JSONToken_EndObject:
+            case JSONToken_EndArray:
+                parents.Pop();
+                if (parents.GetSize() == 0)
+                    return root;
+                continue;
+
+            default:
+                AssignError(perror, reader->GetError() ? reader->GetError() :
+                                                         "Syntax Error: Invalid syntax");
+                if (root)
+                    root->Release();
+                return 0;
+        }
+
+        if (!root)
+            root = item;
+        else if (parents.Back()->Type == JSON_Object)
+            parents.Back()->AddItem(name, item);
+        else
+            parents.Back()->AddArrayElement(item);
+
+        if (item->Type == JSON_Object || item->Type == JSON_Array)
+            parents.PushBack(item);
+        else if (parents.GetSize() == 0)
+            return root;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -1047,21 +760,991 @@ bool JSON::Save(const char* path)
     if (!f.Open(path, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_Write))
         return false;
 
-    char* text = PrintValue(0, true);
-    if (text)
+    JSONWriter writer(&f, true);
+    writer.AddItem(0, this);
+
+    bool result = writer.Flush();
+    f.Close();
+    return result;
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONDocumentParser
+
+// Objects smaller than this are searched linearly.
+static const unsigned JSONIndexMinItems = 8;
+// Deeper nesting is rejected rather than risking the stack.
+static const int      JSONMaxDepth      = 512;
+
+static const char* JSONEmptyString = "";
+
+static char* skip(char* in)
+{
+    return (char*)skip((const char*)in);
+}
+
+// FNV-1a hash of a member name.
+static UInt32 HashName(const char* name)
+{
+    UInt32 hash = 2166136261u;
+    while (*name)
     {
-        SPInt len   = OVR_strlen(text);
-        OVR_ASSERT(len < (SPInt)(int)len);
+        hash = (hash ^ (UByte)*name++) * 16777619u;
+    }
+    return hash;
+}
 
-        int   bytes = f.Write((UByte*)text, (int)len);
-        f.Close();
-        OVR_FREE(text);
-        return (bytes == len);
+// JSONDocumentParser parses the text of a document in place, following the same rules
+// as JSON::parseValue. The children of the containers being parsed are collected on
+// Stack and moved into the arena once a container is closed, so that they end up
+// contiguous.
+class JSONDocumentParser
+{
+public:
+    JSONDocumentParser(JSONDocument* document, const char** perror)
+        : pDocument(document), pError(perror)
+    {
     }
-    else
+
+    static void InitValue(JSONValue* item, JSONDocument* document);
+
+    char*   parseValue(char* buff, JSONValue* item, int depth);
+
+private:
+    char*   parseString(char* str, const char** out);
+    char*   parseNumber(char* num, JSONValue* item);
+    char*   parseArray(char* buff, JSONValue* item, int depth);
+    char*   parseObject(char* buff, JSONValue* item, int depth);
+    bool    moveItems(JSONValue* item, UPInt first);
+
+    char*   assignError(const char* errorMessage)
     {
-        return false;
+        AssignError(pError, errorMessage);
+        return 0;
+    }
+
+    JSONDocument*           pDocument;
+    const char**            pError;
+    ArrayPOD<JSONValue>     Stack;
+};
+
+void JSONDocumentParser::InitValue(JSONValue* item, JSONDocument* document)
+{
+    item->Type      = JSON_None;
+    item->Name      = JSONEmptyString;
+    item->Value     = JSONEmptyString;
+    item->dValue    = 0.0;
+    item->pItems    = 0;
+    item->ItemCount = 0;
+    item->IndexMask = 0;
+    item->pIndex    = 0;
+    item->pDocument = document;
+}
+
+char* JSONDocumentParser::parseValue(char* buff, JSONValue* item, int depth)
+{
+	if (!buff)
+        return NULL;
+
+	if (!strncmp(buff,"null",4))
+    {
+        item->Type = JSON_Null;
+        return buff+4;
+    }
+	if (!strncmp(buff,"false",5))
+    { 
+        item->Type   = JSON_Bool;
+        item->Value  = "false";
+        item->dValue = 0;
+        return buff+5;
+    }
+	if (!strncmp(buff,"true",4))
+    {
+        item->Type   = JSON_Bool;
+        item->Value  = "true";
+        item->dValue = 1;
+        return buff+4;
+    }
+	if (*buff=='\"')
+    {
+        item->Type = JSON_String;
+        return parseString(buff, &item->Value);
+    }
+	if (*buff=='-' || (*buff>='0' && *buff<='9'))
+    { 
+        return parseNumber(buff, item);
+    }
+	if (*buff=='[' || *buff=='{')
+    {
+        if (depth >= JSONMaxDepth)
+            return assignError("Syntax Error: Nesting too deep");
+
+        return (*buff=='[') ? parseArray(buff, item, depth + 1) :
+                              parseObject(buff, item, depth + 1);
+    }
+
+    return assignError("Syntax Error: Invalid syntax");
+}
+
+// Strings are un-escaped in place, and out is pointed at the result.
+char* JSONDocumentParser::parseString(char* str, const char** out)
+{
+    if (*str!='\"')
+    {
+        return assignError("Syntax Error: Missing quote");
+    }
+
+    *out = str+1;
+    return (char*)UnescapeString(str+1, str+1);
+}
+
+// The number is followed by the next token, so its text is copied out.
+char* JSONDocumentParser::parseNumber(char* num, JSONValue* item)
+{
+    char* end = (char*)ParseNumberText(num, &item->dValue);
+    char* text = (char*)pDocument->alloc(end - num + 1);
+    if (!text)
+        return assignError("Error: Failed to allocate memory");
+
+    memcpy(text, num, end - num);
+    text[end - num] = 0;
+
+    item->Type  = JSON_Number;
+    item->Value = text;
+    return end;
+}
+
+char* JSONDocumentParser::parseArray(char* buff, JSONValue* item, int depth)
+{
+	item->Type=JSON_Array;
+	buff=skip(buff+1);
+	
+    if (*buff==']')
+        return buff+1;	// empty array.
+
+    UPInt first = Stack.GetSize();
+
+    while (true)
+    {
+        JSONValue child;
+        InitValue(&child, pDocument);
+
+		buff=skip(parseValue(skip(buff), &child, depth));
+		if (!buff)
+            return 0;
+
+        Stack.PushBack(child);
+
+        if (*buff!=',')
+            break;
+        buff++;
+    }
+
+	if (*buff!=']')
+        return assignError("Syntax Error: Missing ending bracket");
+
+    if (!moveItems(item, first))
+        return assignError("Error: Failed to allocate memory");
+    return buff+1;
+}
+
+char* JSONDocumentParser::parseObject(char* buff, JSONValue* item, int depth)
+{
+	item->Type=JSON_Object;
+	buff=skip(buff+1);
+
+	if (*buff=='}')
+        return buff+1;	// empty object.
+
+    UPInt first = Stack.GetSize();
+
+    while (true)
+    {
+        JSONValue child;
+        InitValue(&child, pDocument);
+
+		buff=skip(parseString(skip(buff), &child.Name));
+		if (!buff)
+            return 0;
+
+        if (*buff!=':')
+            return assignError("Syntax Error: Missing colon");
+
+		buff=skip(parseValue(skip(buff+1), &child, depth));
+		if (!buff)
+            return 0;
+
+        Stack.PushBack(child);
+
+        if (*buff!=',')
+            break;
+        buff++;
+    }
+
+	if (*buff!='}')
+        return assignError("Syntax Error: Missing closing brace");
+
+    if (!moveItems(item, first))
+        return assignError("Error: Failed to allocate memory");
+    return buff+1;
+}
+
+// Moves the children of item from the top of the stack into the arena.
+bool JSONDocumentParser::moveItems(JSONValue* item, UPInt first)
+{
+    UPInt count = Stack.GetSize() - first;
+
+    item->pItems = (JSONValue*)pDocument->alloc(count * sizeof(JSONValue));
+    if (!item->pItems)
+        return false;
+
+    memcpy(item->pItems, &Stack[first], count * sizeof(JSONValue));
+    item->ItemCount = (UInt32)count;
+    Stack.Resize(first);
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONValue
+
+const JSONValue* JSONValue::GetItemByName(const char* name) const
+{
+    if (Type == JSON_Object && ItemCount >= JSONIndexMinItems)
+    {
+        if (!pIndex)
+            buildIndex();
+
+        if (pIndex)
+        {
+            for (UInt32 slot = HashName(name) & IndexMask; pIndex[slot]; slot = (slot + 1) & IndexMask)
+            {
+                const JSONValue* item = pItems + pIndex[slot] - 1;
+                if (OVR_strcmp(item->Name, name) == 0)
+                    return item;
+            }
+            return 0;
+        }
+    }
+
+    for (UInt32 i = 0; i < ItemCount; i++)
+    {
+        if (OVR_strcmp(pItems[i].Name, name) == 0)
+            return pItems + i;
+    }
+    return 0;
+}
+
+// Builds an open addressing table at most half full. If allocation fails, pIndex stays
+// null and lookups fall back to a linear search.
+void JSONValue::buildIndex() const
+{
+    UInt32 size = 16;
+    while (size < ItemCount * 2)
+        size *= 2;
+
+    UInt32* index = (UInt32*)pDocument->alloc(size * sizeof(UInt32));
+    if (!index)
+        return;
+    memset(index, 0, size * sizeof(UInt32));
+
+    UInt32 mask = size - 1;
+    for (UInt32 i = 0; i < ItemCount; i++)
+    {
+        UInt32 slot = HashName(pItems[i].Name) & mask;
+        while (index[slot] && OVR_strcmp(pItems[index[slot] - 1].Name, pItems[i].Name) != 0)
+            slot = (slot + 1) & mask;
+
+        // Keep the first of duplicate names, as a linear search would find.
+        if (!index[slot])
+            index[slot] = i + 1;
+    }
+
+    IndexMask = mask;
+    pIndex    = index;
+}
+
+double JSONValue::GetArrayNumber(int index) const
+{
+    const JSONValue* number = (Type == JSON_Array) ? GetItemByIndex(index) : 0;
+    return number ? number->dValue : 0.0;
+}
+
+const char* JSONValue::GetArrayString(int index) const
+{
+    const JSONValue* string = (Type == JSON_Array) ? GetItemByIndex(index) : 0;
+    return string ? string->Value : 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONDocument
+
+JSONDocument::JSONDocument()
+    : pText(0), TextSize(0), pChunks(0), FirstChunkSize(4096), ArenaSize(0)
+{
+    JSONDocumentParser::InitValue(&Root, this);
+}
+
+JSONDocument::~JSONDocument()
+{
+    while (pChunks)
+    {
+        ArenaChunk* next = pChunks->pNext;
+        OVR_FREE(pChunks);
+        pChunks = next;
+    }
+    if (pText)
+        OVR_FREE(pText);
+}
+
+// Parses a copy of the supplied buffer. The returned document must be Released after use.
+JSONDocument* JSONDocument::Parse(const char* buff, const char** perror)
+{
+    if (!buff)
+    {
+        AssignError(perror, "Syntax Error: Invalid syntax");
+        return 0;
+    }
+
+    JSONDocument* document = new JSONDocument();
+    document->TextSize = OVR_strlen(buff);
+    document->pText    = (char*)OVR_ALLOC(document->TextSize + 1);
+    if (!document->pText)
+    {
+        AssignError(perror, "Error: Failed to allocate memory");
+        document->Release();
+        return 0;
+    }
+    memcpy(document->pText, buff, document->TextSize + 1);
+
+    if (!document->parse(perror))
+    {
+        document->Release();
+        return 0;
+    }
+    return document;
+}
+
+// Reads the file into the document's text buffer and parses it there.
+// The returned document must be Released after use.
+JSONDocument* JSONDocument::Load(const char* path, const char** perror)
+{
+    SysFile f;
+    if (!f.Open(path, File::Open_Read, File::Mode_Read))
+    {
+        AssignError(perror, "Failed to open file");
+        return NULL;
+    }
+
+    int len = f.GetLength();
+    if (len <= 0)
+    {
+        AssignError(perror, "Failed to read file");
+        return NULL;
+    }
+
+    JSONDocument* document = new JSONDocument();
+    document->TextSize = len;
+    document->pText    = (char*)OVR_ALLOC(len + 1);
+    if (!document->pText)
+    {
+        AssignError(perror, "Error: Failed to allocate memory");
+        document->Release();
+        return NULL;
+    }
+
+    int bytes = f.Read((UByte*)document->pText, len);
+    f.Close();
+
+    if (bytes != len)
+    {
+        AssignError(perror, "Failed to read file");
+        document->Release();
+        return NULL;
+    }
+    document->pText[len] = 0;
+
+    if (!document->parse(perror))
+    {
+        document->Release();
+        return NULL;
+    }
+    return document;
+}
+
+bool JSONDocument::parse(const char** perror)
+{
+    if (perror)
+        *perror = 0;
+
+    // Every value but the first follows a separator or an opening bracket, so this bounds
+    // the number of values; allow for the text of a short number in each.
+    UPInt valueCount = 1;
+    for (const char* p = pText; *p; p++)
+    {
+        if (*p == ',' || *p == '[' || *p == '{')
+            valueCount++;
+    }
+    FirstChunkSize = valueCount * (sizeof(JSONValue) + 8) + 4096;
+
+    JSONDocumentParser parser(this, perror);
+    return parser.parseValue(skip(pText), &Root, 0) != 0;
+}
+
+// Allocates from the arena, adding a chunk twice as large as the last one when it
+// is full; the first chunk is sized by parse, and is usually the only one.
+void* JSONDocument::alloc(UPInt size)
+{
+    const UPInt headerSize = (sizeof(ArenaChunk) + 7) & ~(UPInt)7;
+
+    size = (size + 7) & ~(UPInt)7;
+    if (!pChunks || pChunks->Used + size > pChunks->Size)
+    {
+        UPInt chunkSize = pChunks ? pChunks->Size * 2 : FirstChunkSize;
+        if (chunkSize < size)
+            chunkSize = size;
+
+        ArenaChunk* chunk = (ArenaChunk*)OVR_ALLOC(headerSize + chunkSize);
+        if (!chunk)
+            return 0;
+
+        chunk->pNext = pChunks;
+        chunk->Size  = chunkSize;
+        chunk->Used  = 0;
+        pChunks      = chunk;
+        ArenaSize   += headerSize + chunkSize;
+    }
+
+    void* p = (UByte*)pChunks + headerSize + pChunks->Used;
+    pChunks->Used += size;
+    return p;
+}
+
+UPInt JSONDocument::GetMemoryUsed() const
+{
+    return sizeof(JSONDocument) + (pText ? TextSize + 1 : 0) + ArenaSize;
+}
+
+static JSON* CopyToJSON(const JSONValue* value)
+{
+    JSON* json = JSON::CreateNull();
+    json->Type   = value->Type;
+    json->Value  = value->Value;
+    json->dValue = value->dValue;
+
+    for (const JSONValue* item = value->GetFirstItem(); item; item = value->GetNextItem(item))
+    {
+        if (value->Type == JSON_Object)
+            json->AddItem(item->Name, CopyToJSON(item));
+        else
+            json->AddArrayElement(CopyToJSON(item));
+    }
+    return json;
+}
+
+JSON* JSONDocument::CreateJSON() const
+{
+    return CopyToJSON(&Root);
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONReader
+
+JSONReader::JSONReader(File* file)
+    : pFile(file), BufferPos(0), BufferLength(0), Number(0.0),
+      Token(JSONToken_None), pError(0), State(State_Value), Depth(0)
+{
+    memset(ObjectBits, 0, sizeof(ObjectBits));
+}
+
+JSONToken JSONReader::Next()
+{
+    if (Token == JSONToken_Error || Token == JSONToken_End)
+        return Token;
+
+    int c = skipWhitespace();
+    switch (State)
+    {
+    case State_Value:
+        return readValue(c);
+
+    case State_FirstItem:
+        if (c == (isObject() ? '}' : ']'))
+            return endContainer();
+        return isObject() ? readName(c) : readValue(c);
+
+    case State_NextItem:
+        if (c == (isObject() ? '}' : ']'))
+            return endContainer();
+        if (c != ',')
+            return setError(isObject() ? "Syntax Error: Missing closing brace" :
+                                         "Syntax Error: Missing ending bracket");
+        BufferPos++;
+        c = skipWhitespace();
+        return isObject() ? readName(c) : readValue(c);
+
+    case State_Done:
+        break;
+    }
+
+    Token = JSONToken_End;
+    Text.Clear();
+    return Token;
+}
+
+bool JSONReader::Skip()
+{
+    if (Token == JSONToken_Name)
+        Next();
+
+    if (Token == JSONToken_BeginObject || Token == JSONToken_BeginArray)
+    {
+        int depth = Depth - 1;
+        while (Depth > depth)
+        {
+            if (Next() == JSONToken_Error)
+                return false;
+        }
+    }
+    return Token != JSONToken_Error;
+}
+
+int JSONReader::peekChar()
+{
+    if (BufferPos == BufferLength)
+    {
+        BufferPos    = 0;
+        BufferLength = pFile ? pFile->Read(Buffer, BufferSize) : 0;
+        if (BufferLength <= 0)
+        {
+            BufferLength = 0;
+            return -1;
+        }
+    }
+    return Buffer[BufferPos];
+}
+
+int JSONReader::skipWhitespace()
+{
+    int c = peekChar();
+    while (c >= 0 && c <= ' ')
+    {
+        BufferPos++;
+        c = peekChar();
+    }
+    return c;
+}
+
+bool JSONReader::isObject() const
+{
+    return (ObjectBits[(Depth - 1) >> 5] & (1u << ((Depth - 1) & 31))) != 0;
+}
+
+JSONToken JSONReader::readName(int c)
+{
+    if (c != '\"')
+        return setError("Syntax Error: Missing quote");
+    if (!readString())
+        return setError("Syntax Error: Missing closing quote");
+
+    if (skipWhitespace() != ':')
+        return setError("Syntax Error: Missing colon");
+    BufferPos++;
+
+    State = State_Value;
+    Token = JSONToken_Name;
+    return Token;
+}
+
+JSONToken JSONReader::readValue(int c)
+{
+    Text.Clear();
+
+    if (c == '{' || c == '[')
+    {
+        if (Depth >= MaxDepth)
+            return setError("Syntax Error: Nesting too deep");
+
+        if (c == '{')
+            ObjectBits[Depth >> 5] |= (1u << (Depth & 31));
+        else
+            ObjectBits[Depth >> 5] &= ~(1u << (Depth & 31));
+        Depth++;
+        BufferPos++;
+
+        State = State_FirstItem;
+        Token = (c == '{') ? JSONToken_BeginObject : JSONToken_BeginArray;
+        return Token;
+    }
+
+    if (c == '\"')
+    {
+        if (!readString())
+            return setError("Syntax Error: Missing closing quote");
+        Token = JSONToken_String;
+    }
+    else if (c == '-' || (c >= '0' && c <= '9'))
+    {
+        while (c >= 0 && strchr("0123456789+-.eE", c))
+        {
+            Text.PushBack((char)c);
+            BufferPos++;
+            c = peekChar();
+        }
+        Text.PushBack(0);
+
+        // Reject what parseNumber would stop short of, such as "1.e5".
+        const char* end = ParseNumberText(&Text[0], &Number);
+        if (*end)
+            return setError("Syntax Error: Invalid syntax");
+        Token = JSONToken_Number;
+    }
+    else if (c >= 'a' && c <= 'z')
+    {
+        while (c >= 'a' && c <= 'z')
+        {
+            Text.PushBack((char)c);
+            BufferPos++;
+            c = peekChar();
+        }
+        Text.PushBack(0);
+
+        if (!strcmp(&Text[0], "null"))
+            Token = JSONToken_Null;
+        else if (!strcmp(&Text[0], "true") || !strcmp(&Text[0], "false"))
+            Token = JSONToken_Bool;
+        else
+            return setError("Syntax Error: Invalid syntax");
+
+        Number = (Text[0] == 't') ? 1.0 : 0.0;
+    }
+    else
+    {
+        return setError("Syntax Error: Invalid syntax");
+    }
+
+    State = Depth ? State_NextItem : State_Done;
+    return Token;
+}
+
+// Collects the escaped string up to the closing quote, which may span several blocks,
+// and then decodes it in place.
+bool JSONReader::readString()
+{
+    Text.Clear();
+    BufferPos++;
+
+    while (true)
+    {
+        if (peekChar() < 0)
+            return false;
+
+        // Copy up to the next quote or escape in one go.
+        int start = BufferPos;
+        while (BufferPos < BufferLength && Buffer[BufferPos] != '\"' && Buffer[BufferPos] != '\\')
+            BufferPos++;
+        Text.Append((const char*)Buffer + start, BufferPos - start);
+
+        if (BufferPos == BufferLength)
+            continue;
+
+        if (Buffer[BufferPos++] == '\"')
+            break;
+
+        // Keep the escaped character with its backslash.
+        Text.PushBack('\\');
+        int c = peekChar();
+        if (c < 0)
+            return false;
+        Text.PushBack((char)c);
+        BufferPos++;
+    }
+
+    Text.PushBack(0);
+    UnescapeString(&Text[0], &Text[0]);
+    return true;
+}
+
+JSONToken JSONReader::endContainer()
+{
+    Token = isObject() ? JSONToken_EndObject : JSONToken_EndArray;
+    Depth--;
+    BufferPos++;
+
+    Text.Clear();
+    State = Depth ? State_NextItem : State_Done;
+    return Token;
+}
+
+JSONToken JSONReader::setError(const char* errorMessage)
+{
+    pError = errorMessage;
+    Token  = JSONToken_Error;
+    Text.Clear();
+    return Token;
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONWriter
+
+JSONWriter::JSONWriter(File* file, bool formatted)
+    : pFile(file), Formatted(formatted), Failed(false), BufferUsed(0), Depth(0)
+{
+    memset(ObjectBits, 0, sizeof(ObjectBits));
+    memset(ItemBits, 0, sizeof(ItemBits));
+}
+
+JSONWriter::~JSONWriter()
+{
+    Flush();
+}
+
+void JSONWriter::BeginObject(const char* name)
+{
+    beginContainer(name, '{', true);
+}
+
+void JSONWriter::EndObject()
+{
+    endContainer('}', true);
+}
+
+void JSONWriter::BeginArray(const char* name)
+{
+    beginContainer(name, '[', false);
+}
+
+void JSONWriter::EndArray()
+{
+    endContainer(']', false);
+}
+
+void JSONWriter::AddNullItem(const char* name)
+{
+    beginItem(name);
+    write("null", 4);
+}
+
+void JSONWriter::AddBoolItem(const char* name, bool b)
+{
+    beginItem(name);
+    if (b)
+        write("true", 4);
+    else
+        write("false", 5);
+}
+
+void JSONWriter::AddNumberItem(const char* name, double n)
+{
+    char str[32];
+    UPInt length = OVR_dtoa(n, str, sizeof(str));
+
+    beginItem(name);
+    write(str, length);
+}
+
+void JSONWriter::AddStringItem(const char* name, const char* s)
+{
+    beginItem(name);
+    writeString(s);
+}
+
+void JSONWriter::AddItem(const char* name, JSON* item)
+{
+    switch (item->Type)
+    {
+        case JSON_Null:     AddNullItem(name); break;
+        case JSON_Bool:     AddBoolItem(name, item->dValue != 0); break;
+        case JSON_Number:   AddNumberItem(name, item->dValue); break;
+        case JSON_String:   AddStringItem(name, item->Value); break;
+
+        case JSON_Array:
+            BeginArray(name);
+            for (JSON* child = item->GetFirstItem(); child; child = item->GetNextItem(child))
+                AddItem(0, child);
+            EndArray();
+            break;
+
+        case JSON_Object:
+            BeginObject(name);
+            for (JSON* child = item->GetFirstItem(); child; child = item->GetNextItem(child))
+                AddItem(child->Name, child);
+            EndObject();
+            break;
+
+        case JSON_None: OVR_ASSERT_LOG(false, ("Bad JSON type.")); break;
+    }
+}
+
+bool JSONWriter::Flush()
+{
+    flushBuffer();
+    if (pFile && !Failed && !pFile->Flush())
+        Failed = true;
+    return !Failed;
+}
+
+// Writes the separator from the previous item and, in objects, the name.
+void JSONWriter::beginItem(const char* name)
+{
+    if (Depth == 0)
+        return;
+
+    UInt32 bit    = 1u << ((Depth - 1) & 31);
+    bool   object = isObject();
+
+    if (ItemBits[(Depth - 1) >> 5] & bit)
+    {
+        write(',');
+        if (Formatted)
+            write(object ? '\n' : ' ');
+    }
+    ItemBits[(Depth - 1) >> 5] |= bit;
+
+    if (object)
+    {
+        if (Formatted)
+            writeTabs(Depth);
+        writeString(name ? name : "");
+        write(':');
+        if (Formatted)
+            write('\t');
+    }
+}
+
+void JSONWriter::beginContainer(const char* name, char open, bool object)
+{
+    beginItem(name);
+
+    if (Depth >= MaxDepth)
+    {
+        OVR_ASSERT_LOG(false, ("JSONWriter: nesting too deep."));
+        Failed = true;
+        return;
+    }
+
+    UInt32 bit = 1u << (Depth & 31);
+    if (object)
+        ObjectBits[Depth >> 5] |= bit;
+    else
+        ObjectBits[Depth >> 5] &= ~bit;
+    ItemBits[Depth >> 5] &= ~bit;
+    Depth++;
+
+    write(open);
+    if (object && Formatted)
+        write('\n');
+}
+
+// Objects close on a line of their own; an empty one is indented one level less, to
+// match the layout JSON::Save has always produced.
+void JSONWriter::endContainer(char close, bool object)
+{
+    OVR_ASSERT(Depth > 0 && isObject() == object);
+    if (Depth == 0)
+        return;
+
+    if (object && Formatted)
+    {
+        if (ItemBits[(Depth - 1) >> 5] & (1u << ((Depth - 1) & 31)))
+        {
+            write('\n');
+            writeTabs(Depth - 1);
+        }
+        else
+        {
+            writeTabs(Depth - 2);
+        }
+    }
+
+    Depth--;
+    write(close);
+}
+
+bool JSONWriter::isObject() const
+{
+    return (ObjectBits[(Depth - 1) >> 5] & (1u << ((Depth - 1) & 31))) != 0;
+}
+
+void JSONWriter::write(const char* text, UPInt length)
+{
+    while (length)
+    {
+        if (BufferUsed == BufferSize)
+            flushBuffer();
+
+        UPInt count = Alg::Min(length, (UPInt)(BufferSize - BufferUsed));
+        memcpy(Buffer + BufferUsed, text, count);
+        BufferUsed += (int)count;
+        text       += count;
+        length     -= count;
+    }
+}
+
+void JSONWriter::write(char c)
+{
+    if (BufferUsed == BufferSize)
+        flushBuffer();
+    Buffer[BufferUsed++] = (UByte)c;
+}
+
+void JSONWriter::writeTabs(int count)
+{
+    for (int i = 0; i < count; i++)
+        write('\t');
+}
+
+// Writes the string quoted, with the escapes of the original cJSON printer.
+void JSONWriter::writeString(const char* str)
+{
+    write('\"');
+
+    const char* ptr = str ? str : "";
+    while (*ptr)
+    {
+        const char* start = ptr;
+        while ((unsigned char)*ptr>31 && *ptr!='\"' && *ptr!='\\')
+            ptr++;
+        write(start, ptr - start);
+
+        if (!*ptr)
+            break;
+
+        unsigned char token = *ptr++;
+        char          escape[8];
+        escape[0] = '\\';
+        switch (token)
+        {
+            case '\\':	escape[1]='\\';	break;
+            case '\"':	escape[1]='\"';	break;
+            case '\b':	escape[1]='b';	break;
+            case '\f':	escape[1]='f';	break;
+            case '\n':	escape[1]='n';	break;
+            case '\r':	escape[1]='r';	break;
+            case '\t':	escape[1]='t';	break;
+            default:
+                OVR_sprintf(escape + 1, sizeof(escape) - 1, "u%04x", token);
+                write(escape, 6);
+                continue;
+        }
+        write(escape, 2);
+    }
+
+    write('\"');
+}
+
+void JSONWriter::flushBuffer()
+{
+    if (BufferUsed && !Failed)
+    {
+        if (!pFile || pFile->Write(Buffer, BufferUsed) != BufferUsed)
+            Failed = true;
     }
+    BufferUsed = 0;
 }
 
 }
@@ -32,9 +32,13 @@ limitations under the License.
 #include "Kernel/OVR_RefCount.h"
 #include "Kernel/OVR_String.h"
 #include "Kernel/OVR_List.h"
+#include "Kernel/OVR_Array.h"
 
 namespace OVR {  
 
+class File;
+class JSONReader;
+
 // JSONItemType describes the type of JSON item, specifying the type of
 // data that can be obtained from it.
 enum JSONItemType
@@ -83,11 +87,15 @@ public:
     // Returns null pointer and fills in *perror in case of parse error.
     static JSON*    Parse(const char* buff, const char** perror = 0);
 
-    // Loads and parses a JSON object from a file.
+    // Loads and parses a JSON object from a file, streaming it through a JSONReader.
     // Returns 0 and assigns perror with error message on fail.
     static JSON*    Load(const char* path, const char** perror = 0);
 
-    // Saves a JSON object to a file.
+    // Reads the next value of the reader into a new JSON object; on a syntax error,
+    // returns 0 and assigns perror with the error message of the reader.
+    static JSON*    Read(JSONReader* reader, const char** perror = 0);
+
+    // Saves a JSON object to a file through a JSONWriter.
     bool            Save(const char* path);
 
 
@@ -142,10 +150,288 @@ protected:
     const char*     parseArray(const char* value, const char** perror);
     const char*     parseObject(const char* value, const char** perror);
     const char*     parseString(const char* str, const char** perror);
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONValue
+
+// JSONValue is a read-only node of a JSONDocument. It has the same fields as JSON, except
+// that Name and Value are C strings owned by the document, so they must be compared with
+// OVR_strcmp rather than ==. As with JSON, Value holds the text of numbers, "true" or
+// "false" for booleans, and is empty for null, arrays and objects.
+//
+// The children of arrays and objects are stored contiguously, so indexed access is O(1).
+// Objects with more than a few members build a hash index on the first GetItemByName;
+// as with duplicate names in JSON, the first member with a name is returned.
+
+class JSONDocument;
+
+class JSONValue
+{
+    friend class JSONDocument;
+    friend class JSONDocumentParser;
+public:
+    JSONItemType    Type;
+    const char*     Name;
+    const char*     Value;
+    double          dValue;
+
+    // *** Object Member Access
+
+    bool             HasItems() const                 { return ItemCount != 0; }
+    unsigned         GetItemCount() const             { return ItemCount; }
+    const JSONValue* GetFirstItem() const             { return ItemCount ? pItems : 0; }
+    const JSONValue* GetLastItem() const              { return ItemCount ? pItems + ItemCount - 1 : 0; }
+    const JSONValue* GetNextItem(const JSONValue* item) const
+    { return (item + 1 < pItems + ItemCount) ? item + 1 : 0; }
+    const JSONValue* GetPrevItem(const JSONValue* item) const
+    { return (item > pItems) ? item - 1 : 0; }
+    const JSONValue* GetItemByIndex(unsigned i) const { return (i < ItemCount) ? pItems + i : 0; }
+    const JSONValue* GetItemByName(const char* name) const;
+
+    // *** Array Element Access
+
+    int             GetArraySize() const            { return (Type == JSON_Array) ? (int)ItemCount : 0; }
+    double          GetArrayNumber(int index) const;
+    const char*     GetArrayString(int index) const;
+
+private:
+    void            buildIndex() const;
+
+    JSONValue*          pItems;
+    UInt32              ItemCount;
+    mutable UInt32      IndexMask;  // Hash table size - 1, or 0 if not built.
+    mutable UInt32*     pIndex;     // Item index + 1 per slot, 0 for empty slots.
+    JSONDocument*       pDocument;  // For allocating the index.
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONDocument
+
+// JSONDocument parses JSON text into a tree of JSONValues that lives in a single arena,
+// for loading large files that are only read. The document keeps a copy of the text (or,
+// with Load, the file contents) and decodes strings in place, so that string names and
+// values point into it; only the text of numbers is copied into the arena. Parsing a
+// document makes a handful of allocations regardless of its size, where JSON::Parse makes
+// several per value.
+//
+// Use JSON for trees that are built or modified; CreateJSON copies a document into one.
+// Like JSON, a document must not be accessed from several threads at once.
+
+class JSONDocument : public RefCountBase<JSONDocument>
+{
+    friend class JSONValue;
+    friend class JSONDocumentParser;
+public:
+    ~JSONDocument();
+
+    // Returns null pointer and fills in *perror in case of parse error.
+    static JSONDocument* Parse(const char* buff, const char** perror = 0);
+    static JSONDocument* Load(const char* path, const char** perror = 0);
+
+    const JSONValue*     GetRoot() const         { return &Root; }
+
+    // Copies the document into a new JSON tree, which must be Released after use.
+    JSON*                CreateJSON() const;
+
+    // Memory held by the document: text and arena.
+    UPInt                GetMemoryUsed() const;
+
+private:
+    JSONDocument();
 
-    char*           PrintValue(int depth, bool fmt);
-    char*           PrintObject(int depth, bool fmt);
-    char*           PrintArray(int depth, bool fmt);
+    struct ArenaChunk
+    {
+        ArenaChunk* pNext;
+        UPInt       Size;
+        UPInt       Used;
+    };
+
+    bool            parse(const char** perror);
+    void*           alloc(UPInt size);
+
+    char*           pText;
+    UPInt           TextSize;
+    ArenaChunk*     pChunks;
+    UPInt           FirstChunkSize;
+    UPInt           ArenaSize;
+    JSONValue       Root;
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONReader
+
+// JSONToken describes the event returned by JSONReader::Next.
+enum JSONToken
+{
+    JSONToken_None,
+    JSONToken_BeginObject,
+    JSONToken_EndObject,
+    JSONToken_BeginArray,
+    JSONToken_EndArray,
+    JSONToken_Name,         // Name of the object member whose value follows.
+    JSONToken_Null,
+    JSONToken_Bool,
+    JSONToken_Number,
+    JSONToken_String,
+    JSONToken_End,          // The top level value is complete.
+    JSONToken_Error
+};
+
+// JSONReader is a pull parser that reads JSON text from a File in fixed size blocks
+// and returns it one token at a time, so that files of any size can be read in constant
+// memory; only the text of the current token is kept, in a buffer that grows to the
+// longest string. Reading stops at the first error, after which Next keeps returning
+// JSONToken_Error. Members are typically read as follows:
+//
+//      SysFile file(path);
+//      JSONReader reader(&file);
+//      if (reader.Next() == JSONToken_BeginObject)
+//      {
+//          while (reader.Next() == JSONToken_Name)
+//          {
+//              if (!OVR_strcmp(reader.GetString(), "Serial"))
+//                  serial = (reader.Next() == JSONToken_String) ? reader.GetString() : "";
+//              else
+//                  reader.Skip();
+//          }
+//      }
+
+class JSONReader
+{
+public:
+    JSONReader(File* file);
+
+    // Reads the next token; returns JSONToken_Error if the text is malformed.
+    JSONToken       Next();
+    // Skips the value that follows a Name token, or the rest of the object or array
+    // that the last token began. Returns false on error.
+    bool            Skip();
+
+    JSONToken       GetToken() const        { return Token; }
+    // Decoded text of a Name or String token, the text of a Number token, or "true"
+    // or "false" for a Bool token; valid until the next call to Next.
+    const char*     GetString() const       { return Text.GetSize() ? &Text[0] : ""; }
+    // Value of a Number token, or 0 or 1 for a Bool token.
+    double          GetNumber() const       { return Number; }
+    // Number of objects and arrays that enclose the next token.
+    int             GetDepth() const        { return Depth; }
+    // Message describing the error, or null.
+    const char*     GetError() const        { return pError; }
+
+private:
+    enum ReadState
+    {
+        State_Value,        // A value is expected.
+        State_FirstItem,    // After the opening of a container.
+        State_NextItem,     // After a member or element.
+        State_Done
+    };
+
+    enum
+    {
+        BufferSize = 4096,
+        MaxDepth   = 512
+    };
+
+    int             peekChar();
+    int             skipWhitespace();
+    bool            isObject() const;
+    JSONToken       readName(int c);
+    JSONToken       readValue(int c);
+    bool            readString();
+    JSONToken       endContainer();
+    JSONToken       setError(const char* errorMessage);
+
+    File*           pFile;
+    UByte           Buffer[BufferSize];
+    int             BufferPos;
+    int             BufferLength;
+
+    ArrayPOD<char>  Text;
+    double          Number;
+    JSONToken       Token;
+    const char*     pError;
+
+    ReadState       State;
+    int             Depth;
+    UInt32          ObjectBits[MaxDepth / 32];  // Bit per depth, set for objects.
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** JSONWriter
+
+// JSONWriter formats JSON text into a fixed size buffer, writing it to a File whenever
+// the buffer fills, so that documents of any size are written in constant memory. With
+// formatting enabled, the output is laid out the same way as by JSON::Save.
+//
+// Names are only used for the members of objects. Write failures are remembered, and
+// are reported by Flush, which is also called by the destructor.
+//
+//      JSONWriter writer(&file);
+//      writer.BeginObject();
+//      writer.AddStringItem("Serial", serial);
+//      writer.BeginArray("Offsets");
+//      writer.AddArrayNumber(0.5);
+//      writer.EndArray();
+//      writer.EndObject();
+//      bool ok = writer.Flush();
+
+class JSONWriter
+{
+public:
+    JSONWriter(File* file, bool formatted = true);
+    ~JSONWriter();
+
+    void            BeginObject(const char* name = 0);
+    void            EndObject();
+    void            BeginArray(const char* name = 0);
+    void            EndArray();
+
+    void            AddNullItem(const char* name);
+    void            AddBoolItem(const char* name, bool b);
+    void            AddNumberItem(const char* name, double n);
+    void            AddStringItem(const char* name, const char* s);
+    // Writes the tree of a JSON object.
+    void            AddItem(const char* name, JSON* item);
+
+    void            AddArrayNumber(double n)        { AddNumberItem(0, n); }
+    void            AddArrayString(const char* s)   { AddStringItem(0, s); }
+
+    // Writes out buffered text; returns false if any write has failed.
+    bool            Flush();
+    bool            IsValid() const                 { return !Failed; }
+
+private:
+    enum
+    {
+        BufferSize = 4096,
+        MaxDepth   = 512
+    };
+
+    void            beginItem(const char* name);
+    void            beginContainer(const char* name, char open, bool object);
+    void            endContainer(char close, bool object);
+    bool            isObject() const;
+    void            write(const char* text, UPInt length);
+    void            write(char c);
+    void            writeTabs(int count);
+    void            writeString(const char* str);
+    void            flushBuffer();
+
+    File*           pFile;
+    bool            Formatted;
+    bool            Failed;
+    UByte           Buffer[BufferSize];
+    int             BufferUsed;
+
+    int             Depth;
+    UInt32          ObjectBits[MaxDepth / 32];  // Bit per depth, set for objects.
+    UInt32          ItemBits[MaxDepth / 32];    // Bit per depth, set once an item is written.
 };
 
 
@@ -0,0 +1,178 @@
+/************************************************************************************
+
+Filename    :   OVR_LatencyTrace.cpp
+Content     :   Latency histograms for the stages of the sensor input pipeline
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "OVR_LatencyTrace.h"
+#include "Kernel/OVR_Alg.h"
+
+#ifdef OVR_ENABLE_LATENCY_TRACE
+#include "Kernel/OVR_Atomic.h"
+#include "Kernel/OVR_Timer.h"
+#endif
+
+namespace OVR {
+
+#ifdef OVR_ENABLE_LATENCY_TRACE
+
+// Histograms[0] holds the totals, since the ReportRead stage has no duration of its own.
+static Lock             TraceLock;
+static LatencyHistogram TraceHistograms[LatencyTrace_StageCount];
+static UInt64           TraceStageTicks[LatencyTrace_StageCount];
+
+static void recordStage(LatencyTraceStage stage, UInt64 ticks)
+{
+    UInt64 previous = TraceStageTicks[stage - 1];
+    if (previous != 0 && ticks >= previous)
+    {
+        TraceHistograms[stage].Record((UInt32) Alg::Min(ticks - previous, (UInt64) UINT_MAX));
+    }
+    TraceStageTicks[stage] = ticks;
+}
+
+void LatencyTrace::Mark(LatencyTraceStage stage)
+{
+    UInt64 ticks = Timer::GetTicks();
+
+    Lock::Locker lock(&TraceLock);
+    if (stage == LatencyTrace_ReportRead)
+    {
+        for (int i = 0; i < LatencyTrace_StageCount; i++)
+        {
+            TraceStageTicks[i] = 0;
+        }
+        TraceStageTicks[LatencyTrace_ReportRead] = ticks;
+    }
+    else
+    {
+        recordStage(stage, ticks);
+    }
+}
+
+LatencyTrace::Stamp LatencyTrace::MarkFused()
+{
+    UInt64 ticks = Timer::GetTicks();
+
+    Lock::Locker lock(&TraceLock);
+    recordStage(LatencyTrace_Fused, ticks);
+
+    // Samples that weren't dispatched from a traced report, e.g. replayed ones, get no
+    // stamp; the dispatch is used up so that such samples can't pick up an old one.
+    Stamp stamp;
+    if (TraceStageTicks[LatencyTrace_Dispatched] != 0)
+    {
+        stamp.ReportTicks = TraceStageTicks[LatencyTrace_ReportRead];
+        stamp.FusedTicks  = ticks;
+        TraceStageTicks[LatencyTrace_Dispatched] = 0;
+    }
+    return stamp;
+}
+
+void LatencyTrace::MarkConsumed(Stamp* stamp)
+{
+    if (stamp->FusedTicks == 0)
+    {
+        return;
+    }
+
+    UInt64 ticks = Timer::GetTicks();
+
+    Lock::Locker lock(&TraceLock);
+    if (ticks >= stamp->FusedTicks)
+    {
+        TraceHistograms[LatencyTrace_Consumed].Record(
+            (UInt32) Alg::Min(ticks - stamp->FusedTicks, (UInt64) UINT_MAX));
+        TraceHistograms[0].Record(
+            (UInt32) Alg::Min(ticks - stamp->ReportTicks, (UInt64) UINT_MAX));
+    }
+    *stamp = Stamp();
+}
+
+bool LatencyTrace::IsEnabled()
+{
+    return true;
+}
+
+bool LatencyTrace::GetStats(LatencyTraceStage stage, LatencyStats* stats)
+{
+    OVR_ASSERT(stage > LatencyTrace_ReportRead && stage < LatencyTrace_StageCount);
+
+    Lock::Locker lock(&TraceLock);
+    return TraceHistograms[stage].GetStats(stats);
+}
+
+bool LatencyTrace::GetTotalStats(LatencyStats* stats)
+{
+    Lock::Locker lock(&TraceLock);
+    return TraceHistograms[0].GetStats(stats);
+}
+
+void LatencyTrace::Reset()
+{
+    Lock::Locker lock(&TraceLock);
+    for (int i = 0; i < LatencyTrace_StageCount; i++)
+    {
+        TraceHistograms[i].Reset();
+    }
+}
+
+#else // OVR_ENABLE_LATENCY_TRACE
+
+void LatencyTrace::Mark(LatencyTraceStage)
+{
+}
+
+LatencyTrace::Stamp LatencyTrace::MarkFused()
+{
+    return Stamp();
+}
+
+void LatencyTrace::MarkConsumed(Stamp*)
+{
+}
+
+bool LatencyTrace::IsEnabled()
+{
+    return false;
+}
+
+bool LatencyTrace::GetStats(LatencyTraceStage, LatencyStats* stats)
+{
+    memset(stats, 0, sizeof(LatencyStats));
+    return false;
+}
+
+bool LatencyTrace::GetTotalStats(LatencyStats* stats)
+{
+    memset(stats, 0, sizeof(LatencyStats));
+    return false;
+}
+
+void LatencyTrace::Reset()
+{
+}
+
+#endif // OVR_ENABLE_LATENCY_TRACE
+
+} // OVR
@@ -0,0 +1,103 @@
+/************************************************************************************
+
+PublicHeader:   OVR.h
+Filename    :   OVR_LatencyTrace.h
+Content     :   Latency histograms for the stages of the sensor input pipeline
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_LatencyTrace_h
+#define OVR_LatencyTrace_h
+
+#include "Kernel/OVR_LatencyHistogram.h"
+
+namespace OVR {
+
+// Points of the input pipeline, in order, at which a sensor report is timestamped.
+enum LatencyTraceStage
+{
+    LatencyTrace_ReportRead,    // The HID report has been read from the device.
+    LatencyTrace_Decoded,       // The report has been decoded into a TrackerMessage.
+    LatencyTrace_Dispatched,    // A body frame from it is passed to the message handler.
+    LatencyTrace_Fused,         // SensorFusion has finished processing that body frame.
+    LatencyTrace_Consumed,      // The resulting orientation was read by GetOrientation.
+    LatencyTrace_StageCount
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** LatencyTrace
+
+// LatencyTrace measures where time goes between a sensor report arriving and the
+// application reading the orientation computed from it. Each stage records the time since
+// the previous stage of the same report into a LatencyHistogram; the Consumed stage is only
+// recorded the first time an orientation is read, so that it measures how old the newest
+// sample is when the application uses it rather than how often it polls.
+//
+// Tracing is compiled in only when OVR_ENABLE_LATENCY_TRACE is defined (see OVR_Types.h);
+// otherwise the OVR_LATENCY_TRACE macros expand to nothing, and GetStats always returns
+// false. The stages before Consumed are expected to run on the device manager thread, one
+// report at a time.
+
+class LatencyTrace
+{
+public:
+    // Times of a processed sample, kept by its consumer until the sample is read.
+    struct Stamp
+    {
+        UInt64  ReportTicks;
+        UInt64  FusedTicks;
+
+        Stamp() : ReportTicks(0), FusedTicks(0) { }
+    };
+
+    // Timestamps the stage of the report in progress; ReportRead starts a new report.
+    static void     Mark(LatencyTraceStage stage);
+    // Marks LatencyTrace_Fused and returns the times of the report for MarkConsumed.
+    static Stamp    MarkFused();
+    // Records the Consumed stage and the total for the stamp, once; clears the stamp.
+    static void     MarkConsumed(Stamp* stamp);
+
+    static bool     IsEnabled();
+
+    // Time taken to reach the stage from the one before it; stage must be after ReportRead.
+    static bool     GetStats(LatencyTraceStage stage, LatencyStats* stats);
+    // Time from the report being read to the application reading the orientation.
+    static bool     GetTotalStats(LatencyStats* stats);
+    static void     Reset();
+};
+
+// The stamp arguments are not evaluated when tracing is disabled, so the members that
+// hold them can be left out as well.
+#ifdef OVR_ENABLE_LATENCY_TRACE
+    #define OVR_LATENCY_TRACE(stage)                OVR::LatencyTrace::Mark(stage)
+    #define OVR_LATENCY_TRACE_FUSED(stamp)          ((stamp) = OVR::LatencyTrace::MarkFused())
+    #define OVR_LATENCY_TRACE_CONSUMED(stamp)       OVR::LatencyTrace::MarkConsumed(&(stamp))
+#else
+    #define OVR_LATENCY_TRACE(stage)                ((void)0)
+    #define OVR_LATENCY_TRACE_FUSED(stamp)          ((void)0)
+    #define OVR_LATENCY_TRACE_CONSUMED(stamp)       ((void)0)
+#endif
+
+} // OVR
+
+#endif
@@ -30,6 +30,7 @@ limitations under the License.
 #include <errno.h>
 #include <linux/hidraw.h>
 #include "OVR_HIDDeviceImpl.h"
+#include "OVR_LatencyTrace.h"
 
 namespace OVR { namespace Linux {
 
@@ -677,6 +678,7 @@ void HIDDevice::OnEvent(int i, int fd)
 // TODO: I need to handle partial messages and package reconstruction
         if (Handler)
         {
+            OVR_LATENCY_TRACE(LatencyTrace_ReportRead);
             Handler->OnInputReport(ReadBuffer, bytes);
         }
     }
@@ -0,0 +1,218 @@
+/************************************************************************************
+
+Filename    :   OVR_MultiSensorFusion.cpp
+Content     :   Combines the orientation estimates of several rigidly mounted sensors
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "OVR_MultiSensorFusion.h"
+#include "Kernel/OVR_Log.h"
+
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** MultiSensorFusion
+
+MultiSensorFusion::MultiSensorFusion()
+  : SensorCount(0), OutlierThreshold(0.05f), WorldYawValid(false), InlierCount(0)
+{
+}
+
+MultiSensorFusion::~MultiSensorFusion()
+{
+    for (int i = 0; i < SensorCount; i++)
+        delete Sensors[i].pFusion;
+}
+
+int MultiSensorFusion::AddSensor(SensorDevice* sensor, const Quatf& mounting)
+{
+    int index = AddSensor(mounting);
+    if (index < 0 || sensor == NULL)
+        return index;
+
+    if (!Sensors[index].pFusion->AttachToSensor(sensor))
+    {
+        delete Sensors[index].pFusion;
+        SensorCount--;
+        return -1;
+    }
+    return index;
+}
+
+int MultiSensorFusion::AddSensor(const Quatf& mounting)
+{
+    if (SensorCount >= MaxSensors)
+    {
+        OVR_DEBUG_LOG(("MultiSensorFusion::AddSensor failed - at most %d sensors are supported", (int)MaxSensors));
+        return -1;
+    }
+
+    SensorEntry& entry = Sensors[SensorCount];
+    entry.pFusion     = new SensorFusion();
+    entry.MountingInv = (SensorCount == 0) ? Quatf() : mounting.Normalized().Inverted();
+
+    Lock::Locker lockScope(&ResultLock);
+    WorldYaw[SensorCount] = Quatf();
+    WorldYawValid         = false;
+    return SensorCount++;
+}
+
+void MultiSensorFusion::OnMessage(int index, const MessageBodyFrame& msg)
+{
+    OVR_ASSERT(index >= 0 && index < SensorCount);
+    Sensors[index].pFusion->OnMessage(msg);
+}
+
+void MultiSensorFusion::Reset()
+{
+    for (int i = 0; i < SensorCount; i++)
+        Sensors[i].pFusion->Reset();
+
+    Lock::Locker lockScope(&ResultLock);
+    WorldYawValid = false;
+}
+
+Quatf MultiSensorFusion::GetOrientation() const
+{
+    return fuse(false);
+}
+
+Quatf MultiSensorFusion::GetPredictedOrientation() const
+{
+    return fuse(true);
+}
+
+double MultiSensorFusion::GetSampleTime() const
+{
+    double time = 0;
+    for (int i = 0; i < SensorCount; i++)
+    {
+        double sampleTime = Sensors[i].pFusion->GetSampleTime();
+        if (i == 0 || sampleTime < time)
+            time = sampleTime;
+    }
+    return time;
+}
+
+int MultiSensorFusion::collect(Quatf* estimates, bool predicted) const
+{
+    if (SensorCount == 0)
+        return 0;
+
+    // Past orientations come from each pipeline's history, future ones are predicted from
+    // each pipeline's latest sample; either way all estimates refer to the same instant
+    double time = predicted ? Sensors[0].pFusion->GetSampleTime() + Sensors[0].pFusion->GetPredictionDelta()
+                            : GetSampleTime();
+
+    for (int i = 0; i < SensorCount; i++)
+    {
+        SensorFusion* fusion = Sensors[i].pFusion;
+        Quatf q;
+        if (predicted)
+            q = fusion->GetPredictedOrientationAt(time);
+        else if (!fusion->GetOrientationAt(time, &q))
+            q = fusion->GetOrientation();
+        // World_i <- sensor_i <- reference body
+        estimates[i] = q * Sensors[i].MountingInv;
+    }
+
+    if (!WorldYawValid)
+    {
+        // Pipelines agree on gravity but not on yaw; once all of them are done aligning,
+        // successfully or not, capture the yaw rotation that brings each one onto the first
+        for (int i = 0; i < SensorCount; i++)
+            if (!Sensors[i].pFusion->IsAligned() && !Sensors[i].pFusion->IsAlignmentTimedOut())
+                return 1;
+
+        for (int i = 0; i < SensorCount; i++)
+        {
+            // Twist of the relative rotation about the vertical axis
+            Quatf rel = estimates[0] * estimates[i].Inverted();
+            Quatf yaw(0, rel.y, 0, rel.w);
+            WorldYaw[i] = (yaw.LengthSq() > 0) ? yaw.Normalized() : Quatf();
+        }
+        WorldYawValid = true;
+    }
+
+    for (int i = 0; i < SensorCount; i++)
+        estimates[i] = WorldYaw[i] * estimates[i];
+
+    return SensorCount;
+}
+
+Quatf MultiSensorFusion::fuse(bool predicted) const
+{
+    Lock::Locker lockScope(&ResultLock);
+
+    Quatf estimates[MaxSensors];
+    int   count = collect(estimates, predicted);
+    if (count == 0)
+    {
+        InlierCount = 0;
+        return Quatf();
+    }
+
+    // The medoid (estimate closest to all others) is robust against a single bad sensor
+    // and serves as the consensus the outliers are measured against
+    int   medoid   = 0;
+    float bestCost = 0;
+    float dot[MaxSensors][MaxSensors];
+    for (int i = 0; i < count; i++)
+    {
+        float cost = 0;
+        for (int j = 0; j < count; j++)
+        {
+            const Quatf& a = estimates[i];
+            const Quatf& b = estimates[j];
+            dot[i][j] = fabs(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+            cost += 1.0f - dot[i][j];
+        }
+        if (i == 0 || cost < bestCost)
+        {
+            bestCost = cost;
+            medoid   = i;
+        }
+    }
+
+    // Average the inliers on the medoid's hemisphere; for small spreads the normalized
+    // mean is an accurate approximation of the rotation mean
+    float minDot = cos(OutlierThreshold * 0.5f);
+    const Quatf& ref = estimates[medoid];
+    Quatf sum(0, 0, 0, 0);
+    int   inliers = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (dot[medoid][i] < minDot)
+            continue;
+
+        const Quatf& q = estimates[i];
+        float sign = (ref.x * q.x + ref.y * q.y + ref.z * q.z + ref.w * q.w) < 0 ? -1.0f : 1.0f;
+        sum += q * sign;
+        inliers++;
+    }
+
+    InlierCount = inliers;
+    return sum.Normalized();
+}
+
+
+} // namespace OVR
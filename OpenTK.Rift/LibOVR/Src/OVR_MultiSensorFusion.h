@@ -0,0 +1,133 @@
+/************************************************************************************
+
+PublicHeader:   OVR.h
+Filename    :   OVR_MultiSensorFusion.h
+Content     :   Combines the orientation estimates of several rigidly mounted sensors
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_MultiSensorFusion_h
+#define OVR_MultiSensorFusion_h
+
+#include "OVR_SensorFusion.h"
+
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** MultiSensorFusion
+
+// MultiSensorFusion tracks one rigid body (typically the HMD) with several sensors
+// mounted on it. Every sensor runs its own SensorFusion pipeline; the pipelines share
+// no state, so each one can be fed from its own thread. Queries read every pipeline at
+// the same time, map each estimate into the frame of the first sensor through its
+// mounting rotation, reject estimates that disagree with the consensus and average
+// the rest into a lower-noise orientation.
+//
+// The sensors stream independently, so at any moment their latest samples were taken
+// at different times. GetOrientation reads every pipeline's history at the latest time
+// all of them have a sample for, and GetPredictedOrientation predicts every pipeline
+// to the same absolute time.
+//
+// Mounting rotations transform vectors from the added sensor's frame into the frame of
+// the first sensor (the reference body frame); the first sensor's mounting is ignored.
+// The yaw of every pipeline starts out arbitrary, so the pipelines are related to the
+// first one by a yaw offset that is captured once all of them have aligned.
+
+class MultiSensorFusion : public NewOverrideBase
+{
+public:
+    enum
+    {
+        MaxSensors = 8
+    };
+
+    MultiSensorFusion();
+    ~MultiSensorFusion();
+
+    // Adds a sensor with the given mounting. The sensor is attached to its own
+    // SensorFusion. Returns the sensor index, or -1 if no more sensors fit or the
+    // sensor already has a message handler.
+    int         AddSensor(SensorDevice* sensor, const Quatf& mounting = Quatf());
+    // Adds a pipeline that will be fed manually through OnMessage.
+    int         AddSensor(const Quatf& mounting = Quatf());
+
+    int         GetSensorCount() const                  { return SensorCount; }
+    SensorFusion* GetSensorFusion(int index) const      { OVR_ASSERT(index >= 0 && index < SensorCount); return Sensors[index].pFusion; }
+
+    // Feeds a BodyFrame message to a manually driven pipeline.
+    void        OnMessage(int index, const MessageBodyFrame& msg);
+
+    // Resets all pipelines and the yaw offsets between them.
+    void        Reset();
+
+
+    // *** State Query
+
+    // Obtains the fused orientation of the reference body frame at GetSampleTime().
+    Quatf       GetOrientation() const;
+    // Obtains the fused orientation predicted for the first sensor's latest sample time
+    // plus its prediction delta, see SensorFusion::GetPredictedOrientation.
+    Quatf       GetPredictedOrientation() const;
+
+    // Obtains the host time (Timer::GetSeconds) that GetOrientation refers to: the time
+    // of the oldest among the pipelines' latest samples.
+    double      GetSampleTime() const;
+
+    // Number of estimates that were averaged into the last fused result.
+    int         GetInlierCount() const                  { return InlierCount; }
+
+
+    // *** Configuration
+
+    // Estimates further than this angle (radians) from the consensus are rejected.
+    void        SetOutlierThreshold(float angle)        { OutlierThreshold = angle; }
+    float       GetOutlierThreshold() const             { return OutlierThreshold; }
+
+private:
+    // Reads every pipeline at one time, maps the orientations into the common world and
+    // body frames and returns the number of usable estimates; only the first one is
+    // usable until all have aligned.
+    int         collect(Quatf* estimates, bool predicted) const;
+    Quatf       fuse(bool predicted) const;
+
+    struct SensorEntry
+    {
+        SensorFusion* pFusion;
+        Quatf         MountingInv;
+    };
+
+    SensorEntry     Sensors[MaxSensors];
+    int             SensorCount;
+    float           OutlierThreshold;
+
+    // Updated by the (const) queries; guarded by ResultLock.
+    mutable Lock    ResultLock;
+    mutable bool    WorldYawValid;
+    // Rotates each pipeline's world frame into the first one's.
+    mutable Quatf   WorldYaw[MaxSensors];
+    mutable int     InlierCount;
+};
+
+
+} // namespace OVR
+
+#endif
@@ -24,6 +24,7 @@ limitations under the License.
 *************************************************************************************/
 
 #include "OVR_OSX_HIDDevice.h"
+#include "OVR_LatencyTrace.h"
 
 #include <IOKit/usb/IOUSBLib.h>
 
@@ -778,6 +779,7 @@ void HIDDevice::hidReportCallback(UByte* pData, UInt32 length)
     // We got data.
     if (Handler)
     {
+        OVR_LATENCY_TRACE(LatencyTrace_ReportRead);
         Handler->OnInputReport(pData, length);
     }
 }
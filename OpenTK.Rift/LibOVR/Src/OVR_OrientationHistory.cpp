@@ -0,0 +1,131 @@
+/************************************************************************************
+
+Filename    :   OVR_OrientationHistory.cpp
+Content     :   Timestamped orientation history of a SensorFusion
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "OVR_OrientationHistory.h"
+
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** OrientationHistory
+
+OrientationHistory::OrientationHistory()
+  : Head(0), Start(0), LastTime(0)
+{
+}
+
+void OrientationHistory::Add(double time, const Quatf& q, const Vector3f& angVel)
+{
+    UInt32 head = Head;
+    if (head != Start && time <= LastTime)
+        return;
+
+    Sample& s = Samples[head % Capacity];
+    s.Time   = time;
+    s.Q      = q;
+    s.AngVel = angVel;
+    LastTime = time;
+
+    // Publish the sample only once it is completely written
+    Head.Store_Release(head + 1);
+}
+
+void OrientationHistory::Clear()
+{
+    Start.Store_Release(Head);
+}
+
+bool OrientationHistory::GetRange(double* oldest, double* newest) const
+{
+    Sample first, last;
+    for (int attempt = 0; attempt < 4; attempt++)
+    {
+        UInt32 head  = Head.Load_Acquire();
+        UInt32 count = head - Start.Load_Acquire();
+        // The slot after the newest sample may be in the middle of being rewritten
+        if (count > Capacity - 1)
+            count = Capacity - 1;
+        if (count < 2)
+            return false;
+
+        first = Samples[(head - count) % Capacity];
+        last  = Samples[(head - 1) % Capacity];
+
+        // Full barrier: the sample reads above must complete before Head is read again
+        if (Head.ExchangeAdd_Sync(0) - (head - count) < Capacity)
+        {
+            *oldest = first.Time;
+            *newest = last.Time;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OrientationHistory::GetSampleAt(double time, Sample* sample) const
+{
+    Sample a, b;
+    for (int attempt = 0; attempt < 4; attempt++)
+    {
+        UInt32 head  = Head.Load_Acquire();
+        UInt32 count = head - Start.Load_Acquire();
+        if (count > Capacity - 1)
+            count = Capacity - 1;
+        if (count < 2)
+            return false;
+
+        // Binary search for the last sample at or before the requested time. The times
+        // read here may be torn by the writer; the pair is validated below.
+        UInt32 first = head - count;
+        UInt32 lo = 0, hi = count - 1;
+        while (lo + 1 < hi)
+        {
+            UInt32 mid = (lo + hi) / 2;
+            if (Samples[(first + mid) % Capacity].Time <= time)
+                lo = mid;
+            else
+                hi = mid;
+        }
+
+        a = Samples[(first + lo) % Capacity];
+        b = Samples[(first + hi) % Capacity];
+
+        if (Head.ExchangeAdd_Sync(0) - first >= Capacity)
+            continue;
+
+        if (time < a.Time || time > b.Time)
+            return false;
+
+        float s = (b.Time > a.Time) ? (float)((time - a.Time) / (b.Time - a.Time)) : 0.0f;
+        sample->Time   = time;
+        sample->Q      = a.Q.Slerp(b.Q, s);
+        sample->AngVel = a.AngVel.Lerp(b.AngVel, s);
+        return true;
+    }
+    return false;
+}
+
+
+} // namespace OVR
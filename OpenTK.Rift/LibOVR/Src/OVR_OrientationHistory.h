@@ -0,0 +1,94 @@
+/************************************************************************************
+
+PublicHeader:   OVR.h
+Filename    :   OVR_OrientationHistory.h
+Content     :   Timestamped orientation history of a SensorFusion
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_OrientationHistory_h
+#define OVR_OrientationHistory_h
+
+#include "Kernel/OVR_Math.h"
+#include "Kernel/OVR_Atomic.h"
+
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** OrientationHistory
+
+// OrientationHistory retains the most recent orientation states of a SensorFusion,
+// each stamped with its absolute sample time, so that the orientation at a past time
+// (e.g. the time a frame was rendered) can be recovered for reprojection or to match
+// tracking against other timestamped input.
+//
+// There is a single writer, the thread that feeds the fusion. Queries do not lock and
+// may run on any thread: they read a pair of samples and then check that the writer has
+// not wrapped around onto them in the meantime, retrying if it has.
+class OrientationHistory
+{
+public:
+    enum
+    {
+        // A little over one second of samples at the 1000 Hz sensor rate.
+        Capacity = 1024
+    };
+
+    struct Sample
+    {
+        double   Time;
+        Quatf    Q;
+        Vector3f AngVel;
+    };
+
+    OrientationHistory();
+
+    // *** Writer
+
+    // Appends a sample. Times must increase; samples that do not are dropped.
+    void    Add(double time, const Quatf& q, const Vector3f& angVel);
+    // Forgets all samples, e.g. after the orientation was reset.
+    void    Clear();
+
+    // *** Readers
+
+    // Obtains the time span covered by the history. Returns false if it holds fewer
+    // than two samples.
+    bool    GetRange(double* oldest, double* newest) const;
+    // Obtains the state at the given time, interpolated between the two samples around
+    // it. Returns false if the time is outside of the retained window.
+    bool    GetSampleAt(double time, Sample* sample) const;
+
+private:
+    // Number of samples written so far (the next sample goes to slot Head % Capacity),
+    // and the value Head had at the last Clear. Both only ever increase.
+    mutable AtomicInt<UInt32> Head;
+    AtomicInt<UInt32>   Start;
+    double              LastTime;
+
+    Sample              Samples[Capacity];
+};
+
+
+} // namespace OVR
+
+#endif
@@ -0,0 +1,312 @@
+/************************************************************************************
+
+Filename    :   OVR_PredictionMonitor.cpp
+Content     :   Measures the error of served orientation predictions
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "OVR_PredictionMonitor.h"
+#include "Kernel/OVR_Alg.h"
+
+#if defined(OVR_CPU_SSE)
+#include <xmmintrin.h>
+#endif
+
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** PredictionErrorStats
+
+void PredictionErrorStats::Clear()
+{
+    for (int s = 0; s < SpeedBins; s++)
+    {
+        Count[s]     = 0;
+        MeanError[s] = 0;
+        MaxError[s]  = 0;
+        for (int e = 0; e < ErrorBins; e++)
+            Histogram[s][e] = 0;
+    }
+    Dropped = 0;
+}
+
+float PredictionErrorStats::GetSpeedBinStart(int bin)
+{
+    static const float starts[SpeedBins] = { 0.0f, 0.25f, 0.5f, 1.0f, 2.0f, 4.0f };
+    OVR_ASSERT(bin >= 0 && bin < SpeedBins);
+    return starts[bin];
+}
+
+float PredictionErrorStats::GetErrorBinEnd(int bin)
+{
+    // 0.05, 0.1, 0.2, 0.5, 1, 2 and 5 degrees
+    static const float ends[ErrorBins - 1] =
+        { 0.000873f, 0.001745f, 0.003491f, 0.008727f, 0.017453f, 0.034907f, 0.087266f };
+    OVR_ASSERT(bin >= 0 && bin < ErrorBins);
+    return (bin < ErrorBins - 1) ? ends[bin] : Mathf::MaxValue;
+}
+
+int PredictionErrorStats::SpeedBin(float speed)
+{
+    int bin = 0;
+    while (bin < SpeedBins - 1 && speed >= GetSpeedBinStart(bin + 1))
+        bin++;
+    return bin;
+}
+
+int PredictionErrorStats::ErrorBin(float error)
+{
+    int bin = 0;
+    while (bin < ErrorBins - 1 && error >= GetErrorBinEnd(bin))
+        bin++;
+    return bin;
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** PredictionMonitor
+
+PredictionMonitor::PredictionMonitor()
+  : PendingCount(0), NextSequence(0), EnableAdaptation(false)
+{
+    ResetAdaptation();
+}
+
+void PredictionMonitor::ResetAdaptation()
+{
+    HorizonScale     = 1.0f;
+    Damping          = 1.0f;
+    CandidateSamples = 0;
+    for (int i = 0; i < CandidateCount; i++)
+        CandidateError[i] = 0;
+}
+
+Vector3f PredictionMonitor::rotation(const Vector3f& angVel, const Vector3f& angAcc, float dt,
+                                     float horizonScale, float damping)
+{
+    // Rotation vector of w(t) = angVel + angAcc * t over [0, h], including the
+    // coning term from the rotation axis turning during the interval
+    float h = dt * horizonScale;
+    return angVel * h + angAcc * (0.5f * damping * h * h) +
+           angVel.Cross(angAcc) * (damping * h * h * h / 12.0f);
+}
+
+Quatf PredictionMonitor::rotate(const Quatf& q, const Vector3f& rotation)
+{
+    float angle = rotation.Length();
+    if (angle < 1e-6f)
+        return q;
+    return q * Quatf(rotation / angle, angle);
+}
+
+void PredictionMonitor::Extrapolate(const Quatf& q, const Vector3f& angVel, const Vector3f& angAcc,
+                                    const float* dts, int count, Quatf* orientations) const
+{
+    int i = 0;
+#if defined(OVR_CPU_SSE)
+    OVR_COMPILER_ASSERT(sizeof(Quatf) == 4 * sizeof(float));
+
+    // rotation() with the coefficients of each power of h broadcast across the lanes
+    const Vector3f acc  = angAcc * (0.5f * Damping);
+    const Vector3f cone = angVel.Cross(angAcc) * (Damping / 12.0f);
+    const __m128 wx = _mm_set1_ps(angVel.x), wy = _mm_set1_ps(angVel.y), wz = _mm_set1_ps(angVel.z);
+    const __m128 ax = _mm_set1_ps(acc.x),    ay = _mm_set1_ps(acc.y),    az = _mm_set1_ps(acc.z);
+    const __m128 cx = _mm_set1_ps(cone.x),   cy = _mm_set1_ps(cone.y),   cz = _mm_set1_ps(cone.z);
+    const __m128 qx = _mm_set1_ps(q.x), qy = _mm_set1_ps(q.y), qz = _mm_set1_ps(q.z), qw = _mm_set1_ps(q.w);
+    const __m128 scale   = _mm_set1_ps(HorizonScale);
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    const __m128 half    = _mm_set1_ps(0.5f);
+    // (pi/2)^2; up to this half angle the series below are accurate to float precision
+    const __m128 limit   = _mm_set1_ps(2.4674011f);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 h  = _mm_mul_ps(_mm_loadu_ps(dts + i), scale);
+        __m128 h2 = _mm_mul_ps(h, h);
+        __m128 h3 = _mm_mul_ps(h2, h);
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, h), _mm_mul_ps(ax, h2)), _mm_mul_ps(cx, h3));
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wy, h), _mm_mul_ps(ay, h2)), _mm_mul_ps(cy, h3));
+        __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wz, h), _mm_mul_ps(az, h2)), _mm_mul_ps(cz, h3));
+
+        // Square of the half angle; cos and sin(a)/a of the half angle by their series
+        __m128 x = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)),
+                                         _mm_mul_ps(rz, rz)), quarter);
+        __m128 cosA = _mm_set1_ps(-1.0f / 3628800);
+        cosA = _mm_add_ps(_mm_mul_ps(cosA, x), _mm_set1_ps(1.0f / 40320));
+        cosA = _mm_add_ps(_mm_mul_ps(cosA, x), _mm_set1_ps(-1.0f / 720));
+        cosA = _mm_add_ps(_mm_mul_ps(cosA, x), _mm_set1_ps(1.0f / 24));
+        cosA = _mm_add_ps(_mm_mul_ps(cosA, x), _mm_set1_ps(-0.5f));
+        cosA = _mm_add_ps(_mm_mul_ps(cosA, x), _mm_set1_ps(1.0f));
+        __m128 sinc = _mm_set1_ps(-1.0f / 39916800);
+        sinc = _mm_add_ps(_mm_mul_ps(sinc, x), _mm_set1_ps(1.0f / 362880));
+        sinc = _mm_add_ps(_mm_mul_ps(sinc, x), _mm_set1_ps(-1.0f / 5040));
+        sinc = _mm_add_ps(_mm_mul_ps(sinc, x), _mm_set1_ps(1.0f / 120));
+        sinc = _mm_add_ps(_mm_mul_ps(sinc, x), _mm_set1_ps(-1.0f / 6));
+        sinc = _mm_add_ps(_mm_mul_ps(sinc, x), _mm_set1_ps(1.0f));
+
+        // Delta quaternion (r / |r| * sin(|r| / 2), cos(|r| / 2))
+        __m128 s  = _mm_mul_ps(sinc, half);
+        __m128 dx = _mm_mul_ps(rx, s), dy = _mm_mul_ps(ry, s), dz = _mm_mul_ps(rz, s), dw = cosA;
+
+        // q * delta
+        __m128 ox = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qw, dx), _mm_mul_ps(qx, dw)), _mm_mul_ps(qy, dz)), _mm_mul_ps(qz, dy));
+        __m128 oy = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(qw, dy), _mm_mul_ps(qx, dz)), _mm_mul_ps(qy, dw)), _mm_mul_ps(qz, dx));
+        __m128 oz = _mm_add_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(qw, dz), _mm_mul_ps(qx, dy)), _mm_mul_ps(qy, dx)), _mm_mul_ps(qz, dw));
+        __m128 ow = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(qw, dw), _mm_mul_ps(qx, dx)), _mm_mul_ps(qy, dy)), _mm_mul_ps(qz, dz));
+
+        _MM_TRANSPOSE4_PS(ox, oy, oz, ow);
+        float* out = &orientations[i].x;
+        _mm_storeu_ps(out,      ox);
+        _mm_storeu_ps(out + 4,  oy);
+        _mm_storeu_ps(out + 8,  oz);
+        _mm_storeu_ps(out + 12, ow);
+
+        // Rotations past half a turn are redone exactly
+        int wide = _mm_movemask_ps(_mm_cmpgt_ps(x, limit));
+        for (int j = 0; wide; j++, wide >>= 1)
+            if (wide & 1)
+                orientations[i + j] = rotate(q, GetRotation(angVel, angAcc, dts[i + j]));
+    }
+#endif
+    for (; i < count; i++)
+        orientations[i] = rotate(q, GetRotation(angVel, angAcc, dts[i]));
+}
+
+void PredictionMonitor::Record(double targetTime, const Quatf& q, const Vector3f& angVel,
+                               const Vector3f& angAcc, float dt)
+{
+    // Renderers that stop consuming their predictions must not grow the log. Evicting
+    // the oldest keeps the evaluated samples representative of recent predictions.
+    int slot = PendingCount;
+    if (PendingCount == MaxPending)
+    {
+        slot = 0;
+        for (int i = 1; i < PendingCount; i++)
+            if ((SInt32)(Pending[i].Sequence - Pending[slot].Sequence) < 0)
+                slot = i;
+        Stats.Dropped++;
+    }
+    else
+    {
+        PendingCount++;
+    }
+
+    PendingPrediction& p = Pending[slot];
+    p.TargetTime = targetTime;
+    p.Q          = q;
+    p.AngVel     = angVel;
+    p.AngAcc     = angAcc;
+    p.DT         = dt;
+    p.Sequence   = NextSequence++;
+}
+
+void PredictionMonitor::Update(double sampleTime, const Quatf& qPrev, const Vector3f& rate, float dt)
+{
+    double prevTime = sampleTime - dt;
+    float  rateL    = rate.Length();
+
+    for (int i = 0; i < PendingCount; )
+    {
+        const PendingPrediction& p = Pending[i];
+        if (p.TargetTime > sampleTime)
+        {
+            i++;
+            continue;
+        }
+
+        // The orientation at the target time, within the step that crosses it
+        float step  = (float)Alg::Max(p.TargetTime - prevTime, 0.0) * rateL;
+        Quatf truth = (step > 0) ? qPrev * Quatf(rate, step) : qPrev;
+        evaluate(p, truth);
+
+        Pending[i] = Pending[--PendingCount];
+    }
+}
+
+void PredictionMonitor::evaluate(const PendingPrediction& p, const Quatf& truth)
+{
+    // Motion that actually happened over the prediction interval, in the body frame
+    Quatf actual = p.Q.Inverted() * truth;
+
+    int candidates = EnableAdaptation ? CandidateCount : 1;
+    for (int c = 0; c < candidates; c++)
+    {
+        const float scaleStep   = 0.05f;
+        const float dampingStep = 0.1f;
+
+        float scale   = HorizonScale + ((c == 1) ? -scaleStep : (c == 2) ? scaleStep : 0);
+        float damping = Damping + ((c == 3) ? -dampingStep : (c == 4) ? dampingStep : 0);
+
+        Vector3f r     = rotation(p.AngVel, p.AngAcc, p.DT, scale, damping);
+        float    angle = r.Length();
+        Quatf    predicted = (angle > 0) ? Quatf(r / angle, angle) : Quatf();
+
+        Quatf    e     = predicted.Inverted() * actual;
+        float    sinH  = sqrt(e.x * e.x + e.y * e.y + e.z * e.z);
+        float    error = 2.0f * asin(Alg::Min(sinH, 1.0f));
+
+        if (c == 0)
+        {
+            int s = PredictionErrorStats::SpeedBin(p.AngVel.Length());
+            Stats.Count[s]++;
+            Stats.MeanError[s] += (error - Stats.MeanError[s]) / Stats.Count[s];
+            Stats.MaxError[s]   = Alg::Max(Stats.MaxError[s], error);
+            Stats.Histogram[s][PredictionErrorStats::ErrorBin(error)]++;
+        }
+        CandidateError[c] += error;
+    }
+
+    if (EnableAdaptation && ++CandidateSamples == AdaptBatchSize)
+        adapt();
+}
+
+void PredictionMonitor::adapt()
+{
+    const float scaleRate   = 0.025f;
+    const float dampingRate = 0.05f;
+    // Near the optimum the differences are mostly noise; require a clear improvement
+    // so the factors settle instead of wandering
+    const float margin      = 0.99f;
+
+    // Move half a candidate step toward the better neighbor, if either improved on
+    // the current setting
+    float current = CandidateError[0] * margin;
+    if (CandidateError[1] < current && CandidateError[1] <= CandidateError[2])
+        HorizonScale -= scaleRate;
+    else if (CandidateError[2] < current)
+        HorizonScale += scaleRate;
+
+    if (CandidateError[3] < current && CandidateError[3] <= CandidateError[4])
+        Damping -= dampingRate;
+    else if (CandidateError[4] < current)
+        Damping += dampingRate;
+
+    HorizonScale = Alg::Clamp(HorizonScale, 0.5f, 1.5f);
+    Damping      = Alg::Clamp(Damping, 0.0f, 1.0f);
+
+    CandidateSamples = 0;
+    for (int i = 0; i < CandidateCount; i++)
+        CandidateError[i] = 0;
+}
+
+
+} // namespace OVR
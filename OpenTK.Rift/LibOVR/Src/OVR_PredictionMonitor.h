@@ -0,0 +1,163 @@
+/************************************************************************************
+
+PublicHeader:   OVR.h
+Filename    :   OVR_PredictionMonitor.h
+Content     :   Measures the error of served orientation predictions
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_PredictionMonitor_h
+#define OVR_PredictionMonitor_h
+
+#include "Kernel/OVR_Math.h"
+
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** PredictionErrorStats
+
+// Prediction error statistics, binned by the head angular speed at the time the
+// prediction was made. Errors are angles in radians.
+struct PredictionErrorStats
+{
+    enum
+    {
+        SpeedBins = 6,
+        ErrorBins = 8
+    };
+
+    UInt32  Count[SpeedBins];
+    float   MeanError[SpeedBins];
+    float   MaxError[SpeedBins];
+    UInt32  Histogram[SpeedBins][ErrorBins];
+    // Predictions evicted from a full log before they could be evaluated.
+    UInt32  Dropped;
+
+    PredictionErrorStats() { Clear(); }
+    void    Clear();
+
+    // Lower edge of a speed bin in rad/s; the last bin is open ended.
+    static float GetSpeedBinStart(int bin);
+    // Upper edge of an error bin in radians; the last bin is open ended.
+    static float GetErrorBinEnd(int bin);
+
+    static int   SpeedBin(float speed);
+    static int   ErrorBin(float error);
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** PredictionMonitor
+
+// PredictionMonitor logs every prediction served by SensorFusion together with its
+// target time. Once the sensor stream has passed the target, the prediction is compared
+// with the integrated orientation at that time and the error is added to the stats.
+//
+// When adaptation is enabled, every logged prediction is also replayed with slightly
+// different horizon scale and damping factors (the damping scales the angular
+// acceleration term), and the factors drift toward whichever setting produced lower
+// errors over the last batch of evaluations.
+class PredictionMonitor
+{
+public:
+    enum
+    {
+        MaxPending     = 64,
+        AdaptBatchSize = 256
+    };
+
+    PredictionMonitor();
+
+    // Logs a prediction made at the given sample orientation q: angVel and angAcc are the
+    // bias-free body rates it extrapolated and dt the lookahead it used, before scaling.
+    // When the log is full, the oldest prediction is evicted and counted as dropped.
+    void    Record(double targetTime, const Quatf& q, const Vector3f& angVel,
+                   const Vector3f& angAcc, float dt);
+
+    // Called for each sensor sample before the orientation advances from qPrev, at
+    // sampleTime - dt, to the next sample at sampleTime by the body rate rate.
+    void    Update(double sampleTime, const Quatf& qPrev, const Vector3f& rate, float dt);
+
+    // Drops the logged predictions, e.g. after the orientation was reset.
+    void    DiscardPending()                        { PendingCount = 0; }
+
+    // Rotation vector a prediction extrapolates over dt with the current factors.
+    Vector3f GetRotation(const Vector3f& angVel, const Vector3f& angAcc, float dt) const
+    {
+        return rotation(angVel, angAcc, dt, HorizonScale, Damping);
+    }
+
+    // Extrapolates q by each of the count lookaheads in dts with the current factors,
+    // i.e. q rotated by GetRotation(angVel, angAcc, dts[i]); evaluated four at a time.
+    void    Extrapolate(const Quatf& q, const Vector3f& angVel, const Vector3f& angAcc,
+                        const float* dts, int count, Quatf* orientations) const;
+
+    const PredictionErrorStats& GetStats() const    { return Stats; }
+    void    ClearStats()                            { Stats.Clear(); }
+
+    void    SetAdaptationEnabled(bool enable)       { EnableAdaptation = enable; }
+    bool    IsAdaptationEnabled() const             { return EnableAdaptation; }
+    float   GetHorizonScale() const                 { return HorizonScale; }
+    float   GetDamping() const                      { return Damping; }
+    // Restores the factors to 1, which is the plain second order prediction.
+    void    ResetAdaptation();
+
+private:
+    enum
+    {
+        // Current factors, then horizon scale down/up, then damping down/up
+        CandidateCount = 5
+    };
+
+    struct PendingPrediction
+    {
+        double   TargetTime;
+        Quatf    Q;
+        Vector3f AngVel;
+        Vector3f AngAcc;
+        float    DT;
+        UInt32   Sequence;      // Order of recording, to find the oldest
+    };
+
+    static Vector3f rotation(const Vector3f& angVel, const Vector3f& angAcc, float dt,
+                             float horizonScale, float damping);
+    static Quatf    rotate(const Quatf& q, const Vector3f& rotation);
+    void    evaluate(const PendingPrediction& p, const Quatf& truth);
+    void    adapt();
+
+    PendingPrediction Pending[MaxPending];
+    int     PendingCount;
+    UInt32  NextSequence;
+
+    PredictionErrorStats Stats;
+
+    bool    EnableAdaptation;
+    float   HorizonScale;
+    float   Damping;
+    int     CandidateSamples;
+    float   CandidateError[CandidateCount];
+};
+
+
+} // namespace OVR
+
+#endif
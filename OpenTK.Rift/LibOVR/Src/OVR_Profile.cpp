@@ -33,6 +33,7 @@ limitations under the License.
 
 #include "OVR_Profile.h"
 #include "OVR_JSON.h"
+#include "OVR_StoreCache.h"
 #include "Kernel/OVR_Types.h"
 #include "Kernel/OVR_SysFile.h"
 #include "Kernel/OVR_Allocator.h"
@@ -53,6 +54,7 @@ limitations under the License.
 
 #define PROFILE_VERSION 1.0
 #define MAX_PROFILE_MAJOR_VERSION 1
+#define PROFILE_STORE_KIND 1
 
 namespace OVR {
 
@@ -137,10 +139,92 @@ String GetProfilePath(bool create_dir)
 //-----------------------------------------------------------------------------
 // ***** ProfileManager
 
+// A property of a profile in the store cache.
+struct ProfileStoreRecord
+{
+    UInt32  Section;    // The device object the property is in, or "" for the base profile.
+    UInt32  Name;
+    UInt32  Value;
+};
+
+// Compiles the profile file into a StoreCache with an entry per profile, keyed by name.
+// Only the first device object of each name is kept, as that's the one LoadCache used.
+static bool CompileProfileStore(const JSONValue* root, StoreCacheBuilder* builder)
+{
+    if (root->GetItemCount() < 3)
+        return false;
+
+    // First read the file type and version to make sure this is a valid file
+    const JSONValue* item0 = root->GetFirstItem();
+    const JSONValue* item1 = root->GetNextItem(item0);
+    const JSONValue* item2 = root->GetNextItem(item1);
+
+    if (OVR_strcmp(item0->Name, "Oculus Profile Version") != 0)
+        return false;
+    if (atoi(item0->Value) > MAX_PROFILE_MAJOR_VERSION)
+        return false;   // don't parse the file on unsupported major version number
+
+    builder->SetHeaderString(item1->Value);
+
+    // Read the number of profiles
+    int              profileCount = (int)item2->dValue;
+    const JSONValue* profileItem  = item2;
+
+    for (int p=0; p<profileCount; p++)
+    {
+        profileItem = root->GetNextItem(profileItem);
+        if (profileItem == NULL)
+            break;
+        if (OVR_strcmp(profileItem->Name, "Profile") != 0)
+            continue;
+
+        // Read the required Name field
+        const JSONValue* item = profileItem->GetFirstItem();
+        if (!item || OVR_strcmp(item->Name, "Name") != 0)
+            break;   // invalid field
+
+        builder->AddEntry(item->Value);
+
+        ArrayPOD<const char*> sections;
+        while (item = profileItem->GetNextItem(item), item)
+        {
+            ProfileStoreRecord record;
+            if (item->Type != JSON_Object)
+            {
+                record.Section = 0;
+                record.Name    = builder->AddString(item->Name);
+                record.Value   = builder->AddString(item->Value);
+                builder->AddRecord(&record);
+                continue;
+            }
+
+            bool seen = false;
+            for (UPInt i = 0; i < sections.GetSize() && !seen; i++)
+                seen = (OVR_strcmp(sections[i], item->Name) == 0);
+            if (seen || item->Name[0] == 0)
+                continue;
+            sections.PushBack(item->Name);
+
+            UInt32 section = builder->AddString(item->Name);
+            for (const JSONValue* deviceItem = item->GetFirstItem(); deviceItem;
+                 deviceItem = item->GetNextItem(deviceItem))
+            {
+                record.Section = section;
+                record.Name    = builder->AddString(deviceItem->Name);
+                record.Value   = builder->AddString(deviceItem->Value);
+                builder->AddRecord(&record);
+            }
+        }
+    }
+
+    return true;
+}
+
 ProfileManager::ProfileManager()
 {
     Changed = false;
     CacheDevice = Profile_Unknown;
+    StoreOpened = false;
 }
 
 ProfileManager::~ProfileManager()
@@ -195,97 +279,70 @@ void ProfileManager::ClearCache()
     CacheDevice = Profile_Unknown;
 }
 
-// Poplulates the local profile cache.  This occurs on the first access of the profile
-// data.  All profile operations are performed against the local cache until the
-// ProfileManager is released or goes out of scope at which time the cache is serialized
-// to disk.
-void ProfileManager::LoadCache(ProfileType device)
+// Opens the binary cache of the profile file on first use; the same copy of the profiles
+// is then used for the lifetime of the ProfileManager.
+StoreCache* ProfileManager::OpenStore()
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    ClearCache();
-
-    String path = GetProfilePath(false);
-
-    Ptr<JSON> root = *JSON::Load(path);
-    if (!root || root->GetItemCount() < 3)
-        return;
-
-    // First read the file type and version to make sure this is a valid file
-    JSON* item0 = root->GetFirstItem();
-    JSON* item1 = root->GetNextItem(item0);
-    JSON* item2 = root->GetNextItem(item1);
-
-    if (item0->Name == "Oculus Profile Version")
+    if (!StoreOpened)
     {
-        int major = atoi(item0->Value.ToCStr());
-        if (major > MAX_PROFILE_MAJOR_VERSION)
-            return;   // don't parse the file on unsupported major version number
+        Store = *StoreCache::Open(GetProfilePath(false), PROFILE_STORE_KIND,
+                                  sizeof(ProfileStoreRecord), CompileProfileStore);
+        StoreOpened = true;
     }
-    else
-    {
-        return;
-    }
-
-    DefaultProfile = item1->Value;
+    return Store;
+}
 
-    // Read the number of profiles
-    int   profileCount = (int)item2->dValue;
-    JSON* profileItem  = item2;
+// Creates the profile of a store entry for the given device.
+Profile* ProfileManager::LoadStoreProfile(ProfileType device, int index)
+{
+    const char* deviceName = 0;
+    Profile*    profile    = CreateProfileObject(Store->GetKey(index), device, &deviceName);
+    if (profile == NULL)
+        return NULL;
 
-    for (int p=0; p<profileCount; p++)
+    // Read the base profile fields, and those of the matching device.
+    for (int i = 0; i < Store->GetRecordCount(index); i++)
     {
-        profileItem = root->GetNextItem(profileItem);
-        if (profileItem == NULL)
+        const ProfileStoreRecord* record = (const ProfileStoreRecord*)Store->GetRecord(index, i);
+        if (record == NULL)
             break;
 
-        if (profileItem->Name == "Profile")
-        {
-            // Read the required Name field
-            const char* profileName;
-            JSON* item = profileItem->GetFirstItem();
-        
-            if (item && (item->Name == "Name"))
-            {   
-                profileName = item->Value;
-            }
-            else
-            {
-                return;   // invalid field
-            }
+        const char* section = Store->GetString(record->Section);
+        if (section[0] == 0 || (deviceName && OVR_strcmp(section, deviceName) == 0))
+            profile->ParseProperty(Store->GetString(record->Name), Store->GetString(record->Value));
+    }
+    return profile;
+}
 
-            const char*   deviceName  = 0;
-            bool          deviceFound = false;
-            Ptr<Profile>  profile     = *CreateProfileObject(profileName, device, &deviceName);
+// Loads the profiles for the device into the local cache, unless it already holds them
+// or holds changes that haven't been saved.
+void ProfileManager::PrepareCache(ProfileType device)
+{
+    if (CacheDevice == Profile_Unknown || (CacheDevice != device && !Changed))
+        LoadCache(device);
+}
 
-            // Read the base profile fields.
-            if (profile)
-            {
-                while (item = profileItem->GetNextItem(item), item)
-                {
-                    if (item->Type != JSON_Object)
-                    {
-                        profile->ParseProperty(item->Name, item->Value);
-                    }
-                    else
-                    {   // Search for the matching device to get device specific fields
-                        if (!deviceFound && deviceName && OVR_strcmp(item->Name, deviceName) == 0)
-                        {
-                            deviceFound = true;
+// Poplulates the local profile cache.  This occurs on the first access of the profile
+// data.  All profile operations are performed against the local cache until the
+// ProfileManager is released or goes out of scope at which time the cache is serialized
+// to disk.
+void ProfileManager::LoadCache(ProfileType device)
+{
+    Lock::Locker lockScope(&ProfileLock);
 
-                            for (JSON* deviceItem = item->GetFirstItem(); deviceItem;
-                                 deviceItem = item->GetNextItem(deviceItem))
-                            {
-                                profile->ParseProperty(deviceItem->Name, deviceItem->Value);
-                            }
-                        }
-                    }
-                }
-            }
+    ClearCache();
 
-            // Add the new profile
-            ProfileCache.PushBack(profile);
-        }
+    if (!OpenStore())
+        return;
+
+    DefaultProfile = Store->GetHeaderString();
+
+    for (int i = 0; i < Store->GetEntryCount(); i++)
+    {
+        Ptr<Profile> profile = *LoadStoreProfile(device, i);
+        ProfileCache.PushBack(profile);
     }
 
     CacheDevice = device;
@@ -446,6 +503,7 @@ void ProfileManager::SaveCache()
 
     // Save the profile to disk
     root->Save(path);
+    StoreCache::Invalidate(path);
 }
 
 // Returns the number of stored profiles for this device type
@@ -453,8 +511,7 @@ int ProfileManager::GetProfileCount(ProfileType device)
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (CacheDevice == Profile_Unknown)
-        LoadCache(device);
+    PrepareCache(device);
 
     return (int)ProfileCache.GetSize();
 }
@@ -466,8 +523,7 @@ const char* ProfileManager::GetProfileName(ProfileType device, unsigned int inde
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (CacheDevice == Profile_Unknown)
-        LoadCache(device);
+    PrepareCache(device);
 
     if (index < ProfileCache.GetSize())
     {
@@ -485,8 +541,10 @@ bool ProfileManager::HasProfile(ProfileType device, const char* name)
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (CacheDevice == Profile_Unknown)
-        LoadCache(device);
+    if (!Changed && OpenStore())
+        return Store->FindEntry(name) >= 0;
+
+    PrepareCache(device);
 
     for (unsigned i = 0; i< ProfileCache.GetSize(); i++)
     {
@@ -504,8 +562,7 @@ Profile* ProfileManager::LoadProfile(ProfileType device, unsigned int index)
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (CacheDevice == Profile_Unknown)
-        LoadCache(device);
+    PrepareCache(device);
 
     if (index < ProfileCache.GetSize())
     {
@@ -527,9 +584,15 @@ Profile* ProfileManager::LoadProfile(ProfileType device, const char* user)
         return NULL;
 
     Lock::Locker lockScope(&ProfileLock);
-    
-    if (CacheDevice == Profile_Unknown)
-        LoadCache(device);
+
+    // Without changes, the profile can be read from the store without loading the others
+    if (!Changed && OpenStore())
+    {
+        int index = Store->FindEntry(user);
+        return (index >= 0) ? LoadStoreProfile(device, index) : NULL;
+    }
+
+    PrepareCache(device);
 
     for (unsigned int i=0; i<ProfileCache.GetSize(); i++)
     {
@@ -555,8 +618,16 @@ const char* ProfileManager::GetDefaultProfileName(ProfileType device)
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (CacheDevice == Profile_Unknown)
-        LoadCache(device);
+    if (!Changed && OpenStore())
+    {
+        if (Store->GetEntryCount() == 0)
+            return NULL;
+
+        OVR_strcpy(NameBuff, Profile::MaxNameLen, Store->GetHeaderString());
+        return NameBuff;
+    }
+
+    PrepareCache(device);
 
     if (ProfileCache.GetSize() > 0)
     {
@@ -574,8 +645,7 @@ bool ProfileManager::SetDefaultProfileName(ProfileType device, const char* name)
 {
     Lock::Locker lockScope(&ProfileLock);
 
-    if (CacheDevice == Profile_Unknown)
-        LoadCache(device);
+    PrepareCache(device);
 // TODO: I should verify that the user is valid
     if (ProfileCache.GetSize() > 0)
     {
@@ -599,9 +669,7 @@ bool ProfileManager::Save(const Profile* profile)
     if (OVR_strcmp(profile->Name, "default") == 0)
         return false;  // don't save a default profile
 
-    // TODO: I should also verify that this profile type matches the current cache
-    if (CacheDevice == Profile_Unknown)
-        LoadCache(profile->Type);
+    PrepareCache(profile->Type);
 
     // Look for the pre-existence of this profile
     bool added = false;
@@ -643,8 +711,7 @@ bool ProfileManager::Delete(const Profile* profile)
     if (OVR_strcmp(profile->Name, "default") == 0)
         return false;  // don't delete a default profile
 
-    if (CacheDevice == Profile_Unknown)
-        LoadCache(profile->Type);
+    PrepareCache(profile->Type);
 
     // Look for the existence of this profile
     for (unsigned int i=0; i<ProfileCache.GetSize(); i++)
@@ -698,12 +765,12 @@ bool Profile::ParseProperty(const char* prop, const char* sval)
     }
     else if (OVR_strcmp(prop, "PlayerHeight") == 0)
     {
-        PlayerHeight = (float)atof(sval);
+        PlayerHeight = OVR_strtof(sval, NULL);
         return true;
     }
     else if (OVR_strcmp(prop, "IPD") == 0)
     {
-        IPD = (float)atof(sval);
+        IPD = OVR_strtof(sval, NULL);
         return true;
     }
 
@@ -49,6 +49,7 @@ enum ProfileType
 };
 
 class Profile;
+class StoreCache;
 
 // -----------------------------------------------------------------------------
 // ***** ProfileManager
@@ -58,7 +59,9 @@ class Profile;
 // The scope of the ProfileManager object defines when disk I/O is performed.  Disk
 // reads are performed on the first profile access and disk writes are performed when
 // the ProfileManager goes out of scope.  All profile interactions between these times
-// are performed in local memory and are fast.  A typical profile interaction might
+// are performed in local memory and are fast.  Until profiles are changed, they are read
+// from a binary cache of the profile file (see StoreCache), where they can be looked up by
+// name without loading the others.  A typical profile interaction might
 // look like this:
 //
 // {
@@ -76,6 +79,8 @@ protected:
     // Synchronize ProfileManager access since it may be accessed from multiple threads,
     // as it's shared through DeviceManager.
     Lock                    ProfileLock;
+    Ptr<StoreCache>         Store;
+    bool                    StoreOpened;
     Array<Ptr<Profile> >    ProfileCache;
     ProfileType             CacheDevice;
     String                  DefaultProfile;
@@ -100,6 +105,9 @@ public:
 protected:
     ProfileManager();
     ~ProfileManager();
+    StoreCache*         OpenStore();
+    Profile*            LoadStoreProfile(ProfileType device, int index);
+    void                PrepareCache(ProfileType device);
     void                LoadCache(ProfileType device);
     void                SaveCache();
     void                ClearCache();
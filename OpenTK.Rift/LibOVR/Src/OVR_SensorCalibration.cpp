@@ -0,0 +1,106 @@
+/************************************************************************************
+
+Filename    :   OVR_SensorCalibration.cpp
+Content     :   Online learned sensor calibration models
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "OVR_SensorCalibration.h"
+#include "Kernel/OVR_Alg.h"
+
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** GyroTempCalibration
+
+GyroTempCalibration::GyroTempCalibration(float minTemperature, float binWidth)
+  : MinTemperature(minTemperature), BinWidth(binWidth)
+{
+    OVR_ASSERT(binWidth > 0);
+    Clear();
+}
+
+void GyroTempCalibration::Clear()
+{
+    for (int i = 0; i < BinCount; i++)
+    {
+        Bins[i].Bias   = Vector3f();
+        Bins[i].Weight = 0;
+    }
+}
+
+bool GyroTempCalibration::IsEmpty() const
+{
+    for (int i = 0; i < BinCount; i++)
+        if (Bins[i].Weight > 0)
+            return false;
+    return true;
+}
+
+int GyroTempCalibration::binIndex(float temperature) const
+{
+    int i = (int)floor((temperature - MinTemperature) / BinWidth);
+    return Alg::Clamp(i, 0, (int)BinCount - 1);
+}
+
+void GyroTempCalibration::Update(const Vector3f& gyro, float temperature)
+{
+    Bin& bin = Bins[binIndex(temperature)];
+    if (bin.Weight < MaxWeight)
+        bin.Weight += 1;
+    bin.Bias += (gyro - bin.Bias) / bin.Weight;
+}
+
+bool GyroTempCalibration::GetBias(float temperature, Vector3f* bias) const
+{
+    // Position in units of bins, relative to the center of the first one
+    float pos = (temperature - MinTemperature) / BinWidth - 0.5f;
+
+    // Closest populated bins at or below and above the temperature
+    int lower = -1, upper = -1;
+    for (int i = 0; i < BinCount; i++)
+    {
+        if (Bins[i].Weight <= 0)
+            continue;
+        if (i <= pos)
+            lower = i;
+        else if (upper < 0)
+            upper = i;
+    }
+
+    if (lower < 0 && upper < 0)
+        return false;
+
+    if (lower < 0)
+        *bias = Bins[upper].Bias;
+    else if (upper < 0)
+        *bias = Bins[lower].Bias;
+    else
+    {
+        float f = (temperature - binCenter(lower)) / (binCenter(upper) - binCenter(lower));
+        *bias = Bins[lower].Bias.Lerp(Bins[upper].Bias, f);
+    }
+    return true;
+}
+
+
+} // namespace OVR
@@ -0,0 +1,91 @@
+/************************************************************************************
+
+PublicHeader:   OVR.h
+Filename    :   OVR_SensorCalibration.h
+Content     :   Online learned sensor calibration models
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_SensorCalibration_h
+#define OVR_SensorCalibration_h
+
+#include "Kernel/OVR_Math.h"
+
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** GyroTempCalibration
+
+// GyroTempCalibration models the gyro zero-rate offset as a function of the sensor
+// temperature. The temperature range is split into fixed width bins, each holding a
+// running average of the gyro readings taken while the device was stationary at that
+// temperature. Queries interpolate linearly between the centers of populated bins and
+// clamp to the closest populated bin outside of them.
+class GyroTempCalibration
+{
+public:
+    enum
+    {
+        BinCount  = 16,
+        // Caps the weight of a bin so that it keeps adapting to slow sensor aging.
+        MaxWeight = 5000
+    };
+
+    struct Bin
+    {
+        Vector3f Bias;
+        float    Weight;    // Number of samples averaged into Bias, up to MaxWeight.
+    };
+
+    // Default bins span 15 to 55 degrees Celsius.
+    GyroTempCalibration(float minTemperature = 15.0f, float binWidth = 2.5f);
+
+    void        Clear();
+    bool        IsEmpty() const;
+
+    // Adds a gyro reading taken while the device was at rest at the given temperature.
+    void        Update(const Vector3f& gyro, float temperature);
+
+    // Obtains the bias estimate at the given temperature. Returns false, leaving
+    // bias unchanged, if no bin has been populated yet.
+    bool        GetBias(float temperature, Vector3f* bias) const;
+
+    float       GetMinTemperature() const   { return MinTemperature; }
+    float       GetBinWidth() const         { return BinWidth; }
+
+    // Raw bin access, used to persist the table.
+    const Bin&  GetBin(int i) const         { OVR_ASSERT(i >= 0 && i < BinCount); return Bins[i]; }
+    void        SetBin(int i, const Bin& b) { OVR_ASSERT(i >= 0 && i < BinCount); Bins[i] = b; }
+
+private:
+    int         binIndex(float temperature) const;
+    float       binCenter(int i) const      { return MinTemperature + (i + 0.5f) * BinWidth; }
+
+    float       MinTemperature;
+    float       BinWidth;
+    Bin         Bins[BinCount];
+};
+
+
+} // namespace OVR
+
+#endif
@@ -26,103 +26,200 @@ limitations under the License.
 *************************************************************************************/
 
 #include "OVR_SensorFilter.h"
+#include "Kernel/OVR_Alg.h"
 
 namespace OVR {
 
-Vector3f SensorFilter::Median() const
-{
-    int half_window = Count / 2;
-    float* sortx = (float*) OVR_ALLOC(Count * sizeof(float));
-    float* sorty = (float*) OVR_ALLOC(Count * sizeof(float));
-    float* sortz = (float*) OVR_ALLOC(Count * sizeof(float));
-    float resultx = 0.0f, resulty = 0.0f, resultz = 0.0f;
+//-------------------------------------------------------------------------------------
+// ***** Savitzky-Golay weights
 
-    for (int i = 0; i < Count; i++) 
+void SensorFilter_SavitzkyGolayWeights(float* weights, int window, int order, int derivative)
+{
+    enum { MaxTerms = SavitzkyGolayWeights<1, 0>::MaxOrder + 1 };
+    OVR_ASSERT(order >= 0 && order < window && order < MaxTerms && derivative >= 0 && derivative <= order);
+
+    // Sample i sits at t = (i - (window - 1)) * scale, so the newest one is at t = 0 and
+    // the window spans [-1, 0], which keeps the normal equations well conditioned.
+    int    terms = order + 1;
+    double scale = (window > 1) ? 1.0 / (window - 1) : 1.0;
+
+    // Normal equations G c = A^T y, with G = A^T A and A[i][j] = t_i^j
+    double g[MaxTerms][2 * MaxTerms];
+    for (int j = 0; j < terms; j++)
+        for (int k = 0; k < 2 * terms; k++)
+            g[j][k] = 0;
+    for (int i = 0; i < window; i++)
     {
-        sortx[i] = Elements[i].x;
-        sorty[i] = Elements[i].y;
-        sortz[i] = Elements[i].z;
+        double t = (i - (window - 1)) * scale;
+        double tj = 1;
+        for (int j = 0; j < terms; j++, tj *= t)
+        {
+            double tk = 1;
+            for (int k = 0; k < terms; k++, tk *= t)
+                g[j][k] += tj * tk;
+        }
     }
-    for (int j = 0; j <= half_window; j++) 
+
+    // Invert G in place by Gauss-Jordan elimination with partial pivoting
+    for (int j = 0; j < terms; j++)
+        g[j][terms + j] = 1;
+    for (int col = 0; col < terms; col++)
     {
-        int minx = j;
-        int miny = j;
-        int minz = j;
-        for (int k = j + 1; k < Count; k++) 
+        int pivot = col;
+        for (int r = col + 1; r < terms; r++)
+            if (fabs(g[r][col]) > fabs(g[pivot][col]))
+                pivot = r;
+        for (int k = 0; k < 2 * terms; k++)
+            Alg::Swap(g[col][k], g[pivot][k]);
+
+        double inv = 1.0 / g[col][col];
+        for (int k = 0; k < 2 * terms; k++)
+            g[col][k] *= inv;
+        for (int r = 0; r < terms; r++)
         {
-            if (sortx[k] < sortx[minx]) minx = k;
-            if (sorty[k] < sorty[miny]) miny = k;
-            if (sortz[k] < sortz[minz]) minz = k;
+            if (r == col)
+                continue;
+            double f = g[r][col];
+            for (int k = 0; k < 2 * terms; k++)
+                g[r][k] -= f * g[col][k];
         }
-        const float tempx = sortx[j];
-        const float tempy = sorty[j];
-        const float tempz = sortz[j];
-        sortx[j] = sortx[minx];
-        sortx[minx] = tempx;
+    }
 
-        sorty[j] = sorty[miny];
-        sorty[miny] = tempy;
+    // The derivative at t = 0 is derivative! * c[derivative], and c = G^-1 A^T y
+    double factor = 1;
+    for (int d = 2; d <= derivative; d++)
+        factor *= d;
+    for (int d = 0; d < derivative; d++)
+        factor *= scale;
 
-        sortz[j] = sortz[minz];
-        sortz[minz] = tempz;
+    for (int i = 0; i < window; i++)
+    {
+        double t  = (i - (window - 1)) * scale;
+        double w  = 0;
+        double tj = 1;
+        for (int j = 0; j < terms; j++, tj *= t)
+            w += g[derivative][terms + j] * tj;
+        weights[i] = (float)(w * factor);
     }
-    resultx = sortx[half_window];
-    resulty = sorty[half_window];
-    resultz = sortz[half_window];
+}
 
-    OVR_FREE(sortx);
-    OVR_FREE(sorty);
-    OVR_FREE(sortz);
 
-    return Vector3f(resultx, resulty, resultz);
+//-------------------------------------------------------------------------------------
+// ***** SensorFilter statistics
+
+// Picks the element whose rank is n / 2 by counting, for each candidate, the elements
+// below and equal to it. The comparisons don't branch, which beats selection or sorting
+// at the window sizes used for sensor data, where those mispredict on every other step.
+float SensorFilter_Median(const float* a, int n)
+{
+    OVR_ASSERT(n > 0);
+    int k = n / 2;
+    for (int i = 0; i < n; i++)
+    {
+        float v = a[i];
+        int   less = 0, equal = 0;
+        for (int j = 0; j < n; j++)
+        {
+            less  += a[j] < v;
+            equal += a[j] == v;
+        }
+        if (less <= k && k < less + equal)
+            return v;
+    }
+    return a[k];
 }
 
-//  Only the diagonal of the covariance matrix.
-Vector3f SensorFilter::Variance() const
+// The deviations are taken from the running mean, which may be off by round-off;
+// subtracting (sum d)^2 / n corrects for that exactly.
+Vector3f SensorFilter_SumSquares(const float* x, const float* y, const float* z, int n,
+                                 const Vector3f& mean)
 {
-    Vector3f mean = Mean();
-    Vector3f total = Vector3f(0.0f, 0.0f, 0.0f);
-    for (int i = 0; i < Count; i++) 
+    Vector3f sum, sumSq;
+    for (int i = 0; i < n; i++)
     {
-        total.x += (Elements[i].x - mean.x) * (Elements[i].x - mean.x);
-        total.y += (Elements[i].y - mean.y) * (Elements[i].y - mean.y);
-        total.z += (Elements[i].z - mean.z) * (Elements[i].z - mean.z);
+        Vector3f d(x[i] - mean.x, y[i] - mean.y, z[i] - mean.z);
+        sum   += d;
+        sumSq += Vector3f(d.x * d.x, d.y * d.y, d.z * d.z);
     }
-    return total / (float) Count;
+    return sumSq - Vector3f(sum.x * sum.x, sum.y * sum.y, sum.z * sum.z) / (float)n;
 }
 
-// Should be a 3x3 matrix returned, but OVR_math.h doesn't have one
-Matrix4f SensorFilter::Covariance() const
+Matrix3f SensorFilter_CoMoment(const float* x, const float* y, const float* z, int n,
+                               const Vector3f& mean)
 {
-    Vector3f mean = Mean();
-    Matrix4f total = Matrix4f(0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0);
-    for (int i = 0; i < Count; i++) 
+    Vector3f sum;
+    float    xx = 0, yy = 0, zz = 0, xy = 0, yz = 0, zx = 0;
+    for (int i = 0; i < n; i++)
     {
-        total.M[0][0] += (Elements[i].x - mean.x) * (Elements[i].x - mean.x);
-        total.M[1][0] += (Elements[i].y - mean.y) * (Elements[i].x - mean.x);
-        total.M[2][0] += (Elements[i].z - mean.z) * (Elements[i].x - mean.x);
-        total.M[1][1] += (Elements[i].y - mean.y) * (Elements[i].y - mean.y);
-        total.M[2][1] += (Elements[i].z - mean.z) * (Elements[i].y - mean.y);
-        total.M[2][2] += (Elements[i].z - mean.z) * (Elements[i].z - mean.z);
+        Vector3f d(x[i] - mean.x, y[i] - mean.y, z[i] - mean.z);
+        sum += d;
+        xx  += d.x * d.x;
+        yy  += d.y * d.y;
+        zz  += d.z * d.z;
+        xy  += d.x * d.y;
+        yz  += d.y * d.z;
+        zx  += d.z * d.x;
     }
-    total.M[0][1] = total.M[1][0];
-    total.M[0][2] = total.M[2][0];
-    total.M[1][2] = total.M[2][1];
-    for (int i = 0; i < 3; i++)
-        for (int j = 0; j < 3; j++)
-            total.M[i][j] *= 1.0f / Count;
-    return total;
+
+    float inv = 1.0f / n;
+    return Matrix3f(xx - sum.x * sum.x * inv, xy - sum.x * sum.y * inv, zx - sum.z * sum.x * inv,
+                    xy - sum.x * sum.y * inv, yy - sum.y * sum.y * inv, yz - sum.y * sum.z * inv,
+                    zx - sum.z * sum.x * inv, yz - sum.y * sum.z * inv, zz - sum.z * sum.z * inv);
+}
+
+//-------------------------------------------------------------------------------------
+// ***** OrientationFilter
+
+const float OrientationFilter::MaxGap = 0.25f;
+
+OrientationFilter::OrientationFilter(float minCutoff, float beta, float derivativeCutoff)
+  : Valid(false), LastTime(0), FilteredSpeed(0), LastAlpha(1)
+{
+    Configure(minCutoff, beta, derivativeCutoff);
 }
 
-Vector3f SensorFilter::PearsonCoefficient() const
+void OrientationFilter::Configure(float minCutoff, float beta, float derivativeCutoff)
 {
-    Matrix4f cov = Covariance();
-    Vector3f pearson = Vector3f();
-    pearson.x = cov.M[0][1]/(sqrt(cov.M[0][0])*sqrt(cov.M[1][1]));
-    pearson.y = cov.M[1][2]/(sqrt(cov.M[1][1])*sqrt(cov.M[2][2]));
-    pearson.z = cov.M[2][0]/(sqrt(cov.M[2][2])*sqrt(cov.M[0][0]));
+    OVR_ASSERT(minCutoff > 0 && beta >= 0 && derivativeCutoff > 0);
+    MinCutoff        = minCutoff;
+    Beta             = beta;
+    DerivativeCutoff = derivativeCutoff;
+}
+
+Quatf OrientationFilter::Filter(double time, const Quatf& q, float speed)
+{
+    float dt = (float)(time - LastTime);
+    if (!Valid || dt > MaxGap || dt < -MaxGap)
+    {
+        Valid         = true;
+        LastTime      = time;
+        Filtered      = q;
+        FilteredSpeed = speed;
+        LastAlpha     = 1;
+        return q;
+    }
+    if (dt <= 0)
+    {
+        LastAlpha = 0;
+        return Filtered;
+    }
+
+    LastTime       = time;
+    FilteredSpeed += alpha(DerivativeCutoff, dt) * (speed - FilteredSpeed);
 
-    return pearson;
+    float cutoff = MinCutoff + Beta * FilteredSpeed;
+    LastAlpha    = alpha(cutoff, dt);
+    Filtered     = Filtered.Slerp(q, LastAlpha);
+    return Filtered;
 }
 
+void OrientationFilter::FilterRates(Vector3f* angVel, Vector3f* angAcc)
+{
+    FilteredAngVel += (*angVel - FilteredAngVel) * LastAlpha;
+    FilteredAngAcc += (*angAcc - FilteredAngAcc) * LastAlpha;
+    *angVel = FilteredAngVel;
+    *angAcc = FilteredAngAcc;
+}
+
+
 } //namespace OVR
@@ -30,37 +30,167 @@ limitations under the License.
 
 #include "Kernel/OVR_Math.h"
 
+#if defined(OVR_CPU_SSE)
+#include <xmmintrin.h>
+#endif
+
 
 namespace OVR {
 
-// A simple circular buffer data structure that stores last N elements in an array
+// Smallest power of two that is not less than N
+template <int N>
+struct CircularBufferStorage
+{
+    enum { Size = CircularBufferStorage<(N + 1) / 2>::Size * 2 };
+};
+
+template <>
+struct CircularBufferStorage<1>
+{
+    enum { Size = 1 };
+};
+
+// Filter kernels: weighted sums over contiguous history windows, vectorized where the
+// CPU allows it. They are inline so that fixed-length kernels unroll completely.
+inline float SensorFilter_Dot(const float* a, const float* w, int n)
+{
+    int i = 0;
+    float result = 0;
+#if defined(OVR_CPU_SSE)
+    if (n >= 4)
+    {
+        __m128 acc = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(w + i)));
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+        result = _mm_cvtss_f32(acc);
+    }
+#endif
+    for (; i < n; i++)
+        result += a[i] * w[i];
+    return result;
+}
+
+// Applies the same weights to three axis windows at once.
+inline Vector3f SensorFilter_Dot3(const float* x, const float* y, const float* z, const float* w, int n)
+{
+    int i = 0;
+    Vector3f result;
+#if defined(OVR_CPU_SSE)
+    if (n >= 4)
+    {
+        __m128 ax = _mm_setzero_ps(), ay = _mm_setzero_ps(), az = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 wi = _mm_loadu_ps(w + i);
+            ax = _mm_add_ps(ax, _mm_mul_ps(_mm_loadu_ps(x + i), wi));
+            ay = _mm_add_ps(ay, _mm_mul_ps(_mm_loadu_ps(y + i), wi));
+            az = _mm_add_ps(az, _mm_mul_ps(_mm_loadu_ps(z + i), wi));
+        }
+        // Transpose and add, reducing the three accumulators together
+        __m128 zero = _mm_setzero_ps();
+        __m128 t0 = _mm_unpacklo_ps(ax, ay);    // x0 y0 x1 y1
+        __m128 t1 = _mm_unpackhi_ps(ax, ay);    // x2 y2 x3 y3
+        __m128 t2 = _mm_unpacklo_ps(az, zero);  // z0 0  z1 0
+        __m128 t3 = _mm_unpackhi_ps(az, zero);  // z2 0  z3 0
+        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_movelh_ps(t0, t2), _mm_movehl_ps(t2, t0)),
+                                _mm_add_ps(_mm_movelh_ps(t1, t3), _mm_movehl_ps(t3, t1)));
+        float lanes[4];
+        _mm_storeu_ps(lanes, sum);
+        result = Vector3f(lanes[0], lanes[1], lanes[2]);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        result.x += x[i] * w[i];
+        result.y += y[i] * w[i];
+        result.z += z[i] * w[i];
+    }
+    return result;
+}
+
+// Weighted sum of n consecutive elements
 template <typename T>
+inline T SensorFilter_WeightedSum(const T* elements, const float* weights, int n)
+{
+    T result = T();
+    for (int i = 0; i < n; i++)
+        result += elements[i] * weights[i];
+    return result;
+}
+
+inline float SensorFilter_WeightedSum(const float* elements, const float* weights, int n)
+{
+    return SensorFilter_Dot(elements, weights, n);
+}
+
+// Computes Savitzky-Golay weights for a window of the given length, ordered oldest to
+// newest: a polynomial of the given order is fit to the window by least squares and its
+// derivative of the given order (per sample step) is evaluated at the newest sample.
+void SensorFilter_SavitzkyGolayWeights(float* weights, int window, int order, int derivative);
+
+// Weight table for one Savitzky-Golay filter, computed once in double precision when the
+// module is loaded.
+template <int Window, int Order, int Derivative = 0>
+class SavitzkyGolayWeights
+{
+public:
+    enum
+    {
+        MaxOrder = 6
+    };
+
+    static const float* Get() { return Table.Weights; }
+
+private:
+    struct WeightTable
+    {
+        float Weights[Window];
+
+        WeightTable()
+        {
+            OVR_COMPILER_ASSERT(Order < Window && Order <= MaxOrder && Derivative <= Order);
+            SensorFilter_SavitzkyGolayWeights(Weights, Window, Order, Derivative);
+        }
+    };
+
+    static const WeightTable Table;
+};
+
+template <int Window, int Order, int Derivative>
+const typename SavitzkyGolayWeights<Window, Order, Derivative>::WeightTable
+    SavitzkyGolayWeights<Window, Order, Derivative>::Table;
+
+// A simple circular buffer data structure that stores last N elements in an array.
+// The storage is rounded up to a power of two so that wrapping is a mask, and every
+// slot is mirrored StorageSize entries later, so the most recent N elements always
+// form one contiguous window that filter kernels can run over directly.
+// Slots that have not been written yet hold T(), so GetPrev(i) returns T() for i
+// beyond the number of elements added.
+template <typename T, int N = 20>
 class CircularBuffer
 {
-protected:
+public:
     enum
     {
-        DefaultFilterCapacity = 20
+        Capacity    = N,
+        StorageSize = CircularBufferStorage<N>::Size,
+        StorageMask = StorageSize - 1
     };
 
-    int         LastIdx;                    // The index of the last element that was added to the buffer
-    int         Capacity;                   // The buffer size (maximum number of elements)
+protected:
+    int         Head;                       // The slot of the last element that was added to the buffer
     int         Count;                      // Number of elements in the filter
-    T*          Elements;
+    T           Elements[2 * StorageSize];
 
 public:
-    CircularBuffer(int capacity = DefaultFilterCapacity) 
-        : LastIdx(-1), Capacity(capacity), Count(0)
+    CircularBuffer() : Head(StorageMask), Count(0)
     {
-        Elements = (T*)OVR_ALLOC(capacity * sizeof(T));
-        for (int i = 0; i < Capacity; i++)
+        for (int i = 0; i < 2 * StorageSize; i++)
             Elements[i] = T();
     }
 
-    ~CircularBuffer() {
-        OVR_FREE(Elements);
-    }
-
 private:
     // Make the class non-copyable
     CircularBuffer(const CircularBuffer& other);
@@ -70,54 +200,159 @@ public:
     // Add a new element to the filter
     void AddElement (const T &e)
     {
-        LastIdx = (LastIdx + 1) % Capacity;
-        Elements[LastIdx] = e;
-        if (Count < Capacity)
+        Head = (Head + 1) & StorageMask;
+        Elements[Head] = Elements[Head + StorageSize] = e;
+        if (Count < N)
             Count++;
     }
 
+    // Remove all elements
+    void Clear()
+    {
+        Head  = StorageMask;
+        Count = 0;
+        for (int i = 0; i < 2 * StorageSize; i++)
+            Elements[i] = T();
+    }
+
+    // Number of elements currently stored; never exceeds the capacity.
+    int GetSize() const     { return Count; }
+    int GetCapacity() const { return N; }
+
     // Get element i.  0 is the most recent, 1 is one step ago, 2 is two steps ago, ...
     T GetPrev(int i = 0) const
     {
-		OVR_ASSERT(i >= 0);
-        if (i >= Count) // return 0 if the filter doesn't have enough elements
-            return T();
-        int idx = (LastIdx - i);
-        if (idx < 0) // Fix the wraparound case
-            idx += Capacity;
-		OVR_ASSERT(idx >= 0); // Multiple wraparounds not allowed
-        return Elements[idx];
+        OVR_ASSERT(i >= 0 && i < N);
+        return Elements[Head + StorageSize - i];
+    }
+
+    // The n most recent elements, ordered oldest to newest.
+    const T* GetWindow(int n) const
+    {
+        OVR_ASSERT(n > 0 && n <= N);
+        return Elements + Head + StorageSize - n + 1;
+    }
+
+    // Sum of the n most recent elements weighted by weights, which are ordered oldest to newest.
+    T WeightedSum(const float* weights, int n) const
+    {
+        return SensorFilter_WeightedSum(GetWindow(n), weights, n);
+    }
+};
+
+// Vector data is stored as a structure of arrays, so each axis of the window is a
+// contiguous float array.
+template <int N>
+class CircularBuffer<Vector3f, N>
+{
+public:
+    enum
+    {
+        Capacity    = N,
+        StorageSize = CircularBufferStorage<N>::Size,
+        StorageMask = StorageSize - 1
+    };
+
+protected:
+    int         Head;                       // The slot of the last element that was added to the buffer
+    int         Count;                      // Number of elements in the filter
+    float       Elements[3][2 * StorageSize];
+
+public:
+    CircularBuffer() : Head(StorageMask), Count(0)
+    {
+        for (int a = 0; a < 3; a++)
+            for (int i = 0; i < 2 * StorageSize; i++)
+                Elements[a][i] = 0;
+    }
+
+private:
+    // Make the class non-copyable
+    CircularBuffer(const CircularBuffer& other);
+    CircularBuffer& operator=(const CircularBuffer& other);
+
+public:
+    // Add a new element to the filter
+    void AddElement (const Vector3f &e)
+    {
+        Head = (Head + 1) & StorageMask;
+        Elements[0][Head] = Elements[0][Head + StorageSize] = e.x;
+        Elements[1][Head] = Elements[1][Head + StorageSize] = e.y;
+        Elements[2][Head] = Elements[2][Head + StorageSize] = e.z;
+        if (Count < N)
+            Count++;
+    }
+
+    // Remove all elements
+    void Clear()
+    {
+        Head  = StorageMask;
+        Count = 0;
+        for (int a = 0; a < 3; a++)
+            for (int i = 0; i < 2 * StorageSize; i++)
+                Elements[a][i] = 0;
+    }
+
+    // Number of elements currently stored; never exceeds the capacity.
+    int GetSize() const     { return Count; }
+    int GetCapacity() const { return N; }
+
+    // Get element i.  0 is the most recent, 1 is one step ago, 2 is two steps ago, ...
+    Vector3f GetPrev(int i = 0) const
+    {
+        OVR_ASSERT(i >= 0 && i < N);
+        int idx = Head + StorageSize - i;
+        return Vector3f(Elements[0][idx], Elements[1][idx], Elements[2][idx]);
+    }
+
+    // The n most recent values of one axis, ordered oldest to newest.
+    const float* GetWindow(int axis, int n) const
+    {
+        OVR_ASSERT(axis >= 0 && axis < 3 && n > 0 && n <= N);
+        return Elements[axis] + Head + StorageSize - n + 1;
+    }
+
+    // Sum of the n most recent elements weighted by weights, which are ordered oldest to newest.
+    Vector3f WeightedSum(const float* weights, int n) const
+    {
+        return SensorFilter_Dot3(GetWindow(0, n), GetWindow(1, n), GetWindow(2, n), weights, n);
     }
 };
 
 // A base class for filters that maintains a buffer of sensor data taken over time and implements
 // various simple filters, most of which are linear functions of the data history.
 // Maintains the running sum of its elements for better performance on large capacity values
-template <typename T>
-class SensorFilterBase : public CircularBuffer<T>
+template <typename T, int N = 20>
+class SensorFilterBase : public CircularBuffer<T, N>
 {
 protected:
     T RunningTotal;               // Cached sum of the elements
 
 public:
-    SensorFilterBase(int capacity = CircularBuffer<T>::DefaultFilterCapacity) : CircularBuffer<T>(capacity), RunningTotal() { };
+    SensorFilterBase() : RunningTotal() { };
 
     // Add a new element to the filter
     // Updates the running sum value
     void AddElement (const T &e)
     {
-        int NextIdx = (this->LastIdx + 1) % this->Capacity;
-        RunningTotal += (e - this->Elements[NextIdx]);
-        CircularBuffer<T>::AddElement(e);
-        if (this->LastIdx == 0)
+        // The oldest element is evicted; it is T() until the buffer fills up
+        RunningTotal += (e - this->GetPrev(N - 1));
+        CircularBuffer<T, N>::AddElement(e);
+        if (this->Head == 0)
         {
             // update the cached total to avoid error accumulation
             RunningTotal = T();
             for (int i = 0; i < this->Count; i++)
-                RunningTotal += this->Elements[i];
+                RunningTotal += this->GetPrev(i);
         } 
     }
 
+    void Clear()
+    {
+        CircularBuffer<T, N>::Clear();
+        RunningTotal = T();
+    }
+
     // Simple statistics
     T Total() const 
     { 
@@ -129,83 +364,161 @@ public:
         return (this->Count == 0) ? T() : (Total() / (float) this->Count);
     }
 
-    // A popular family of smoothing filters and smoothed derivatives
+    // A popular family of smoothing filters and smoothed derivatives.
+    // SavitzkyGolay<Window, Order, Derivative> fits a polynomial of degree Order to the
+    // last Window elements and returns its Derivative-th derivative (per sample step) at
+    // the most recent one; Derivative = 0 gives the smoothed value.
+    template <int Window, int Order, int Derivative>
+    T SavitzkyGolay() const
+    {
+        OVR_COMPILER_ASSERT(Window <= N);
+        return this->WeightedSum(SavitzkyGolayWeights<Window, Order, Derivative>::Get(), Window);
+    }
+
     T SavitzkyGolaySmooth8() const
     {
-        OVR_ASSERT(this->Capacity >= 8);
-        return this->GetPrev(0)*0.41667f +
-                this->GetPrev(1)*0.33333f +
-                this->GetPrev(2)*0.25f +
-                this->GetPrev(3)*0.16667f +
-                this->GetPrev(4)*0.08333f -
-                this->GetPrev(6)*0.08333f -
-                this->GetPrev(7)*0.16667f;
+        return SavitzkyGolay<8, 1, 0>();
     }
 
     T SavitzkyGolayDerivative4() const
     {
-        OVR_ASSERT(this->Capacity >= 4);
-        return this->GetPrev(0)*0.3f +
-                this->GetPrev(1)*0.1f -
-                this->GetPrev(2)*0.1f -
-                this->GetPrev(3)*0.3f;
+        return SavitzkyGolay<4, 1, 1>();
     }
 
     T SavitzkyGolayDerivative5() const
     {
-            OVR_ASSERT(this->Capacity >= 5);
-            return this->GetPrev(0)*0.2f +
-                    this->GetPrev(1)*0.1f -
-                    this->GetPrev(3)*0.1f -
-                    this->GetPrev(4)*0.2f;
+        return SavitzkyGolay<5, 1, 1>();
     }
 
     T SavitzkyGolayDerivative12() const
     {
-        OVR_ASSERT(this->Capacity >= 12);
-        return this->GetPrev(0)*0.03846f +
-                this->GetPrev(1)*0.03147f +
-                this->GetPrev(2)*0.02448f +
-                this->GetPrev(3)*0.01748f +
-                this->GetPrev(4)*0.01049f +
-                this->GetPrev(5)*0.0035f -
-                this->GetPrev(6)*0.0035f -
-                this->GetPrev(7)*0.01049f -
-                this->GetPrev(8)*0.01748f -
-                this->GetPrev(9)*0.02448f -
-                this->GetPrev(10)*0.03147f -
-                this->GetPrev(11)*0.03846f;
+        return SavitzkyGolay<12, 1, 1>();
     } 
 
     T SavitzkyGolayDerivativeN(int n) const
     {    
-        OVR_ASSERT(this->Capacity >= n);
+        OVR_ASSERT(n >= 3 && n <= N);
         int m = (n-1)/2;
-        T result = T();
+        float coef = 3.0f/(m*(m+1.0f)*(2.0f*m+1.0f));
+        float weights[N];
+        for (int i = 0; i < n; i++)
+            weights[i] = 0;
+        // Element GetPrev(i) sits at window position n - 1 - i
         for (int k = 1; k <= m; k++) 
         {
-            int ind1 = m - k;
-            int ind2 = n - m + k - 1;
-            result += (this->GetPrev(ind1) - this->GetPrev(ind2)) * (float) k;
+            weights[n - 1 - (m - k)]         += k * coef;
+            weights[n - 1 - (n - m + k - 1)] -= k * coef;
         }
-        float coef = 3.0f/(m*(m+1.0f)*(2.0f*m+1.0f));
-        result = result*coef;
-        return result;
+        return this->WeightedSum(weights, n);
     }
 };
 
+// Window statistics behind SensorFilter<N>, over n contiguous samples per axis.
+// The element of rank n / 2.
+float    SensorFilter_Median(const float* a, int n);
+// Sums of squared deviations from the window mean, per axis.
+Vector3f SensorFilter_SumSquares(const float* x, const float* y, const float* z, int n,
+                                 const Vector3f& mean);
+// Sum of (e - mean)(e - mean)^T over the window.
+Matrix3f SensorFilter_CoMoment(const float* x, const float* y, const float* z, int n,
+                               const Vector3f& mean);
+
 // This class maintains a buffer of sensor data taken over time and implements
 // various simple filters, most of which are linear functions of the data history.
-class SensorFilter : public SensorFilterBase<Vector3f>
+// Adding an element only updates the running total, so samples cost no more than in
+// SensorFilterBase; the order statistics and second moments are computed from the
+// window when they are queried, without allocating.
+template <int N = 20>
+class SensorFilter : public SensorFilterBase<Vector3f, N>
 {
 public:
-    SensorFilter(int capacity = DefaultFilterCapacity) : SensorFilterBase<Vector3f>(capacity) { };
+    SensorFilter() { };
 
     // Simple statistics
-    Vector3f Median() const;
-    Vector3f Variance() const; // The diagonal of covariance matrix
-    Matrix4f Covariance() const;
-    Vector3f PearsonCoefficient() const;
+    Vector3f Median() const
+    {
+        if (this->Count == 0)
+            return Vector3f();
+        return Vector3f(SensorFilter_Median(this->GetWindow(0, this->Count), this->Count),
+                        SensorFilter_Median(this->GetWindow(1, this->Count), this->Count),
+                        SensorFilter_Median(this->GetWindow(2, this->Count), this->Count));
+    }
+
+    //  Only the diagonal of the covariance matrix.
+    Vector3f Variance() const
+    {
+        if (this->Count == 0)
+            return Vector3f();
+        return SensorFilter_SumSquares(this->GetWindow(0, this->Count), this->GetWindow(1, this->Count),
+                                       this->GetWindow(2, this->Count), this->Count, this->Mean())
+               / (float) this->Count;
+    }
+
+    Matrix3f Covariance() const
+    {
+        if (this->Count == 0)
+            return Matrix3f(0, 0, 0, 0, 0, 0, 0, 0, 0);
+        return SensorFilter_CoMoment(this->GetWindow(0, this->Count), this->GetWindow(1, this->Count),
+                                     this->GetWindow(2, this->Count), this->Count, this->Mean())
+               * (1.0f / this->Count);
+    }
+
+    Vector3f PearsonCoefficient() const
+    {
+        Matrix3f cov = Covariance();
+        Vector3f pearson = Vector3f();
+        pearson.x = cov.M[0][1]/(sqrt(cov.M[0][0])*sqrt(cov.M[1][1]));
+        pearson.y = cov.M[1][2]/(sqrt(cov.M[1][1])*sqrt(cov.M[2][2]));
+        pearson.z = cov.M[2][0]/(sqrt(cov.M[2][2])*sqrt(cov.M[0][0]));
+        return pearson;
+    }
+};
+
+// One-Euro filter for an orientation stream. The orientation is low-passed along the
+// shortest arc with a cutoff that grows with the angular speed, so jitter is smoothed
+// heavily while the head is still and motion passes with little lag. Since the lag of
+// a first order low-pass is speed / (2 pi cutoff), it never exceeds 1 / (2 pi Beta)
+// radians once the speed term dominates the cutoff.
+class OrientationFilter
+{
+public:
+    // minCutoff in Hz, beta in Hz per rad/s, derivativeCutoff (Hz) smooths the speed.
+    OrientationFilter(float minCutoff = 1.0f, float beta = 50.0f, float derivativeCutoff = 10.0f);
+
+    void     Configure(float minCutoff, float beta, float derivativeCutoff = 10.0f);
+    float    GetMinCutoff() const           { return MinCutoff; }
+    float    GetBeta() const                { return Beta; }
+    float    GetDerivativeCutoff() const    { return DerivativeCutoff; }
+
+    // Filters orientation q, sampled at time (seconds) while rotating at speed (rad/s).
+    // Times are expected to increase; a repeated time returns the previous output, and
+    // a gap or jump back of more than MaxGap seconds restarts the filter.
+    Quatf    Filter(double time, const Quatf& q, float speed);
+    // Smooths the angular velocity and acceleration sampled along with the orientation
+    // last passed to Filter, with the same cutoff.
+    void     FilterRates(Vector3f* angVel, Vector3f* angAcc);
+    void     Reset()                        { Valid = false; }
+
+private:
+    static float alpha(float cutoff, float dt)
+    {
+        float r = 2 * Mathf::Pi * cutoff * dt;
+        return r / (1 + r);
+    }
+
+    static const float MaxGap;
+
+    float    MinCutoff;
+    float    Beta;
+    float    DerivativeCutoff;
+
+    bool     Valid;
+    double   LastTime;
+    Quatf    Filtered;
+    float    FilteredSpeed;
+    float    LastAlpha;         // 1 after a restart, 0 after a repeated time.
+    Vector3f FilteredAngVel;
+    Vector3f FilteredAngAcc;
 };
 
 } //namespace OVR
@@ -29,22 +29,38 @@ limitations under the License.
 #include "Kernel/OVR_System.h"
 #include "OVR_JSON.h"
 #include "OVR_Profile.h"
+#include "OVR_StoreCache.h"
+#include "Kernel/OVR_SysFile.h"
+#include "Kernel/OVR_Timer.h"
 
 #define MAX_DEVICE_PROFILE_MAJOR_VERSION 1
+#define DEVICE_STORE_KIND 2
+
+// Identifies the binary blob written by SensorFusion::SaveState ('OVFS').
+#define FUSION_STATE_MAGIC   0x5346564F
+#define FUSION_STATE_VERSION 3
 
 namespace OVR {
 
+// Lookaheads are clamped to this many seconds; extrapolation errors grow quickly past it.
+static const float MaxPredictionDT = 0.1f;
+
 //-------------------------------------------------------------------------------------
 // ***** Sensor Fusion
 
 SensorFusion::SensorFusion(SensorDevice* sensor)
-  : Stage(0), RunningTime(0), DeltaT(0.001f), 
+  : Temperature(0), Stage(0), RunningTime(0), DeltaT(0.001f), 
+    SensorTime(0), HostTimeOffset(0), HostTimeValid(false), SampleTime(0),
     Handler(getThis()), pDelegate(0),
     Gain(0.05f), EnableGravity(true), 
     EnablePrediction(true), PredictionDT(0.03f), PredictionTimeIncrement(0.001f),
-    FRawMag(10), FAngV(20), 
-    GyroOffset(), TiltAngleFilter(1000),
+    EnableOutputFilter(false),
+    GyroOffset(), GyroBias(), GyroOffsetTemperature(0),
+    EnableGyroTempCompensation(true), TempBiasValid(false), TempBiasTemperature(0),
+    Stationary(false), StillTime(0), GyroOffsetKnown(false),
+    GravityCorrectionPeriod(1.0f / 250), YawCorrectionPeriod(1.0f / 100), GravityCorrectionDT(0), YawCorrectionDT(0),
     EnableYawCorrection(false), MagCalibrated(false), MagNumReferences(0), MagRefIdx(-1), MagRefScore(0),
+    MagRefsRestored(false),
     MotionTrackingEnabled(true)
 {
    if (sensor)
@@ -100,6 +116,11 @@ bool SensorFusion::AttachToSensor(SensorDevice* sensor)
     }
 
     Reset();
+
+    // Warm-start from the state saved by a previous session, if any
+    if (sensor != NULL)
+        LoadStateFile();
+
     return true;
 }
 
@@ -114,7 +135,80 @@ void SensorFusion::Reset()
     RunningTime           = 0;
     MagNumReferences      = 0;
     MagRefIdx             = -1;
+    MagRefsRestored       = false;
     GyroOffset            = Vector3f();
+    GyroOffsetKnown       = false;
+    Stationary            = false;
+    StillTime             = 0;
+    Alignment             = AlignmentState();
+    GravityCorrectionDT   = 0;
+    YawCorrectionDT       = 0;
+    Monitor.DiscardPending();
+    History.Clear();
+    OutputFilter.Reset();
+    FilteredQ             = Q;
+    FilteredAngVel        = Vector3f();
+    FilteredAngAcc        = Vector3f();
+}
+
+void SensorFusion::ResetPredictionErrorStats()
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    Monitor.ClearStats();
+}
+
+void SensorFusion::SetAdaptivePredictionEnabled(bool enable)
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    Monitor.SetAdaptationEnabled(enable);
+    if (!enable)
+        Monitor.ResetAdaptation();
+}
+
+float SensorFusion::GetPredictionHorizonScale() const
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    return Monitor.GetHorizonScale();
+}
+
+float SensorFusion::GetPredictionDamping() const
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    return Monitor.GetDamping();
+}
+
+void SensorFusion::SetOutputFilter(float minCutoff, float beta, bool enable)
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    OutputFilter.Configure(minCutoff, beta);
+    SetOutputFilterEnabled(enable);
+}
+
+void SensorFusion::SetOutputFilterEnabled(bool enable)
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    if (enable && !EnableOutputFilter)
+    {
+        // Start from the current orientation rather than a stale one
+        OutputFilter.Reset();
+        FilteredQ = Q;
+        FilteredAngVel = FilteredAngAcc = Vector3f();
+    }
+    EnableOutputFilter = enable;
+}
+
+void SensorFusion::ClearGyroTempCalibration()
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    GyroTempCal.Clear();
+    TempBiasValid = false;
+}
+
+void SensorFusion::SetCorrectionRates(float gravityHz, float yawHz)
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    GravityCorrectionPeriod = (gravityHz > 0) ? 1.0f / gravityHz : 0.0f;
+    YawCorrectionPeriod     = (yawHz > 0) ? 1.0f / yawHz : 0.0f;
 }
 
 // Compute a rotation required to transform "estimated" into "measured"
@@ -146,19 +240,35 @@ void SensorFusion::handleMessage(const MessageBodyFrame& msg)
     FRawMag.AddElement(mag);
     FAngV.AddElement(gyro);
 
-    // Apply the calibration parameters to raw mag
-    Vector3f calMag = MagCalibrated ? GetCalibratedMagValue(FRawMag.Mean()) : FRawMag.Mean();
-
     // Set variables accessible through the class API
     DeltaT = msg.TimeDelta;
     AngV   = gyro;
     A      = accel;
     RawMag = mag;  
-    CalMag = calMag;
+    Temperature = msg.Temperature;
 
     // Keep track of time
     Stage++;
     RunningTime += DeltaT;
+    SensorTime  += DeltaT;
+    if (msg.AbsoluteTimeSeconds > 0)
+        SampleTime = msg.AbsoluteTimeSeconds;
+    else
+        updateSampleTime();
+
+    // The gyro is integrated on every sample; the corrections run at their own
+    // (possibly lower) rates over the exact time accumulated since they last ran
+    GravityCorrectionDT += DeltaT;
+    YawCorrectionDT     += DeltaT;
+    // (half a sample of slack keeps float round-off from skipping a whole sample)
+    float slack     = 0.5f * DeltaT;
+    bool runGravity = (GravityCorrectionDT + slack >= GravityCorrectionPeriod) || Stage <= 5;
+    bool runYaw     = (YawCorrectionDT + slack >= YawCorrectionPeriod);
+
+    // Apply the calibration parameters to raw mag
+    if (runYaw)
+        CalMag = MagCalibrated ? GetCalibratedMagValue(FRawMag.Mean()) : FRawMag.Mean();
+    Vector3f calMag = CalMag;
 
     // Small preprocessing
     Quatf Qinv = Q.Inverted();
@@ -166,14 +276,46 @@ void SensorFusion::handleMessage(const MessageBodyFrame& msg)
 
     Vector3f gyroCorrected = gyro;
 
+    // Remove the temperature dependent part of the gyro bias
+    if (runGravity)
+    {
+        FAccel.AddElement(accel);
+        Stationary = detectStationary(accel, GravityCorrectionDT);
+    }
+    if (EnableGyroTempCompensation)
+    {
+        if (runGravity && Stationary)
+            updateGyroTempCalibration(GravityCorrectionDT);
+
+        // The table lookup only changes with the temperature or the table itself
+        if (!TempBiasValid || Temperature != TempBiasTemperature)
+        {
+            if (!GyroTempCal.GetBias(Temperature, &TempBias))
+                TempBias = Vector3f();
+            TempBiasTemperature = Temperature;
+            TempBiasValid       = true;
+        }
+        gyroCorrected -= TempBias;
+    }
+
     // Apply integral term
     // All the corrections are stored in the Simultaneous Orthogonal Rotations Angle representation,
     // which allows to combine and scale them by just addition and multiplication
     if (EnableGravity || EnableYawCorrection)
         gyroCorrected -= GyroOffset;
+    GyroBias = gyro - gyroCorrected;
+
+    if (EnableGravity && !Alignment.Done)
+        updateAlignment(gyro, accel, mag);
 
-    if (EnableGravity)
+    if (EnableGravity && runGravity)
     {
+        // Scales a correction rate so that it is applied over the whole accumulated
+        // interval within this sample's integration step
+        float dt         = GravityCorrectionDT;
+        float stepScale  = dt / DeltaT;
+        GravityCorrectionDT = 0;
+
         const float spikeThreshold = 0.01f;
         const float gravityThreshold = 0.1f;
         float proportionalGain     = 5 * Gain; // Gain parameter should be removed in a future release
@@ -185,7 +327,10 @@ void SensorFusion::handleMessage(const MessageBodyFrame& msg)
         {
             // Spike detection
             float tiltAngle = up.Angle(accel);
-            TiltAngleFilter.AddElement(tiltAngle);
+            // The filter window is in sensor samples; hold the value over the skipped ones
+            int holdCount = (int)(stepScale + 0.5f);
+            for (int k = 0; k < holdCount; k++)
+                TiltAngleFilter.AddElement(tiltAngle);
             if (tiltAngle > TiltAngleFilter.Mean() + spikeThreshold)
                 proportionalGain = integralGain = 0;
             // Acceleration detection
@@ -195,21 +340,32 @@ void SensorFusion::handleMessage(const MessageBodyFrame& msg)
         }
         else // Apply full correction at the startup
         {
-            proportionalGain = 1 / DeltaT;
+            proportionalGain = 1 / dt;
             integralGain = 0;
         }
 
-        gyroCorrected += (tiltCorrection * proportionalGain);
-        GyroOffset -= (tiltCorrection * integralGain * DeltaT);
+        gyroCorrected += (tiltCorrection * proportionalGain * stepScale);
+        GyroOffset -= (tiltCorrection * integralGain * dt);
+        if (integralGain > 0)
+            GyroOffsetTemperature = Temperature;
     }
+    else if (!EnableGravity)
+        GravityCorrectionDT = 0;
 
-    if (EnableYawCorrection && MagCalibrated && RunningTime > 2.0f)
+    if (EnableYawCorrection && MagCalibrated && RunningTime > 2.0f && runYaw)
     {
+        float dt         = YawCorrectionDT;
+        float stepScale  = dt / DeltaT;
+
         const float maxMagRefDist = 0.1f;
         const float maxTiltError = 0.05f;
         float proportionalGain   = 0.01f;
         float integralGain       = 0.0005f;
 
+        // References restored from a saved state live in the previous session's yaw frame
+        if (MagRefsRestored)
+            anchorRestoredMagReferences(calMag);
+
         // Update the reference point if needed
         if (MagRefIdx < 0 || calMag.Distance(MagRefsInBodyFrame[MagRefIdx]) > maxMagRefDist)
         {
@@ -261,11 +417,19 @@ void SensorFusion::handleMessage(const MessageBodyFrame& msg)
                 MagRefScore -= 1;
                 proportionalGain = integralGain = 0;
             }
-            gyroCorrected += (yawCorrection * proportionalGain);
-            GyroOffset -= (yawCorrection * integralGain * DeltaT);
+            gyroCorrected += (yawCorrection * proportionalGain * stepScale);
+            GyroOffset -= (yawCorrection * integralGain * dt);
+            if (integralGain > 0)
+                GyroOffsetTemperature = Temperature;
         }
     }
 
+    if (runYaw)
+        YawCorrectionDT = 0;
+
+    // Score the predictions whose target falls within this step
+    Monitor.Update(SampleTime, Q, gyroCorrected, DeltaT);
+
     // Update the orientation quaternion based on the corrected angular velocity vector
     float angle = gyroCorrected.Length() * DeltaT;
     if (angle > 0.0f)
@@ -275,46 +439,315 @@ void SensorFusion::handleMessage(const MessageBodyFrame& msg)
     // so it is periodically normalized.
     if (Stage % 500 == 0)
         Q.Normalize();
+
+    History.Add(SampleTime, Q, gyroCorrected);
+
+    // The output filter follows the orientation and the prediction rates once per sample,
+    // so every query, current or predicted and in any order, starts from the same state
+    if (EnableOutputFilter)
+    {
+        FilteredQ = OutputFilter.Filter(SampleTime, Q, gyroCorrected.Length());
+        predictionRates(&FilteredAngVel, &FilteredAngAcc);
+        OutputFilter.FilterRates(&FilteredAngVel, &FilteredAngAcc);
+    }
+
+    OVR_LATENCY_TRACE_FUSED(TraceStamp);
 }
 
-//  A predictive filter based on extrapolating the smoothed, current angular velocity
-Quatf SensorFusion::GetPredictedOrientation(float pdt)
-{		
-    Lock::Locker lockScope(Handler.GetHandlerLock());
-    Quatf        qP = Q;
-    
-    if (EnablePrediction)
-    {
-        // This method assumes a constant angular velocity
-        Vector3f angVelF  = FAngV.SavitzkyGolaySmooth8();
-        float    angVelFL = angVelF.Length();
-
-        // Force back to raw measurement
-        angVelF  = AngV;
-        angVelFL = AngV.Length();
-
-        // Dynamic prediction interval: Based on angular velocity to reduce vibration
-        const float minPdt   = 0.001f;
-        const float slopePdt = 0.1f;
-        float       newpdt   = pdt;
-        float       tpdt     = minPdt + slopePdt * angVelFL;
-        if (tpdt < pdt)
-            newpdt = tpdt;
-        //LogText("PredictonDTs: %d\n",(int)(newpdt / PredictionTimeIncrement + 0.5f));
-
-        if (angVelFL > 0.001f)
+// Solves for the initial attitude and gyro bias from a window of still samples.
+// The window grows until the mean gravity direction is known to well under a
+// tenth of a degree, and restarts whenever the variance indicates motion.
+void SensorFusion::updateAlignment(const Vector3f& gyro, const Vector3f& accel, const Vector3f& rawMag)
+{
+    const int   minSamples       = 50;
+    const int   maxSamples       = 1000;
+    const float maxTiltError     = 0.001f;  // rad, standard error of the mean gravity direction
+    const float maxAlignmentTime = 3.0f;    // s, give up and rely on the running filter
+
+    AlignmentState& a = Alignment;
+
+    if (RunningTime > maxAlignmentTime)
+    {
+        a.Done     = true;
+        a.TimedOut = true;
+        a.Time     = RunningTime;
+        return;
+    }
+
+    // Welford update of the window statistics
+    a.Count++;
+    float    n          = (float)a.Count;
+    Vector3f accelDelta = accel - a.AccelMean;
+    Vector3f gyroDelta  = gyro - a.GyroMean;
+    a.AccelMean += accelDelta / n;
+    a.GyroMean  += gyroDelta / n;
+    a.MagMean   += (rawMag - a.MagMean) / n;
+    a.AccelM2   += accelDelta.EntrywiseMultiply(accel - a.AccelMean);
+    a.GyroM2    += gyroDelta.EntrywiseMultiply(gyro - a.GyroMean);
+
+    if (a.Count < minSamples)
+        return;
+
+    Vector3f accelVar    = a.AccelM2 / n;
+    float    accelVarSum = accelVar.x + accelVar.y + accelVar.z;
+    if (!isStill(a.GyroM2 / n, a.AccelMean, accelVar) || !isZeroRate(a.GyroMean, 0))
+    {   // Moving; start over with a fresh window
+        a.Restart();
+        return;
+    }
+
+    float tiltError = sqrt(accelVarSum / n) / a.AccelMean.Length();
+    if (tiltError > maxTiltError && a.Count < maxSamples)
+        return;
+
+    // One-shot attitude: rotate the estimated up vector onto the mean gravity direction
+    Vector3f up         = Q.Inverted().Rotate(Vector3f(0, 1, 0));
+    Vector3f correction = SensorFusion_ComputeCorrection(a.AccelMean, up);
+    float    angle      = correction.Length();
+    if (angle > 0.0f)
+        Q = Q * Quatf(correction, angle);
+
+    // While still, the mean gyro reading is the bias; GyroOffset holds whatever part
+    // of it the temperature table doesn't already remove
+    Vector3f tempBias;
+    if (!EnableGyroTempCompensation || !GyroTempCal.GetBias(Temperature, &tempBias))
+        tempBias = Vector3f();
+    GyroOffset            = a.GyroMean - tempBias;
+    GyroOffsetTemperature = Temperature;
+    GyroOffsetKnown       = true;
+
+    // Seed the yaw reference from the averaged field, unless one was restored.
+    // The calibration is affine, so calibrating the mean is the mean of calibrated values.
+    if (MagCalibrated && MagNumReferences == 0 && a.MagMean.LengthSq() > 0)
+    {
+        Vector3f calMag = GetCalibratedMagValue(a.MagMean);
+        MagRefsInBodyFrame[0]  = calMag;
+        MagRefsInWorldFrame[0] = Q.Rotate(calMag).Normalized();
+        MagNumReferences       = 1;
+        MagRefIdx              = -1;
+    }
+
+    a.Done = true;
+    a.Time = RunningTime;
+}
+
+bool SensorFusion::detectStationary(const Vector3f& accel, float dt)
+{
+    if (FAngV.GetSize() < FAngV.GetCapacity() ||
+        !isStill(FAngV.Variance(), accel, FAccel.Variance()))
+    {
+        StillTime = 0;
+        return false;
+    }
+
+    StillTime += dt;
+    return isZeroRate(FAngV.Mean(), StillTime);
+}
+
+bool SensorFusion::isStill(const Vector3f& gyroVar, const Vector3f& accel, const Vector3f& accelVar) const
+{
+    const float maxGyroVariance  = 1e-4f;   // (rad/s)^2, summed over the axes
+    const float maxAccelVariance = 0.05f;   // (m/s^2)^2, summed over the axes
+    const float gravityThreshold = 0.05f;
+    const float gravity          = 9.8f;
+
+    return (gyroVar.x + gyroVar.y + gyroVar.z) < maxGyroVariance &&
+           (accelVar.x + accelVar.y + accelVar.z) < maxAccelVariance &&
+           fabs(accel.Length() / gravity - 1) < gravityThreshold;
+}
+
+// A steady turn has as little variance as rest, and a turn about the vertical axis doesn't
+// show in the accelerometer either. So the mean rate is taken for the zero-rate offset only if
+// it agrees with the bias already known; before any is known, or once the device has been
+// still for longer than any turn is that steady, every rate a gyro offset can have is.
+bool SensorFusion::isZeroRate(const Vector3f& gyroMean, float stillTime) const
+{
+    const float maxGyroOffset = 0.1f;       // rad/s, the largest offset of an uncalibrated gyro
+    const float maxBiasError  = 0.005f;     // rad/s, between the mean rate and the known bias
+    const float minSteadyTime = 10.0f;      // s
+
+    if (gyroMean.Length() > maxGyroOffset)
+        return false;
+    if (stillTime >= minSteadyTime)
+        return true;
+
+    // GyroBias holds an aligned or restored offset; otherwise only the table knows the bias
+    Vector3f bias = GyroBias;
+    if (!GyroOffsetKnown && !GyroTempCal.GetBias(Temperature, &bias))
+        return true;
+    return (gyroMean - bias).Length() < maxBiasError;
+}
+
+void SensorFusion::updateGyroTempCalibration(float dt)
+{
+    const float offsetTimeConstant = 0.5f;  // s
+
+    Vector3f before, after;
+    bool hadBias = GyroTempCal.GetBias(Temperature, &before);
+
+    Vector3f gyroMean = FAngV.Mean();
+    GyroTempCal.Update(gyroMean, Temperature);
+    GyroTempCal.GetBias(Temperature, &after);
+    TempBiasValid = false;
+
+    // GyroOffset only tracks what the table doesn't explain; move the bias the
+    // table just absorbed out of it so the total correction stays continuous
+    GyroOffset -= hadBias ? (after - before) : after;
+
+    // At rest that residual is measured directly. Without it, the yaw part of GyroOffset
+    // would only ever be corrected by the magnetometer.
+    if (EnableGravity || EnableYawCorrection)
+    {
+        float gain = dt / (dt + offsetTimeConstant);
+        GyroOffset += (gyroMean - after - GyroOffset) * gain;
+        GyroOffsetTemperature = Temperature;
+    }
+}
+
+// Messages from the device carry only the time since the previous sample. The sensor clock is
+// mapped onto the host clock through the smallest receipt delay seen so far, which is
+// the transport latency floor; the estimate may creep up slowly to follow clock drift.
+void SensorFusion::updateSampleTime()
+{
+    const double maxClockDrift = 0.001;  // Seconds per second
+    const double maxDelay      = 0.1;    // Larger receipt delays mean the streams lost sync
+
+    double offset = Timer::GetSeconds() - SensorTime;
+    if (!HostTimeValid || offset > HostTimeOffset + maxDelay)
+    {
+        HostTimeOffset = offset;
+        HostTimeValid  = true;
+    }
+    else
+    {
+        HostTimeOffset = Alg::Min(HostTimeOffset + maxClockDrift * DeltaT, offset);
+    }
+    SampleTime = SensorTime + HostTimeOffset;
+}
+
+// A second order predictor: the bias-free angular velocity and its rate of change are
+// estimated by Savitzky-Golay fits over the gyro history and integrated over dt.
+Quatf SensorFusion::predict(float dt)
+{
+    Quatf q = getOutputOrientation();
+    if (!EnablePrediction || dt <= 0)
+        return q;
+    dt = Alg::Min(dt, MaxPredictionDT);
+
+    // The monitor scores the predictor itself, without the filter lag
+    Vector3f angVel, angAcc;
+    predictionRates(&angVel, &angAcc);
+    Monitor.Record(SampleTime + dt, Q, angVel, angAcc, dt);
+    if (EnableOutputFilter)
+    {
+        angVel = FilteredAngVel;
+        angAcc = FilteredAngAcc;
+    }
+
+    Vector3f rotation = Monitor.GetRotation(angVel, angAcc, dt);
+    float    angle    = rotation.Length();
+    return (angle < 1e-6f) ? q : q * Quatf(rotation / angle, angle);
+}
+
+void SensorFusion::predictionRates(Vector3f* angVel, Vector3f* angAcc) const
+{
+    if (FAngV.GetSize() == FAngV.GetCapacity() && DeltaT > 0)
+    {
+        *angVel = FAngV.SavitzkyGolay<10, 2, 0>() - GyroBias;
+        *angAcc = FAngV.SavitzkyGolay<20, 2, 1>() / DeltaT;
+    }
+    else
+    {
+        *angVel = AngV - GyroBias;
+        *angAcc = Vector3f();
+    }
+}
+
+void SensorFusion::predictBatch(const double* times, double startTime, double step,
+                                int count, Quatf* orientations)
+{
+    const int chunkSize = 64;
+
+    if (count <= 0)
+        return;
+
+    // Extrapolation starts from the filtered output, if enabled, and the monitor
+    // scores the raw prediction
+    Vector3f angVel, angAcc;
+    predictionRates(&angVel, &angAcc);
+    Vector3f outAngVel = EnableOutputFilter ? FilteredAngVel : angVel;
+    Vector3f outAngAcc = EnableOutputFilter ? FilteredAngAcc : angAcc;
+    if (!EnablePrediction)
+        outAngVel = outAngAcc = Vector3f();
+
+    // Lookaheads are converted in fixed size chunks to stay off the heap
+    float dts[chunkSize];
+    for (int i = 0; i < count; i += chunkSize)
+    {
+        int n = Alg::Min(count - i, chunkSize);
+        for (int j = 0; j < n; j++)
         {
-            Vector3f    rotAxisP      = angVelF / angVelFL;  
-            float       halfRotAngleP = angVelFL * newpdt * 0.5f;
-            float       sinaHRAP      = sin(halfRotAngleP);
-            Quatf       deltaQP(rotAxisP.x*sinaHRAP, rotAxisP.y*sinaHRAP,
-                                rotAxisP.z*sinaHRAP, cos(halfRotAngleP));
-            qP = Q * deltaQP;
+            double time = times ? times[i + j] : startTime + step * (i + j);
+            dts[j] = Alg::Clamp((float)(time - SampleTime), 0.0f, MaxPredictionDT);
         }
+        Monitor.Extrapolate(getOutputOrientation(), outAngVel, outAngAcc, dts, n, orientations + i);
     }
-    return qP;
+
+    // Only the middle point is scored
+    int    mid     = count / 2;
+    double midTime = times ? times[mid] : startTime + step * mid;
+    float  midDT   = Alg::Clamp((float)(midTime - SampleTime), 0.0f, MaxPredictionDT);
+    if (EnablePrediction && midDT > 0)
+        Monitor.Record(SampleTime + midDT, Q, angVel, angAcc, midDT);
+}
+
+void SensorFusion::GetPredictedOrientations(const double* absoluteTimes, int count, Quatf* orientations)
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    predictBatch(absoluteTimes, 0, 0, count, orientations);
+}
+
+void SensorFusion::GetPredictedOrientations(double startTime, double endTime, int count, Quatf* orientations)
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    double step = (count > 1) ? (endTime - startTime) / (count - 1) : 0;
+    predictBatch(NULL, startTime, step, count, orientations);
+}
+
+Quatf SensorFusion::GetOrientation() const
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    OVR_LATENCY_TRACE_CONSUMED(TraceStamp);
+    return getOutputOrientation();
+}
+
+Quatf SensorFusion::GetPredictedOrientation(float pdt)
+{		
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    OVR_LATENCY_TRACE_CONSUMED(TraceStamp);
+    return predict(pdt);
 }    
 
+Quatf SensorFusion::GetPredictedOrientationAt(double absoluteTime)
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+    OVR_LATENCY_TRACE_CONSUMED(TraceStamp);
+    return predict((float)(absoluteTime - SampleTime));
+}
+
+bool SensorFusion::GetOrientationAt(double absoluteTime, Quatf* orientation,
+                                    Vector3f* angularVelocity) const
+{
+    OrientationHistory::Sample sample;
+    if (!History.GetSampleAt(absoluteTime, &sample))
+        return false;
+
+    *orientation = sample.Q;
+    if (angularVelocity)
+        *angularVelocity = sample.AngVel;
+    return true;
+}
+
 
 Vector3f SensorFusion::GetCalibratedMagValue(const Vector3f& rawMag) const
 {
@@ -322,6 +755,329 @@ Vector3f SensorFusion::GetCalibratedMagValue(const Vector3f& rawMag) const
     return MagCalibrationMatrix.Transform(rawMag);
     }
 
+void SensorFusion::anchorRestoredMagReferences(const Vector3f& calMag)
+{
+    const float maxMagRefDist = 0.1f;
+
+    MagRefsRestored = false;
+
+    // Use the restored reference closest to the current reading to find the yaw offset
+    // between the saved world frame and the current one
+    int   closest  = -1;
+    float bestDist = maxMagRefDist;
+    for (int i = 0; i < MagNumReferences; i++)
+    {
+        float dist = calMag.Distance(MagRefsInBodyFrame[i]);
+        if (bestDist > dist)
+        {
+            bestDist = dist;
+            closest  = i;
+        }
+    }
+
+    if (closest < 0)
+    {   // Nothing to anchor against; the saved references can't be trusted
+        MagNumReferences = 0;
+        MagRefIdx        = -1;
+        return;
+    }
+
+    Vector3f saved   = MagRefsInWorldFrame[closest];
+    Vector3f current = Q.Rotate(calMag);
+    saved.y = current.y = 0;
+    if (saved.LengthSq() < Mathf::Tolerance || current.LengthSq() < Mathf::Tolerance)
+        return;
+
+    float yaw = atan2(saved.z * current.x - saved.x * current.z, saved.Dot(current));
+    Quatf realign(Vector3f(0, 1, 0), yaw);
+    for (int i = 0; i < MagNumReferences; i++)
+        MagRefsInWorldFrame[i] = realign.Rotate(MagRefsInWorldFrame[i]);
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** Warm-start State
+
+namespace {
+
+// Little-endian serializer for the state blob. When constructed without a
+// buffer it only counts the bytes, which is how the blob size is computed.
+class FusionStateWriter
+{
+    UByte* pBuffer;
+    int    Size;
+    int    Pos;
+public:
+    FusionStateWriter(UByte* buffer, int size) : pBuffer(buffer), Size(size), Pos(0) { }
+
+    int  GetPos() const { return Pos; }
+
+    void Write(const void* src, int size)
+    {
+        if (pBuffer && Pos + size <= Size)
+            memcpy(pBuffer + Pos, src, size);
+        Pos += size;
+    }
+    void WriteUInt8(UByte v)     { Write(&v, 1); }
+    void WriteUInt16(UInt16 v)   { v = Alg::ByteUtil::SystemToLE(v); Write(&v, 2); }
+    void WriteUInt32(UInt32 v)   { v = Alg::ByteUtil::SystemToLE(v); Write(&v, 4); }
+    void WriteSInt64(SInt64 v)   { v = Alg::ByteUtil::SystemToLE(v); Write(&v, 8); }
+    void WriteFloat(float v)     { v = Alg::ByteUtil::SystemToLE(v); Write(&v, 4); }
+    void WriteVector(const Vector3f& v) { WriteFloat(v.x); WriteFloat(v.y); WriteFloat(v.z); }
+};
+
+class FusionStateReader
+{
+    const UByte* pBuffer;
+    int          Size;
+    int          Pos;
+public:
+    FusionStateReader(const UByte* buffer, int size) : pBuffer(buffer), Size(size), Pos(0) { }
+
+    // True if every read so far was within the buffer
+    bool IsValid() const { return Pos <= Size; }
+
+    void Skip(int size)  { Pos += size; }
+
+    void Read(void* dest, int size)
+    {
+        if (Pos + size <= Size)
+            memcpy(dest, pBuffer + Pos, size);
+        else
+            memset(dest, 0, size);
+        Pos += size;
+    }
+    UByte  ReadUInt8()   { UByte v;  Read(&v, 1); return v; }
+    UInt16 ReadUInt16()  { UInt16 v; Read(&v, 2); return Alg::ByteUtil::LEToSystem(v); }
+    UInt32 ReadUInt32()  { UInt32 v; Read(&v, 4); return Alg::ByteUtil::LEToSystem(v); }
+    SInt64 ReadSInt64()  { SInt64 v; Read(&v, 8); return Alg::ByteUtil::LEToSystem(v); }
+    float  ReadFloat()   { float v;  Read(&v, 4); return Alg::ByteUtil::LEToSystem(v); }
+    Vector3f ReadVector()
+    {
+        Vector3f v;
+        v.x = ReadFloat(); v.y = ReadFloat(); v.z = ReadFloat();
+        return v;
+    }
+};
+
+// Versions 1 and 2 end with the filter histories, which are no longer restored: their
+// samples are stale by the time the state is loaded. Checks a history against the
+// capacity of the filter it was saved from, and skips it.
+bool SensorFusion_SkipFilter(FusionStateReader& r, int capacity, int elementSize)
+{
+    int count = r.ReadUInt16();
+    r.Skip(count * elementSize);
+    return count <= capacity && r.IsValid();
+}
+
+} // namespace
+
+int SensorFusion::SaveState(UByte* buffer, int bufferSize) const
+{
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+
+    // First pass only measures the blob
+    FusionStateWriter measure(NULL, 0);
+    FusionStateWriter output(buffer, bufferSize);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        FusionStateWriter& w = (pass == 0) ? measure : output;
+        if (pass == 1 && (buffer == NULL || bufferSize < measure.GetPos()))
+            break;
+
+        w.WriteUInt32(FUSION_STATE_MAGIC);
+        w.WriteUInt16(FUSION_STATE_VERSION);
+        w.Write(CachedSensorInfo.SerialNumber, sizeof(CachedSensorInfo.SerialNumber));
+
+        w.WriteVector(GyroOffset);
+        w.WriteFloat(GyroOffsetTemperature);
+
+        w.WriteFloat(GyroTempCal.GetMinTemperature());
+        w.WriteFloat(GyroTempCal.GetBinWidth());
+        w.WriteUInt16((UInt16)GyroTempCalibration::BinCount);
+        for (int i = 0; i < GyroTempCalibration::BinCount; i++)
+        {
+            w.WriteVector(GyroTempCal.GetBin(i).Bias);
+            w.WriteFloat(GyroTempCal.GetBin(i).Weight);
+        }
+
+        w.WriteUInt8(MagCalibrated ? 1 : 0);
+        w.WriteUInt8(EnableYawCorrection ? 1 : 0);
+        w.WriteSInt64((SInt64)MagCalibrationTime);
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++)
+                w.WriteFloat(MagCalibrationMatrix.M[r][c]);
+
+        w.WriteUInt16((UInt16)MagNumReferences);
+        for (int i = 0; i < MagNumReferences; i++)
+        {
+            w.WriteVector(MagRefsInBodyFrame[i]);
+            w.WriteVector(MagRefsInWorldFrame[i]);
+        }
+    }
+
+    return measure.GetPos();
+}
+
+bool SensorFusion::RestoreState(const UByte* buffer, int bufferSize)
+{
+    if (buffer == NULL)
+        return false;
+
+    FusionStateReader r(buffer, bufferSize);
+    if (r.ReadUInt32() != FUSION_STATE_MAGIC)
+        return false;
+    // Version 1 blobs lack the temperature table; versions before 3 have filter histories
+    int version = r.ReadUInt16();
+    if (version < 1 || version > FUSION_STATE_VERSION)
+        return false;
+
+    char serial[sizeof(CachedSensorInfo.SerialNumber)];
+    r.Read(serial, sizeof(serial));
+    serial[sizeof(serial) - 1] = 0;
+    if (strncmp(serial, CachedSensorInfo.SerialNumber, sizeof(serial)) != 0)
+        return false;
+
+    Lock::Locker lockScope(Handler.GetHandlerLock());
+
+    // The whole blob is read and checked before any state changes, so a malformed
+    // blob leaves the fusion state as it was.
+    Vector3f gyroOffset            = r.ReadVector();
+    float    gyroOffsetTemperature = r.ReadFloat();
+
+    GyroTempCalibration gyroTempCal;
+    if (version >= 2)
+    {
+        float minTemperature = r.ReadFloat();
+        float binWidth       = r.ReadFloat();
+        if (binWidth <= 0 || r.ReadUInt16() != GyroTempCalibration::BinCount)
+            return false;
+        gyroTempCal = GyroTempCalibration(minTemperature, binWidth);
+        for (int i = 0; i < GyroTempCalibration::BinCount; i++)
+        {
+            GyroTempCalibration::Bin bin;
+            bin.Bias   = r.ReadVector();
+            bin.Weight = r.ReadFloat();
+            gyroTempCal.SetBin(i, bin);
+        }
+    }
+
+    bool     magCalibrated         = r.ReadUInt8() != 0;
+    bool     enableYawCorrection   = r.ReadUInt8() != 0;
+    time_t   magCalibrationTime    = (time_t)r.ReadSInt64();
+    Matrix4f magCalibration;
+    for (int row = 0; row < 4; row++)
+        for (int c = 0; c < 4; c++)
+            magCalibration.M[row][c] = r.ReadFloat();
+
+    int magNumReferences = r.ReadUInt16();
+    if (magNumReferences > MagMaxReferences)
+        return false;
+    Vector3f magRefsInBodyFrame[MagMaxReferences];
+    Vector3f magRefsInWorldFrame[MagMaxReferences];
+    for (int i = 0; i < magNumReferences; i++)
+    {
+        magRefsInBodyFrame[i]  = r.ReadVector();
+        magRefsInWorldFrame[i] = r.ReadVector();
+    }
+
+    if (version < 3 &&
+        (!SensorFusion_SkipFilter(r, FRawMag.GetCapacity(), 3 * sizeof(float)) ||
+         !SensorFusion_SkipFilter(r, FAngV.GetCapacity(), 3 * sizeof(float)) ||
+         !SensorFusion_SkipFilter(r, TiltAngleFilter.GetCapacity(), sizeof(float))))
+        return false;
+    if (!r.IsValid())
+        return false;
+
+    GyroOffset            = gyroOffset;
+    GyroOffsetTemperature = gyroOffsetTemperature;
+    GyroOffsetKnown       = true;
+    if (version >= 2)
+        GyroTempCal       = gyroTempCal;
+    TempBiasValid         = false;
+
+    // Devices.json stays authoritative; only take a calibration that is at least as recent
+    if (magCalibrated && (!MagCalibrated || magCalibrationTime >= MagCalibrationTime))
+    {
+        MagCalibrationMatrix = magCalibration;
+        MagCalibrationTime   = magCalibrationTime;
+        MagCalibrated        = true;
+        EnableYawCorrection  = enableYawCorrection;
+    }
+
+    for (int i = 0; i < magNumReferences; i++)
+    {
+        MagRefsInBodyFrame[i]  = magRefsInBodyFrame[i];
+        MagRefsInWorldFrame[i] = magRefsInWorldFrame[i];
+    }
+    MagNumReferences = magNumReferences;
+    MagRefIdx        = -1;
+    MagRefsRestored  = (MagNumReferences > 0);
+    return true;
+}
+
+String SensorFusion::getStateFilePath() const
+{
+    String path = GetBaseOVRPath(true);
+    path += "/FusionState_";
+    path += CachedSensorInfo.SerialNumber;
+    path += ".bin";
+    return path;
+}
+
+bool SensorFusion::SaveStateFile() const
+{
+    if (CachedSensorInfo.SerialNumber[0] == 0)
+        return false;
+
+    UByte* buffer;
+    int    size;
+    {
+        // Measured and written under the same lock, so no sample can change the size
+        // in between; the lock is recursive
+        Lock::Locker lockScope(Handler.GetHandlerLock());
+        size   = SaveState(NULL, 0);
+        buffer = (UByte*)OVR_ALLOC(size);
+        SaveState(buffer, size);
+    }
+
+    bool    result = false;
+    SysFile file;
+    if (file.Open(getStateFilePath(), File::Open_Write | File::Open_Create | File::Open_Truncate))
+    {
+        result = (file.Write(buffer, size) == size);
+        file.Close();
+    }
+
+    OVR_FREE(buffer);
+    return result;
+}
+
+bool SensorFusion::LoadStateFile()
+{
+    if (CachedSensorInfo.SerialNumber[0] == 0)
+        return false;
+
+    SysFile file(getStateFilePath());
+    if (!file.IsValid())
+        return false;
+
+    int    size   = file.GetLength();
+    if (size <= 0)
+    {
+        file.Close();
+        return false;
+    }
+
+    UByte* buffer = (UByte*)OVR_ALLOC(size);
+    bool   result = (file.Read(buffer, size) == size) && RestoreState(buffer, size);
+    file.Close();
+
+    OVR_FREE(buffer);
+    return result;
+}
+
 SensorFusion::BodyFrameHandler::~BodyFrameHandler()
 {
     RemoveHandlerFromDevices();
@@ -477,7 +1233,78 @@ bool SensorFusion::SaveMagCalibration(const char* calibrationName) const
     // Create and the add the new calibration event to the device
     device->AddItem("MagCalibration", calibration);
 
-    return root->Save(path);
+    bool result = root->Save(path);
+    StoreCache::Invalidate(path);
+    return result;
+}
+
+// A MagCalibration of a device in the store cache of the device profile file.
+struct DeviceStoreRecord
+{
+    UInt32  Name;
+    UInt32  Time;           // As written, since it's converted to local time when loaded.
+    UInt32  HasTime;
+    SInt32  Version;        // Major version
+    float   Matrix[16];
+};
+
+// Entry flags of the device store.
+enum
+{
+    DeviceStore_EnableYawCorrection = 0x1
+};
+
+// Compiles the device profile file into a StoreCache with an entry per device, keyed by
+// serial number, holding the calibrations that follow the serial number.
+static bool CompileDeviceStore(const JSONValue* root, StoreCacheBuilder* builder)
+{
+    // Quick sanity check of the file type and format before we parse it
+    const JSONValue* version = root->GetFirstItem();
+    if (!version || OVR_strcmp(version->Name, "Oculus Device Profile Version") != 0)
+        return false;
+    if (atoi(version->Value) > MAX_DEVICE_PROFILE_MAJOR_VERSION)
+        return false;   // don't parse the file on unsupported major version number
+
+    for (const JSONValue* device = root->GetNextItem(version); device;
+         device = root->GetNextItem(device))
+    {
+        if (OVR_strcmp(device->Name, "Device") != 0)
+            continue;
+
+        const JSONValue* item = device->GetItemByName("Serial");
+        if (item == NULL)
+            continue;
+
+        const JSONValue* autoyaw = device->GetItemByName("EnableYawCorrection");
+        builder->AddEntry(item->Value, (autoyaw && autoyaw->dValue != 0) ? DeviceStore_EnableYawCorrection : 0);
+
+        for (item = device->GetNextItem(item); item; item = device->GetNextItem(item))
+        {
+            if (OVR_strcmp(item->Name, "MagCalibration") != 0)
+                continue;
+
+            const JSONValue* name = item->GetItemByName("Name");
+            const JSONValue* cal  = item->GetItemByName("CalibrationMatrix");
+            if (cal == NULL)
+                cal = item->GetItemByName("Calibration");
+            if (name == NULL || cal == NULL)
+                continue;
+
+            const JSONValue* calversion = item->GetItemByName("Version");
+            const JSONValue* caltime    = item->GetItemByName("Time");
+            Matrix4f         calmat     = Matrix4f::FromString(cal->Value);
+
+            DeviceStoreRecord record;
+            record.Name    = builder->AddString(name->Value);
+            record.Time    = caltime ? builder->AddString(caltime->Value) : 0;
+            record.HasTime = (caltime != NULL);
+            record.Version = calversion ? atoi(calversion->Value) : 0;
+            memcpy(record.Matrix, calmat.M, sizeof(record.Matrix));
+            builder->AddRecord(&record);
+        }
+    }
+
+    return true;
 }
 
 // Loads a saved calibration for the specified device from the device profile file
@@ -496,118 +1323,76 @@ bool SensorFusion::LoadMagCalibration(const char* calibrationName)
     String path = GetBaseOVRPath(true);
     path += "/Devices.json";
 
-    // Load the device profiles
-    Ptr<JSON> root = *JSON::Load(path);
-    if (root == NULL)
-        return false;
-
-    // Quick sanity check of the file type and format before we parse it
-    JSON* version = root->GetFirstItem();
-    if (version && version->Name == "Oculus Device Profile Version")
-    {   
-        int major = atoi(version->Value.ToCStr());
-        if (major > MAX_DEVICE_PROFILE_MAJOR_VERSION)
-            return false;   // don't parse the file on unsupported major version number
-    }
-    else
-    {
+    // Look up the device in the compiled device profiles
+    Ptr<StoreCache> store = *StoreCache::Open(path, DEVICE_STORE_KIND, sizeof(DeviceStoreRecord),
+                                              CompileDeviceStore);
+    if (store == NULL)
         return false;
-    }
 
-    bool autoEnableCorrection = false;    
+    // A hand edited file may list the device more than once. The calibrations of all its
+    // entries are considered; of equal versions the first one wins, which is the one
+    // SaveMagCalibration updates.
+    const char* serial                = CachedSensorInfo.SerialNumber;
+    int         maxCalibrationVersion = 0;
 
-    JSON* device = root->GetNextItem(version);
-    while (device)
-    {   // Search for a previous calibration with the same name for this device
-        // and remove it before adding the new one
-        if (device->Name == "Device")
-        {   
-            JSON* item = device->GetItemByName("Serial");
-            if (item && item->Value == CachedSensorInfo.SerialNumber)
-            {   // found an entry for this device
+    for (int device = store->FindEntry(serial); device >= 0; device = store->FindEntry(serial, device))
+    {
+        bool autoEnableCorrection = (store->GetFlags(device) & DeviceStore_EnableYawCorrection) != 0;
 
-                JSON* autoyaw = device->GetItemByName("EnableYawCorrection");
-                if (autoyaw)
-                    autoEnableCorrection = (autoyaw->dValue != 0);
+        for (int i = 0; i < store->GetRecordCount(device); i++)
+        {
+            const DeviceStoreRecord* calibration = (const DeviceStoreRecord*)store->GetRecord(device, i);
+            if (calibration == NULL)
+                break;
+            if (OVR_strcmp(store->GetString(calibration->Name), calibrationName) != 0)
+                continue;
+
+            int major = calibration->Version;
+            if (major > maxCalibrationVersion && major <= 2)
+            {
+                time_t now;
+                time(&now);
 
-                int maxCalibrationVersion = 0;
-                item = device->GetNextItem(item);
-                while (item)
+                // parse the calibration time
+                time_t calibration_time = now;
+                if (calibration->HasTime)
                 {
-                    if (item->Name == "MagCalibration")
-                    {   
-                        JSON* calibration = item;
-                        JSON* name = calibration->GetItemByName("Name");
-                        if (name && name->Value == calibrationName)
-                        {   // found a calibration with this name
-                            
-                            int major = 0;
-                            JSON* version = calibration->GetItemByName("Version");
-                            if (version)
-                                major = atoi(version->Value.ToCStr());
-
-                            if (major > maxCalibrationVersion && major <= 2)
-                            {
-                                time_t now;
-                                time(&now);
-
-                                // parse the calibration time
-                                time_t calibration_time = now;
-                                JSON* caltime = calibration->GetItemByName("Time");
-                                if (caltime)
-                                {
-                                    const char* caltime_str = caltime->Value.ToCStr();
-
-                                    tm ct;
-                                    memset(&ct, 0, sizeof(tm));
+                    const char* caltime_str = store->GetString(calibration->Time);
+
+                    tm ct;
+                    memset(&ct, 0, sizeof(tm));
                             
 #ifdef OVR_OS_WIN32
-                                    struct tm nowtime;
-                                    localtime_s(&nowtime, &now);
-                                    ct.tm_isdst = nowtime.tm_isdst;
-                                    sscanf_s(caltime_str, "%d-%d-%d %d:%d:%d", 
-                                        &ct.tm_year, &ct.tm_mon, &ct.tm_mday,
-                                        &ct.tm_hour, &ct.tm_min, &ct.tm_sec);
+                    struct tm nowtime;
+                    localtime_s(&nowtime, &now);
+                    ct.tm_isdst = nowtime.tm_isdst;
+                    sscanf_s(caltime_str, "%d-%d-%d %d:%d:%d", 
+                        &ct.tm_year, &ct.tm_mon, &ct.tm_mday,
+                        &ct.tm_hour, &ct.tm_min, &ct.tm_sec);
 #else
-                                    struct tm* nowtime = localtime(&now);
-                                    ct.tm_isdst = nowtime->tm_isdst;
-                                    sscanf(caltime_str, "%d-%d-%d %d:%d:%d", 
-                                        &ct.tm_year, &ct.tm_mon, &ct.tm_mday,
-                                        &ct.tm_hour, &ct.tm_min, &ct.tm_sec);
+                    struct tm* nowtime = localtime(&now);
+                    ct.tm_isdst = nowtime->tm_isdst;
+                    sscanf(caltime_str, "%d-%d-%d %d:%d:%d", 
+                        &ct.tm_year, &ct.tm_mon, &ct.tm_mday,
+                        &ct.tm_hour, &ct.tm_min, &ct.tm_sec);
 #endif
-                                    ct.tm_year -= 1900;
-                                    ct.tm_mon--;
-                                    calibration_time = mktime(&ct);
-                                }
-                                                        
-                                // parse the calibration matrix
-                                JSON* cal = calibration->GetItemByName("CalibrationMatrix");
-                                if (cal == NULL)
-                                    cal = calibration->GetItemByName("Calibration");
-                               
-                                if (cal)
-                                {
-                                    Matrix4f calmat = Matrix4f::FromString(cal->Value.ToCStr());
-                                    SetMagCalibration(calmat);
-                                    MagCalibrationTime  = calibration_time;
-                                    EnableYawCorrection = autoEnableCorrection;
-
-                                    maxCalibrationVersion = major;
-                                }
-                            }
-                        } 
-                    }
-                    item = device->GetNextItem(item);
+                    ct.tm_year -= 1900;
+                    ct.tm_mon--;
+                    calibration_time = mktime(&ct);
                 }
 
-                return (maxCalibrationVersion > 0);
+                Matrix4f calmat;
+                memcpy(calmat.M, calibration->Matrix, sizeof(calmat.M));
+                SetMagCalibration(calmat);
+                MagCalibrationTime  = calibration_time;
+                EnableYawCorrection = autoEnableCorrection;
+
+                maxCalibrationVersion = major;
             }
         }
-
-        device = root->GetNextItem(device);
     }
-    
-    return false;
+
+    return (maxCalibrationVersion > 0);
 }
 
 
@@ -30,6 +30,10 @@ limitations under the License.
 
 #include "OVR_Device.h"
 #include "OVR_SensorFilter.h"
+#include "OVR_SensorCalibration.h"
+#include "OVR_PredictionMonitor.h"
+#include "OVR_OrientationHistory.h"
+#include "OVR_LatencyTrace.h"
 #include <time.h>
 
 namespace OVR {
@@ -78,12 +82,40 @@ public:
 
     // Obtain the current accumulated orientation. Many apps will want to use GetPredictedOrientation
     // instead to reduce latency.
-    Quatf       GetOrientation() const      { return lockedGet(&Q); }
+    Quatf       GetOrientation() const;
 
     // Get predicted orientaion in the near future; predictDt is lookahead amount in seconds.
     Quatf       GetPredictedOrientation(float predictDt);
     Quatf       GetPredictedOrientation()   { return GetPredictedOrientation(PredictionDT); }
 
+    // Get the orientation predicted for an absolute time on the Timer::GetSeconds clock,
+    // such as the time the next frame will be scanned out. The lookahead is measured from
+    // the latest sample, so it does not depend on when this function is called.
+    Quatf       GetPredictedOrientationAt(double absoluteTime);
+
+    // Get the orientations predicted for several absolute times, all extrapolated from
+    // the same sample. Rolling-scanout panels light each row at a different time, so
+    // e.g. a few points spread over each eye's scanout let every row be corrected for
+    // the orientation at the time it is shown.
+    void        GetPredictedOrientations(const double* absoluteTimes, int count, Quatf* orientations);
+    // Same for count times evenly spaced from startTime to endTime, both included.
+    void        GetPredictedOrientations(double startTime, double endTime, int count, Quatf* orientations);
+
+    // Obtain the host time (Timer::GetSeconds) at which the latest sample was taken.
+    double      GetSampleTime() const       { return lockedGet(&SampleTime); }
+
+    // Obtain the orientation and angular velocity (rad/s) the sensor had at a past time
+    // on the Timer::GetSeconds clock, such as the time a frame was rendered. About one
+    // second of history is retained; returns false if the time falls outside of it.
+    // Does not lock, so it may be called from any thread without stalling the sensor.
+    bool        GetOrientationAt(double absoluteTime, Quatf* orientation,
+                                 Vector3f* angularVelocity = NULL) const;
+    // Obtain the time span covered by the orientation history.
+    bool        GetHistoryRange(double* oldest, double* newest) const
+    {
+        return History.GetRange(oldest, newest);
+    }
+
     // Obtain the last absolute acceleration reading, in m/s^2.
     Vector3f    GetAcceleration() const     { return lockedGet(&A); }
     // Obtain the last angular velocity reading, in rad/s.
@@ -98,6 +130,17 @@ public:
     // Resets the current orientation.
     void        Reset();
 
+    // After a reset, the initial attitude and gyro bias are solved in one shot from a
+    // window of samples taken while the device is at rest. Returns true once that
+    // alignment has succeeded.
+    bool        IsAligned() const           { return Alignment.Done && !Alignment.TimedOut; }
+    // Returns true if the device never settled within the first seconds, so alignment was
+    // given up and the running filter converges on its own.
+    bool        IsAlignmentTimedOut() const { return Alignment.TimedOut; }
+    // Seconds of sensor time from the reset until the orientation was aligned, or a
+    // negative value while alignment is still in progress or after it timed out.
+    float       GetAlignmentTime() const    { return IsAligned() ? Alignment.Time : -1.0f; }
+
 
 
     // *** Configuration
@@ -118,6 +161,30 @@ public:
     void		SetPredictionEnabled(bool enable = true)    { EnablePrediction = enable; }    
     bool		IsPredictionEnabled()                       { return EnablePrediction; }
 
+    // Every prediction served is checked against the orientation reached at its target
+    // time; the errors are collected by head angular speed.
+    PredictionErrorStats GetPredictionErrorStats() const    { return lockedGet(&Monitor.GetStats()); }
+    void        ResetPredictionErrorStats();
+
+    // Lets the monitor tune the horizon scale and the damping of the angular acceleration
+    // term to minimize the measured error (off by default).
+    void        SetAdaptivePredictionEnabled(bool enable = true);
+    bool        IsAdaptivePredictionEnabled() const         { return Monitor.IsAdaptationEnabled(); }
+    float       GetPredictionHorizonScale() const;
+    float       GetPredictionDamping() const;
+
+
+    // *** Output Filter Control
+
+    // Smooths the orientations returned by GetOrientation and the GetPredictedOrientation
+    // functions with a One-Euro filter, whose cutoff starts at minCutoff (Hz) for a still
+    // head and rises by beta Hz per rad/s of angular speed (off by default). The filter
+    // follows the orientation at the sensor rate and predictions extrapolate from its
+    // output, so any number of queries per frame, for any target times, agree.
+    void        SetOutputFilter(float minCutoff, float beta, bool enable = true);
+    void        SetOutputFilterEnabled(bool enable = true);
+    bool        IsOutputFilterEnabled() const               { return EnableOutputFilter; }
+
 
     // *** Accelerometer/Gravity Correction Control
 
@@ -130,6 +197,33 @@ public:
     void        SetAccelGain(float ag)                      { Gain = ag; }
 
 
+    // *** Correction Scheduling
+
+    // Gyro integration always runs at the sensor rate (1 kHz). The gravity correction
+    // (including spike detection and rest detection) and the magnetometer yaw correction
+    // can run at lower rates; each pass applies its correction over the exact time
+    // accumulated since the previous one. A rate of 0 runs the stage on every sample.
+    // Defaults are 250 Hz for gravity and 100 Hz for yaw correction.
+    void        SetCorrectionRates(float gravityHz, float yawHz);
+    float       GetGravityCorrectionRate() const { return GravityCorrectionPeriod > 0 ? 1.0f / GravityCorrectionPeriod : 0.0f; }
+    float       GetYawCorrectionRate() const     { return YawCorrectionPeriod > 0 ? 1.0f / YawCorrectionPeriod : 0.0f; }
+
+
+    // *** Gyro Temperature Compensation
+
+    // When enabled (default), the gyro bias is learned as a function of the sensor temperature
+    // whenever the device is at rest, and subtracted before the integral drift correction.
+    // This keeps the bias valid while the headset warms up.
+    void        SetGyroTempCompensationEnabled(bool enable) { EnableGyroTempCompensation = enable; }
+    bool        IsGyroTempCompensationEnabled() const       { return EnableGyroTempCompensation; }
+
+    const GyroTempCalibration& GetGyroTempCalibration() const { return GyroTempCal; }
+    void        ClearGyroTempCalibration();
+
+    // Returns true if the latest samples indicate the device is at rest.
+    bool        IsStationary() const                        { return Stationary; }
+
+
     // *** Magnetometer and Yaw Drift Correction Control
 
     // Methods to load and save a mag calibration.  Calibrations can optionally
@@ -170,6 +264,28 @@ public:
     Vector3f    GetCalibratedMagValue(const Vector3f& rawMag) const;
 
 
+    // *** Warm-start State
+
+    // The learned state (gyro bias and the temperature it was learned at, the temperature
+    // bias table, mag reference points and mag calibration) can be checkpointed into a
+    // compact binary blob tagged with the sensor serial number, so that a restarted
+    // application does not need to wait for the bias and yaw references to converge again.
+    // Filter histories are not kept; they would be stale by the next run.
+    // AttachToSensor automatically restores the state saved by SaveStateFile; saving is
+    // up to the application.
+
+    // Serializes the state into buffer. Returns the number of bytes the state needs;
+    // nothing is written if buffer is NULL or bufferSize is smaller than that.
+    int         SaveState(UByte* buffer, int bufferSize) const;
+    // Restores a blob produced by SaveState. Fails if the blob is malformed or was
+    // recorded for a different sensor.
+    bool        RestoreState(const UByte* buffer, int bufferSize);
+
+    // Writes/reads the state to "FusionState_<Serial>.bin" next to Devices.json.
+    bool        SaveStateFile() const;
+    bool        LoadStateFile();
+
+
 
     // *** Message Handler Logic
 
@@ -201,12 +317,66 @@ private:
     // Internal handler for messages; bypasses error checking.
     void        handleMessage(const MessageBodyFrame& msg);
 
+    // Maps the sensor clock of the latest sample onto the host clock.
+    void        updateSampleTime();
+
+    // Extrapolates Q by dt seconds past the latest sample and logs the prediction;
+    // the handler lock must be held.
+    Quatf       predict(float dt);
+    // Bias-free angular velocity and acceleration to extrapolate with.
+    void        predictionRates(Vector3f* angVel, Vector3f* angAcc) const;
+    // Batch prediction for the given times, or for startTime + i * step when times is NULL;
+    // the handler lock must be held.
+    void        predictBatch(const double* times, double startTime, double step,
+                             int count, Quatf* orientations);
+    // The orientation returned to the application: the output filter's, if enabled.
+    Quatf       getOutputOrientation() const    { return EnableOutputFilter ? FilteredQ : Q; }
+
     // Set the magnetometer's reference orientation for use in yaw correction
     // The supplied mag is an uncalibrated value
     void        setMagReference(const Quatf& q, const Vector3f& rawMag);
     // Default to current HMD orientation
     void        setMagReference()  { setMagReference(Q, RawMag); }
 
+    // Rotates restored world frame mag references about the vertical axis so that they
+    // agree with the current (reset) yaw; called on the first yaw correction step.
+    void        anchorRestoredMagReferences(const Vector3f& calMag);
+
+    String      getStateFilePath() const;
+
+    // Accumulates startup samples and solves for the initial attitude once they are still.
+    void        updateAlignment(const Vector3f& gyro, const Vector3f& accel, const Vector3f& rawMag);
+
+    // Detects whether the device is at rest from the gyro and accelerometer histories;
+    // dt is the time since the previous call.
+    bool        detectStationary(const Vector3f& accel, float dt);
+    // True if gyro and accelerometer statistics show no motion, only sensor noise.
+    bool        isStill(const Vector3f& gyroVar, const Vector3f& accel, const Vector3f& accelVar) const;
+    // True if the mean gyro rate of a still window is the zero-rate offset, not a steady turn.
+    bool        isZeroRate(const Vector3f& gyroMean, float stillTime) const;
+    // Learns the temperature dependent gyro bias while the device is at rest; dt is the
+    // time since the previous call.
+    void        updateGyroTempCalibration(float dt);
+
+    // Running statistics of the startup alignment window.
+    struct AlignmentState
+    {
+        bool     Done;
+        bool     TimedOut;
+        float    Time;
+        int      Count;
+        Vector3f AccelMean, AccelM2;
+        Vector3f GyroMean,  GyroM2;
+        Vector3f MagMean;
+
+        AlignmentState() { Restart(); Done = TimedOut = false; Time = 0; }
+        void Restart()
+        {
+            Count = 0;
+            AccelMean = AccelM2 = GyroMean = GyroM2 = MagMean = Vector3f();
+        }
+    };
+
 	class BodyFrameHandler : public MessageHandler
     {
         SensorFusion* pFusion;
@@ -226,9 +396,14 @@ private:
     Vector3f          AngV;
     Vector3f          CalMag;
     Vector3f          RawMag;
+    float             Temperature;
     unsigned int      Stage;
 	float             RunningTime;
 	float             DeltaT;
+    double            SensorTime;       // Sum of all sample deltas; never reset
+    double            HostTimeOffset;   // Host clock minus sensor clock
+    bool              HostTimeValid;
+    double            SampleTime;
     BodyFrameHandler  Handler;
     MessageHandler*   pDelegate;
     float             Gain;
@@ -237,12 +412,39 @@ private:
     bool              EnablePrediction;
     float             PredictionDT;
 	float             PredictionTimeIncrement;
+    PredictionMonitor Monitor;
+    OrientationHistory History;
+#ifdef OVR_ENABLE_LATENCY_TRACE
+    mutable LatencyTrace::Stamp TraceStamp;    // Of the newest sample until it is read.
+#endif
+
+    bool              EnableOutputFilter;
+    OrientationFilter OutputFilter;
+    Quatf             FilteredQ;
+    Vector3f          FilteredAngVel, FilteredAngAcc;
 
-    SensorFilter      FRawMag;
-    SensorFilter      FAngV;
+    SensorFilter<10>  FRawMag;
+    SensorFilter<20>  FAngV;
+    SensorFilter<20>  FAccel;           // Only fed at the gravity correction rate
 
     Vector3f          GyroOffset;
-    SensorFilterBase<float> TiltAngleFilter;
+    Vector3f          GyroBias;         // Total bias removed from the latest gyro sample
+    float             GyroOffsetTemperature;
+    bool              EnableGyroTempCompensation;
+    GyroTempCalibration GyroTempCal;
+    bool              TempBiasValid;
+    float             TempBiasTemperature;
+    Vector3f          TempBias;
+    bool              Stationary;
+    float             StillTime;        // Time the device has been still, whatever its mean rate
+    bool              GyroOffsetKnown;  // GyroOffset was aligned or restored, not just reset
+    AlignmentState    Alignment;
+
+    float             GravityCorrectionPeriod;
+    float             YawCorrectionPeriod;
+    float             GravityCorrectionDT;
+    float             YawCorrectionDT;
+    SensorFilterBase<float, 1000> TiltAngleFilter;
 
 
     bool              EnableYawCorrection;
@@ -254,6 +456,7 @@ private:
     Vector3f          MagRefsInWorldFrame[MagMaxReferences];
     int               MagRefIdx;
     int               MagRefScore;
+    bool              MagRefsRestored;
 
     bool              MotionTrackingEnabled;
 };
@@ -29,6 +29,7 @@ limitations under the License.
 // HMDDeviceDesc can be created/updated through Sensor carrying DisplayInfo.
 
 #include "Kernel/OVR_Timer.h"
+#include "OVR_LatencyTrace.h"
 
 namespace OVR {
     
@@ -609,6 +610,7 @@ void SensorDeviceImpl::OnInputReport(UByte* pData, UInt32 length)
         TrackerMessage message;
         if (DecodeTrackerMessage(&message, pData, length))
         {
+            OVR_LATENCY_TRACE(LatencyTrace_Decoded);
             processed = true;
             onTrackerMessage(&message);
         }
@@ -856,6 +858,7 @@ void SensorDeviceImpl::onTrackerMessage(TrackerMessage* message)
                 sensors.MagneticField = LastMagneticField;
                 sensors.Temperature   = LastTemperature;
 
+                OVR_LATENCY_TRACE(LatencyTrace_Dispatched);
                 HandlerRef.GetHandler()->OnMessage(sensors);
             }
         }
@@ -895,6 +898,7 @@ void SensorDeviceImpl::onTrackerMessage(TrackerMessage* message)
             sensors.RotationRate = EulerFromBodyFrameUpdate(s, i, convertHMDToSensor);
             sensors.MagneticField= MagFromBodyFrameUpdate(s, convertHMDToSensor);
             sensors.Temperature  = s.Temperature * 0.01f;
+            OVR_LATENCY_TRACE(LatencyTrace_Dispatched);
             HandlerRef.GetHandler()->OnMessage(sensors);
             // TimeDelta for the last two sample is always fixed.
             sensors.TimeDelta = timeUnit;
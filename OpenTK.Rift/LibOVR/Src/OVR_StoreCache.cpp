@@ -0,0 +1,503 @@
+/************************************************************************************
+
+Filename    :   OVR_StoreCache.cpp
+Content     :   Memory-mapped binary cache of the JSON profile and device stores
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_StoreCache.h"
+#include "OVR_JSON.h"
+#include "Kernel/OVR_SysFile.h"
+#include "Kernel/OVR_Atomic.h"
+#include "Kernel/OVR_UTF8Util.h"
+
+#include <time.h>
+
+#ifdef OVR_OS_WIN32
+#include <windows.h>
+#else
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define STORE_CACHE_MAGIC   0x4352564F  // "OVRC"
+#define STORE_CACHE_VERSION 2
+
+namespace OVR {
+
+static UInt32 hashKey(const char* key)
+{
+    return (UInt32)String::BernsteinHashFunction(key, OVR_strlen(key));
+}
+
+static String getCachePath(const String& jsonPath)
+{
+    String path = jsonPath;
+    if (OVR_stricmp(path.GetExtension().ToCStr(), ".json") == 0)
+        path.StripExtension();
+    path += ".cache";
+    return path;
+}
+
+// Sizes of the sections that follow the header, each a multiple of 4 bytes.
+static UPInt getEntriesSize(UInt32 entryCount)  { return entryCount * sizeof(StoreCacheEntry); }
+static UPInt getIndexSize(UInt32 indexMask)     { return ((UPInt)indexMask + 1) * sizeof(UInt32); }
+static UPInt getStringsSize(UInt32 stringSize)  { return (stringSize + 3) & ~3; }
+
+#ifdef OVR_OS_WIN32
+
+// Win32 file functions take UTF-16 paths.
+static wchar_t* decodePath(const String& path)
+{
+    wchar_t* wpath = (wchar_t*)OVR_ALLOC((UTF8Util::GetLength(path.ToCStr()) + 1) * sizeof(wchar_t));
+    UTF8Util::DecodeString(wpath, path.ToCStr());
+    return wpath;
+}
+
+#endif
+
+// Replaces the file at path by the contents of image, through a temporary file so that
+// other readers never see a partly written cache.
+// Numbers the temporary files of the threads of this process.
+static AtomicInt<UInt32> TempFileCounter;
+
+static bool writeCacheFile(const String& path, const ArrayPOD<UByte>& image)
+{
+    // Every writer has a temporary file of its own, so that processes or threads that
+    // rebuild the cache at the same time can't truncate each other's before the rename.
+    char suffix[32];
+#ifdef OVR_OS_WIN32
+    UInt32 processId = (UInt32)GetCurrentProcessId();
+#else
+    UInt32 processId = (UInt32)getpid();
+#endif
+    OVR_sprintf(suffix, sizeof(suffix), ".%u.%u.tmp", processId, TempFileCounter.ExchangeAdd_Sync(1));
+
+    String tempPath = path;
+    tempPath += suffix;
+
+    SysFile file;
+    if (!file.Open(tempPath, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_ReadWrite))
+        return false;
+
+    int  size    = (int)image.GetSize();
+    bool written = (file.Write(&image[0], size) == size);
+    file.Close();
+
+#ifdef OVR_OS_WIN32
+    wchar_t* wtemp = decodePath(tempPath);
+    wchar_t* wpath = decodePath(path);
+    bool     moved = written && MoveFileExW(wtemp, wpath, MOVEFILE_REPLACE_EXISTING) != 0;
+    if (!moved)
+        DeleteFileW(wtemp);
+    OVR_FREE(wtemp);
+    OVR_FREE(wpath);
+#else
+    bool     moved = written && rename(tempPath.ToCStr(), path.ToCStr()) == 0;
+    if (!moved)
+        unlink(tempPath.ToCStr());
+#endif
+    return moved;
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** StoreCache
+
+#ifdef OVR_OS_WIN32
+
+// The handles that keep a view of the cache file mapped.
+struct StoreCacheMapping
+{
+    HANDLE  File;
+    HANDLE  Mapping;
+};
+
+#endif
+
+StoreCache::StoreCache()
+    : pMapping(0), pImage(0), ImageSize(0),
+      pHeader(0), pEntries(0), pIndex(0), pRecords(0), pStrings(0)
+{
+}
+
+StoreCache::~StoreCache()
+{
+    unmap();
+}
+
+bool StoreCache::map(const String& path)
+{
+#ifdef OVR_OS_WIN32
+    wchar_t* wpath = decodePath(path);
+    HANDLE   file  = CreateFileW(wpath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    OVR_FREE(wpath);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    HANDLE        mapping = NULL;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && size.QuadPart < 0x7FFFFFFF)
+        mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (view == NULL)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    StoreCacheMapping* handles = new StoreCacheMapping;
+    handles->File    = file;
+    handles->Mapping = mapping;
+    pMapping         = handles;
+    pImage           = (UByte*)view;
+    ImageSize        = (UPInt)size.QuadPart;
+#else
+    int fd = open(path.ToCStr(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+    void*       view = MAP_FAILED;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0 && fileStat.st_size < 0x7FFFFFFF)
+        view = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    pMapping  = view;
+    pImage    = (UByte*)view;
+    ImageSize = (UPInt)fileStat.st_size;
+#endif
+
+    if (!setImage(pImage, ImageSize))
+    {
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+void StoreCache::unmap()
+{
+    if (pMapping)
+    {
+#ifdef OVR_OS_WIN32
+        StoreCacheMapping* handles = (StoreCacheMapping*)pMapping;
+        UnmapViewOfFile(pImage);
+        CloseHandle(handles->Mapping);
+        CloseHandle(handles->File);
+        delete handles;
+#else
+        munmap(pImage, ImageSize);
+#endif
+    }
+    else if (pImage)
+    {
+        OVR_FREE(pImage);
+    }
+
+    pMapping  = 0;
+    pImage    = 0;
+    ImageSize = 0;
+    pHeader   = 0;
+}
+
+// Checks that the sections described by the header fit the image and finds them. Each
+// entry and index slot is checked again when it's used, so a damaged file can give
+// wrong results but can't be read out of bounds.
+bool StoreCache::setImage(const UByte* data, UPInt size)
+{
+    if (size < sizeof(Header))
+        return false;
+
+    const Header* header = (const Header*)data;
+    if (header->Magic != STORE_CACHE_MAGIC || header->FormatVersion != STORE_CACHE_VERSION ||
+        header->FileSize != size || header->RecordSize == 0 || (header->RecordSize & 3) != 0 ||
+        header->StringSize == 0 || ((header->IndexMask + 1) & header->IndexMask) != 0)
+        return false;
+
+    // Sizes are compared piece by piece so that huge counts can't wrap around.
+    UPInt remaining = size - sizeof(Header);
+    UPInt entries   = getEntriesSize(header->EntryCount);
+    UPInt index     = getIndexSize(header->IndexMask);
+    UPInt strings   = getStringsSize(header->StringSize);
+    if (header->EntryCount > remaining / sizeof(StoreCacheEntry) || entries > remaining)
+        return false;
+    remaining -= entries;
+    if (header->IndexMask >= remaining / sizeof(UInt32) || index > remaining)
+        return false;
+    remaining -= index;
+    if (header->RecordCount > remaining / header->RecordSize)
+        return false;
+    remaining -= (UPInt)header->RecordCount * header->RecordSize;
+    if (strings != remaining)
+        return false;
+
+    const UByte* p = data + sizeof(Header);
+    pHeader  = header;
+    pEntries = (const StoreCacheEntry*)p;
+    pIndex   = (const UInt32*)(p + entries);
+    pRecords = p + entries + index;
+    pStrings = (const char*)(pRecords + (UPInt)header->RecordCount * header->RecordSize);
+
+    // Every string ends before the end of the pool.
+    return pStrings[header->StringSize - 1] == 0;
+}
+
+// The modification time only has a resolution of a second, so a cache built in the same
+// second as the JSON file was last written isn't trusted.
+bool StoreCache::isCurrent(UInt32 kind, UInt32 recordSize, const FileStat& source) const
+{
+    return pHeader->Kind == kind && pHeader->RecordSize == recordSize &&
+           pHeader->SourceModifyTime == source.ModifyTime &&
+           pHeader->SourceSize == source.FileSize &&
+           pHeader->BuildTime > source.ModifyTime;
+}
+
+StoreCache* StoreCache::Open(const String& jsonPath, UInt32 kind, UInt32 recordSize,
+                             CompileFunc compile)
+{
+    OVR_ASSERT(recordSize > 0 && (recordSize & 3) == 0);
+
+    FileStat source;
+    if (!SysFile::GetFileStat(&source, jsonPath))
+        return 0;
+
+    String      cachePath = getCachePath(jsonPath);
+    StoreCache* cache     = new StoreCache;
+
+    if (cache->map(cachePath))
+    {
+        if (cache->isCurrent(kind, recordSize, source))
+            return cache;
+        cache->unmap();
+    }
+
+    // Compile the JSON file and save the result for the next time.
+    Ptr<JSONDocument> document = *JSONDocument::Load(jsonPath);
+    StoreCacheBuilder builder(recordSize);
+    if (!document || !compile(document->GetRoot(), &builder))
+    {
+        cache->Release();
+        return 0;
+    }
+
+    ArrayPOD<UByte> image;
+    builder.build(&image, kind, source);
+    writeCacheFile(cachePath, image);
+
+    UByte* data = (UByte*)OVR_ALLOC(image.GetSize());
+    memcpy(data, &image[0], image.GetSize());
+    cache->pImage    = data;
+    cache->ImageSize = image.GetSize();
+    if (!cache->setImage(data, image.GetSize()))
+    {
+        OVR_ASSERT(false);
+        cache->Release();
+        return 0;
+    }
+    return cache;
+}
+
+void StoreCache::Invalidate(const String& jsonPath)
+{
+    String cachePath = getCachePath(jsonPath);
+
+#ifdef OVR_OS_WIN32
+    wchar_t* wpath = decodePath(cachePath);
+    DeleteFileW(wpath);
+    OVR_FREE(wpath);
+#else
+    unlink(cachePath.ToCStr());
+#endif
+}
+
+int StoreCache::FindEntry(const char* key, int after) const
+{
+    UInt32 hash = hashKey(key);
+    UInt32 mask = pHeader->IndexMask;
+
+    // The index is never full, but a damaged one could be, so probe each slot once.
+    for (UInt32 probe = 0, slot = hash & mask; probe <= mask; probe++, slot = (slot + 1) & mask)
+    {
+        UInt32 entry = pIndex[slot];
+        if (entry == 0 || entry > pHeader->EntryCount)
+            break;
+
+        // Entries with the same key were inserted in order, so they're probed in order
+        const StoreCacheEntry& e = pEntries[entry - 1];
+        if ((int)entry - 1 > after && e.KeyHash == hash && OVR_strcmp(GetString(e.Key), key) == 0)
+            return (int)entry - 1;
+    }
+    return -1;
+}
+
+const char* StoreCache::GetKey(int entry) const
+{
+    OVR_ASSERT(entry >= 0 && entry < GetEntryCount());
+    return GetString(pEntries[entry].Key);
+}
+
+UInt32 StoreCache::GetFlags(int entry) const
+{
+    OVR_ASSERT(entry >= 0 && entry < GetEntryCount());
+    return pEntries[entry].Flags;
+}
+
+int StoreCache::GetRecordCount(int entry) const
+{
+    OVR_ASSERT(entry >= 0 && entry < GetEntryCount());
+    return (int)pEntries[entry].RecordCount;
+}
+
+const void* StoreCache::GetRecord(int entry, int index) const
+{
+    if (entry < 0 || entry >= GetEntryCount())
+        return 0;
+
+    const StoreCacheEntry& e = pEntries[entry];
+    if (index < 0 || (UInt32)index >= e.RecordCount ||
+        e.FirstRecord >= pHeader->RecordCount ||
+        (UInt32)index >= pHeader->RecordCount - e.FirstRecord)
+        return 0;
+
+    return pRecords + (UPInt)(e.FirstRecord + index) * pHeader->RecordSize;
+}
+
+const char* StoreCache::GetString(UInt32 offset) const
+{
+    return (offset < pHeader->StringSize) ? pStrings + offset : "";
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** StoreCacheBuilder
+
+StoreCacheBuilder::StoreCacheBuilder(UInt32 recordSize)
+    : RecordSize(recordSize), HeaderString(0)
+{
+    // Offset 0 is the empty string.
+    Strings.PushBack(0);
+}
+
+UInt32 StoreCacheBuilder::AddString(const char* str)
+{
+    UPInt length = OVR_strlen(str);
+    if (length == 0)
+        return 0;
+
+    UInt32 offset = (UInt32)Strings.GetSize();
+    Strings.Resize(offset + length + 1);
+    memcpy(&Strings[offset], str, length + 1);
+    return offset;
+}
+
+void StoreCacheBuilder::SetHeaderString(const char* str)
+{
+    HeaderString = AddString(str);
+}
+
+void StoreCacheBuilder::AddEntry(const char* key, UInt32 flags)
+{
+    StoreCacheEntry entry;
+    entry.Key         = AddString(key);
+    entry.KeyHash     = hashKey(key);
+    entry.Flags       = flags;
+    entry.FirstRecord = (UInt32)(Records.GetSize() / RecordSize);
+    entry.RecordCount = 0;
+    Entries.PushBack(entry);
+}
+
+void StoreCacheBuilder::AddRecord(const void* record)
+{
+    OVR_ASSERT(Entries.GetSize() > 0);
+
+    UPInt offset = Records.GetSize();
+    Records.Resize(offset + RecordSize);
+    memcpy(&Records[offset], record, RecordSize);
+    Entries.Back().RecordCount++;
+}
+
+void StoreCacheBuilder::build(ArrayPOD<UByte>* image, UInt32 kind, const FileStat& source) const
+{
+    UInt32 entryCount = (UInt32)Entries.GetSize();
+    UInt32 indexSize  = 1;
+    while (indexSize < entryCount * 2)
+        indexSize <<= 1;
+
+    UInt32 stringSize = (UInt32)Strings.GetSize();
+    UPInt  size       = sizeof(StoreCache::Header) + getEntriesSize(entryCount) +
+                        getIndexSize(indexSize - 1) + Records.GetSize() + getStringsSize(stringSize);
+
+    image->Resize(size);
+    UByte* p = &(*image)[0];
+    memset(p, 0, size);
+
+    StoreCache::Header* header = (StoreCache::Header*)p;
+    header->Magic            = STORE_CACHE_MAGIC;
+    header->FormatVersion    = STORE_CACHE_VERSION;
+    header->Kind             = kind;
+    header->RecordSize       = RecordSize;
+    header->SourceModifyTime = source.ModifyTime;
+    header->SourceSize       = source.FileSize;
+    header->BuildTime        = (SInt64)time(NULL);
+    header->FileSize         = (UInt32)size;
+    header->EntryCount       = entryCount;
+    header->IndexMask        = indexSize - 1;
+    header->RecordCount      = (UInt32)(Records.GetSize() / RecordSize);
+    header->StringSize       = stringSize;
+    header->HeaderString     = HeaderString;
+    p += sizeof(StoreCache::Header);
+
+    if (entryCount)
+        memcpy(p, &Entries[0], getEntriesSize(entryCount));
+    p += getEntriesSize(entryCount);
+
+    // Every entry is indexed, including repeated keys; linear probing keeps entries with
+    // the same key in the order they were added.
+    UInt32* index = (UInt32*)p;
+    for (UInt32 i = 0; i < entryCount; i++)
+    {
+        UInt32 slot = Entries[i].KeyHash & (indexSize - 1);
+        while (index[slot] != 0)
+            slot = (slot + 1) & (indexSize - 1);
+        index[slot] = i + 1;
+    }
+    p += getIndexSize(indexSize - 1);
+
+    if (Records.GetSize())
+        memcpy(p, &Records[0], Records.GetSize());
+    p += Records.GetSize();
+
+    memcpy(p, &Strings[0], stringSize);
+}
+
+} // OVR
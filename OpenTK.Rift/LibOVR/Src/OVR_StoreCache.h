@@ -0,0 +1,173 @@
+/************************************************************************************
+
+PublicHeader:   None
+Filename    :   OVR_StoreCache.h
+Content     :   Memory-mapped binary cache of the JSON profile and device stores
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_StoreCache_h
+#define OVR_StoreCache_h
+
+#include "Kernel/OVR_String.h"
+#include "Kernel/OVR_RefCount.h"
+#include "Kernel/OVR_Array.h"
+
+namespace OVR {
+
+class JSONValue;
+class StoreCacheBuilder;
+struct FileStat;
+
+// An entry of a StoreCache, as stored in the file.
+struct StoreCacheEntry
+{
+    UInt32  Key;            // String offset.
+    UInt32  KeyHash;
+    UInt32  Flags;
+    UInt32  FirstRecord;
+    UInt32  RecordCount;
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** StoreCache
+
+// StoreCache is a compiled copy of one of the JSON stores in the Oculus directory, such
+// as Profiles.json or Devices.json. It is saved next to the JSON file, with the ".cache"
+// extension, and memory-mapped when opened. The cache holds a list of entries, each with
+// a key, a flags value and a run of fixed-size records, and the strings they refer to;
+// entries are found by key through a hash index, so lookups don't depend on the size of
+// the store.
+//
+// The owner of the store provides a function that compiles the parsed JSON into entries
+// and records. It is only called when the cache is missing, has another layout, or was
+// built from a JSON file with a different modification time or size; if the new cache
+// can't be written, it's used from memory.
+
+class StoreCache : public RefCountBase<StoreCache>
+{
+public:
+    // Fills in the builder from the JSON root; returns false if the file isn't usable.
+    typedef bool (*CompileFunc)(const JSONValue* root, StoreCacheBuilder* builder);
+
+    ~StoreCache();
+
+    // Returns the cache of the JSON file, or null if the file doesn't exist or doesn't
+    // compile. kind identifies the record layout and should change along with it;
+    // recordSize must be a multiple of 4.
+    static StoreCache*  Open(const String& jsonPath, UInt32 kind, UInt32 recordSize,
+                             CompileFunc compile);
+    // Removes the cache of the JSON file; to be called after writing the file, whose
+    // modification time has a resolution of a second.
+    static void         Invalidate(const String& jsonPath);
+
+    int                 GetEntryCount() const  { return (int)pHeader->EntryCount; }
+    // Returns the first entry with the key that comes after the given entry, or -1 if
+    // there is none; keys may repeat, and their entries are found in the order added.
+    int                 FindEntry(const char* key, int after = -1) const;
+    const char*         GetKey(int entry) const;
+    UInt32              GetFlags(int entry) const;
+    int                 GetRecordCount(int entry) const;
+    // Returns null if the entry or index is out of range.
+    const void*         GetRecord(int entry, int index) const;
+
+    // Strings are referred to by offset; an offset that's out of range gives "".
+    const char*         GetString(UInt32 offset) const;
+    // A string that applies to the whole store, set by the compile function.
+    const char*         GetHeaderString() const { return GetString(pHeader->HeaderString); }
+
+    // False if the cache was compiled by this call, and is in memory.
+    bool                IsMapped() const        { return pMapping != 0; }
+
+private:
+    friend class StoreCacheBuilder;
+
+    struct Header
+    {
+        UInt32  Magic;
+        UInt32  FormatVersion;
+        UInt32  Kind;
+        UInt32  RecordSize;
+        SInt64  SourceModifyTime;
+        SInt64  SourceSize;
+        SInt64  BuildTime;
+        UInt32  FileSize;
+        UInt32  EntryCount;
+        UInt32  IndexMask;      // Hash table size - 1.
+        UInt32  RecordCount;
+        UInt32  StringSize;
+        UInt32  HeaderString;
+    };
+
+    StoreCache();
+
+    bool                    map(const String& path);
+    void                    unmap();
+    bool                    setImage(const UByte* data, UPInt size);
+    bool                    isCurrent(UInt32 kind, UInt32 recordSize, const FileStat& source) const;
+
+    void*                   pMapping;       // Platform mapping, or null for an image in memory.
+    UByte*                  pImage;
+    UPInt                   ImageSize;
+
+    const Header*           pHeader;
+    const StoreCacheEntry*  pEntries;
+    const UInt32*           pIndex;         // Entry index + 1 per slot, 0 for empty slots.
+    const UByte*            pRecords;
+    const char*             pStrings;
+};
+
+
+//-----------------------------------------------------------------------------
+// ***** StoreCacheBuilder
+
+// StoreCacheBuilder collects the contents of a StoreCache for its compile function.
+// String offsets returned by AddString can be stored in records.
+
+class StoreCacheBuilder
+{
+public:
+    StoreCacheBuilder(UInt32 recordSize);
+
+    UInt32  AddString(const char* str);
+    void    SetHeaderString(const char* str);
+
+    // Starts an entry; records added after it belong to it.
+    void    AddEntry(const char* key, UInt32 flags = 0);
+    void    AddRecord(const void* record);
+
+private:
+    friend class StoreCache;
+
+    void    build(ArrayPOD<UByte>* image, UInt32 kind, const FileStat& source) const;
+
+    UInt32                      RecordSize;
+    UInt32                      HeaderString;
+    ArrayPOD<StoreCacheEntry>   Entries;
+    ArrayPOD<UByte>             Records;
+    ArrayPOD<char>              Strings;
+};
+
+} // OVR
+
+#endif
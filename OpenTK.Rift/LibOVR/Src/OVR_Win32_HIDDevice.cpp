@@ -26,6 +26,7 @@ limitations under the License.
 
 #include "OVR_Win32_HIDDevice.h"
 #include "OVR_Win32_DeviceManager.h"
+#include "OVR_LatencyTrace.h"
 
 #include "Kernel/OVR_System.h"
 #include "Kernel/OVR_Log.h"
@@ -453,6 +454,7 @@ bool HIDDevice::processReadResult()
         // We've got data.
         if (Handler)
         {
+            OVR_LATENCY_TRACE(LatencyTrace_ReportRead);
             Handler->OnInputReport(ReadBuffer, bytesRead);
         }
 
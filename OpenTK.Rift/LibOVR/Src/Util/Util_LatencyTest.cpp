@@ -51,7 +51,14 @@ static const float      SMALL_FLOAT = -1000000.0f;
 // ***** LatencyTest
 
 LatencyTest::LatencyTest(LatencyTestDevice* device)
- :  Handler(getThis())
+ :  Handler(getThis()),
+    ResultCount(0),
+    SamplesToIgnore(INITIAL_SAMPLES_TO_IGNORE),
+    Continuous(false),
+    pTimeSource(NULL),
+    pTimeSourceContext(NULL),
+    TimeoutCount(0),
+    TestCount(0)
 {
     if (device != NULL)
     {
@@ -118,6 +125,7 @@ void LatencyTest::BeginTest()
     {
         // Set color to black and wait a while.
         RenderColor = CALIBRATE_BLACK;
+        SamplesToIgnore = INITIAL_SAMPLES_TO_IGNORE;
 
         State = State_WaitingForSettlePreCalibrationColorBlack;
         OVR_DEBUG_LOG(("State_WaitingForButton -> State_WaitingForSettlePreCalibrationColorBlack."));
@@ -126,6 +134,30 @@ void LatencyTest::BeginTest()
     }
 }
 
+void LatencyTest::EndTest()
+{
+    if (State != State_WaitingForButton)
+    {
+        reset();
+
+        if (Device)
+        {
+            LatencyTestDisplay ltd(2, 0x40400040);
+            Device->SetDisplay(ltd);
+        }
+    }
+}
+
+void LatencyTest::beginMeasurements()
+{
+    clearMeasurementResults();
+
+    State = State_WaitingForSettlePostMeasurement;
+
+    UInt32 waitTime = TIME_TO_WAIT_FOR_SETTLE_POST_MEASUREMENT + getRandomComponent(TIME_TO_WAIT_FOR_SETTLE_POST_MEASUREMENT_RANDOMNESS);
+    setTimer(waitTime);
+}
+
 void LatencyTest::handleMessage(const Message& msg, LatencyTestMessageType latencyTestMessage)
 {
     // For debugging.
@@ -186,19 +218,27 @@ void LatencyTest::handleMessage(const Message& msg, LatencyTestMessageType laten
             // Calibration is done. Switch to color 1 and wait for it to settle.
             RenderColor = COLOR1;
 
-            State = State_WaitingForSettlePostMeasurement;
             OVR_DEBUG_LOG(("State_WaitingForSettlePostCalibrationColorWhite -> State_WaitingForSettlePostMeasurement."));
-
-            UInt32 waitTime = TIME_TO_WAIT_FOR_SETTLE_POST_MEASUREMENT + getRandomComponent(TIME_TO_WAIT_FOR_SETTLE_POST_MEASUREMENT_RANDOMNESS);
-            setTimer(waitTime);
+            beginMeasurements();
         }
         else if (State == State_WaitingForSettlePostMeasurement)
         {
             // Prepare for next measurement.
 
-            // Create a new result object.
-            MeasurementResult* pResult = new MeasurementResult();
-            Results.PushBack(pResult);
+            if (ResultCount == MaxMeasurements)
+            {
+                // Nearly all measurements timed out; the tester probably isn't over the screen.
+                OVR_DEBUG_LOG(("** Out of measurement slots, abandoning test."));
+                if (!Continuous)
+                {
+                    reset();
+                    return;
+                }
+                clearMeasurementResults();
+            }
+
+            // Start a new result.
+            Results[ResultCount++] = MeasurementResult();
 
             State = State_WaitingToTakeMeasurement;
             OVR_DEBUG_LOG(("State_WaitingForSettlePostMeasurement -> State_WaitingToTakeMeasurement."));
@@ -207,6 +247,7 @@ void LatencyTest::handleMessage(const Message& msg, LatencyTestMessageType laten
         {
             // We timed out waiting for 'TestStarted'. Abandon this measurement and setup for the next.
             getActiveResult()->TimedOutWaitingForTestStarted = true;
+            recordTimeout();
 
             State = State_WaitingForSettlePostMeasurement;
             OVR_DEBUG_LOG(("** Timed out waiting for 'TestStarted'."));
@@ -219,6 +260,7 @@ void LatencyTest::handleMessage(const Message& msg, LatencyTestMessageType laten
         {
             // We timed out waiting for 'ColorDetected'. Abandon this measurement and setup for the next.
             getActiveResult()->TimedOutWaitingForColorDetected = true;
+            recordTimeout();
 
             State = State_WaitingForSettlePostMeasurement;
             OVR_DEBUG_LOG(("** Timed out waiting for 'ColorDetected'."));
@@ -251,7 +293,7 @@ void LatencyTest::handleMessage(const Message& msg, LatencyTestMessageType laten
             getActiveResult()->TargetColor = RenderColor;
             
             // Record time so we can determine usb roundtrip time.
-            getActiveResult()->StartTestTicksMicroS = Timer::GetTicks();
+            getActiveResult()->StartTestTicksMicroS = getTicks();
 
             Device->SetStartTest(RenderColor);
 
@@ -275,7 +317,7 @@ void LatencyTest::handleMessage(const Message& msg, LatencyTestMessageType laten
             clearTimer();
 
             // Record time so we can determine usb roundtrip time.
-            getActiveResult()->TestStartedTicksMicroS = Timer::GetTicks();
+            getActiveResult()->TestStartedTicksMicroS = getTicks();
             
             State = State_WaitingForColorDetected;
             OVR_DEBUG_LOG(("State_WaitingForTestStarted -> State_WaitingForColorDetected."));
@@ -293,12 +335,24 @@ void LatencyTest::handleMessage(const Message& msg, LatencyTestMessageType laten
             OVR_DEBUG_LOG(("Time to 'ColorDetected' = %d", elapsedTime));
             
             getActiveResult()->DeviceMeasuredElapsedMilliS = elapsedTime;
+            recordMeasurement(*getActiveResult());
 
             if (areResultsComplete())
             {
                 // We're done.
                 processResults();
-                reset();
+
+                if (Continuous)
+                {
+                    // Go on without recalibrating; the display has already settled.
+                    SamplesToIgnore = 0;
+                    OVR_DEBUG_LOG(("State_WaitingForColorDetected -> State_WaitingForSettlePostMeasurement (next test)."));
+                    beginMeasurements();
+                }
+                else
+                {
+                    reset();
+                }
             }
             else
             {
@@ -322,8 +376,8 @@ void LatencyTest::handleMessage(const Message& msg, LatencyTestMessageType laten
 
 LatencyTest::MeasurementResult* LatencyTest::getActiveResult()
 {
-    OVR_ASSERT(!Results.IsEmpty());    
-    return Results.GetLast();
+    OVR_ASSERT(ResultCount > 0);
+    return &Results[ResultCount - 1];
 }
 
 void LatencyTest::setTimer(UInt32 timeMilliS)
@@ -347,12 +401,83 @@ void LatencyTest::reset()
 
 void LatencyTest::clearMeasurementResults()
 {
-    while(!Results.IsEmpty())
+    ResultCount = 0;
+}
+
+UInt64 LatencyTest::getTicks()
+{
+    return pTimeSource ? pTimeSource(pTimeSourceContext) : Timer::GetTicks();
+}
+
+void LatencyTest::SetTimeSource(TimeSourceFn timeSource, void* context)
+{
+    pTimeSource        = timeSource;
+    pTimeSourceContext = context;
+    HaveOldTime        = false;
+}
+
+// Statistics are updated as each measurement comes in, so that they reflect the latency
+// while a long continuous run is going on.
+void LatencyTest::recordMeasurement(const MeasurementResult& result)
+{
+    UInt32 measurements = 0;
+    for (UInt32 i = 0; i < ResultCount; i++)
+    {
+        if (!Results[i].TimedOutWaitingForTestStarted &&
+            !Results[i].TimedOutWaitingForColorDetected)
+        {
+            measurements++;
+        }
+    }
+    if (measurements <= SamplesToIgnore)
     {
-        MeasurementResult* pElem = Results.GetFirst();
-        pElem->RemoveNode();
-        delete pElem;
+        return;
     }
+
+    UInt32 elapsedMicroS = result.DeviceMeasuredElapsedMilliS * 1000;
+    UInt32 usbMicroS     = (UInt32) (result.TestStartedTicksMicroS - result.StartTestTicksMicroS);
+
+    Lock::Locker lock(&StatsLock);
+    Histograms[Latency_Total].Record(elapsedMicroS + usbMicroS);
+    Histograms[result.TargetColor == COLOR2 ? Latency_BlackToWhite : Latency_WhiteToBlack].Record(elapsedMicroS);
+    Histograms[Latency_USBRoundTrip].Record(usbMicroS);
+}
+
+void LatencyTest::recordTimeout()
+{
+    Lock::Locker lock(&StatsLock);
+    TimeoutCount++;
+}
+
+bool LatencyTest::GetStats(LatencyMeasure measure, LatencyStats* stats) const
+{
+    OVR_ASSERT(measure >= 0 && measure < Latency_MeasureCount);
+
+    Lock::Locker lock(&StatsLock);
+    return Histograms[measure].GetStats(stats);
+}
+
+UInt32 LatencyTest::GetTimeoutCount() const
+{
+    Lock::Locker lock(&StatsLock);
+    return TimeoutCount;
+}
+
+UInt32 LatencyTest::GetTestCount() const
+{
+    Lock::Locker lock(&StatsLock);
+    return TestCount;
+}
+
+void LatencyTest::ResetStats()
+{
+    Lock::Locker lock(&StatsLock);
+    for (int i = 0; i < Latency_MeasureCount; i++)
+    {
+        Histograms[i].Reset();
+    }
+    TimeoutCount = 0;
+    TestCount    = 0;
 }
 
 LatencyTest::LatencyTestHandler::~LatencyTestHandler()
@@ -402,16 +527,17 @@ bool LatencyTest::areResultsComplete()
     UInt32 measurements1to2 = 0;
     UInt32 measurements2to1 = 0;
 
-    MeasurementResult* pCurr = Results.GetFirst();
-    while(true)
+    for (UInt32 i = 0; i < ResultCount; i++)
     {
+        const MeasurementResult* pCurr = &Results[i];
+
         // Process.
         if (!pCurr->TimedOutWaitingForTestStarted &&
             !pCurr->TimedOutWaitingForColorDetected)
         {
             initialMeasurements++;
 
-            if (initialMeasurements > INITIAL_SAMPLES_TO_IGNORE)
+            if (initialMeasurements > SamplesToIgnore)
             {
                 if (pCurr->TargetColor == COLOR2)
                 {
@@ -423,12 +549,6 @@ bool LatencyTest::areResultsComplete()
                 }
             }
         }
-
-        if (Results.IsLast(pCurr))
-        {
-            break;
-        }
-        pCurr = Results.GetNext(pCurr);
     }
 
     if (measurements1to2 >= DEFAULT_NUMBER_OF_SAMPLES &&
@@ -459,10 +579,10 @@ void LatencyTest::processResults()
     UInt32 measurements1to2 = 0;
     UInt32 measurements2to1 = 0;
 
-    MeasurementResult* pCurr = Results.GetFirst();
     UInt32 count = 0;
-    while(true)
+    for (UInt32 i = 0; i < ResultCount; i++)
     {
+        const MeasurementResult* pCurr = &Results[i];
         count++;
 
         if (!pCurr->TimedOutWaitingForTestStarted &&
@@ -470,7 +590,7 @@ void LatencyTest::processResults()
         {
             measurementsCount++;
 
-            if (measurementsCount > INITIAL_SAMPLES_TO_IGNORE)
+            if (measurementsCount > SamplesToIgnore)
             {
                 if (pCurr->TargetColor == COLOR2)
                 {
@@ -514,12 +634,6 @@ void LatencyTest::processResults()
         {
             break;
         }
-
-        if (Results.IsLast(pCurr))
-        {
-            break;
-        }
-        pCurr = Results.GetNext(pCurr);
     }
 
     averageTime1To2 /= (float) DEFAULT_NUMBER_OF_SAMPLES;      
@@ -538,6 +652,11 @@ void LatencyTest::processResults()
                 minUSBTripMilliS, averageUSBTripMilliS, maxUSBTripMilliS,
                 DEFAULT_NUMBER_OF_SAMPLES*2, count - measurementsCount);
     
+    {
+        Lock::Locker lock(&StatsLock);
+        TestCount++;
+    }
+
     // Display result on latency tester display.
     LatencyTestDisplay ltd(1, (int)finalResult);
     Device->SetDisplay(ltd);
@@ -548,11 +667,11 @@ void LatencyTest::updateForTimeouts()
     if (!HaveOldTime)
     {
         HaveOldTime = true;
-        OldTime = Timer::GetTicksMs();
+        OldTime = (UInt32) (getTicks() / 1000);
         return;
     }
 
-    UInt32 newTime = Timer::GetTicksMs();
+    UInt32 newTime = (UInt32) (getTicks() / 1000);
     UInt32 elapsedMilliS = newTime - OldTime;
     if (newTime < OldTime)
     {
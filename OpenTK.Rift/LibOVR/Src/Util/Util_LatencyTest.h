@@ -31,11 +31,27 @@ limitations under the License.
 #include "../OVR_Device.h"
 
 #include "../Kernel/OVR_String.h"
-#include "../Kernel/OVR_List.h"
+#include "../Kernel/OVR_Atomic.h"
+#include "../Kernel/OVR_LatencyHistogram.h"
 
 namespace OVR { namespace Util {
 
 
+//-------------------------------------------------------------------------------------
+// ***** LatencyMeasure
+
+// Measurements kept by LatencyTest. Total is the motion-to-photon latency of a sample:
+// the time measured by the device for the color change plus the USB round trip.
+enum LatencyMeasure
+{
+    Latency_Total,
+    Latency_BlackToWhite,
+    Latency_WhiteToBlack,
+    Latency_USBRoundTrip,
+    Latency_MeasureCount
+};
+
+
 //-------------------------------------------------------------------------------------
 // ***** LatencyTest
 //
@@ -60,6 +76,12 @@ namespace OVR { namespace Util {
 //							If the string has already been gotten then NULL will be returned.
 //							The string pointer will remain valid until the next time this 
 //							method is called.
+//      GetStats -          Returns percentiles of all the measurements taken since the last
+//                          ResetStats, across tests.
+//
+// In continuous mode a finished test is followed by the next one without recalibrating, so
+// the tester keeps measuring until EndTest is called and the statistics track the latency
+// over the whole run.
 //
 
 class LatencyTest : public NewOverrideBase
@@ -82,6 +104,28 @@ public:
 
     // Begin test. Equivalent to pressing the button on the latency tester.
     void BeginTest();
+    // Stops the test in progress, if any; the statistics are kept.
+    void EndTest();
+    bool IsTestRunning() const  { return State != State_WaitingForButton; }
+
+    // Makes tests restart as soon as they finish, see above.
+    void SetContinuous(bool continuous) { Continuous = continuous; }
+    bool IsContinuous() const           { return Continuous; }
+
+    // Statistics of the measurements taken since the last ResetStats; returns false if there
+    // are none. Safe to call from any thread.
+    bool   GetStats(LatencyMeasure measure, LatencyStats* stats) const;
+    // Measurements abandoned because the device didn't respond in time.
+    UInt32 GetTimeoutCount() const;
+    // Number of completed tests.
+    UInt32 GetTestCount() const;
+    void   ResetStats();
+
+    // Replaces the clock used for timeouts and USB round trip times, in microseconds; this
+    // allows the test to run on simulated time (see LatencyTestDeviceMock). A NULL function
+    // restores Timer::GetTicks.
+    typedef UInt64 (*TimeSourceFn)(void* context);
+    void SetTimeSource(TimeSourceFn timeSource, void* context);
 
 private:
     LatencyTest* getThis()  { return this; }
@@ -112,6 +156,8 @@ private:
     bool areResultsComplete();
     void processResults();
     void updateForTimeouts();
+    void beginMeasurements();
+    UInt64 getTicks();
 
     Ptr<LatencyTestDevice>      Device;
     LatencyTestHandler          Handler;
@@ -136,7 +182,7 @@ private:
 
     Color                       RenderColor;
 
-    struct MeasurementResult : public ListNode<MeasurementResult>, public NewOverrideBase
+    struct MeasurementResult
     {
         MeasurementResult()
          :  DeviceMeasuredElapsedMilliS(0),
@@ -157,11 +203,28 @@ private:
         UInt64                  TestStartedTicksMicroS;
     };
 
-    List<MeasurementResult>     Results;
+    // Enough for a test with many timeouts; a test that runs out of space is abandoned.
+    enum { MaxMeasurements = 64 };
+
+    MeasurementResult           Results[MaxMeasurements];
+    UInt32                      ResultCount;
+    UInt32                      SamplesToIgnore;
     void clearMeasurementResults();
 
     MeasurementResult*          getActiveResult();
 
+    void recordMeasurement(const MeasurementResult& result);
+    void recordTimeout();
+
+    bool                        Continuous;
+    TimeSourceFn                pTimeSource;
+    void*                       pTimeSourceContext;
+
+    mutable Lock                StatsLock;
+    LatencyHistogram            Histograms[Latency_MeasureCount];
+    UInt32                      TimeoutCount;
+    UInt32                      TestCount;
+
     StringBuffer			    ResultsString;
 	String					    ReturnedResultString;
 };
@@ -0,0 +1,290 @@
+/************************************************************************************
+
+Filename    :   Util_LatencyTestMock.cpp
+Content     :   Simulated Latency Tester device for running LatencyTest without hardware.
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Util_LatencyTestMock.h"
+
+#include "../Kernel/OVR_Alg.h"
+
+namespace OVR { namespace Util {
+
+static const UInt32     DEFAULT_PHOTON_LATENCY = 40000;
+static const UInt32     DEFAULT_USB_LATENCY = 1000;
+
+//-------------------------------------------------------------------------------------
+// ***** LatencyTestDeviceMock
+
+LatencyTestDeviceMock::LatencyTestDeviceMock()
+ :  Common(getThis()),
+    TicksMicroS(0),
+    PhotonMicroS(DEFAULT_PHOTON_LATENCY),
+    PhotonJitterMicroS(0),
+    USBMicroS(DEFAULT_USB_LATENCY),
+    DropCount(0),
+    RandomState(1),
+    Configuration(Color(128, 128, 128)),
+    Display(0, 0),
+    StartTestCount(0),
+    CalibrateCount(0),
+    ScreenColor(0, 0, 0),
+    ScreenPhotonTicks(0),
+    TestArmed(false),
+    TestStartTicks(0),
+    PendingCount(0)
+{
+}
+
+LatencyTestDeviceMock::~LatencyTestDeviceMock()
+{
+}
+
+void LatencyTestDeviceMock::SetLatency(UInt32 photonMicroS, UInt32 usbMicroS, UInt32 photonJitterMicroS)
+{
+    PhotonMicroS       = photonMicroS;
+    USBMicroS          = usbMicroS;
+    PhotonJitterMicroS = photonJitterMicroS;
+}
+
+void LatencyTestDeviceMock::SetScreenColor(const Color& color)
+{
+    if (!(color == ScreenColor))
+    {
+        ScreenColor       = color;
+        ScreenPhotonTicks = TicksMicroS + PhotonMicroS + getJitter();
+        checkColorDetected();
+    }
+}
+
+void LatencyTestDeviceMock::PressButton()
+{
+    PendingMessage msg;
+    msg.Type     = Message_LatencyTestButton;
+    msg.DueTicks = TicksMicroS + USBMicroS;
+    msg.Elapsed  = 0;
+    pushMessage(msg);
+}
+
+void LatencyTestDeviceMock::Advance(UInt32 microS)
+{
+    UInt64 endTicks = TicksMicroS + microS;
+
+    // Delivering a message can queue new ones, so look for the earliest one each time.
+    while (true)
+    {
+        UInt32 next = PendingCount;
+        for (UInt32 i = 0; i < PendingCount; i++)
+        {
+            if (Pending[i].DueTicks <= endTicks &&
+                (next == PendingCount || Pending[i].DueTicks < Pending[next].DueTicks))
+            {
+                next = i;
+            }
+        }
+        if (next == PendingCount)
+        {
+            break;
+        }
+
+        PendingMessage msg = Pending[next];
+        Pending[next] = Pending[--PendingCount];
+
+        TicksMicroS = Alg::Max(TicksMicroS, msg.DueTicks);
+        deliver(msg);
+    }
+
+    TicksMicroS = endTicks;
+}
+
+UInt64 LatencyTestDeviceMock::TimeSource(void* device)
+{
+    return ((LatencyTestDeviceMock*) device)->GetTicks();
+}
+
+bool LatencyTestDeviceMock::SetConfiguration(const LatencyTestConfiguration& configuration, bool)
+{
+    Configuration = configuration;
+    return true;
+}
+
+bool LatencyTestDeviceMock::GetConfiguration(LatencyTestConfiguration* configuration)
+{
+    *configuration = Configuration;
+    return true;
+}
+
+bool LatencyTestDeviceMock::SetCalibrate(const Color&, bool)
+{
+    CalibrateCount++;
+    return true;
+}
+
+// The device starts its timer when the command arrives and reports 'TestStarted' straight
+// away; the color is detected once the screen shows the target color at the sensor.
+bool LatencyTestDeviceMock::SetStartTest(const Color& targetColor, bool)
+{
+    StartTestCount++;
+    if (DropCount > 0)
+    {
+        DropCount--;
+        return true;
+    }
+
+    TestArmed      = true;
+    TestTarget     = targetColor;
+    TestStartTicks = TicksMicroS + USBMicroS;
+
+    PendingMessage msg;
+    msg.Type        = Message_LatencyTestStarted;
+    msg.DueTicks    = TestStartTicks + USBMicroS;
+    msg.TargetColor = targetColor;
+    msg.Elapsed     = 0;
+    pushMessage(msg);
+
+    checkColorDetected();
+    return true;
+}
+
+bool LatencyTestDeviceMock::SetDisplay(const LatencyTestDisplay& display, bool)
+{
+    Display = display;
+    return true;
+}
+
+bool LatencyTestDeviceMock::SetFeatureReport(UByte*, UInt32)
+{
+    return false;
+}
+
+bool LatencyTestDeviceMock::GetFeatureReport(UByte*, UInt32)
+{
+    return false;
+}
+
+void LatencyTestDeviceMock::AddRef()
+{
+    Common.RefCount++;
+}
+
+void LatencyTestDeviceMock::Release()
+{
+    if (--Common.RefCount == 0)
+    {
+        delete this;
+    }
+}
+
+DeviceManager* LatencyTestDeviceMock::GetManager() const
+{
+    return NULL;
+}
+
+bool LatencyTestDeviceMock::GetDeviceInfo(DeviceInfo* info) const
+{
+    if (info->InfoClassType != Device_LatencyTester &&
+        info->InfoClassType != Device_None)
+    {
+        return false;
+    }
+
+    info->Type    = Device_LatencyTester;
+    info->Version = 0;
+    OVR_strcpy(info->ProductName, DeviceInfo::MaxNameLength, "Simulated Latency Tester");
+    OVR_strcpy(info->Manufacturer, DeviceInfo::MaxNameLength, "Oculus VR, Inc.");
+    return true;
+}
+
+DeviceCommon* LatencyTestDeviceMock::getDeviceCommon() const
+{
+    return const_cast<LatencyTestDeviceMockCommon*>(&Common);
+}
+
+void LatencyTestDeviceMock::pushMessage(const PendingMessage& msg)
+{
+    // LatencyTest has at most one measurement in flight, so this only fills up if
+    // the button is pressed repeatedly without advancing time.
+    if (PendingCount < MaxPending)
+    {
+        Pending[PendingCount++] = msg;
+    }
+}
+
+void LatencyTestDeviceMock::deliver(const PendingMessage& msg)
+{
+    if (msg.Type == Message_LatencyTestStarted)
+    {
+        MessageLatencyTestStarted started(this);
+        started.TargetValue = msg.TargetColor;
+        Common.HandlerRef.Call(started);
+    }
+    else if (msg.Type == Message_LatencyTestColorDetected)
+    {
+        MessageLatencyTestColorDetected detected(this);
+        detected.Elapsed       = msg.Elapsed;
+        detected.DetectedValue = msg.TargetColor;
+        detected.TargetValue   = msg.TargetColor;
+        Common.HandlerRef.Call(detected);
+    }
+    else if (msg.Type == Message_LatencyTestButton)
+    {
+        Common.HandlerRef.Call(MessageLatencyTestButton(this));
+    }
+}
+
+void LatencyTestDeviceMock::checkColorDetected()
+{
+    if (!TestArmed || isPastThreshold(ScreenColor) != isPastThreshold(TestTarget))
+    {
+        return;
+    }
+    TestArmed = false;
+
+    // The device only sees the change once it has started timing.
+    UInt64 detectTicks = Alg::Max(ScreenPhotonTicks, TestStartTicks);
+
+    PendingMessage msg;
+    msg.Type        = Message_LatencyTestColorDetected;
+    msg.DueTicks    = detectTicks + USBMicroS;
+    msg.TargetColor = TestTarget;
+    msg.Elapsed     = (UInt16) Alg::Min((detectTicks - TestStartTicks + 500) / 1000, (UInt64) 0xFFFF);
+    pushMessage(msg);
+}
+
+bool LatencyTestDeviceMock::isPastThreshold(const Color& color) const
+{
+    return color.R >= Configuration.Threshold.R;
+}
+
+UInt32 LatencyTestDeviceMock::getJitter()
+{
+    if (PhotonJitterMicroS == 0)
+    {
+        return 0;
+    }
+
+    RandomState = RandomState * 1664525 + 1013904223;
+    return (RandomState >> 8) % (PhotonJitterMicroS + 1);
+}
+
+}} // namespace OVR::Util
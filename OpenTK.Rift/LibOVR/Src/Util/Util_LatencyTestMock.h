@@ -0,0 +1,169 @@
+/************************************************************************************
+
+PublicHeader:   None
+Filename    :   Util_LatencyTestMock.h
+Content     :   Simulated Latency Tester device for running LatencyTest without hardware.
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_Util_LatencyTestMock_h
+#define OVR_Util_LatencyTestMock_h
+
+#include "../OVR_Device.h"
+#include "../OVR_DeviceImpl.h"
+#include "../OVR_DeviceMessages.h"
+
+namespace OVR { namespace Util {
+
+// DeviceCommon holds the handler reference of the mock; it has no create descriptor, so
+// the DeviceBase functions that go through it to the manager are overridden.
+class LatencyTestDeviceMockCommon : public DeviceCommon
+{
+public:
+    LatencyTestDeviceMockCommon(DeviceBase* device)
+        : DeviceCommon(NULL, device, NULL)
+    {
+    }
+
+    virtual bool Initialize(DeviceBase*) { return true; }
+    virtual void Shutdown() { }
+};
+
+//-------------------------------------------------------------------------------------
+// ***** LatencyTestDeviceMock
+//
+// LatencyTestDeviceMock behaves like a Latency Tester placed over a display with a given
+// latency, on a simulated clock. It is created directly rather than through a
+// DeviceManager, and messages are delivered to its handler from Advance, on the calling
+// thread. A test loop looks like:
+//
+//      Ptr<LatencyTestDeviceMock> device = *new LatencyTestDeviceMock();
+//      LatencyTest test(device);
+//      test.SetTimeSource(LatencyTestDeviceMock::TimeSource, device);
+//      test.BeginTest();
+//      while (test.IsTestRunning())
+//      {
+//          device->Advance(frameMicroS);
+//          test.ProcessInputs();
+//          Color c;
+//          if (test.DisplayScreenColor(c))
+//              device->SetScreenColor(c);
+//      }
+
+class LatencyTestDeviceMock : public LatencyTestDevice
+{
+public:
+    LatencyTestDeviceMock();
+    ~LatencyTestDeviceMock();
+
+    // *** Simulation
+
+    // Sets the time from the application drawing a color to the sensor seeing it, which
+    // varies randomly by up to photonJitterMicroS above photonMicroS, and the time taken by
+    // each USB transfer.
+    void    SetLatency(UInt32 photonMicroS, UInt32 usbMicroS, UInt32 photonJitterMicroS = 0);
+    // Makes the device ignore the next count StartTest commands, so that they time out.
+    void    DropStartTests(UInt32 count)    { DropCount = count; }
+
+    // The color drawn beneath the sensor from now on.
+    void    SetScreenColor(const Color& color);
+    void    PressButton();
+
+    // Advances the simulated clock, delivering the messages that fall due in order.
+    void    Advance(UInt32 microS);
+    UInt64  GetTicks() const                { return TicksMicroS; }
+    // Clock for LatencyTest::SetTimeSource; the context is the device.
+    static UInt64 TimeSource(void* device);
+
+    UInt32                      GetStartTestCount() const   { return StartTestCount; }
+    UInt32                      GetCalibrateCount() const   { return CalibrateCount; }
+    const LatencyTestDisplay&   GetDisplay() const          { return Display; }
+
+    // *** LatencyTestDevice
+
+    virtual bool SetConfiguration(const LatencyTestConfiguration& configuration, bool waitFlag = false);
+    virtual bool GetConfiguration(LatencyTestConfiguration* configuration);
+    virtual bool SetCalibrate(const Color& calibrationColor, bool waitFlag = false);
+    virtual bool SetStartTest(const Color& targetColor, bool waitFlag = false);
+    virtual bool SetDisplay(const LatencyTestDisplay& display, bool waitFlag = false);
+
+    virtual bool SetFeatureReport(UByte* data, UInt32 length);
+    virtual bool GetFeatureReport(UByte* data, UInt32 length);
+
+    // *** DeviceBase; the mock has no manager, so it owns its reference count.
+
+    virtual void            AddRef();
+    virtual void            Release();
+    virtual DeviceManager*  GetManager() const;
+    virtual bool            GetDeviceInfo(DeviceInfo* info) const;
+
+protected:
+    virtual DeviceCommon*   getDeviceCommon() const;
+
+private:
+    struct PendingMessage
+    {
+        MessageType Type;
+        UInt64      DueTicks;
+        Color       TargetColor;
+        UInt16      Elapsed;
+    };
+
+    enum { MaxPending = 4 };
+
+    void    pushMessage(const PendingMessage& msg);
+    void    deliver(const PendingMessage& msg);
+    void    checkColorDetected();
+    bool    isPastThreshold(const Color& color) const;
+    UInt32  getJitter();
+
+    // Inline to avoid warnings.
+    LatencyTestDeviceMock*  getThis()   { return this; }
+
+    LatencyTestDeviceMockCommon Common;
+
+    UInt64                      TicksMicroS;
+    UInt32                      PhotonMicroS;
+    UInt32                      PhotonJitterMicroS;
+    UInt32                      USBMicroS;
+    UInt32                      DropCount;
+    UInt32                      RandomState;
+
+    LatencyTestConfiguration    Configuration;
+    LatencyTestDisplay          Display;
+    UInt32                      StartTestCount;
+    UInt32                      CalibrateCount;
+
+    Color                       ScreenColor;
+    UInt64                      ScreenPhotonTicks;  // When ScreenColor reaches the sensor.
+
+    bool                        TestArmed;
+    Color                       TestTarget;
+    UInt64                      TestStartTicks;     // When the device started its timer.
+
+    PendingMessage              Pending[MaxPending];
+    UInt32                      PendingCount;
+};
+
+}} // namespace OVR::Util
+
+#endif // OVR_Util_LatencyTestMock_h
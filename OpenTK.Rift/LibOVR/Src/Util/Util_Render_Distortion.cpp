@@ -0,0 +1,507 @@
+/************************************************************************************
+
+Filename    :   Util_Render_Distortion.cpp
+Content     :   CPU generation of lens distortion meshes and warp maps.
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Util_Render_Distortion.h"
+#include "../Kernel/OVR_Threads.h"
+
+#if defined(OVR_CPU_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace OVR { namespace Util { namespace Render {
+
+
+//-----------------------------------------------------------------------------------
+// ***** Distortion Evaluation
+
+// Constants of the distortion shader for one eye, all in render target texture units.
+struct DistortionParams
+{
+    float    K[4];
+    float    Chroma[4];
+    Vector2f Origin, Size;      // Eye viewport
+    Vector2f LensCenter;
+    Vector2f ScreenCenter;
+    Vector2f Scale, ScaleIn;
+
+    bool Init(const StereoEyeParams& eye, const Viewport& fullViewport)
+    {
+        const Viewport& vp = eye.VP;
+        if (!eye.pDistortion || fullViewport.w <= 0 || fullViewport.h <= 0 || vp.w <= 0 || vp.h <= 0)
+            return false;
+
+        const DistortionConfig& d = *eye.pDistortion;
+        for (int i = 0; i < 4; i++)
+        {
+            K[i]      = d.K[i];
+            Chroma[i] = d.ChromaticAberration[i];
+        }
+
+        float x  = float(vp.x - fullViewport.x) / float(fullViewport.w);
+        float y  = float(vp.y - fullViewport.y) / float(fullViewport.h);
+        float w  = float(vp.w) / float(fullViewport.w);
+        float h  = float(vp.h) / float(fullViewport.h);
+        float as = float(vp.w) / float(vp.h);
+        float xCenterOffset = (eye.Eye == StereoEye_Right) ? -d.XCenterOffset : d.XCenterOffset;
+
+        // Same as the shader constants; the center offset is relative to the [-1,1] eye
+        // range, which maps onto [0, 0.5] for a half-screen eye.
+        Origin       = Vector2f(x, y);
+        Size         = Vector2f(w, h);
+        LensCenter   = Vector2f(x + (w + xCenterOffset * 0.5f) * 0.5f, y + h * 0.5f);
+        ScreenCenter = Vector2f(x + w * 0.5f, y + h * 0.5f);
+        Scale        = Vector2f((w / 2) / d.Scale, (h / 2) / d.Scale * as);
+        ScaleIn      = Vector2f(2 / w, (2 / h) / as);
+        return true;
+    }
+
+    // Evaluates the distortion at a render target position: the green channel texture
+    // coordinate, and the red and blue scale factors relative to the lens center.
+    void Evaluate(float tx, float ty, float* gx, float* gy, float* sr, float* sb) const
+    {
+        float thx = (tx - LensCenter.x) * ScaleIn.x;
+        float thy = (ty - LensCenter.y) * ScaleIn.y;
+        float rsq = thx * thx + thy * thy;
+        float k   = K[0] + rsq * (K[1] + rsq * (K[2] + rsq * K[3]));
+        *gx = LensCenter.x + Scale.x * thx * k;
+        *gy = LensCenter.y + Scale.y * thy * k;
+        *sr = Chroma[0] + Chroma[1] * rsq;
+        *sb = Chroma[2] + Chroma[3] * rsq;
+    }
+
+    bool IsInside(float tx, float ty) const
+    {
+        return fabs(tx - ScreenCenter.x) <= Size.x * 0.5f && fabs(ty - ScreenCenter.y) <= Size.y * 0.5f;
+    }
+};
+
+#if defined(OVR_CPU_SSE)
+
+// DistortionParams::Evaluate for four positions on the same row.
+struct DistortionParams4
+{
+    __m128 K0, K1, K2, K3;
+    __m128 C0, C1, C2, C3;
+    __m128 LensX, LensY, ScaleX, ScaleY, ScaleInX;
+    float  ScaleInY, LensYf;
+
+    DistortionParams4(const DistortionParams& p)
+    {
+        K0 = _mm_set1_ps(p.K[0]);      K1 = _mm_set1_ps(p.K[1]);
+        K2 = _mm_set1_ps(p.K[2]);      K3 = _mm_set1_ps(p.K[3]);
+        C0 = _mm_set1_ps(p.Chroma[0]); C1 = _mm_set1_ps(p.Chroma[1]);
+        C2 = _mm_set1_ps(p.Chroma[2]); C3 = _mm_set1_ps(p.Chroma[3]);
+        LensX    = _mm_set1_ps(p.LensCenter.x);
+        LensY    = _mm_set1_ps(p.LensCenter.y);
+        ScaleX   = _mm_set1_ps(p.Scale.x);
+        ScaleY   = _mm_set1_ps(p.Scale.y);
+        ScaleInX = _mm_set1_ps(p.ScaleIn.x);
+        ScaleInY = p.ScaleIn.y;
+        LensYf   = p.LensCenter.y;
+    }
+
+    void Evaluate(__m128 tx, float ty, __m128* gx, __m128* gy, __m128* sr, __m128* sb) const
+    {
+        __m128 thx = _mm_mul_ps(_mm_sub_ps(tx, LensX), ScaleInX);
+        __m128 thy = _mm_set1_ps((ty - LensYf) * ScaleInY);
+        __m128 rsq = _mm_add_ps(_mm_mul_ps(thx, thx), _mm_mul_ps(thy, thy));
+        __m128 k   = _mm_add_ps(K0, _mm_mul_ps(rsq, _mm_add_ps(K1, _mm_mul_ps(rsq, _mm_add_ps(K2, _mm_mul_ps(rsq, K3))))));
+        *gx = _mm_add_ps(LensX, _mm_mul_ps(_mm_mul_ps(ScaleX, thx), k));
+        *gy = _mm_add_ps(LensY, _mm_mul_ps(_mm_mul_ps(ScaleY, thy), k));
+        *sr = _mm_add_ps(C0, _mm_mul_ps(C1, rsq));
+        *sb = _mm_add_ps(C2, _mm_mul_ps(C3, rsq));
+    }
+};
+
+// Converts four floats to half precision, in the low 16 bits of each 32-bit lane.
+static inline __m128i floatToHalf4(__m128 f)
+{
+    const __m128  signMask = _mm_set1_ps(-0.0f);
+    __m128i sign = _mm_srli_epi32(_mm_castps_si128(_mm_and_ps(f, signMask)), 16);
+    // Clamping to the largest half also turns NaNs into it
+    __m128i bits = _mm_castps_si128(_mm_min_ps(_mm_andnot_ps(signMask, f), _mm_set1_ps(65504.0f)));
+
+    // Round to nearest even, then rebias the exponent from 127 to 15
+    __m128i odd  = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+    __m128i h    = _mm_add_epi32(bits, _mm_add_epi32(odd, _mm_set1_epi32(0x0FFF)));
+    h            = _mm_sub_epi32(_mm_srli_epi32(h, 13), _mm_set1_epi32((127 - 15) << 10));
+
+    __m128i tiny = _mm_cmplt_epi32(bits, _mm_set1_epi32(0x38800000));
+    return _mm_or_si128(_mm_andnot_si128(tiny, h), sign);
+}
+
+#endif // OVR_CPU_SSE
+
+UInt16 FloatToHalf(float f)
+{
+    union { float F; UInt32 U; } v;
+    v.F = f;
+    UInt32 sign = (v.U >> 16) & 0x8000;
+    v.F = fabs(f);
+    if (!(v.F <= 65504.0f))
+        v.F = 65504.0f;
+    if (v.U < 0x38800000)
+        return (UInt16)sign;
+
+    UInt32 h = ((v.U + 0x0FFF + ((v.U >> 13) & 1)) >> 13) - ((127 - 15) << 10);
+    return (UInt16)(h | sign);
+}
+
+float HalfToFloat(UInt16 h)
+{
+    union { float F; UInt32 U; } v;
+    UInt32 sign     = (UInt32)(h & 0x8000) << 16;
+    UInt32 exponent = (h >> 10) & 0x1F;
+    UInt32 mantissa = h & 0x3FF;
+
+    if (exponent == 0)
+    {
+        // Zero or subnormal
+        v.F = (float)mantissa * (1.0f / (1 << 24));
+        v.U |= sign;
+    }
+    else if (exponent == 31)
+    {
+        v.U = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else
+    {
+        v.U = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    return v.F;
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** Parallel Rows
+
+// Rows are handed out in bands to the calling thread and up to MaxWorkers - 1 helper
+// threads; small jobs run on the calling thread only.
+enum
+{
+    MaxWorkers      = 8,
+    BandRows        = 8,
+    MinWorkerPixels = 64 * 1024
+};
+
+typedef void (*DistortionRowFn)(void* context, int row);
+
+struct DistortionRowJob
+{
+    DistortionRowFn   Fn;
+    void*             Context;
+    int               Rows;
+    AtomicInt<SInt32> NextRow;
+    AtomicInt<SInt32> Pending;
+    Event             Done;
+
+    void RunBands()
+    {
+        for (;;)
+        {
+            int row = NextRow.ExchangeAdd_Sync(BandRows);
+            if (row >= Rows)
+                break;
+            int end = Alg::Min(row + BandRows, Rows);
+            for (; row < end; row++)
+                Fn(Context, row);
+        }
+    }
+
+    void Finish()
+    {
+        if (Pending.ExchangeAdd_Sync(-1) == 1)
+            Done.SetEvent();
+    }
+};
+
+#ifdef OVR_ENABLE_THREADS
+static int distortionRowWorker(Thread*, void* h)
+{
+    DistortionRowJob* job = (DistortionRowJob*)h;
+    job->RunBands();
+    job->Finish();
+    return 0;
+}
+#endif
+
+static void runRows(DistortionRowFn fn, void* context, int rows, int pixelsPerRow)
+{
+    DistortionRowJob job;
+    job.Fn      = fn;
+    job.Context = context;
+    job.Rows    = rows;
+    job.NextRow = 0;
+
+    int workers = 1;
+#ifdef OVR_ENABLE_THREADS
+    workers = Alg::Min(Alg::Min(Thread::GetCPUCount(), (int)MaxWorkers), (rows + BandRows - 1) / BandRows);
+    workers = Alg::Max(1, Alg::Min(workers, (int)(((SInt64)rows * pixelsPerRow) / MinWorkerPixels)));
+#else
+    OVR_UNUSED(pixelsPerRow);
+#endif
+
+    job.Pending = workers;
+
+#ifdef OVR_ENABLE_THREADS
+    for (int i = 1; i < workers; i++)
+    {
+        Ptr<Thread> worker = *new Thread(distortionRowWorker, &job);
+        if (!worker->Start())
+            job.Finish();
+    }
+#endif
+
+    job.RunBands();
+    if (job.Pending.ExchangeAdd_Sync(-1) != 1)
+        job.Done.Wait();
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** DistortionMesh
+
+struct DistortionMeshJob
+{
+    DistortionParams      Params;
+    DistortionMeshVertex* pVertices;
+    int                   GridX, GridY;
+
+    void SetVertex(DistortionMeshVertex& vert, float u, float v,
+                   float gx, float gy, float sr, float sb) const
+    {
+        const Vector2f& lc = Params.LensCenter;
+        vert.Pos  = Vector2f(2 * u - 1, 2 * v - 1);
+        vert.TexG = Vector2f(gx, gy);
+        vert.TexR = Vector2f(lc.x + (gx - lc.x) * sr, lc.y + (gy - lc.y) * sr);
+        vert.TexB = Vector2f(lc.x + (gx - lc.x) * sb, lc.y + (gy - lc.y) * sb);
+        vert.Fade = Params.IsInside(vert.TexB.x, vert.TexB.y) ? 1.0f : 0.0f;
+    }
+};
+
+static void generateMeshRow(void* context, int row)
+{
+    const DistortionMeshJob& job = *(const DistortionMeshJob*)context;
+    const DistortionParams&  p   = job.Params;
+    DistortionMeshVertex*    out = job.pVertices + row * (job.GridX + 1);
+
+    float v  = float(row) / float(job.GridY);
+    float ty = p.Origin.y + v * p.Size.y;
+    int   i  = 0;
+
+#if defined(OVR_CPU_SSE)
+    DistortionParams4 p4(p);
+    for (; i + 4 <= job.GridX + 1; i += 4)
+    {
+        float u[4], tx[4], gx[4], gy[4], sr[4], sb[4];
+        for (int j = 0; j < 4; j++)
+        {
+            u[j]  = float(i + j) / float(job.GridX);
+            tx[j] = p.Origin.x + u[j] * p.Size.x;
+        }
+
+        __m128 gx4, gy4, sr4, sb4;
+        p4.Evaluate(_mm_loadu_ps(tx), ty, &gx4, &gy4, &sr4, &sb4);
+        _mm_storeu_ps(gx, gx4);
+        _mm_storeu_ps(gy, gy4);
+        _mm_storeu_ps(sr, sr4);
+        _mm_storeu_ps(sb, sb4);
+
+        for (int j = 0; j < 4; j++)
+            job.SetVertex(out[i + j], u[j], v, gx[j], gy[j], sr[j], sb[j]);
+    }
+#endif
+
+    for (; i <= job.GridX; i++)
+    {
+        float u  = float(i) / float(job.GridX);
+        float tx = p.Origin.x + u * p.Size.x;
+        float gx, gy, sr, sb;
+        p.Evaluate(tx, ty, &gx, &gy, &sr, &sb);
+        job.SetVertex(out[i], u, v, gx, gy, sr, sb);
+    }
+}
+
+DistortionMesh::DistortionMesh()
+  : pVertices(NULL), pIndices(NULL), GridX(0), GridY(0)
+{
+}
+
+DistortionMesh::~DistortionMesh()
+{
+    Clear();
+}
+
+void DistortionMesh::Clear()
+{
+    OVR_FREE(pVertices);
+    OVR_FREE(pIndices);
+    pVertices = NULL;
+    pIndices  = NULL;
+    GridX     = 0;
+    GridY     = 0;
+}
+
+bool DistortionMesh::Generate(const StereoEyeParams& eye, const Viewport& fullViewport,
+                              int gridX, int gridY)
+{
+    DistortionMeshJob job;
+    if (gridX < 1 || gridY < 1 || gridX > MaxGridSize || gridY > MaxGridSize ||
+        !job.Params.Init(eye, fullViewport))
+    {
+        return false;
+    }
+
+    Clear();
+    GridX     = gridX;
+    GridY     = gridY;
+    pVertices = (DistortionMeshVertex*)OVR_ALLOC(GetVertexCount() * sizeof(DistortionMeshVertex));
+    pIndices  = (UInt16*)OVR_ALLOC(GetIndexCount() * sizeof(UInt16));
+
+    job.pVertices = pVertices;
+    job.GridX     = gridX;
+    job.GridY     = gridY;
+    runRows(generateMeshRow, &job, gridY + 1, gridX + 1);
+
+    // Two counter-clockwise triangles per quad
+    UInt16* index = pIndices;
+    for (int y = 0; y < gridY; y++)
+    {
+        for (int x = 0; x < gridX; x++)
+        {
+            UInt16 a = (UInt16)(y * (gridX + 1) + x);
+            UInt16 b = (UInt16)(a + 1);
+            UInt16 c = (UInt16)(a + gridX + 1);
+            UInt16 d = (UInt16)(c + 1);
+            index[0] = a; index[1] = b; index[2] = c;
+            index[3] = c; index[4] = b; index[5] = d;
+            index += 6;
+        }
+    }
+    return true;
+}
+
+
+//-----------------------------------------------------------------------------------
+// ***** DistortionWarpMap
+
+struct DistortionWarpMapJob
+{
+    DistortionParams Params;
+    UInt16*          pData;
+    int              Width, Height;
+};
+
+static void generateWarpMapRow(void* context, int row)
+{
+    const DistortionWarpMapJob& job = *(const DistortionWarpMapJob*)context;
+    const DistortionParams&     p   = job.Params;
+    UInt16*                     out = job.pData + row * job.Width * 4;
+
+    // Pixel centers
+    float du = p.Size.x / float(job.Width);
+    float ty = p.Origin.y + (row + 0.5f) * (p.Size.y / float(job.Height));
+    int   i  = 0;
+
+#if defined(OVR_CPU_SSE)
+    DistortionParams4 p4(p);
+    const __m128 step4 = _mm_set1_ps(4 * du);
+    __m128       tx    = _mm_add_ps(_mm_set1_ps(p.Origin.x),
+                                    _mm_mul_ps(_mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f), _mm_set1_ps(du)));
+
+    for (; i + 4 <= job.Width; i += 4)
+    {
+        __m128 gx, gy, sr, sb;
+        p4.Evaluate(tx, ty, &gx, &gy, &sr, &sb);
+        gx = _mm_sub_ps(gx, p4.LensX);
+        gy = _mm_sub_ps(gy, p4.LensY);
+        tx = _mm_add_ps(tx, step4);
+
+        // One register per pixel, then two pixels per store
+        _MM_TRANSPOSE4_PS(gx, gy, sr, sb);
+        __m128i h0 = floatToHalf4(gx), h1 = floatToHalf4(gy);
+        __m128i h2 = floatToHalf4(sr), h3 = floatToHalf4(sb);
+        // Sign extend so that the signed pack keeps all 16 bits
+        h0 = _mm_srai_epi32(_mm_slli_epi32(h0, 16), 16);
+        h1 = _mm_srai_epi32(_mm_slli_epi32(h1, 16), 16);
+        h2 = _mm_srai_epi32(_mm_slli_epi32(h2, 16), 16);
+        h3 = _mm_srai_epi32(_mm_slli_epi32(h3, 16), 16);
+        _mm_storeu_si128((__m128i*)(out + i * 4),     _mm_packs_epi32(h0, h1));
+        _mm_storeu_si128((__m128i*)(out + i * 4 + 8), _mm_packs_epi32(h2, h3));
+    }
+#endif
+
+    for (; i < job.Width; i++)
+    {
+        float tx = p.Origin.x + (i + 0.5f) * du;
+        float gx, gy, sr, sb;
+        p.Evaluate(tx, ty, &gx, &gy, &sr, &sb);
+        out[i * 4]     = FloatToHalf(gx - p.LensCenter.x);
+        out[i * 4 + 1] = FloatToHalf(gy - p.LensCenter.y);
+        out[i * 4 + 2] = FloatToHalf(sr);
+        out[i * 4 + 3] = FloatToHalf(sb);
+    }
+}
+
+DistortionWarpMap::DistortionWarpMap()
+  : pData(NULL), Width(0), Height(0)
+{
+}
+
+DistortionWarpMap::~DistortionWarpMap()
+{
+    Clear();
+}
+
+void DistortionWarpMap::Clear()
+{
+    OVR_FREE(pData);
+    pData  = NULL;
+    Width  = 0;
+    Height = 0;
+}
+
+bool DistortionWarpMap::Generate(const StereoEyeParams& eye, const Viewport& fullViewport)
+{
+    DistortionWarpMapJob job;
+    if (!job.Params.Init(eye, fullViewport))
+        return false;
+
+    Clear();
+    Width      = eye.VP.w;
+    Height     = eye.VP.h;
+    LensCenter = job.Params.LensCenter;
+    pData      = (UInt16*)OVR_ALLOC(Width * Height * 4 * sizeof(UInt16));
+
+    job.pData  = pData;
+    job.Width  = Width;
+    job.Height = Height;
+    runRows(generateWarpMapRow, &job, Height, Width);
+    return true;
+}
+
+
+}}}  // OVR::Util::Render
@@ -0,0 +1,130 @@
+/************************************************************************************
+
+PublicHeader:   OVR.h
+Filename    :   Util_Render_Distortion.h
+Content     :   CPU generation of lens distortion meshes and warp maps.
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_Util_Render_Distortion_h
+#define OVR_Util_Render_Distortion_h
+
+#include "Util_Render_Stereo.h"
+
+namespace OVR { namespace Util { namespace Render {
+
+// The distortion shader evaluates, for every output pixel of an eye, the barrel distortion
+// and chromatic aberration correction to find where to sample the rendered image. The
+// classes below evaluate the same function on the CPU once, so that rendering only needs
+// to interpolate the result: either as texture coordinates on a mesh covering the eye
+// (DistortionMesh), or as a per-pixel lookup texture (DistortionWarpMap).
+//
+// Texture coordinates are in [0,1] units of the full render target, which is described by
+// the full viewport passed to Generate (StereoConfig::GetFullViewport); the eye covers
+// StereoEyeParams::VP within it. As with the shader, the right eye uses the negated
+// DistortionConfig::XCenterOffset.
+
+
+//-----------------------------------------------------------------------------------
+// ***** DistortionMesh
+
+struct DistortionMeshVertex
+{
+    Vector2f Pos;    // Position in the eye viewport, [-1,1] clip space.
+    Vector2f TexR;   // Where each color channel is sampled in the render target.
+    Vector2f TexG;
+    Vector2f TexB;
+    float    Fade;   // 0 where the shader would output black (blue sampled outside the
+                     // eye's part of the render target), 1 elsewhere.
+};
+
+// DistortionMesh is a grid of GridX by GridY quads covering one eye, drawn as an indexed
+// triangle list. Interpolation error shrinks with the square of the density; for DK1 it is
+// within 2 pixels of the shader at 32x32 quads and within 0.6 pixels at 64x64.
+class DistortionMesh : public NewOverrideBase
+{
+public:
+    enum
+    {
+        MaxGridSize = 255   // Keeps vertex indices within 16 bits.
+    };
+
+    DistortionMesh();
+    ~DistortionMesh();
+
+    // Generates the mesh for the eye; returns false if the grid size or viewports are invalid.
+    bool Generate(const StereoEyeParams& eye, const Viewport& fullViewport, int gridX, int gridY);
+    void Clear();
+
+    const DistortionMeshVertex* GetVertices() const    { return pVertices; }
+    int                         GetVertexCount() const { return (GridX + 1) * (GridY + 1); }
+    const UInt16*               GetIndices() const     { return pIndices; }
+    int                         GetIndexCount() const  { return GridX * GridY * 6; }
+    int                         GetGridX() const       { return GridX; }
+    int                         GetGridY() const       { return GridY; }
+
+private:
+    DistortionMeshVertex* pVertices;
+    UInt16*               pIndices;
+    int                   GridX, GridY;
+};
+
+
+//-----------------------------------------------------------------------------------
+// ***** DistortionWarpMap
+
+// DistortionWarpMap holds, for every pixel of an eye viewport, four half floats suitable
+// for an RGBA16F texture: the offset (u, v) of the green channel's texture coordinate from
+// the lens center, then the red and blue scale factors, so that
+//     green = LensCenter + offset
+//     red   = LensCenter + offset * redScale, and likewise for blue
+// with LensCenter from GetLensCenter. Storing offsets keeps the error of the half floats
+// within a quarter of a pixel for DK1. Rows go up from the bottom of the viewport.
+class DistortionWarpMap : public NewOverrideBase
+{
+public:
+    DistortionWarpMap();
+    ~DistortionWarpMap();
+
+    bool Generate(const StereoEyeParams& eye, const Viewport& fullViewport);
+    void Clear();
+
+    const UInt16* GetData() const       { return pData; }
+    int           GetWidth() const      { return Width; }
+    int           GetHeight() const     { return Height; }
+    Vector2f      GetLensCenter() const { return LensCenter; }
+
+private:
+    UInt16*  pData;
+    int      Width, Height;
+    Vector2f LensCenter;
+};
+
+// Converts a float to the nearest half precision value; values below the smallest
+// normal half are flushed to zero.
+UInt16 FloatToHalf(float f);
+float  HalfToFloat(UInt16 h);
+
+
+}}}  // OVR::Util::Render
+
+#endif
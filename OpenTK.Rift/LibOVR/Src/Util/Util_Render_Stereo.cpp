@@ -25,17 +25,23 @@ limitations under the License.
 *************************************************************************************/
 
 #include "Util_Render_Stereo.h"
+#include "../Kernel/OVR_Alg.h"
+
+#if defined(OVR_CPU_SSE)
+#include <xmmintrin.h>
+#endif
 
 namespace OVR { namespace Util { namespace Render {
 
 
 //-----------------------------------------------------------------------------------
+// **** DistortionConfig Implementation
 
-// DistortionFnInverse computes the inverse of the distortion function on an argument.
-float DistortionConfig::DistortionFnInverse(float r)
-{    
-    OVR_ASSERT((r <= 10.0f));
+const float DistortionConfig::InverseMaxRadius = 10.0f;
 
+// Bracketing search for the inverse; used when the distortion function is not monotone.
+float DistortionConfig::inverseSearch(float r) const
+{    
     float s, d;
     float delta = r * 0.25f;
 
@@ -68,6 +74,194 @@ float DistortionConfig::DistortionFnInverse(float r)
     return s;
 }
 
+// One Newton step towards DistortionFn(s) = r.
+float DistortionConfig::inverseNewton(float r, float s) const
+{
+    float ssq   = s * s;
+    float deriv = K[0] + ssq * (3 * K[1] + ssq * (5 * K[2] + ssq * 7 * K[3]));
+    return s - (DistortionFn(s) - r) / deriv;
+}
+
+// Double precision distortion function, for building the inverse table.
+struct DistortionPolynomial
+{
+    double K[4];
+
+    double Value(double s) const
+    {
+        double ssq = s * s;
+        return s * (K[0] + ssq * (K[1] + ssq * (K[2] + ssq * K[3])));
+    }
+    double Deriv(double s) const
+    {
+        double ssq = s * s;
+        return K[0] + ssq * (3 * K[1] + ssq * (5 * K[2] + ssq * 7 * K[3]));
+    }
+    // Newton iteration for Value(s) = r, starting from an s below the solution
+    double Solve(double r, double s) const
+    {
+        for (int i = 0; i < 50; i++)
+        {
+            double step = (Value(s) - r) / Deriv(s);
+            s -= step;
+            if (fabs(step) <= 1e-15 * (1 + fabs(s)))
+                break;
+        }
+        return s;
+    }
+};
+
+// Rebuilds the inverse table if K changed; returns whether the table can be used.
+bool DistortionConfig::updateInverse()
+{
+    if (InverseValid && K[0] == InverseK[0] && K[1] == InverseK[1] &&
+                        K[2] == InverseK[2] && K[3] == InverseK[3])
+    {
+        return InverseMonotone;
+    }
+
+    const int    checkPoints = 16;
+    const double h           = InverseMaxRadius / (InverseTableSize - 1);
+
+    for (int i = 0; i < 4; i++)
+        InverseK[i] = K[i];
+    InverseValid    = true;
+    InverseMonotone = false;
+    InverseError    = 0;
+
+    DistortionPolynomial fn = { { K[0], K[1], K[2], K[3] } };
+
+    // The function must be increasing over the whole range for the inverse to exist
+    if (!(fn.Deriv(0) > 0))
+        return false;
+
+    // Nodes evenly spaced in r, with their slopes ds/dr scaled to a segment
+    double nodeS[InverseTableSize], nodeM[InverseTableSize];
+    double s = 0;
+    for (int i = 0; i < InverseTableSize; i++)
+    {
+        double sPrev = s;
+        s = fn.Solve(i * h, s);
+        for (int j = 1; j <= checkPoints; j++)
+        {
+            if (!(fn.Deriv(sPrev + (s - sPrev) * j / checkPoints) > 0))
+                return false;
+        }
+        nodeS[i] = s;
+        nodeM[i] = h / fn.Deriv(s);
+    }
+
+    for (int i = 0; i < InverseTableSize - 1; i++)
+    {
+        double s0 = nodeS[i], s1 = nodeS[i + 1], ds = s1 - s0;
+        double m0 = nodeM[i], m1 = nodeM[i + 1];
+
+        // Fritsch-Carlson condition, which keeps the Hermite segment monotone
+        double a = m0 / ds, b = m1 / ds, t = a * a + b * b;
+        if (t > 9)
+        {
+            double tau = 3 / sqrt(t);
+            m0 *= tau;
+            m1 *= tau;
+        }
+
+        InverseTable[i][0] = (float)s0;
+        InverseTable[i][1] = (float)m0;
+        InverseTable[i][2] = (float)(3 * ds - 2 * m0 - m1);
+        InverseTable[i][3] = (float)(m0 + m1 - 2 * ds);
+    }
+    // The last entry only serves r == InverseMaxRadius
+    InverseTable[InverseTableSize - 1][0] = (float)nodeS[InverseTableSize - 1];
+    InverseTable[InverseTableSize - 1][1] = 0;
+    InverseTable[InverseTableSize - 1][2] = 0;
+    InverseTable[InverseTableSize - 1][3] = 0;
+    InverseMonotone = true;
+
+    // Measure the error of the complete float evaluation against the exact inverse
+    for (int i = 0; i <= (InverseTableSize - 1) * checkPoints; i++)
+    {
+        float  r     = (float)(i * h / checkPoints);
+        double exact = fn.Solve(r, nodeS[i / checkPoints]);
+        InverseError = Alg::Max(InverseError, (float)fabs(DistortionFnInverse(r) - exact));
+    }
+    return true;
+}
+
+// DistortionFnInverse computes the inverse of the distortion function on an argument.
+float DistortionConfig::DistortionFnInverse(float r)
+{    
+    OVR_ASSERT((r <= InverseMaxRadius));
+
+    if (r < 0)
+        return -DistortionFnInverse(-r);
+    if (!updateInverse() || !(r <= InverseMaxRadius))
+        return inverseSearch(r);
+
+    float x = r * ((InverseTableSize - 1) / InverseMaxRadius);
+    int   i = (int)x;
+    float t = x - i;
+    const float* c = InverseTable[i];
+    return inverseNewton(r, c[0] + t * (c[1] + t * (c[2] + t * c[3])));
+}
+
+void DistortionConfig::DistortionFnInverse(const float* r, float* s, int count)
+{
+    int i = 0;
+#if defined(OVR_CPU_SSE)
+    if (updateInverse())
+    {
+        const __m128 scale = _mm_set1_ps((InverseTableSize - 1) / InverseMaxRadius);
+        const __m128 maxR  = _mm_set1_ps(InverseMaxRadius);
+        const __m128 signs = _mm_set1_ps(-0.0f);
+        const __m128 k0 = _mm_set1_ps(K[0]), k1 = _mm_set1_ps(K[1]), k2 = _mm_set1_ps(K[2]), k3 = _mm_set1_ps(K[3]);
+        const __m128 d1 = _mm_set1_ps(3 * K[1]), d2 = _mm_set1_ps(5 * K[2]), d3 = _mm_set1_ps(7 * K[3]);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 rv   = _mm_loadu_ps(r + i);
+            __m128 sign = _mm_and_ps(rv, signs);
+            __m128 ra   = _mm_andnot_ps(signs, rv);
+
+            // Radii outside of the table (or NaNs) take the scalar path
+            if (_mm_movemask_ps(_mm_cmple_ps(ra, maxR)) != 0xF)
+            {
+                for (int j = 0; j < 4; j++)
+                    s[i + j] = DistortionFnInverse(r[i + j]);
+                continue;
+            }
+
+            // Gather the segment cubics, one register per power after the transpose
+            __m128 x = _mm_mul_ps(ra, scale);
+            float  xs[4];
+            _mm_storeu_ps(xs, x);
+            int    idx[4] = { (int)xs[0], (int)xs[1], (int)xs[2], (int)xs[3] };
+            __m128 c0 = _mm_loadu_ps(InverseTable[idx[0]]);
+            __m128 c1 = _mm_loadu_ps(InverseTable[idx[1]]);
+            __m128 c2 = _mm_loadu_ps(InverseTable[idx[2]]);
+            __m128 c3 = _mm_loadu_ps(InverseTable[idx[3]]);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+            __m128 t  = _mm_sub_ps(x, _mm_setr_ps((float)idx[0], (float)idx[1], (float)idx[2], (float)idx[3]));
+            __m128 sv = _mm_add_ps(c0, _mm_mul_ps(t, _mm_add_ps(c1, _mm_mul_ps(t, _mm_add_ps(c2, _mm_mul_ps(t, c3))))));
+
+            // Newton step
+            __m128 ssq   = _mm_mul_ps(sv, sv);
+            __m128 value = _mm_mul_ps(sv, _mm_add_ps(k0, _mm_mul_ps(ssq, _mm_add_ps(k1, _mm_mul_ps(ssq, _mm_add_ps(k2, _mm_mul_ps(ssq, k3)))))));
+            __m128 deriv = _mm_add_ps(k0, _mm_mul_ps(ssq, _mm_add_ps(d1, _mm_mul_ps(ssq, _mm_add_ps(d2, _mm_mul_ps(ssq, d3))))));
+            sv = _mm_sub_ps(sv, _mm_div_ps(_mm_sub_ps(value, ra), deriv));
+
+            _mm_storeu_ps(s + i, _mm_or_ps(sv, sign));
+        }
+    }
+#endif
+    for (; i < count; i++)
+        s[i] = DistortionFnInverse(r[i]);
+}
+
+float DistortionConfig::GetDistortionFnInverseError()
+{
+    return updateInverse() ? InverseError : -1.0f;
+}
+
 
 //-----------------------------------------------------------------------------------
 // **** StereoConfig Implementation
@@ -75,10 +269,13 @@ float DistortionConfig::DistortionFnInverse(float r)
 StereoConfig::StereoConfig(StereoMode mode, const Viewport& vp)
     : Mode(mode),
       InterpupillaryDistance(0.064f), AspectMultiplier(1.0f),
-      FullView(vp), DirtyFlag(true), IPDOverride(false),
+      FullView(vp), DirtyFlags(Dirty_All), IPDOverride(false), ComputedVersion(0),
       YFov(0), Aspect(vp.w / float(vp.h)), ProjectionCenterOffset(0),
-      OrthoPixelOffset(0)
+      OrthoPixelOffset(0), MemoClock(0)
 {
+    for (int i = 0; i < MemoSize; i++)
+        Memo[i].LastUsed = 0;
+
     // And default distortion for it.
     Distortion.SetCoefficients(1.0f, 0.22f, 0.24f);
     Distortion.Scale = 1.0f; // Will be computed later.
@@ -109,7 +306,7 @@ void StereoConfig::SetFullViewport(const Viewport& vp)
     if (vp != FullView)
     { 
         FullView = vp;
-        DirtyFlag = true;
+        DirtyFlags |= Dirty_Viewport;
     }
 }
 
@@ -127,27 +324,27 @@ void StereoConfig::SetHMDInfo(const HMDInfo& hmd)
     if (!IPDOverride)
         InterpupillaryDistance = HMD.InterpupillaryDistance;
 
-    DirtyFlag = true;
+    DirtyFlags |= Dirty_HMD | Dirty_Distortion | Dirty_IPD;
 }
 
 void StereoConfig::SetDistortionFitPointVP(float x, float y)
 {
     DistortionFitX = x;
     DistortionFitY = y;
-    DirtyFlag = true;
+    DirtyFlags |= Dirty_Distortion;
 }
 
 void StereoConfig::SetDistortionFitPointPixels(float x, float y)
 {
     DistortionFitX = (4 * x / float(FullView.w)) - 1.0f;
     DistortionFitY = (2 * y / float(FullView.h)) - 1.0f;
-    DirtyFlag = true;
+    DirtyFlags |= Dirty_Distortion;
 }
 
 void StereoConfig::Set2DAreaFov(float fovRadians)
 {
     Area2DFov = fovRadians;
-    DirtyFlag = true;
+    DirtyFlags |= Dirty_2DFov;
 }
 
 
@@ -170,13 +367,31 @@ void StereoConfig::updateComputedState()
     //   - Distortion XCenterOffset
     //   - Update 2D
     //   - Initialize EyeRenderParams
+    //
+    // Configurations seen recently are restored from the memo; otherwise only the stages
+    // depending on the modified state are recomputed.
+
+    StateKey key;
+    makeStateKey(&key);
+    if (restoreFromMemo(key))
+    {
+        DirtyFlags = 0;
+        ComputedVersion++;
+        return;
+    }
+
+    UInt32 dirty = DirtyFlags;
 
     // Compute aspect ratio. Stereo mode cuts width in half.
-    Aspect = float(FullView.w) / float(FullView.h);
-    Aspect *= (Mode == Stereo_None) ? 1.0f : 0.5f;
-    Aspect *= AspectMultiplier; 
+    if (dirty & (Dirty_Mode | Dirty_Viewport | Dirty_Aspect))
+    {
+        Aspect = float(FullView.w) / float(FullView.h);
+        Aspect *= (Mode == Stereo_None) ? 1.0f : 0.5f;
+        Aspect *= AspectMultiplier; 
+    }
 
-    updateDistortionOffsetAndScale();
+    if (dirty & Dirty_Scale)
+        updateDistortionOffsetAndScale();
 
     // Compute Vertical FOV based on distance, distortion, etc.
     // Distance from vertical center to render vertical edge perceived through the lens.
@@ -195,21 +410,28 @@ void StereoConfig::updateComputedState()
     //
     //  halfRTDistance = (VScreenSize / 2) * DistortionScale
     //
-    if (Mode == Stereo_None)
+    if (dirty & Dirty_Fov)
     {
-        YFov = DegreeToRad(80.0f);
-    }
-    else
-    {
-        float percievedHalfRTDistance = (HMD.VScreenSize / 2) * Distortion.Scale;    
-        YFov = 2.0f * atan(percievedHalfRTDistance/HMD.EyeToScreenDistance);
+        if (Mode == Stereo_None)
+        {
+            YFov = DegreeToRad(80.0f);
+        }
+        else
+        {
+            float percievedHalfRTDistance = (HMD.VScreenSize / 2) * Distortion.Scale;    
+            YFov = 2.0f * atan(percievedHalfRTDistance/HMD.EyeToScreenDistance);
+        }
     }
     
-    updateProjectionOffset();
-    update2D();
-    updateEyeParams();
-
-    DirtyFlag = false;
+    if (dirty & Dirty_HMD)
+        updateProjectionOffset();
+    if (dirty & Dirty_2D)
+        update2D();
+    updateEyeParams(dirty);
+    storeInMemo(key);
+
+    DirtyFlags = 0;
+    ComputedVersion++;
 }
 
 void StereoConfig::updateDistortionOffsetAndScale()
@@ -286,38 +508,202 @@ void StereoConfig::update2D()
     OrthoPixelOffset = orthoPixelOffset * 2.0f / FovPixels;
 }
 
-void StereoConfig::updateEyeParams()
+void StereoConfig::updateEyeParams(UInt32 dirty)
 {
     // Projection matrix for the center eye, which the left/right matrices are based on.
-    Matrix4f projCenter = Matrix4f::PerspectiveRH(YFov, Aspect, 0.01f, 2000.0f);
-   
-    switch(Mode)
+    Matrix4f projCenter;
+    if (dirty & Dirty_Projection)
+        projCenter = Matrix4f::PerspectiveRH(YFov, Aspect, 0.01f, 2000.0f);
+
+    int eyeCount = (Mode == Stereo_None) ? 1 : 2;
+    for (int i = 0; i < eyeCount; i++)
     {
-    case Stereo_None:
+        StereoEyeParams& params = EyeRenderParams[i];
+        // Direction of the per-eye shifts: left eye positive, none for the center eye
+        float            sign   = (Mode == Stereo_None) ? 0.0f : (i == 0) ? 1.0f : -1.0f;
+
+        if (dirty & (Dirty_Mode | Dirty_Viewport))
         {
-            EyeRenderParams[0].Init(StereoEye_Center, FullView, 0, projCenter, OrthoCenter);
+            if (Mode == Stereo_None)
+            {
+                params.Eye         = StereoEye_Center;
+                params.VP          = FullView;
+                params.pDistortion = 0;
+            }
+            else
+            {
+                params.Eye         = (i == 0) ? StereoEye_Left : StereoEye_Right;
+                params.VP          = Viewport(FullView.x + i * (FullView.w/2), FullView.y, FullView.w/2, FullView.h);
+                params.pDistortion = &Distortion;
+            }
         }
-        break;
+        if (dirty & Dirty_Projection)
+        {
+            params.Projection        = Matrix4f::Translation(sign * ProjectionCenterOffset, 0, 0) * projCenter;
+            params.ProjectionInverse = params.Projection.Inverted();
+        }
+        if (dirty & (Dirty_Mode | Dirty_IPD))
+        {
+            // World view shift.
+            params.ViewAdjust = Matrix4f::Translation(Vector3f(sign * InterpupillaryDistance * 0.5f, 0, 0));
+        }
+        if (dirty & (Dirty_Mode | Dirty_2D))
+        {
+            params.OrthoProjection = OrthoCenter * Matrix4f::Translation(sign * OrthoPixelOffset, 0, 0);
+        }
+    }
+}
 
-    case Stereo_LeftRight_Multipass:
+bool StereoConfig::StateKey::operator == (const StateKey& other) const
+{
+    for (int i = 0; i < 4; i++)
+        if (DistortionK[i] != other.DistortionK[i])
+            return false;
+    return Mode == other.Mode && FullView == other.FullView &&
+           AspectMultiplier == other.AspectMultiplier &&
+           InterpupillaryDistance == other.InterpupillaryDistance &&
+           Area2DFov == other.Area2DFov &&
+           DistortionFitX == other.DistortionFitX && DistortionFitY == other.DistortionFitY &&
+           HResolution == other.HResolution && VResolution == other.VResolution &&
+           HScreenSize == other.HScreenSize && VScreenSize == other.VScreenSize &&
+           EyeToScreenDistance == other.EyeToScreenDistance &&
+           LensSeparationDistance == other.LensSeparationDistance;
+}
+
+void StereoConfig::makeStateKey(StateKey* key) const
+{
+    *key = StateKey();
+    key->Mode                   = Mode;
+    key->FullView               = FullView;
+    key->AspectMultiplier       = AspectMultiplier;
+    key->InterpupillaryDistance = InterpupillaryDistance;
+    key->Area2DFov              = Area2DFov;
+    for (int i = 0; i < 4; i++)
+        key->DistortionK[i]     = Distortion.K[i];
+    key->DistortionFitX         = DistortionFitX;
+    key->DistortionFitY         = DistortionFitY;
+    key->HResolution            = HMD.HResolution;
+    key->VResolution            = HMD.VResolution;
+    key->HScreenSize            = HMD.HScreenSize;
+    key->VScreenSize            = HMD.VScreenSize;
+    key->EyeToScreenDistance    = HMD.EyeToScreenDistance;
+    key->LensSeparationDistance = HMD.LensSeparationDistance;
+}
+
+bool StereoConfig::restoreFromMemo(const StateKey& key)
+{
+    for (int i = 0; i < MemoSize; i++)
+    {
+        MemoEntry& entry = Memo[i];
+        if (entry.LastUsed == 0 || !(entry.Key == key))
+            continue;
+
+        entry.LastUsed           = ++MemoClock;
+        YFov                     = entry.YFov;
+        Aspect                   = entry.Aspect;
+        ProjectionCenterOffset   = entry.ProjectionCenterOffset;
+        Distortion.XCenterOffset = entry.XCenterOffset;
+        Distortion.Scale         = entry.DistortionScale;
+        FovPixels                = entry.FovPixels;
+        OrthoPixelOffset         = entry.OrthoPixelOffset;
+        OrthoCenter              = entry.OrthoCenter;
+        EyeRenderParams[0]       = entry.EyeRenderParams[0];
+        EyeRenderParams[1]       = entry.EyeRenderParams[1];
+        return true;
+    }
+    return false;
+}
+
+void StereoConfig::storeInMemo(const StateKey& key)
+{
+    MemoEntry* entry = &Memo[0];
+    for (int i = 1; i < MemoSize; i++)
+    {
+        if (Memo[i].LastUsed < entry->LastUsed)
+            entry = &Memo[i];
+    }
+
+    entry->Key                    = key;
+    entry->LastUsed               = ++MemoClock;
+    entry->YFov                   = YFov;
+    entry->Aspect                 = Aspect;
+    entry->ProjectionCenterOffset = ProjectionCenterOffset;
+    entry->XCenterOffset          = Distortion.XCenterOffset;
+    entry->DistortionScale        = Distortion.Scale;
+    entry->FovPixels              = FovPixels;
+    entry->OrthoPixelOffset       = OrthoPixelOffset;
+    entry->OrthoCenter            = OrthoCenter;
+    entry->EyeRenderParams[0]     = EyeRenderParams[0];
+    entry->EyeRenderParams[1]     = EyeRenderParams[1];
+}
+
+
+
+//-----------------------------------------------------------------------------------
+// **** Timewarp
+
+// d = a * b for count pairs of matrices; the SSE path computes each row of d as a
+// combination of the rows of b.
+static void multiplyMatrices(Matrix4f* d, const Matrix4f* a, const Matrix4f* b, int count)
+{
+    for (int n = 0; n < count; n++)
+    {
+#if defined(OVR_CPU_SSE)
+        __m128 b0 = _mm_loadu_ps(b[n].M[0]);
+        __m128 b1 = _mm_loadu_ps(b[n].M[1]);
+        __m128 b2 = _mm_loadu_ps(b[n].M[2]);
+        __m128 b3 = _mm_loadu_ps(b[n].M[3]);
+        for (int i = 0; i < 4; i++)
         {
-            Matrix4f projLeft  = Matrix4f::Translation(ProjectionCenterOffset, 0, 0) * projCenter,
-                     projRight = Matrix4f::Translation(-ProjectionCenterOffset, 0, 0) * projCenter;
-
-            EyeRenderParams[0].Init(StereoEye_Left,
-                Viewport(FullView.x, FullView.y, FullView.w/2, FullView.h),
-                         +InterpupillaryDistance * 0.5f,  // World view shift.                       
-                         projLeft, OrthoCenter * Matrix4f::Translation(OrthoPixelOffset, 0, 0),
-                         &Distortion);
-            EyeRenderParams[1].Init(StereoEye_Right,
-                Viewport(FullView.x + FullView.w/2, FullView.y, FullView.w/2, FullView.h),
-                         -InterpupillaryDistance * 0.5f,                         
-                         projRight, OrthoCenter * Matrix4f::Translation(-OrthoPixelOffset, 0, 0),
-                         &Distortion);
+            const float* ai = a[n].M[i];
+            __m128 row = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(ai[0]), b0),
+                                               _mm_mul_ps(_mm_set1_ps(ai[1]), b1)),
+                                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ai[2]), b2),
+                                               _mm_mul_ps(_mm_set1_ps(ai[3]), b3)));
+            _mm_storeu_ps(d[n].M[i], row);
         }
-        break;
+#else
+        Matrix4f::Multiply(&d[n], a[n], b[n]);
+#endif
     }
+}
+
+Matrix4f StereoConfig::GetTimewarpMatrix(StereoEye eye, const Quatf& renderOrientation,
+                                         const Quatf& displayOrientation)
+{
+    const StereoEyeParams& params = GetEyeRenderParams(eye);
+
+    // View space of the displayed frame -> world -> view space of the rendered frame
+    Matrix4f delta = renderOrientation.Inverted() * displayOrientation;
+    return params.Projection * delta * params.ProjectionInverse;
+}
+
+int StereoConfig::GetTimewarpMatrices(const Quatf& renderOrientation, const Quatf& scanoutStart,
+                                      const Quatf& scanoutEnd, Matrix4f* matrices)
+{
+    updateIfDirty();
+
+    Quatf    renderInv = renderOrientation.Inverted();
+    Matrix4f deltas[2] = { Matrix4f(renderInv * scanoutStart), Matrix4f(renderInv * scanoutEnd) };
+    int      eyes      = (Mode == Stereo_None) ? 1 : 2;
+
+    // Lay out the operands so that each product is a single batched pass
+    Matrix4f a[4], b[4], temp[4];
+    for (int e = 0; e < eyes; e++)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            a[e * 2 + i] = deltas[i];
+            b[e * 2 + i] = EyeRenderParams[e].ProjectionInverse;
+        }
+    }
+    multiplyMatrices(temp, a, b, eyes * 2);
+
+    for (int e = 0; e < eyes; e++)
+        a[e * 2] = a[e * 2 + 1] = EyeRenderParams[e].Projection;
+    multiplyMatrices(matrices, a, temp, eyes * 2);
 
+    return eyes * 2;
 }
 
 
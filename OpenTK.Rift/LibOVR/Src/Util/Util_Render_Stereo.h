@@ -91,8 +91,16 @@ struct Viewport
 class DistortionConfig
 {
 public:
+    enum
+    {
+        InverseTableSize = 64
+    };
+
+    // Radii up to this value can be inverted.
+    static const float InverseMaxRadius;
+
     DistortionConfig(float k0 = 1.0f, float k1 = 0.0f, float k2 = 0.0f, float k3 = 0.0f)
-        : XCenterOffset(0), YCenterOffset(0), Scale(1.0f)
+        : XCenterOffset(0), YCenterOffset(0), Scale(1.0f), InverseValid(false)
     { 
         SetCoefficients(k0, k1, k2, k3);
         SetChromaticAberration();
@@ -115,7 +123,15 @@ public:
     }
 
     // DistortionFnInverse computes the inverse of the distortion function on an argument.
+    // The inverse is interpolated from a monotone cubic table, rebuilt whenever K changes,
+    // and refined by a Newton step; coefficients for which the distortion function is not
+    // increasing fall back to a bracketing search.
     float DistortionFnInverse(float r);
+    // Inverts count radii at once; r and s may be the same array.
+    void  DistortionFnInverse(const float* r, float* s, int count);
+    // Largest error of DistortionFnInverse, measured over [0, InverseMaxRadius] with
+    // 16 points per table segment when the table was built; -1 if the search is used.
+    float GetDistortionFnInverseError();
 
     float   K[4];
     float   XCenterOffset, YCenterOffset;
@@ -126,6 +142,18 @@ public:
                                     // Index [1] - Red channel r^2 coefficient.
                                     // Index [2] - Blue channel constant coefficient.
                                     // Index [3] - Blue channel r^2 coefficient.
+
+private:
+    bool  updateInverse();
+    float inverseSearch(float r) const;
+    float inverseNewton(float r, float s) const;
+
+    // Cubic in the position within each segment, lowest power first
+    float   InverseTable[InverseTableSize][4];
+    float   InverseK[4];        // Coefficients the table was built for
+    bool    InverseValid;
+    bool    InverseMonotone;
+    float   InverseError;
 };
 
 
@@ -144,6 +172,7 @@ public:
     Matrix4f                 ViewAdjust;       // Translation to be applied to view matrix.
     Matrix4f                 Projection;       // Projection matrix used with this eye.
     Matrix4f                 OrthoProjection;  // Orthographic projection used with this eye.
+    Matrix4f                 ProjectionInverse; // Inverse of Projection, used for reprojection.
 
     void Init(StereoEye eye, const Viewport &vp, float vofs,
               const Matrix4f& proj, const Matrix4f& orthoProj,
@@ -153,6 +182,7 @@ public:
         VP                     = vp;
         ViewAdjust             = Matrix4f::Translation(Vector3f(vofs,0,0));
         Projection             = proj;
+        ProjectionInverse      = proj.Inverted();
         OrthoProjection        = orthoProj;
         pDistortion            = distortion;        
     }
@@ -187,7 +217,7 @@ public:
 
     // Sets a stereo rendering mode and updates internal cached
     // state (matrices, per-eye view) based on it.
-    void        SetStereoMode(StereoMode mode)  { Mode = mode; DirtyFlag = true; }
+    void        SetStereoMode(StereoMode mode)  { Mode = mode; DirtyFlags |= Dirty_Mode; }
     StereoMode  GetStereoMode() const           { return Mode; }
 
     // Sets HMD parameters; also initializes distortion coefficients.
@@ -197,10 +227,10 @@ public:
     // Query physical eye-to-screen distance in meters, which combines screen-to-lens and
     // and lens-to-eye pupil distances. Modifying this value adjusts FOV.
     float       GetEyeToScreenDistance() const  { return HMD.EyeToScreenDistance; }
-    void        SetEyeToScreenDistance(float esd) { HMD.EyeToScreenDistance = esd; DirtyFlag = true; }
+    void        SetEyeToScreenDistance(float esd) { HMD.EyeToScreenDistance = esd; DirtyFlags |= Dirty_HMD; }
 
     // Interpupillary distance used for stereo, in meters. Default is 0.064m (64 mm).
-    void        SetIPD(float ipd)               { InterpupillaryDistance = ipd; IPDOverride = DirtyFlag = true; }
+    void        SetIPD(float ipd)               { InterpupillaryDistance = ipd; IPDOverride = true; DirtyFlags |= Dirty_IPD; }
     float       GetIPD() const                  { return InterpupillaryDistance; }
 
     // Set full render target viewport; for HMD this includes both eyes. 
@@ -209,7 +239,7 @@ public:
 
     // Aspect ratio defaults to ((w/h)*multiplier) computed per eye.
     // Aspect multiplier allows adjusting aspect ratio consistently for Stereo/NoStereo.
-    void        SetAspectMultiplier(float m)    { AspectMultiplier = m; DirtyFlag = true; }
+    void        SetAspectMultiplier(float m)    { AspectMultiplier = m; DirtyFlags |= Dirty_Aspect; }
     float       GetAspectMultiplier() const     { return AspectMultiplier; }
 
     
@@ -227,10 +257,10 @@ public:
 
     // Changes all distortion settings.
     // Note that setting HMDInfo also changes Distortion coefficients.
-    void        SetDistortionConfig(const DistortionConfig& d) { Distortion = d; DirtyFlag = true; }
+    void        SetDistortionConfig(const DistortionConfig& d) { Distortion = d; DirtyFlags |= Dirty_Distortion; }
     
     // Modify distortion coefficients; useful for adjustment tweaking.
-    void        SetDistortionK(int i, float k)  { Distortion.K[i] = k; DirtyFlag = true; }
+    void        SetDistortionK(int i, float k)  { Distortion.K[i] = k; DirtyFlags |= Dirty_Distortion; }
     float       GetDistortionK(int i) const     { return Distortion.K[i]; }
 
     // Sets the fieldOfView that the 2D coordinate area stretches to.
@@ -263,16 +293,90 @@ public:
 
     // Returns full set of Stereo rendering parameters for the specified eye.
     const StereoEyeParams& GetEyeRenderParams(StereoEye eye);
+
+    // Returns a counter that changes whenever the computed state is recomputed, so that
+    // values derived from it can be cached until the next modification.
+    UInt32     GetComputedVersion()             { updateIfDirty(); return ComputedVersion; }
+
+
+    // *** Timewarp
+
+    // Returns the matrix that reprojects a frame rendered for an eye with the head at
+    // renderOrientation to the head orientation at the time it is displayed. Multiplying
+    // the clip space position (x, y, 1, 1) of a displayed pixel by it gives the homogeneous
+    // position (divide x and y by w) in the rendered image of what should be seen there.
+    // Only the head rotation is corrected.
+    Matrix4f   GetTimewarpMatrix(StereoEye eye, const Quatf& renderOrientation,
+                                 const Quatf& displayOrientation);
+
+    // Computes the timewarp matrices of every eye for the orientations at the start and
+    // at the end of scanout in one pass, e.g. for shaders that blend between the two
+    // along the scan direction. The matrices are stored as start, end for the left eye,
+    // then for the right one, or for the center eye only in Stereo_None mode. Returns
+    // the number of matrices written (4 or 2).
+    int        GetTimewarpMatrices(const Quatf& renderOrientation, const Quatf& scanoutStart,
+                                   const Quatf& scanoutEnd, Matrix4f* matrices);
    
 private:    
 
-    void updateIfDirty()   { if (DirtyFlag) updateComputedState(); }
+    // Modifiable state groups; each computation stage is redone only when one of the
+    // groups it depends on changed.
+    enum DirtyBits
+    {
+        Dirty_Mode       = 0x01,
+        Dirty_Viewport   = 0x02,
+        Dirty_Aspect     = 0x04,    // AspectMultiplier
+        Dirty_HMD        = 0x08,
+        Dirty_Distortion = 0x10,    // Coefficients and fit point
+        Dirty_IPD        = 0x20,
+        Dirty_2DFov      = 0x40,
+        Dirty_All        = 0x7F,
+
+        // Inputs of each stage
+        Dirty_Scale      = Dirty_HMD | Dirty_Distortion | Dirty_Viewport,
+        Dirty_Fov        = Dirty_Scale | Dirty_Mode,
+        Dirty_Projection = Dirty_Fov | Dirty_Aspect,
+        Dirty_2D         = Dirty_Scale | Dirty_IPD | Dirty_2DFov
+    };
+
+    // Key of the memo: all the modifiable state the computed state depends on.
+    struct StateKey
+    {
+        SInt32   Mode;
+        Viewport FullView;
+        float    AspectMultiplier, InterpupillaryDistance, Area2DFov;
+        float    DistortionK[4], DistortionFitX, DistortionFitY;
+        SInt32   HResolution, VResolution;
+        float    HScreenSize, VScreenSize, EyeToScreenDistance, LensSeparationDistance;
+
+        bool operator == (const StateKey& other) const;
+    };
+
+    // Computed state of a recently used configuration.
+    struct MemoEntry
+    {
+        StateKey        Key;
+        UInt32          LastUsed;   // 0 for unused entries
+        float           YFov, Aspect, ProjectionCenterOffset;
+        float           XCenterOffset, DistortionScale;
+        float           FovPixels, OrthoPixelOffset;
+        Matrix4f        OrthoCenter;
+        StereoEyeParams EyeRenderParams[2];
+    };
+
+    enum { MemoSize = 4 };
+
+    void updateIfDirty()   { if (DirtyFlags) updateComputedState(); }
     void updateComputedState();
 
     void updateDistortionOffsetAndScale();
     void updateProjectionOffset();
     void update2D();
-    void updateEyeParams();
+    void updateEyeParams(UInt32 dirty);
+
+    void makeStateKey(StateKey* key) const;
+    bool restoreFromMemo(const StateKey& key);
+    void storeInMemo(const StateKey& key);
 
 
     // *** Modifiable State
@@ -289,8 +393,9 @@ private:
  
     // *** Computed State
  
-    bool               DirtyFlag;   // Set when any if the modifiable state changed.
+    UInt32             DirtyFlags;  // DirtyBits of the modifiable state changed since the last update.
     bool               IPDOverride; // True after SetIPD was called.    
+    UInt32             ComputedVersion; // Incremented by updateComputedState.
     float              YFov;        // Vertical FOV.
     float              Aspect;      // Aspect ratio: (w/h)*AspectMultiplier.
     float              ProjectionCenterOffset;
@@ -303,6 +408,11 @@ private:
     float              FovPixels;
     Matrix4f           OrthoCenter;
     float              OrthoPixelOffset;
+
+
+    // ** Memo of recently used configurations, least recently used one replaced first.
+    MemoEntry          Memo[MemoSize];
+    UInt32             MemoClock;
 };
 
 
@@ -27,8 +27,12 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "OVR.h"
+#include "Kernel/OVR_Timer.h"
+#include "OVR_FrameTiming.h"
+#include "Util/Util_Render_Distortion.h"
 #include "OVR_wrapper.h"
 
 using namespace OVR;
@@ -59,13 +63,24 @@ struct OVR_Instance
     SensorDevice  *Sensor;
     SensorFusion  *Fusion;
     HMDInfo       *Info;
+    Util::Render::StereoConfig *Stereo;
+    FrameTiming   *Timing;
+    Util::LatencyTest *Latency;
+
+    // Stereo parameters without the view matrices, valid for StereoVersion
+    OVR_StereoRenderParams StereoParams;
+    UInt32        StereoVersion;
 
     OVR_Instance() :
         System(NULL),
         Device(NULL),
         Sensor(NULL),
         Fusion(NULL),
-        Info(NULL)
+        Info(NULL),
+        Stereo(NULL),
+        Timing(NULL),
+        Latency(NULL),
+        StereoVersion(0)
     {
     }
 };
@@ -121,6 +136,55 @@ namespace
         return q;
     }
 
+    // OVR_Quaternion and Quatf share their layout, so arrays are written in place
+    inline Quatf* quat_array(OVR_Quaternion* q)
+    {
+        OVR_COMPILER_ASSERT(sizeof(OVR_Quaternion) == sizeof(Quatf));
+        return reinterpret_cast<Quatf*>(q);
+    }
+
+    inline Quatf quat_from_quat(OVR_Quaternion q)
+    {
+        return Quatf(q.x, q.y, q.z, q.w);
+    }
+
+    inline const Util::Render::StereoEyeParams& eye_params(OVR_Instance *inst, int eye)
+    {
+        return inst->Stereo->GetEyeRenderParams(eye == 1 ? Util::Render::StereoEye_Right : Util::Render::StereoEye_Left);
+    }
+
+    inline void matrix_to_floats(const Matrix4f& m, float* out)
+    {
+        memcpy(out, m.M, sizeof(m.M));
+    }
+
+    inline void eye_to_params(const Util::Render::StereoEyeParams& eye, OVR_EyeRenderParams* params)
+    {
+        params->Viewport[0] = eye.VP.x;
+        params->Viewport[1] = eye.VP.y;
+        params->Viewport[2] = eye.VP.w;
+        params->Viewport[3] = eye.VP.h;
+        matrix_to_floats(eye.Projection, params->Projection);
+        matrix_to_floats(eye.OrthoProjection, params->OrthoProjection);
+        matrix_to_floats(eye.ViewAdjust, params->ViewAdjust);
+    }
+
+    inline double time_or_now(double time)
+    {
+        return time > 0 ? time : Timer::GetSeconds();
+    }
+
+    inline void stats_to_stats(const LatencyStats& ls, OVR_LatencyStats* stats)
+    {
+        stats->Count = (int)ls.Count;
+        stats->Min   = ls.MinMilliS;
+        stats->Mean  = ls.MeanMilliS;
+        stats->P50   = ls.P50MilliS;
+        stats->P90   = ls.P90MilliS;
+        stats->P99   = ls.P99MilliS;
+        stats->Max   = ls.MaxMilliS;
+    }
+
     inline OVR_Quaternion unit_quat()
     {
         OVR_Quaternion q = { 0.0f, 0.0f, 0.0f, 1.0f };
@@ -172,6 +236,20 @@ OVR_Instance* OVR_Create()
        inst->Fusion->AttachToSensor(inst->Sensor);
     }
 
+    inst->Timing = new FrameTiming();
+
+    // The latency test holds the tester; it does nothing until one is attached
+    Ptr<LatencyTestDevice> tester = *inst->System->Manager->EnumerateDevices<LatencyTestDevice>().CreateDevice();
+    inst->Latency = new Util::LatencyTest(tester);
+
+    // Without an HMD the stereo configuration keeps its DK1 defaults
+    inst->Stereo = new Util::Render::StereoConfig();
+    if (inst->Info)
+    {
+        inst->Stereo->SetHMDInfo(*inst->Info);
+        inst->Stereo->SetFullViewport(Util::Render::Viewport(0, 0, inst->Info->HResolution, inst->Info->VResolution));
+    }
+
     return inst;
 }
 
@@ -183,10 +261,16 @@ void OVR_Destroy(OVR_Instance *inst)
         delete inst->Sensor;
         delete inst->Device;
         delete inst->Info;
+        delete inst->Stereo;
+        delete inst->Timing;
+        delete inst->Latency;
         inst->Fusion = NULL;
         inst->Sensor = NULL;
         inst->Device = NULL;
         inst->Info = NULL;
+        inst->Stereo = NULL;
+        inst->Timing = NULL;
+        inst->Latency = NULL;
     }
     delete inst;
     inst = NULL;
@@ -304,13 +388,121 @@ OVR_Quaternion OVR_GetOrientation(OVR_Instance *inst)
 }
 
 OVR_Quaternion OVR_GetPredictedOrientation(OVR_Instance *inst)
+{
+    if (!inst || !inst->Fusion)
+        return unit_quat();
+
+    // Once frames are timed, predict to the absolute photon time of the current frame,
+    // which doesn't move as newer samples arrive. A photon time that has passed means the
+    // application stopped timing frames (or the frame is late), so it is no target anymore.
+    double photonTime = inst->Timing ? inst->Timing->GetPhotonTime() : 0.0;
+    return
+        photonTime > Timer::GetSeconds() ?
+        quat_to_quat(inst->Fusion->GetPredictedOrientationAt(photonTime)) :
+        quat_to_quat(inst->Fusion->GetPredictedOrientation());
+}
+
+OVR_Quaternion OVR_GetPredictedOrientationAt(OVR_Instance *inst, double time)
 {
     return
         inst && inst->Fusion ?
-        quat_to_quat(inst->Fusion->GetPredictedOrientation()) :
+        quat_to_quat(inst->Fusion->GetPredictedOrientationAt(time)) :
         unit_quat();
 }
 
+void OVR_GetPredictedOrientations(OVR_Instance *inst, double startTime, double endTime, int count, OVR_Quaternion *orientations)
+{
+    if (inst && inst->Fusion && orientations)
+    {
+        inst->Fusion->GetPredictedOrientations(startTime, endTime, count, quat_array(orientations));
+    }
+}
+
+void OVR_GetPredictedOrientationsAt(OVR_Instance *inst, const double *times, int count, OVR_Quaternion *orientations)
+{
+    if (inst && inst->Fusion && times && orientations)
+    {
+        inst->Fusion->GetPredictedOrientations(times, count, quat_array(orientations));
+    }
+}
+
+int OVR_GetTimewarpMatrices(OVR_Instance *inst, OVR_Quaternion renderOrientation,
+    OVR_Quaternion scanoutStart, OVR_Quaternion scanoutEnd, float *matrices)
+{
+    if (!inst || !inst->Stereo || !matrices)
+        return 0;
+
+    Matrix4f m[4];
+    int count = inst->Stereo->GetTimewarpMatrices(quat_from_quat(renderOrientation),
+        quat_from_quat(scanoutStart), quat_from_quat(scanoutEnd), m);
+    memcpy(matrices, m, count * sizeof(Matrix4f));
+    return count;
+}
+
+int OVR_GetDistortionMesh(OVR_Instance *inst, int eye, int gridX, int gridY,
+    float *vertices, unsigned short *indices)
+{
+    OVR_COMPILER_ASSERT(sizeof(Util::Render::DistortionMeshVertex) == 9 * sizeof(float));
+
+    Util::Render::DistortionMesh mesh;
+    if (!inst || !inst->Stereo || !vertices || !indices ||
+        !mesh.Generate(eye_params(inst, eye), inst->Stereo->GetFullViewport(), gridX, gridY))
+    {
+        return 0;
+    }
+
+    memcpy(vertices, mesh.GetVertices(), mesh.GetVertexCount() * sizeof(Util::Render::DistortionMeshVertex));
+    memcpy(indices, mesh.GetIndices(), mesh.GetIndexCount() * sizeof(UInt16));
+    return mesh.GetVertexCount();
+}
+
+int OVR_GetDistortionWarpMap(OVR_Instance *inst, int eye, int width, int height,
+    unsigned short *data, float *lensCenter)
+{
+    if (!inst || !inst->Stereo || !data)
+        return 0;
+
+    const Util::Render::StereoEyeParams& params = eye_params(inst, eye);
+    if (params.VP.w != width || params.VP.h != height)
+        return 0;
+
+    Util::Render::DistortionWarpMap map;
+    if (!map.Generate(params, inst->Stereo->GetFullViewport()))
+        return 0;
+
+    memcpy(data, map.GetData(), width * height * 4 * sizeof(UInt16));
+    if (lensCenter)
+    {
+        lensCenter[0] = map.GetLensCenter().x;
+        lensCenter[1] = map.GetLensCenter().y;
+    }
+    return 1;
+}
+
+double OVR_GetSampleTime(OVR_Instance *inst)
+{
+    return
+        inst && inst->Fusion ?
+        inst->Fusion->GetSampleTime() :
+        0.0;
+}
+
+int OVR_GetOrientationAt(OVR_Instance *inst, double time, OVR_Quaternion *orientation)
+{
+    Quatf q;
+    if (!inst || !inst->Fusion || !inst->Fusion->GetOrientationAt(time, &q))
+        return 0;
+
+    if (orientation)
+        *orientation = quat_to_quat(q);
+    return 1;
+}
+
+double OVR_GetTime()
+{
+    return Timer::GetSeconds();
+}
+
 OVR_Vector3 OVR_GetAcceleration(OVR_Instance *inst)
 {
     return
@@ -358,3 +550,282 @@ int OVR_IsPredictionEnabled(OVR_Instance *inst)
         inst->Fusion->IsPredictionEnabled() :
         0;
 }
+
+int OVR_GetPredictionError(OVR_Instance *inst, int speedBin, float *meanError, float *maxError)
+{
+    if (!inst || !inst->Fusion || speedBin < 0 || speedBin >= PredictionErrorStats::SpeedBins)
+        return 0;
+
+    PredictionErrorStats stats = inst->Fusion->GetPredictionErrorStats();
+    if (meanError)
+        *meanError = stats.MeanError[speedBin];
+    if (maxError)
+        *maxError = stats.MaxError[speedBin];
+    return (int)stats.Count[speedBin];
+}
+
+int OVR_GetPredictionErrorHistogram(OVR_Instance *inst, int speedBin, int *counts)
+{
+    if (!inst || !inst->Fusion || !counts || speedBin < 0 || speedBin >= PredictionErrorStats::SpeedBins)
+        return 0;
+
+    PredictionErrorStats stats = inst->Fusion->GetPredictionErrorStats();
+    for (int i = 0; i < PredictionErrorStats::ErrorBins; i++)
+        counts[i] = (int)stats.Histogram[speedBin][i];
+    return (int)stats.Count[speedBin];
+}
+
+int OVR_GetDroppedPredictions(OVR_Instance *inst)
+{
+    return
+        inst && inst->Fusion ?
+        (int)inst->Fusion->GetPredictionErrorStats().Dropped :
+        0;
+}
+
+void OVR_ResetPredictionError(OVR_Instance *inst)
+{
+    if (inst && inst->Fusion)
+    {
+        inst->Fusion->ResetPredictionErrorStats();
+    }
+}
+
+void OVR_SetAdaptivePredictionEnabled(OVR_Instance *inst, int enable)
+{
+    if (inst && inst->Fusion)
+    {
+        inst->Fusion->SetAdaptivePredictionEnabled(enable != 0);
+    }
+}
+
+void OVR_SetOutputFilter(OVR_Instance *inst, float minCutoff, float beta, int enable)
+{
+    if (inst && inst->Fusion)
+    {
+        inst->Fusion->SetOutputFilter(minCutoff, beta, enable != 0);
+    }
+}
+
+float OVR_GetAlignmentTime(OVR_Instance *inst)
+{
+    if (!inst || !inst->Fusion)
+        return -1.0f;
+
+    return
+        inst->Fusion->IsAlignmentTimedOut() ?
+        -2.0f :
+        inst->Fusion->GetAlignmentTime();
+}
+
+// Sensor Fusion warm-start state
+int OVR_SaveFusionState(OVR_Instance *inst)
+{
+    return
+        inst && inst->Fusion ?
+        inst->Fusion->SaveStateFile() :
+        0;
+}
+
+int OVR_LoadFusionState(OVR_Instance *inst)
+{
+    return
+        inst && inst->Fusion ?
+        inst->Fusion->LoadStateFile() :
+        0;
+}
+
+int OVR_GetFusionState(OVR_Instance *inst, unsigned char *buffer, int size)
+{
+    return
+        inst && inst->Fusion ?
+        inst->Fusion->SaveState(buffer, size) :
+        0;
+}
+
+int OVR_SetFusionState(OVR_Instance *inst, const unsigned char *buffer, int size)
+{
+    return
+        inst && inst->Fusion ?
+        inst->Fusion->RestoreState(buffer, size) :
+        0;
+}
+
+double OVR_BeginFrame(OVR_Instance *inst, double time)
+{
+    return
+        inst && inst->Timing ?
+        inst->Timing->BeginFrame(time_or_now(time)) :
+        0.0;
+}
+
+void OVR_EndFrame(OVR_Instance *inst, double time)
+{
+    if (inst && inst->Timing)
+    {
+        inst->Timing->EndFrame(time_or_now(time));
+    }
+}
+
+void OVR_PresentFrame(OVR_Instance *inst, double time)
+{
+    if (inst && inst->Timing)
+    {
+        inst->Timing->Present(time_or_now(time));
+    }
+}
+
+double OVR_GetPhotonTime(OVR_Instance *inst)
+{
+    return
+        inst && inst->Timing ?
+        inst->Timing->GetPhotonTime() :
+        0.0;
+}
+
+float OVR_GetRefreshPeriod(OVR_Instance *inst)
+{
+    return
+        inst && inst->Timing ?
+        inst->Timing->GetRefreshPeriod() :
+        0.0f;
+}
+
+float OVR_GetPipelineDepth(OVR_Instance *inst)
+{
+    return
+        inst && inst->Timing ?
+        inst->Timing->GetPipelineDepth() :
+        0.0f;
+}
+
+void OVR_SetRenderViewport(OVR_Instance *inst, int x, int y, int width, int height)
+{
+    if (inst && inst->Stereo && width > 0 && height > 0)
+    {
+        inst->Stereo->SetFullViewport(Util::Render::Viewport(x, y, width, height));
+    }
+}
+
+int OVR_GetStereoRenderParams(OVR_Instance *inst, OVR_Quaternion headOrientation,
+    OVR_StereoRenderParams *params)
+{
+    if (!inst || !inst->Stereo || !params)
+        return 0;
+
+    Util::Render::StereoConfig& stereo = *inst->Stereo;
+    if (inst->StereoVersion != stereo.GetComputedVersion())
+    {
+        OVR_StereoRenderParams& cached = inst->StereoParams;
+        eye_to_params(stereo.GetEyeRenderParams(Util::Render::StereoEye_Left), &cached.Eyes[0]);
+        eye_to_params(stereo.GetEyeRenderParams(Util::Render::StereoEye_Right), &cached.Eyes[1]);
+        cached.YFov                   = stereo.GetYFOVRadians();
+        cached.Aspect                 = stereo.GetAspect();
+        cached.ProjectionCenterOffset = stereo.GetProjectionCenterOffset();
+        cached.DistortionScale        = stereo.GetDistortionScale();
+        cached.DistortionCenterOffset = stereo.GetDistortionConfig().XCenterOffset;
+        inst->StereoVersion           = stereo.GetComputedVersion();
+    }
+
+    *params = inst->StereoParams;
+    Matrix4f view = quat_from_quat(headOrientation).Inverted();
+    for (int i = 0; i < 2; i++)
+    {
+        const Util::Render::StereoEyeParams& eye =
+            stereo.GetEyeRenderParams(i == 0 ? Util::Render::StereoEye_Left : Util::Render::StereoEye_Right);
+        matrix_to_floats(eye.ViewAdjust * view, params->Eyes[i].View);
+    }
+    return 1;
+}
+
+int OVR_IsLatencyTesterConnected(OVR_Instance *inst)
+{
+    return inst && inst->Latency && inst->Latency->HasDevice();
+}
+
+void OVR_BeginLatencyTest(OVR_Instance *inst, int continuous)
+{
+    if (inst && inst->Latency)
+    {
+        inst->Latency->SetContinuous(continuous != 0);
+        inst->Latency->BeginTest();
+    }
+}
+
+void OVR_EndLatencyTest(OVR_Instance *inst)
+{
+    if (inst && inst->Latency)
+    {
+        inst->Latency->EndTest();
+    }
+}
+
+void OVR_ProcessLatencyInputs(OVR_Instance *inst)
+{
+    if (inst && inst->Latency)
+    {
+        inst->Latency->ProcessInputs();
+    }
+}
+
+int OVR_GetLatencyTestColor(OVR_Instance *inst, unsigned char *rgb)
+{
+    Color color;
+    if (!inst || !inst->Latency || !rgb || !inst->Latency->DisplayScreenColor(color))
+        return 0;
+
+    rgb[0] = color.R;
+    rgb[1] = color.G;
+    rgb[2] = color.B;
+    return 1;
+}
+
+int OVR_GetLatencyStats(OVR_Instance *inst, int measure, OVR_LatencyStats *stats)
+{
+    if (!inst || !inst->Latency || !stats || measure < 0 || measure >= Util::Latency_MeasureCount)
+        return 0;
+
+    LatencyStats ls;
+    inst->Latency->GetStats((Util::LatencyMeasure)measure, &ls);
+    stats_to_stats(ls, stats);
+    return stats->Count;
+}
+
+int OVR_GetLatencyTimeouts(OVR_Instance *inst)
+{
+    return
+        inst && inst->Latency ?
+        (int)inst->Latency->GetTimeoutCount() :
+        0;
+}
+
+void OVR_ResetLatencyStats(OVR_Instance *inst)
+{
+    if (inst && inst->Latency)
+    {
+        inst->Latency->ResetStats();
+    }
+}
+
+int OVR_GetInputLatencyStats(int stage, OVR_LatencyStats *stats)
+{
+    if (!stats || stage < 0 || stage >= LatencyTrace_StageCount)
+        return 0;
+
+    LatencyStats ls;
+    if (stage == LatencyTrace_ReportRead)
+    {
+        LatencyTrace::GetTotalStats(&ls);
+    }
+    else
+    {
+        LatencyTrace::GetStats((LatencyTraceStage)stage, &ls);
+    }
+    stats_to_stats(ls, stats);
+    return stats->Count;
+}
+
+void OVR_ResetInputLatencyStats()
+{
+    LatencyTrace::Reset();
+}
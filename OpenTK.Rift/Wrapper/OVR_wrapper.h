@@ -54,6 +54,33 @@ extern "C"
         float x, y, z, w;
     } OVR_Vector4;
 
+    // Matrices are row-major for column vectors
+    typedef struct
+    {
+        int   Viewport[4];              // x, y, width, height in pixels
+        float Projection[16];
+        float OrthoProjection[16];
+        float ViewAdjust[16];           // Translation of the eye from the head center
+        float View[16];                 // ViewAdjust * inverse head orientation
+    } OVR_EyeRenderParams;
+
+    typedef struct
+    {
+        OVR_EyeRenderParams Eyes[2];    // Left, right
+        float YFov;                     // Vertical field of view, radians
+        float Aspect;                   // Per eye
+        float ProjectionCenterOffset;   // Positive for the left eye, negative for the right
+        float DistortionScale;
+        float DistortionCenterOffset;   // Lens center offset in the [-1, 1] left eye viewport
+    } OVR_StereoRenderParams;
+
+    // Latencies in milliseconds
+    typedef struct
+    {
+        int   Count;
+        float Min, Mean, P50, P90, P99, Max;
+    } OVR_LatencyStats;
+
     EXPORT void CALLCONV OVR_Init();
     EXPORT void CALLCONV OVR_Shutdown();
     EXPORT OVR_Instance* CALLCONV OVR_Create();
@@ -75,12 +102,91 @@ extern "C"
     // Sensor Fusion
     EXPORT OVR_Quaternion CALLCONV OVR_GetOrientation(OVR_Instance *inst);
     EXPORT OVR_Quaternion CALLCONV OVR_GetPredictedOrientation(OVR_Instance *inst);
+    EXPORT OVR_Quaternion CALLCONV OVR_GetPredictedOrientationAt(OVR_Instance *inst, double time);
+    // Orientations for count times evenly spaced over [startTime, endTime], e.g. across an eye's scanout
+    EXPORT void CALLCONV OVR_GetPredictedOrientations(OVR_Instance *inst, double startTime, double endTime, int count, OVR_Quaternion *orientations);
+    EXPORT void CALLCONV OVR_GetPredictedOrientationsAt(OVR_Instance *inst, const double *times, int count, OVR_Quaternion *orientations);
+    // Timewarp: left start, left end, right start, right end as row-major 4x4 matrices
+    // (64 floats) for column vectors; maps clip (x, y, 1, 1) of a displayed pixel to the
+    // rendered image. Returns the number of matrices written.
+    EXPORT int CALLCONV OVR_GetTimewarpMatrices(OVR_Instance *inst, OVR_Quaternion renderOrientation,
+        OVR_Quaternion scanoutStart, OVR_Quaternion scanoutEnd, float *matrices);
+    // Distortion mesh for eye 0 (left) or 1 (right): (gridX + 1) * (gridY + 1) vertices of
+    // 9 floats (position, red, green and blue texture coordinates, fade) and
+    // gridX * gridY * 6 indices. Returns the number of vertices written.
+    EXPORT int CALLCONV OVR_GetDistortionMesh(OVR_Instance *inst, int eye, int gridX, int gridY,
+        float *vertices, unsigned short *indices);
+    // Per-pixel distortion of an eye as width * height * 4 half floats (green offset from
+    // lensCenter, red and blue scale); the size must match the eye viewport.
+    EXPORT int CALLCONV OVR_GetDistortionWarpMap(OVR_Instance *inst, int eye, int width, int height,
+        unsigned short *data, float *lensCenter);
+    EXPORT double CALLCONV OVR_GetSampleTime(OVR_Instance *inst);
+    // Orientation at a past time (OVR_GetTime clock); returns 0 outside the retained history
+    EXPORT int CALLCONV OVR_GetOrientationAt(OVR_Instance *inst, double time, OVR_Quaternion *orientation);
+    EXPORT double CALLCONV OVR_GetTime();
     EXPORT OVR_Vector3 CALLCONV OVR_GetAcceleration(OVR_Instance *inst);
     EXPORT OVR_Vector3 CALLCONV OVR_GetAngularVelocity(OVR_Instance *inst);
     EXPORT float CALLCONV OVR_GetPredictionDelta(OVR_Instance *inst);
     EXPORT void CALLCONV OVR_SetPrediction(OVR_Instance *inst, float dt, int enable);
     EXPORT void CALLCONV OVR_SetPredictionEnabled(OVR_Instance *inst, int enable);
     EXPORT int CALLCONV OVR_IsPredictionEnabled(OVR_Instance *inst);
+    // Prediction error, per head speed bin (0.25, 0.5, 1, 2 and 4 rad/s edges)
+    EXPORT int CALLCONV OVR_GetPredictionError(OVR_Instance *inst, int speedBin, float *meanError, float *maxError);
+    // Error histogram of a speed bin: fills 8 counts, for errors up to 0.05, 0.1, 0.2, 0.5, 1, 2
+    // and 5 degrees and above 5 degrees. Returns the number of predictions in the speed bin.
+    EXPORT int CALLCONV OVR_GetPredictionErrorHistogram(OVR_Instance *inst, int speedBin, int *counts);
+    // Predictions that were not evaluated because too many were waiting for their target time
+    EXPORT int CALLCONV OVR_GetDroppedPredictions(OVR_Instance *inst);
+    EXPORT void CALLCONV OVR_ResetPredictionError(OVR_Instance *inst);
+    EXPORT void CALLCONV OVR_SetAdaptivePredictionEnabled(OVR_Instance *inst, int enable);
+    // One-Euro output smoothing: cutoff in Hz at rest, plus beta Hz per rad/s
+    EXPORT void CALLCONV OVR_SetOutputFilter(OVR_Instance *inst, float minCutoff, float beta, int enable);
+    // Seconds until the startup orientation was aligned at rest; -1 while aligning, and -2
+    // if the sensor never settled and alignment timed out
+    EXPORT float CALLCONV OVR_GetAlignmentTime(OVR_Instance *inst);
+
+    // Sensor Fusion warm-start state. The state saved by OVR_SaveFusionState is loaded
+    // when the sensor is attached; nothing is saved unless the application asks for it
+    EXPORT int CALLCONV OVR_SaveFusionState(OVR_Instance *inst);
+    EXPORT int CALLCONV OVR_LoadFusionState(OVR_Instance *inst);
+    EXPORT int CALLCONV OVR_GetFusionState(OVR_Instance *inst, unsigned char *buffer, int size);
+    EXPORT int CALLCONV OVR_SetFusionState(OVR_Instance *inst, const unsigned char *buffer, int size);
+
+    // Frame timing; times are on the OVR_GetTime clock, 0 means now. OVR_BeginFrame
+    // returns the predicted photon time; until that time has passed,
+    // OVR_GetPredictedOrientation predicts to it instead of the prediction delta.
+    EXPORT double CALLCONV OVR_BeginFrame(OVR_Instance *inst, double time);
+    EXPORT void CALLCONV OVR_EndFrame(OVR_Instance *inst, double time);
+    EXPORT void CALLCONV OVR_PresentFrame(OVR_Instance *inst, double time);
+    EXPORT double CALLCONV OVR_GetPhotonTime(OVR_Instance *inst);
+    EXPORT float CALLCONV OVR_GetRefreshPeriod(OVR_Instance *inst);
+    EXPORT float CALLCONV OVR_GetPipelineDepth(OVR_Instance *inst);
+
+    // Stereo rendering; the render viewport defaults to the HMD resolution
+    EXPORT void CALLCONV OVR_SetRenderViewport(OVR_Instance *inst, int x, int y, int width, int height);
+    EXPORT int CALLCONV OVR_GetStereoRenderParams(OVR_Instance *inst, OVR_Quaternion headOrientation,
+        OVR_StereoRenderParams *params);
+
+    // Latency tester. Call OVR_ProcessLatencyInputs where the orientation is read, and draw
+    // a quad of the OVR_GetLatencyTestColor color under the tester when it returns 1.
+    EXPORT int CALLCONV OVR_IsLatencyTesterConnected(OVR_Instance *inst);
+    // Continuous tests repeat until OVR_EndLatencyTest
+    EXPORT void CALLCONV OVR_BeginLatencyTest(OVR_Instance *inst, int continuous);
+    EXPORT void CALLCONV OVR_EndLatencyTest(OVR_Instance *inst);
+    EXPORT void CALLCONV OVR_ProcessLatencyInputs(OVR_Instance *inst);
+    EXPORT int CALLCONV OVR_GetLatencyTestColor(OVR_Instance *inst, unsigned char *rgb);
+    // Measure 0 is total motion-to-photon latency, 1 black to white, 2 white to black and
+    // 3 USB round trip; returns the number of samples
+    EXPORT int CALLCONV OVR_GetLatencyStats(OVR_Instance *inst, int measure, OVR_LatencyStats *stats);
+    EXPORT int CALLCONV OVR_GetLatencyTimeouts(OVR_Instance *inst);
+    EXPORT void CALLCONV OVR_ResetLatencyStats(OVR_Instance *inst);
+
+    // Input pipeline latency, when built with OVR_ENABLE_LATENCY_TRACE. Stage 0 is from the
+    // USB report being read to the orientation being read; stages 1 to 4 are the time to
+    // decode the report, dispatch a sample, run sensor fusion and for the application to read
+    // the result. Returns the number of samples.
+    EXPORT int CALLCONV OVR_GetInputLatencyStats(int stage, OVR_LatencyStats *stats);
+    EXPORT void CALLCONV OVR_ResetInputLatencyStats();
 }
 
 #endif
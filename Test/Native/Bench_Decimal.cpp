@@ -0,0 +1,215 @@
+/************************************************************************************
+
+Filename    :   Bench_Decimal.cpp
+Content     :   Cost of the decimal conversions of OVR_Std against the C library
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR.h"
+#include "OVR_JSON.h"
+#include "Kernel/OVR_Timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace OVR;
+
+// Calibration-like matrices: 16 values each, with up to 9 significant digits.
+static const int MatrixCount = 1000;
+static const int Repeats     = 20;
+static const int DeviceCount = 2000;
+
+static Matrix4f Matrices[MatrixCount];
+static char     Texts[MatrixCount][256];
+
+static UInt64 RandomState = 88172645463325252ull;
+
+static UInt64 random64()
+{
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 7;
+    RandomState ^= RandomState << 17;
+    return RandomState;
+}
+
+static const char* skipNumber(const char* src)
+{
+    while (*src && *src != ' ')
+        src++;
+    while (*src == ' ')
+        src++;
+    return src;
+}
+
+static void benchmarkNumbers()
+{
+    volatile double sink = 0;
+    double t0 = Timer::GetProfileSeconds();
+    for (int k = 0; k < Repeats; k++)
+    {
+        for (int i = 0; i < MatrixCount; i++)
+        {
+            const char* src = Texts[i];
+            for (int n = 0; n < 16; n++)
+            {
+                char* end;
+                sink += strtod(src, &end);
+                src = end;
+            }
+        }
+    }
+    double t1 = Timer::GetProfileSeconds();
+    for (int k = 0; k < Repeats; k++)
+    {
+        for (int i = 0; i < MatrixCount; i++)
+        {
+            const char* src = Texts[i];
+            for (int n = 0; n < 16; n++)
+            {
+                char* end;
+                sink += OVR_strtod(src, &end);
+                src = end;
+            }
+        }
+    }
+    double t2 = Timer::GetProfileSeconds();
+
+    char text[32];
+    for (int k = 0; k < Repeats; k++)
+        for (int i = 0; i < MatrixCount; i++)
+            for (int n = 0; n < 16; n++)
+                sink += OVR_sprintf(text, sizeof(text), "%.9g", Matrices[i].M[n / 4][n % 4]);
+    double t3 = Timer::GetProfileSeconds();
+    for (int k = 0; k < Repeats; k++)
+        for (int i = 0; i < MatrixCount; i++)
+            for (int n = 0; n < 16; n++)
+                sink += OVR_ftoa(Matrices[i].M[n / 4][n % 4], text, sizeof(text));
+    double t4 = Timer::GetProfileSeconds();
+
+    double scale = 1e9 / (Repeats * MatrixCount * 16.0);
+    printf("Per number\n");
+    printf("  parse:  strtod %.1f ns, OVR_strtod %.1f ns\n", (t1 - t0) * scale, (t2 - t1) * scale);
+    printf("  print:  %%.9g %.1f ns, OVR_ftoa %.1f ns\n", (t3 - t2) * scale, (t4 - t3) * scale);
+}
+
+static void benchmarkMatrices()
+{
+    volatile float sink = 0;
+    char text[256];
+    double t0 = Timer::GetProfileSeconds();
+    for (int k = 0; k < Repeats; k++)
+    {
+        for (int i = 0; i < MatrixCount; i++)
+        {
+            UPInt pos = 0;
+            for (int n = 0; n < 16; n++)
+                pos += OVR_sprintf(text + pos, sizeof(text) - pos, "%g ", Matrices[i].M[n / 4][n % 4]);
+        }
+    }
+    double t1 = Timer::GetProfileSeconds();
+    for (int k = 0; k < Repeats; k++)
+        for (int i = 0; i < MatrixCount; i++)
+            Matrices[i].ToString(text, sizeof(text));
+    double t2 = Timer::GetProfileSeconds();
+    for (int k = 0; k < Repeats; k++)
+    {
+        for (int i = 0; i < MatrixCount; i++)
+        {
+            const char* src = Texts[i];
+            for (int n = 0; n < 16; n++, src = skipNumber(src))
+                sink += (float)atof(src);
+        }
+    }
+    double t3 = Timer::GetProfileSeconds();
+    for (int k = 0; k < Repeats; k++)
+        for (int i = 0; i < MatrixCount; i++)
+            sink += Matrix4f::FromString(Texts[i]).M[1][1];
+    double t4 = Timer::GetProfileSeconds();
+
+    double scale = 1e6 / (Repeats * MatrixCount);
+    printf("Per matrix\n");
+    printf("  ToString:    %%g %.2f us, OVR_ftoa %.2f us\n", (t1 - t0) * scale, (t2 - t1) * scale);
+    printf("  FromString:  atof %.2f us, OVR_strtof %.2f us\n", (t3 - t2) * scale, (t4 - t3) * scale);
+}
+
+// A Devices.json-style file with a calibration matrix and a few other numbers per device,
+// parsed and decoded as the device store does.
+static void benchmarkDocument()
+{
+    String doc = "{\"Oculus Device Profile Version\": \"1.0\",\n";
+    char   entry[1024];
+    for (int i = 0; i < DeviceCount; i++)
+    {
+        const Matrix4f& m = Matrices[i % MatrixCount];
+        OVR_sprintf(entry, sizeof(entry),
+                    "\"Device\": {\"Serial\": \"SN%06d\", \"MagCalibration\": {\"Version\": \"2\", "
+                    "\"CalibrationMatrix\": \"%s\", \"Center\": [%.9g, %.9g, %.9g], "
+                    "\"Offsets\": [%.17g, %.17g, %.17g, %.17g]}}%s\n",
+                    i, Texts[i % MatrixCount], m.M[0][0], m.M[1][0], m.M[2][0],
+                    random64() / 1e19, random64() / 1e12, random64() / 1e25, random64() / 3.0,
+                    (i + 1 < DeviceCount) ? "," : "");
+        doc += entry;
+    }
+    doc += "}";
+
+    volatile float sink = 0;
+    double best = 1e9;
+    for (int k = 0; k < 10; k++)
+    {
+        double start = Timer::GetProfileSeconds();
+        JSONDocument* d = JSONDocument::Parse(doc);
+        const JSONValue* root = d->GetRoot();
+        for (const JSONValue* device = root->GetFirstItem(); device; device = root->GetNextItem(device))
+        {
+            const JSONValue* cal = device->GetItemByName("MagCalibration");
+            if (cal)
+                sink += Matrix4f::FromString(cal->GetItemByName("CalibrationMatrix")->Value).M[0][0];
+        }
+        d->Release();
+        best = Alg::Min(best, Timer::GetProfileSeconds() - start);
+    }
+
+    printf("Devices.json with %d calibrations (%u KB): parsed and decoded in %.2f ms\n",
+           DeviceCount, (unsigned)(doc.GetSize() / 1024), best * 1e3);
+}
+
+static void runBenchmark()
+{
+    for (int i = 0; i < MatrixCount; i++)
+    {
+        for (int n = 0; n < 16; n++)
+            Matrices[i].M[n / 4][n % 4] = (float)((SInt32)random64() % 200000) / 7919.0f;
+        Matrices[i].ToString(Texts[i], sizeof(Texts[i]));
+    }
+
+    benchmarkNumbers();
+    benchmarkMatrices();
+    benchmarkDocument();
+}
+
+int main()
+{
+    System::Init();
+    runBenchmark();
+    System::Destroy();
+    return 0;
+}
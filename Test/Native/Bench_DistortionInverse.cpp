@@ -0,0 +1,145 @@
+/************************************************************************************
+
+Filename    :   Bench_DistortionInverse.cpp
+Content     :   Cost and accuracy of DistortionConfig::DistortionFnInverse
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR.h"
+#include "Util/Util_Render_Stereo.h"
+#include "Kernel/OVR_Timer.h"
+
+#include <stdio.h>
+#include <math.h>
+
+using namespace OVR;
+using namespace OVR::Util::Render;
+
+// DK1 coefficients, over the radii a DK1 frame samples (|r| <= 2.5)
+static const float K[4]      = { 1.0f, 0.22f, 0.24f, 0.0f };
+static const int   RadiusCount = 100000;
+static const int   Repeats     = 10;
+
+static double distortion(double r)
+{
+    double q = r * r;
+    return r * (K[0] + q * (K[1] + q * (K[2] + q * K[3])));
+}
+
+// The 20 step bracketing search DistortionFnInverse used before the table.
+static float searchInverse(float r)
+{
+    float s     = r * 0.5f;
+    float delta = r * 0.25f;
+    float d     = fabsf(r - (float)distortion(s));
+
+    for (int i = 0; i < 20; i++)
+    {
+        float up    = s + delta;
+        float down  = s - delta;
+        float dUp   = fabsf(r - (float)distortion(up));
+        float dDown = fabsf(r - (float)distortion(down));
+
+        if (dUp < d)
+        {
+            s = up;
+            d = dUp;
+        }
+        else if (dDown < d)
+        {
+            s = down;
+            d = dDown;
+        }
+        else
+        {
+            delta *= 0.5f;
+        }
+    }
+    return s;
+}
+
+// Newton's method in double precision, run to convergence.
+static double exactInverse(double r)
+{
+    double s = r;
+    for (int i = 0; i < 60; i++)
+    {
+        double q     = s * s;
+        double slope = K[0] + q * (3 * K[1] + q * (5 * K[2] + q * 7 * K[3]));
+        s -= (distortion(s) - r) / slope;
+    }
+    return s;
+}
+
+static void runBenchmark()
+{
+    DistortionConfig dc(K[0], K[1], K[2], K[3]);
+
+    float* radii = (float*)OVR_ALLOC(RadiusCount * sizeof(float));
+    float* batch = (float*)OVR_ALLOC(RadiusCount * sizeof(float));
+    for (int i = 0; i < RadiusCount; i++)
+        radii[i] = ((i % 2) ? -2.5f : 2.5f) * i / RadiusCount;
+
+    dc.DistortionFnInverse(radii, batch, RadiusCount);
+    double searchError = 0, tableError = 0, batchError = 0;
+    for (int i = 0; i < RadiusCount; i++)
+    {
+        double exact = exactInverse(radii[i]);
+        searchError = Alg::Max(searchError, fabs(searchInverse(radii[i]) - exact));
+        tableError  = Alg::Max(tableError, fabs(dc.DistortionFnInverse(radii[i]) - exact));
+        batchError  = Alg::Max(batchError, fabs(batch[i] - exact));
+    }
+
+    volatile float sink = 0;
+    double t0 = Timer::GetProfileSeconds();
+    for (int k = 0; k < Repeats; k++)
+        for (int i = 0; i < RadiusCount; i++)
+            sink += searchInverse(radii[i]);
+    double t1 = Timer::GetProfileSeconds();
+    for (int k = 0; k < Repeats; k++)
+        for (int i = 0; i < RadiusCount; i++)
+            sink += dc.DistortionFnInverse(radii[i]);
+    double t2 = Timer::GetProfileSeconds();
+    for (int k = 0; k < Repeats; k++)
+    {
+        dc.DistortionFnInverse(radii, batch, RadiusCount);
+        sink += batch[k];
+    }
+    double t3 = Timer::GetProfileSeconds();
+
+    double scale = 1e9 / ((double)RadiusCount * Repeats);
+    printf("Table error reported by DistortionConfig: %g\n", dc.GetDistortionFnInverseError());
+    printf("  search  max error %.2g   %6.1f ns/call\n", searchError, (t1 - t0) * scale);
+    printf("  table   max error %.2g   %6.1f ns/call\n", tableError, (t2 - t1) * scale);
+    printf("  batch   max error %.2g   %6.1f ns/call\n", batchError, (t3 - t2) * scale);
+
+    OVR_FREE(radii);
+    OVR_FREE(batch);
+}
+
+int main()
+{
+    System::Init();
+    runBenchmark();
+    System::Destroy();
+    return 0;
+}
@@ -0,0 +1,203 @@
+/************************************************************************************
+
+Filename    :   Bench_DistortionMesh.cpp
+Content     :   Cost and accuracy of the CPU distortion meshes and warp maps
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR.h"
+#include "Util/Util_Render_Distortion.h"
+#include "Kernel/OVR_Timer.h"
+
+#include <stdio.h>
+#include <math.h>
+
+using namespace OVR;
+using namespace OVR::Util::Render;
+
+// DK1 at 1280x800. Errors are in pixels of the full render target, measured against
+// the distortion shader's math evaluated in double precision.
+static const int ScreenWidth  = 1280;
+static const int ScreenHeight = 800;
+static const int Repeats      = 5;
+
+struct ShaderReference
+{
+    double LensCenterX, LensCenterY;
+    double ScaleX, ScaleY;
+    double ScaleInX, ScaleInY;
+    double K[4];
+
+    ShaderReference(const StereoEyeParams& eye, const Viewport& full);
+
+    // Green texture coordinate for a texture coordinate of the eye viewport.
+    void Evaluate(double u, double v, double* x, double* y) const;
+};
+
+ShaderReference::ShaderReference(const StereoEyeParams& eye, const Viewport& full)
+{
+    const DistortionConfig& dc = *eye.pDistortion;
+    double x = double(eye.VP.x - full.x) / full.w;
+    double y = double(eye.VP.y - full.y) / full.h;
+    double w = double(eye.VP.w) / full.w;
+    double h = double(eye.VP.h) / full.h;
+    double aspect  = double(eye.VP.w) / eye.VP.h;
+    double xOffset = (eye.Eye == StereoEye_Right) ? -dc.XCenterOffset : dc.XCenterOffset;
+
+    LensCenterX = x + (w + xOffset * 0.5) * 0.5;
+    LensCenterY = y + h * 0.5;
+    ScaleX      = w / 2 / dc.Scale;
+    ScaleY      = h / 2 / dc.Scale * aspect;
+    ScaleInX    = 2 / w;
+    ScaleInY    = 2 / h / aspect;
+    for (int i = 0; i < 4; i++)
+        K[i] = dc.K[i];
+}
+
+void ShaderReference::Evaluate(double u, double v, double* x, double* y) const
+{
+    double thetaX = (u - LensCenterX) * ScaleInX;
+    double thetaY = (v - LensCenterY) * ScaleInY;
+    double r      = thetaX * thetaX + thetaY * thetaY;
+    double k      = K[0] + r * (K[1] + r * (K[2] + r * K[3]));
+    *x = LensCenterX + ScaleX * thetaX * k;
+    *y = LensCenterY + ScaleY * thetaY * k;
+}
+
+static double pixelError(double x0, double y0, double x1, double y1)
+{
+    return Alg::Max(fabs(x0 - x1) * ScreenWidth, fabs(y0 - y1) * ScreenHeight);
+}
+
+static void benchmarkWarpMap(const StereoEyeParams& eye, const Viewport& full,
+                             const ShaderReference& ref)
+{
+    DistortionWarpMap map;
+    double start = Timer::GetProfileSeconds();
+    for (int i = 0; i < Repeats; i++)
+        map.Generate(eye, full);
+    double ms = (Timer::GetProfileSeconds() - start) / Repeats * 1e3;
+
+    // The map stores the offset from the lens center; absolute coordinates in half
+    // precision are scored alongside for comparison. Only texels the shader samples
+    // inside the render target are scored.
+    Vector2f center = map.GetLensCenter();
+    double   offsetError = 0, absoluteError = 0;
+    for (int j = 0; j < map.GetHeight(); j++)
+    {
+        for (int i = 0; i < map.GetWidth(); i++)
+        {
+            double x, y;
+            ref.Evaluate((eye.VP.x + i + 0.5) / ScreenWidth, (eye.VP.y + j + 0.5) / ScreenHeight, &x, &y);
+            if (x < 0 || x > 1 || y < 0 || y > 1)
+                continue;
+
+            const UInt16* texel = map.GetData() + (j * map.GetWidth() + i) * 4;
+            double gx = center.x + HalfToFloat(texel[0]);
+            double gy = center.y + HalfToFloat(texel[1]);
+            offsetError   = Alg::Max(offsetError, pixelError(gx, gy, x, y));
+            absoluteError = Alg::Max(absoluteError,
+                                     pixelError(HalfToFloat(FloatToHalf((float)x)),
+                                                HalfToFloat(FloatToHalf((float)y)), x, y));
+        }
+    }
+
+    printf("  warp map %dx%d   %.2f ms   max error %.2f px (absolute half floats %.2f px)\n",
+           map.GetWidth(), map.GetHeight(), ms, offsetError, absoluteError);
+}
+
+static void benchmarkMesh(const StereoEyeParams& eye, const Viewport& full,
+                          const ShaderReference& ref, int grid)
+{
+    DistortionMesh mesh;
+    double start = Timer::GetProfileSeconds();
+    for (int i = 0; i < Repeats; i++)
+        mesh.Generate(eye, full, grid, grid);
+    double ms = (Timer::GetProfileSeconds() - start) / Repeats * 1e3;
+
+    // Interpolates the green coordinate over the two triangles of each quad, as the
+    // rasterizer does, at every third pixel of quads that aren't faded out.
+    const DistortionMeshVertex* v = mesh.GetVertices();
+    double maxError = 0;
+    for (int j = 0; j < eye.VP.h; j += 3)
+    {
+        for (int i = 0; i < eye.VP.w; i += 3)
+        {
+            double fx = (i + 0.5) / eye.VP.w * grid;
+            double fy = (j + 0.5) / eye.VP.h * grid;
+            int    qx = (int)fx, qy = (int)fy;
+            double a  = fx - qx, b = fy - qy;
+
+            const DistortionMeshVertex& v00 = v[qy * (grid + 1) + qx];
+            const DistortionMeshVertex& v10 = v[qy * (grid + 1) + qx + 1];
+            const DistortionMeshVertex& v01 = v[(qy + 1) * (grid + 1) + qx];
+            const DistortionMeshVertex& v11 = v[(qy + 1) * (grid + 1) + qx + 1];
+            if (v00.Fade * v10.Fade * v01.Fade * v11.Fade <= 0)
+                continue;
+
+            double gx, gy;
+            if (a + b <= 1)
+            {
+                gx = v00.TexG.x + (v10.TexG.x - v00.TexG.x) * a + (v01.TexG.x - v00.TexG.x) * b;
+                gy = v00.TexG.y + (v10.TexG.y - v00.TexG.y) * a + (v01.TexG.y - v00.TexG.y) * b;
+            }
+            else
+            {
+                gx = v11.TexG.x + (v01.TexG.x - v11.TexG.x) * (1 - a) + (v10.TexG.x - v11.TexG.x) * (1 - b);
+                gy = v11.TexG.y + (v01.TexG.y - v11.TexG.y) * (1 - a) + (v10.TexG.y - v11.TexG.y) * (1 - b);
+            }
+
+            double x, y;
+            ref.Evaluate((eye.VP.x + i + 0.5) / ScreenWidth, (eye.VP.y + j + 0.5) / ScreenHeight, &x, &y);
+            maxError = Alg::Max(maxError, pixelError(gx, gy, x, y));
+        }
+    }
+
+    printf("  mesh %2dx%-2d        %.3f ms   max error %.2f px\n", grid, grid, ms, maxError);
+}
+
+static void runBenchmark()
+{
+    StereoConfig stereo;
+    stereo.SetFullViewport(Viewport(0, 0, ScreenWidth, ScreenHeight));
+    stereo.SetDistortionFitPointVP(-1, 0);
+    Viewport full = stereo.GetFullViewport();
+
+    for (int e = StereoEye_Left; e <= StereoEye_Right; e++)
+    {
+        const StereoEyeParams& eye = stereo.GetEyeRenderParams((StereoEye)e);
+        ShaderReference        ref(eye, full);
+
+        printf("%s eye\n", (e == StereoEye_Left) ? "Left" : "Right");
+        benchmarkWarpMap(eye, full, ref);
+        for (int grid = 16; grid <= 64; grid *= 2)
+            benchmarkMesh(eye, full, ref, grid);
+    }
+}
+
+int main()
+{
+    System::Init();
+    runBenchmark();
+    System::Destroy();
+    return 0;
+}
@@ -0,0 +1,284 @@
+/************************************************************************************
+
+Filename    :   Bench_FusionRates.cpp
+Content     :   Cost and accuracy of SensorFusion at decimated correction rates, on
+                synthetic or recorded sensor captures
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR.h"
+#include "Kernel/OVR_Timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+using namespace OVR;
+
+// Usage: Bench_FusionRates [capture]
+//        Bench_FusionRates --save capture
+//
+// Replays a sensor capture through SensorFusion at decimated correction rates. A capture is a
+// text file with one sample per line:
+//
+//     TimeDelta  RotationRate.x y z  Acceleration.x y z  MagneticField.x y z  Temperature
+//
+// in seconds, rad/s, m/s^2, Gauss and degrees Celsius, as decoded into MessageBodyFrame.
+// Recorded captures have no ground truth, so runs at decimated rates are scored against the
+// run that corrects on every sample.
+//
+// Without a capture, 200 seconds of synthetic 1 kHz sensor data are used: smooth head motion
+// alternating with 5 seconds of rest, with a constant gyro bias and noise on every sensor.
+// --save writes that capture, so that the replay path can be checked against it. The first
+// five seconds are not scored, so the filters can settle.
+static const int SyntheticCount = 200000;
+static const int SettleCount    = 5000;
+
+struct Recording
+{
+    MessageBodyFrame* Messages;
+    Quatf*            Truth;        // Null for a recorded capture.
+    int               Count;
+
+    Recording();
+    ~Recording();
+
+    void Synthesize();
+    bool Load(const char* path);
+    bool Save(const char* path) const;
+};
+
+Recording::Recording() : Messages(0), Truth(0), Count(0)
+{
+}
+
+Recording::~Recording()
+{
+    OVR_FREE(Messages);
+    OVR_FREE(Truth);
+}
+
+void Recording::Synthesize()
+{
+    Count    = SyntheticCount;
+    Messages = (MessageBodyFrame*)OVR_ALLOC(Count * sizeof(MessageBodyFrame));
+    Truth    = (Quatf*)OVR_ALLOC(Count * sizeof(Quatf));
+
+    MessageBodyFrame msg(0);
+    msg.TimeDelta   = 0.001f;
+    msg.Temperature = 30;
+
+    const Vector3f gyroBias(0.01f, -0.02f, 0.015f);
+    Quatf          truth;
+    srand(1);
+
+    for (int i = 0; i < Count; i++)
+    {
+        float    t = i * 0.001f;
+        Vector3f rate(0.8f * sinf(t * 1.3f), 1.2f * sinf(t * 0.7f + 1), 0.5f * cosf(t * 2.1f));
+        if ((i / 5000) % 2)
+            rate = Vector3f();
+        // Renormalized, so that rounding doesn't show up as an orientation error
+        if (rate.LengthSq() > 0)
+            truth = (truth * Quatf(rate, rate.Length() * 0.001f)).Normalized();
+
+        float noise  = (rand() % 1000) / 1000.0f - 0.5f;
+        Quatf toBody = truth.Inverted();
+        msg.RotationRate  = rate + gyroBias + Vector3f(noise, -noise, noise) * 0.01f;
+        msg.Acceleration  = toBody.Rotate(Vector3f(0, 9.8f, 0)) + Vector3f(noise, noise, -noise) * 0.05f;
+        msg.MagneticField = toBody.Rotate(Vector3f(0.2f, -0.4f, 0.1f)) + Vector3f(noise, 0, noise) * 0.002f;
+
+        Messages[i] = msg;
+        Truth[i]    = truth;
+    }
+}
+
+bool Recording::Load(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return false;
+
+    int              capacity = 0;
+    MessageBodyFrame msg(0);
+    Vector3f&        g = msg.RotationRate;
+    Vector3f&        a = msg.Acceleration;
+    Vector3f&        m = msg.MagneticField;
+
+    while (fscanf(file, "%f %f %f %f %f %f %f %f %f %f %f", &msg.TimeDelta, &g.x, &g.y, &g.z,
+                  &a.x, &a.y, &a.z, &m.x, &m.y, &m.z, &msg.Temperature) == 11)
+    {
+        if (Count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 65536;
+            Messages = (MessageBodyFrame*)OVR_REALLOC(Messages, capacity * sizeof(MessageBodyFrame));
+        }
+        Messages[Count++] = msg;
+    }
+
+    // Anything left over is a malformed line
+    bool complete = feof(file) != 0;
+    fclose(file);
+    return complete && Count > SettleCount;
+}
+
+bool Recording::Save(const char* path) const
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+        return false;
+
+    for (int i = 0; i < Count; i++)
+    {
+        const MessageBodyFrame& msg = Messages[i];
+        fprintf(file, "%.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g\n", msg.TimeDelta,
+                msg.RotationRate.x, msg.RotationRate.y, msg.RotationRate.z,
+                msg.Acceleration.x, msg.Acceleration.y, msg.Acceleration.z,
+                msg.MagneticField.x, msg.MagneticField.y, msg.MagneticField.z, msg.Temperature);
+    }
+    return fclose(file) == 0;
+}
+
+struct FusionResult
+{
+    double NanoSecondsPerSample;
+    double TiltErrorDegrees;        // Mean angle between the reference and estimated up vectors
+    double TotalErrorDegrees;       // Mean angle of the rotation between the two orientations
+};
+
+static void setupFusion(SensorFusion& fusion, float gravityHz, float yawHz, bool yawCorrection)
+{
+    fusion.SetCorrectionRates(gravityHz, yawHz);
+    fusion.SetMagCalibration(Matrix4f());
+    fusion.SetYawCorrectionEnabled(yawCorrection);
+}
+
+// Scores the orientations against the truth of a synthetic recording, or else against the
+// reference orientations, which are filled in instead when the reference is still empty.
+static FusionResult runFusion(const Recording& rec, Quatf* reference, bool fillReference,
+                              float gravityHz, float yawHz, bool yawCorrection)
+{
+    FusionResult result;
+
+    // Timed on its own, without the per sample queries of the accuracy pass
+    {
+        SensorFusion fusion;
+        setupFusion(fusion, gravityHz, yawHz, yawCorrection);
+        double start = Timer::GetProfileSeconds();
+        for (int i = 0; i < rec.Count; i++)
+            fusion.OnMessage(rec.Messages[i]);
+        result.NanoSecondsPerSample = (Timer::GetProfileSeconds() - start) / rec.Count * 1e9;
+    }
+
+    SensorFusion fusion;
+    setupFusion(fusion, gravityHz, yawHz, yawCorrection);
+    double tiltError  = 0;
+    double totalError = 0;
+
+    for (int i = 0; i < rec.Count; i++)
+    {
+        fusion.OnMessage(rec.Messages[i]);
+        Quatf estimate = fusion.GetOrientation();
+        if (fillReference)
+            reference[i] = estimate;
+        if (i < SettleCount)
+            continue;
+
+        // atan2 rather than acos, which has no precision left for angles this small
+        const Quatf& truth   = rec.Truth ? rec.Truth[i] : reference[i];
+        Quatf        error   = (estimate.Inverted() * truth).Normalized();
+        Vector3f     up      = estimate.Inverted().Rotate(Vector3f(0, 1, 0));
+        Vector3f     trueUp  = truth.Inverted().Rotate(Vector3f(0, 1, 0));
+        Vector3f     axis(error.x, error.y, error.z);
+        totalError += 2 * atan2(axis.Length(), fabs(error.w));
+        tiltError  += atan2(up.Cross(trueUp).Length(), up.Dot(trueUp));
+    }
+
+    int scored = rec.Count - SettleCount;
+    result.TiltErrorDegrees  = tiltError / scored * Mathd::RadToDegreeFactor;
+    result.TotalErrorDegrees = totalError / scored * Mathd::RadToDegreeFactor;
+    return result;
+}
+
+static void runBenchmark(const Recording& rec)
+{
+    struct { const char* Name; float GravityHz, YawHz; } rates[] =
+    {
+        { "every sample ", 0, 0 },
+        { "250 / 100 Hz ", 250, 100 },
+        { "100 / 50 Hz  ", 100, 50 }
+    };
+    Quatf* reference = rec.Truth ? 0 : (Quatf*)OVR_ALLOC(rec.Count * sizeof(Quatf));
+
+    if (rec.Truth)
+        printf("Synthetic capture of %d samples, errors against the true orientation\n", rec.Count);
+    else
+        printf("Capture of %d samples, errors against the run that corrects every sample\n", rec.Count);
+
+    for (int yaw = 0; yaw < 2; yaw++)
+    {
+        printf("Yaw correction %s\n", yaw ? "on" : "off");
+        for (int i = 0; i < 3; i++)
+        {
+            FusionResult r = runFusion(rec, reference, reference && i == 0,
+                                       rates[i].GravityHz, rates[i].YawHz, yaw != 0);
+            printf("  %s %7.1f ns/sample   tilt error %.3f deg   total error %.2f deg\n",
+                   rates[i].Name, r.NanoSecondsPerSample, r.TiltErrorDegrees, r.TotalErrorDegrees);
+        }
+    }
+
+    OVR_FREE(reference);
+}
+
+int main(int argc, char** argv)
+{
+    System::Init();
+
+    int result = 0;
+    {
+        Recording rec;
+        if (argc == 3 && !strcmp(argv[1], "--save"))
+        {
+            rec.Synthesize();
+            if (!rec.Save(argv[2]))
+            {
+                printf("Can't write %s\n", argv[2]);
+                result = 1;
+            }
+        }
+        else if (argc == 2 && !rec.Load(argv[1]))
+        {
+            printf("Can't read a capture of more than %d samples from %s\n", SettleCount, argv[1]);
+            result = 1;
+        }
+        else
+        {
+            if (argc == 1)
+                rec.Synthesize();
+            runBenchmark(rec);
+        }
+    }
+
+    System::Destroy();
+    return result;
+}
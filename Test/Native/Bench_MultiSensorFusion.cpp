@@ -0,0 +1,247 @@
+/************************************************************************************
+
+Filename    :   Bench_MultiSensorFusion.cpp
+Content     :   Throughput and accuracy of MultiSensorFusion for 1 to 8 sensors
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR.h"
+#include "OVR_MultiSensorFusion.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_Timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace OVR;
+
+// 20 seconds of synthetic 1 kHz motion, seen by up to 8 rigidly mounted sensors with
+// independent noise. The group starts at rest for two seconds so every pipeline aligns.
+//
+// Like HID reports, each sensor's samples arrive in batches, and the batches of different
+// sensors are out of phase; so the sensors' latest samples are up to BatchSize - 1 ms
+// apart when the fused orientation is queried. Queries run every 16 samples and are
+// scored after three seconds against the truth at the time they refer to.
+//
+// The same streams are then fed again, serially and with one thread per sensor, to measure
+// the throughput of the pipelines.
+static const int    SampleCount  = 20000;
+static const int    BatchSize    = 4;
+static const int    QueryPeriod  = 16;
+static const int    ScoreStart   = 3000;
+static const int    MaxSensors   = 8;
+static const double StartTime    = 1.0;
+
+static float noise()
+{
+    return (rand() % 1000) / 1000.0f - 0.5f;
+}
+
+// Angle between the up vectors of the true and the estimated orientation.
+static double tiltError(const Quatf& estimate, const Quatf& truth)
+{
+    Vector3f up     = estimate.Inverted().Rotate(Vector3f(0, 1, 0));
+    Vector3f trueUp = truth.Inverted().Rotate(Vector3f(0, 1, 0));
+    return atan2(up.Cross(trueUp).Length(), up.Dot(trueUp));
+}
+
+static int sampleIndex(double time)
+{
+    return (int)floor((time - StartTime) * 1000 + 0.5);
+}
+
+struct Streams
+{
+    int               SensorCount;
+    Quatf             Mounting[MaxSensors];
+    MessageBodyFrame* Messages[MaxSensors];
+    Quatf*            Truth;
+
+    Streams(int sensorCount);
+    ~Streams();
+};
+
+Streams::Streams(int sensorCount) : SensorCount(sensorCount)
+{
+    Truth = (Quatf*)OVR_ALLOC(SampleCount * sizeof(Quatf));
+    for (int i = 0; i < SensorCount; i++)
+    {
+        Mounting[i] = i ? Quatf(Vector3f((float)i, 1, (float)-i), 0.3f * i) : Quatf();
+        Messages[i] = (MessageBodyFrame*)OVR_ALLOC(SampleCount * sizeof(MessageBodyFrame));
+    }
+
+    MessageBodyFrame msg(0);
+    msg.TimeDelta = 0.001f;
+
+    Quatf truth;
+    srand(2);
+
+    for (int k = 0; k < SampleCount; k++)
+    {
+        float    t = k * 0.001f;
+        Vector3f rate(0.4f * sinf(t * 1.3f), 0.6f * sinf(t * 0.7f + 1), 0.3f * cosf(t * 2.1f));
+        if (k < 2000)
+            rate = Vector3f();
+        if (rate.LengthSq() > 0)
+            truth = (truth * Quatf(rate, rate.Length() * 0.001f)).Normalized();
+        Truth[k] = truth;
+
+        msg.AbsoluteTimeSeconds = StartTime + k * 0.001;
+        for (int i = 0; i < SensorCount; i++)
+        {
+            // World from sensor i, and the rate in the sensor's own frame
+            Quatf    sensorTruth = truth * Mounting[i];
+            Vector3f sensorRate  = Mounting[i].Inverted().Rotate(rate);
+            float    n1 = noise(), n2 = noise(), n3 = noise();
+            msg.RotationRate = sensorRate + Vector3f(n1, n2, n3) * 0.05f;
+            msg.Acceleration = sensorTruth.Inverted().Rotate(Vector3f(0, 9.8f, 0)) + Vector3f(n3, n1, n2) * 0.2f;
+            Messages[i][k]   = msg;
+        }
+    }
+}
+
+Streams::~Streams()
+{
+    OVR_FREE(Truth);
+    for (int i = 0; i < SensorCount; i++)
+        OVR_FREE(Messages[i]);
+}
+
+static void measureAccuracy(const Streams& streams)
+{
+    MultiSensorFusion fusion;
+    for (int i = 0; i < streams.SensorCount; i++)
+        fusion.AddSensor(streams.Mounting[i]);
+
+    double fusedError  = 0;
+    double singleError = 0;
+    double queryTime   = 0;
+    int    scored      = 0;
+    int    queries     = 0;
+    int    fed[MaxSensors] = { 0 };
+
+    for (int k = 0; k < SampleCount; k++)
+    {
+        // Sensor i delivers its pending samples once every BatchSize samples, i samples late
+        for (int i = 0; i < streams.SensorCount; i++)
+        {
+            if ((k + i) % BatchSize != BatchSize - 1)
+                continue;
+            for (; fed[i] <= k; fed[i]++)
+                fusion.OnMessage(i, streams.Messages[i][fed[i]]);
+        }
+
+        if (k % QueryPeriod != 0 || fed[streams.SensorCount - 1] == 0)
+            continue;
+
+        double queryStart = Timer::GetProfileSeconds();
+        Quatf  fused      = fusion.GetOrientation();
+        queryTime += Timer::GetProfileSeconds() - queryStart;
+        queries++;
+
+        if (k > ScoreStart)
+        {
+            SensorFusion* first = fusion.GetSensorFusion(0);
+            fusedError  += tiltError(fused, streams.Truth[sampleIndex(fusion.GetSampleTime())]);
+            singleError += tiltError(first->GetOrientation(), streams.Truth[sampleIndex(first->GetSampleTime())]);
+            scored++;
+        }
+    }
+
+    printf("%d sensors: query %5.2f us   tilt error %.3f deg (first sensor alone %.3f deg)   inliers %d\n",
+           streams.SensorCount, queryTime / queries * 1e6,
+           fusedError / scored * Mathd::RadToDegreeFactor,
+           singleError / scored * Mathd::RadToDegreeFactor,
+           fusion.GetInlierCount());
+}
+
+struct FeedJob
+{
+    MultiSensorFusion*      pFusion;
+    int                     Index;
+    const MessageBodyFrame* Messages;
+    double                  EndTime;
+};
+
+static int feedSensor(Thread*, void* param)
+{
+    FeedJob* job = (FeedJob*)param;
+    for (int k = 0; k < SampleCount; k++)
+        job->pFusion->OnMessage(job->Index, job->Messages[k]);
+    job->EndTime = Timer::GetProfileSeconds();
+    return 0;
+}
+
+static void measureThroughput(const Streams& streams)
+{
+    int     count = streams.SensorCount;
+    FeedJob jobs[MaxSensors];
+
+    MultiSensorFusion serial;
+    for (int i = 0; i < count; i++)
+    {
+        serial.AddSensor(streams.Mounting[i]);
+        jobs[i].pFusion  = &serial;
+        jobs[i].Index    = i;
+        jobs[i].Messages = streams.Messages[i];
+    }
+    double start = Timer::GetProfileSeconds();
+    for (int i = 0; i < count; i++)
+        feedSensor(NULL, &jobs[i]);
+    double serialTime = Timer::GetProfileSeconds() - start;
+
+    MultiSensorFusion parallel;
+    Ptr<Thread>       threads[MaxSensors];
+    for (int i = 0; i < count; i++)
+    {
+        parallel.AddSensor(streams.Mounting[i]);
+        jobs[i].pFusion = &parallel;
+        threads[i] = *new Thread(feedSensor, &jobs[i]);
+    }
+    start = Timer::GetProfileSeconds();
+    for (int i = 0; i < count; i++)
+        threads[i]->Start();
+    double parallelTime = 0;
+    for (int i = 0; i < count; i++)
+    {
+        while (!threads[i]->IsFinished())
+            Thread::MSleep(1);
+        parallelTime = Alg::Max(parallelTime, jobs[i].EndTime - start);
+    }
+
+    printf("           feed %5.2f M samples/s on one thread, %5.2f M samples/s on %d threads\n",
+           SampleCount * count / serialTime * 1e-6, SampleCount * count / parallelTime * 1e-6, count);
+}
+
+int main()
+{
+    System::Init();
+    for (int n = 1; n <= MaxSensors; n *= 2)
+    {
+        Streams streams(n);
+        measureAccuracy(streams);
+        measureThroughput(streams);
+    }
+    System::Destroy();
+    return 0;
+}
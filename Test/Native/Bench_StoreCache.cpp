@@ -0,0 +1,217 @@
+/************************************************************************************
+
+Filename    :   Bench_StoreCache.cpp
+Content     :   Cost of opening a StoreCache compared with parsing its JSON file
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR.h"
+#include "OVR_JSON.h"
+#include "OVR_StoreCache.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_Timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace OVR;
+
+// Stores with 5000 profiles and 5000 devices, shaped like Profiles.json and Devices.json.
+// They are written to the working directory, so the user's own stores are left alone.
+static const int EntryCount  = 5000;
+static const int LookupCount = 20000;
+static const int RepeatCount = 20;
+
+static const char* ProfilesPath = "Bench_StoreCache_Profiles.json";
+static const char* DevicesPath  = "Bench_StoreCache_Devices.json";
+
+static const UInt32 BenchStoreKind = 0x42454E43;
+
+struct BenchRecord
+{
+    UInt32  Name;
+    float   Value;
+};
+
+static String makeProfiles()
+{
+    String text;
+    char   buf[512];
+    OVR_sprintf(buf, sizeof(buf), "{\"Oculus Profile Version\": 1.0, \"CurrentProfile\": \"user%d\", \"ProfileCount\": %d",
+                EntryCount - 1, EntryCount);
+    text += buf;
+
+    for (int i = 0; i < EntryCount; i++)
+    {
+        OVR_sprintf(buf, sizeof(buf), ",\n\"Profile\": {\"Name\": \"user%d\", \"Gender\": \"%s\", \"PlayerHeight\": %g, \"IPD\": %g, "
+                    "\"RiftDK1\": {\"EyeCup\": \"%c\", \"LL\": %d, \"LR\": %d, \"RL\": %d, \"RR\": %d}, \"RiftDKHD\": {\"EyeCup\": \"%c\"}}",
+                    i, (i & 1) ? "Male" : "Female", 1.5 + i * 1e-4, 0.06 + (i % 100) * 1e-4,
+                    'A' + i % 3, i, i + 1, i + 2, i + 3, 'A' + (i + 1) % 3);
+        text += buf;
+    }
+    text += "}";
+    return text;
+}
+
+static String makeDevices()
+{
+    String text = "{\"Oculus Device Profile Version\": \"1.0\"";
+    char   buf[512];
+
+    for (int i = 0; i < EntryCount; i++)
+    {
+        OVR_sprintf(buf, sizeof(buf), ",\n\"Device\": {\"Product\": \"Tracker\", \"ProductID\": 1, \"Serial\": \"user%d\", \"EnableYawCorrection\": true, "
+                    "\"MagCalibration\": {\"Version\": \"2\", \"Name\": \"default\", \"Time\": \"2013-06-01 10:20:30\", "
+                    "\"CalibrationMatrix\": \"%g 0.5 0 1 0 1 0 2 0 0 1 3 0 0 0 1\"}}",
+                    i, 1.0 + i * 0.001);
+        text += buf;
+    }
+    text += "}";
+    return text;
+}
+
+static bool writeFile(const char* path, const String& text)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+        return false;
+    bool ok = fwrite(text.ToCStr(), 1, text.GetSize(), file) == text.GetSize();
+    fclose(file);
+    return ok;
+}
+
+// Keys every object member with the given key field; the record holds one string and one number.
+static bool compileStore(const JSONValue* root, StoreCacheBuilder* builder, const char* keyName,
+                         const char* valueName)
+{
+    for (const JSONValue* item = root->GetFirstItem(); item; item = root->GetNextItem(item))
+    {
+        const JSONValue* key = item->GetItemByName(keyName);
+        if (!key)
+            continue;
+
+        const JSONValue* value = item->GetItemByName(valueName);
+        BenchRecord      record;
+        record.Name  = builder->AddString(item->Name);
+        record.Value = value ? (float)value->dValue : 0;
+        builder->AddEntry(key->Value);
+        builder->AddRecord(&record);
+    }
+    return true;
+}
+
+static bool compileProfiles(const JSONValue* root, StoreCacheBuilder* builder)
+{
+    return compileStore(root, builder, "Name", "IPD");
+}
+
+static bool compileDevices(const JSONValue* root, StoreCacheBuilder* builder)
+{
+    return compileStore(root, builder, "Serial", "ProductID");
+}
+
+static void benchmarkStore(const char* title, const char* path, StoreCache::CompileFunc compile)
+{
+    // Parsing the JSON is what opening the store cost before it had a cache.
+    double start = Timer::GetProfileSeconds();
+    for (int i = 0; i < RepeatCount; i++)
+    {
+        Ptr<JSONDocument> doc = *JSONDocument::Load(path);
+        if (!doc)
+        {
+            printf("%s: can't parse %s\n", title, path);
+            return;
+        }
+    }
+    double parseTime = (Timer::GetProfileSeconds() - start) / RepeatCount;
+
+    StoreCache::Invalidate(path);
+    start = Timer::GetProfileSeconds();
+    Ptr<StoreCache> cache = *StoreCache::Open(path, BenchStoreKind, sizeof(BenchRecord), compile);
+    double compileTime = Timer::GetProfileSeconds() - start;
+    if (!cache)
+    {
+        printf("%s: can't compile %s\n", title, path);
+        return;
+    }
+
+    // The cache is only trusted once the JSON file is older than it by a second.
+    Thread::Sleep(2);
+    Ptr<StoreCache> warm = *StoreCache::Open(path, BenchStoreKind, sizeof(BenchRecord), compile);
+    cache = 0;
+    warm  = 0;
+
+    char   key[32];
+    int    found = 0;
+    bool   mapped = true;
+    start = Timer::GetProfileSeconds();
+    for (int i = 0; i < RepeatCount; i++)
+    {
+        cache = *StoreCache::Open(path, BenchStoreKind, sizeof(BenchRecord), compile);
+        OVR_sprintf(key, sizeof(key), "user%d", EntryCount - 1);
+        found += cache->FindEntry(key) >= 0;
+        mapped = mapped && cache->IsMapped();
+    }
+    double openTime = (Timer::GetProfileSeconds() - start) / RepeatCount;
+
+    start = Timer::GetProfileSeconds();
+    for (int i = 0; i < LookupCount; i++)
+    {
+        OVR_sprintf(key, sizeof(key), "user%d", (i * 7919) % EntryCount);
+        found += cache->FindEntry(key) >= 0;
+    }
+    double lookupTime = (Timer::GetProfileSeconds() - start) / LookupCount;
+
+    printf("%s (%d entries)\n", title, EntryCount);
+    printf("  parse JSON           %8.3f ms\n", parseTime * 1e3);
+    printf("  compile and write    %8.3f ms\n", compileTime * 1e3);
+    printf("  open cache + lookup  %8.3f ms%s\n", openTime * 1e3, mapped ? "" : "   (not mapped)");
+    printf("  lookup by key        %8.0f ns\n", lookupTime * 1e9);
+    if (found != RepeatCount + LookupCount)
+        printf("  %d lookups failed\n", RepeatCount + LookupCount - found);
+
+    cache = 0;
+    StoreCache::Invalidate(path);
+}
+
+static void runBenchmark()
+{
+    if (!writeFile(ProfilesPath, makeProfiles()) || !writeFile(DevicesPath, makeDevices()))
+    {
+        printf("Can't write the stores to the working directory\n");
+        return;
+    }
+
+    benchmarkStore("Profiles", ProfilesPath, compileProfiles);
+    benchmarkStore("Devices", DevicesPath, compileDevices);
+
+    remove(ProfilesPath);
+    remove(DevicesPath);
+}
+
+int main()
+{
+    System::Init();
+    runBenchmark();
+    System::Destroy();
+    return 0;
+}
@@ -0,0 +1,293 @@
+/************************************************************************************
+
+Filename    :   Test_Decimal.cpp
+Content     :   Checks the decimal conversions of OVR_Std against the C library
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace OVR;
+
+// Usage: Test_Decimal [count]
+//
+// Checks count random bit patterns and count random decimal strings (200000 by default;
+// the full run uses 3000000). The C library is the reference, so it has to round
+// correctly, as glibc does.
+
+static int Failures = 0;
+
+static void fail(const char* what, const char* text)
+{
+    if (Failures++ < 10)
+        printf("FAILED: %s \"%s\"\n", what, text);
+}
+
+static UInt64 RandomState = 88172645463325252ull;
+
+static UInt64 random64()
+{
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 7;
+    RandomState ^= RandomState << 17;
+    return RandomState;
+}
+
+static bool isFinite(double v)
+{
+    return v == v && v - v == 0;
+}
+
+// Significant digits of a decimal, without leading and trailing zeros.
+static int significantDigits(const char* s)
+{
+    int  count = 0, trailing = 0;
+    bool started = false;
+    for (; *s && *s != 'e'; s++)
+    {
+        if (*s < '0' || *s > '9')
+            continue;
+        started = started || (*s != '0');
+        if (started)
+        {
+            count++;
+            trailing = (*s == '0') ? trailing + 1 : 0;
+        }
+    }
+    return count - trailing;
+}
+
+// The printed text reads back as the same value, with both parsers, and has no more
+// digits than the shortest %.*e that does.
+static void checkDouble(double v)
+{
+    char text[32];
+    UPInt length = OVR_dtoa(v, text, sizeof(text));
+    if (length != strlen(text))
+        fail("OVR_dtoa length", text);
+    if (v != v)
+        return;
+
+    double libc = strtod(text, NULL);
+    double own  = OVR_strtod(text, NULL);
+    if (memcmp(&libc, &v, sizeof(v)) || memcmp(&own, &v, sizeof(v)))
+        fail("OVR_dtoa round trip", text);
+    if (!isFinite(v) || v == 0)
+        return;
+
+    char shortest[40];
+    for (int precision = 0; precision < 17; precision++)
+    {
+        OVR_sprintf(shortest, sizeof(shortest), "%.*e", precision, v);
+        if (strtod(shortest, NULL) == v)
+            break;
+    }
+    if (significantDigits(text) > significantDigits(shortest))
+        fail("OVR_dtoa longer than needed", text);
+}
+
+static void checkFloat(float v)
+{
+    char text[32];
+    OVR_ftoa(v, text, sizeof(text));
+    if (v != v)
+        return;
+
+    float libc = strtof(text, NULL);
+    float own  = OVR_strtof(text, NULL);
+    if (memcmp(&libc, &v, sizeof(v)) || memcmp(&own, &v, sizeof(v)))
+        fail("OVR_ftoa round trip", text);
+    if (!isFinite(v) || v == 0)
+        return;
+
+    char shortest[40];
+    for (int precision = 0; precision < 9; precision++)
+    {
+        OVR_sprintf(shortest, sizeof(shortest), "%.*e", precision, v);
+        if (strtof(shortest, NULL) == v)
+            break;
+    }
+    if (significantDigits(text) > significantDigits(shortest))
+        fail("OVR_ftoa longer than needed", text);
+}
+
+// Both parsers return the same bits and stop at the same character as the C library.
+static void checkParse(const char* text)
+{
+    char*  libcEnd;
+    char*  ownEnd;
+    double libc = strtod(text, &libcEnd);
+    double own  = OVR_strtod(text, &ownEnd);
+    if (memcmp(&libc, &own, sizeof(own)) || libcEnd != ownEnd)
+        fail("OVR_strtod", text);
+
+    float libcF = strtof(text, &libcEnd);
+    float ownF  = OVR_strtof(text, &ownEnd);
+    if (memcmp(&libcF, &ownF, sizeof(ownF)) || libcEnd != ownEnd)
+        fail("OVR_strtof", text);
+}
+
+// Up to 40 digits with a random decimal point and, half the time, an exponent that
+// spans either the whole double range or the range where the fast paths apply.
+static void randomDecimal(char* text)
+{
+    char* p = text;
+    if (random64() & 1)
+        *p++ = '-';
+
+    int digits = 1 + (int)(random64() % ((random64() & 3) ? 18 : 40));
+    int point  = (int)(random64() % (digits + 1));
+    for (int i = 0; i < digits; i++)
+    {
+        if (i == point && i > 0)
+            *p++ = '.';
+        *p++ = (char)('0' + random64() % 10);
+    }
+
+    if (random64() & 1)
+    {
+        int range[3][2] = { { 700, 360 }, { 90, 50 }, { 30, 15 } };
+        int mode = (int)(random64() % 3);
+        int exponent = (int)(random64() % range[mode][0]) - range[mode][1];
+        p += OVR_sprintf(p, 16, "e%d", exponent);
+    }
+    *p = 0;
+}
+
+static void testBitPatterns(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        UInt64 bits = random64();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        checkDouble(d);
+
+        UInt32 fbits = (UInt32)bits;
+        float  f;
+        memcpy(&f, &fbits, sizeof(f));
+        checkFloat(f);
+    }
+
+    // Values next to every power of two, including the subnormals
+    for (UInt64 e = 0; e < 2047; e++)
+    {
+        for (UInt64 m = 0; m < 4; m++)
+        {
+            UInt64 bits[2] = { (e << 52) | m, (e << 52) | (0xFFFFFFFFFFFFFull - m) };
+            for (int i = 0; i < 2; i++)
+            {
+                double d;
+                memcpy(&d, &bits[i], sizeof(d));
+                checkDouble(d);
+            }
+        }
+    }
+    for (UInt32 e = 0; e < 255; e++)
+    {
+        for (UInt32 m = 0; m < 4; m++)
+        {
+            UInt32 bits[2] = { (e << 23) | m, (e << 23) | (0x7FFFFF - m) };
+            for (int i = 0; i < 2; i++)
+            {
+                float f;
+                memcpy(&f, &bits[i], sizeof(f));
+                checkFloat(f);
+            }
+        }
+    }
+}
+
+static void testDecimals(int count)
+{
+    static const char* special[] =
+    {
+        "0", "-0", "1", "1.5", "1e5", "1.e5", "  +3.25", ".5", "5.", "1e", "1e+", "", "-",
+        "9007199254740993", "9007199254740992.5", "1e23", "8.589973e9", "0.1", "0.3",
+        "2.2250738585072011e-308", "4.9e-324", "2.4703282292062327e-324", "1e400", "-1e-400",
+        "1.7976931348623157e308", "1.7976931348623159e308", "3.4028235e38", "3.4028236e38",
+        "1.17549435e-38", "1.4e-45", "7.0064923216240854e-46", "0x1p3", "inf", "-Infinity",
+        "nan", "123456789012345678901234567890", "100000000000000000000000",
+        "0.000000000000000000000000000000000000000000001e45", "1E+2", "00012",
+        "1e0000000000000003"
+    };
+    for (unsigned i = 0; i < sizeof(special) / sizeof(special[0]); i++)
+        checkParse(special[i]);
+
+    char text[128];
+    for (int i = 0; i < count; i++)
+    {
+        randomDecimal(text);
+        checkParse(text);
+    }
+}
+
+static void testMatrix()
+{
+    for (int i = 0; i < 10000; i++)
+    {
+        Matrix4f m;
+        for (int r = 0; r < 4; r++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                UInt32 bits = (UInt32)random64();
+                float  f;
+                memcpy(&f, &bits, sizeof(f));
+                m.M[r][c] = isFinite(f) ? f : 1.25f;
+            }
+        }
+
+        char text[512];
+        m.ToString(text, sizeof(text));
+        Matrix4f back = Matrix4f::FromString(text);
+        if (memcmp(&m, &back, sizeof(m)))
+            fail("Matrix4f round trip", text);
+
+        char truncated[20];
+        m.ToString(truncated, sizeof(truncated));
+        if (strlen(truncated) >= sizeof(truncated))
+            fail("Matrix4f::ToString truncation", truncated);
+    }
+
+    Matrix4f partial = Matrix4f::FromString("1 2 3");
+    if (partial.M[0][2] != 3 || partial.M[3][3] != 0)
+        fail("Matrix4f::FromString of a short string", "1 2 3");
+}
+
+int main(int argc, char** argv)
+{
+    int count = (argc > 1) ? atoi(argv[1]) : 200000;
+
+    System::Init();
+    testBitPatterns(count);
+    testDecimals(count);
+    testMatrix();
+    System::Destroy();
+
+    printf("Test_Decimal: %d failures\n", Failures);
+    return Failures ? 1 : 0;
+}
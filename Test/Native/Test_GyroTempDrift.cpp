@@ -0,0 +1,231 @@
+/************************************************************************************
+
+Filename    :   Test_GyroTempDrift.cpp
+Content     :   Checks the temperature compensated gyro bias on synthetic thermal drift
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace OVR;
+
+static int Failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s\n", what);
+        Failures++;
+    }
+}
+
+// The gyro of the synthetic sensor has a zero-rate offset of about 27 mrad/s at 25 degrees
+// Celsius, which changes linearly by up to 0.5 mrad/s per degree.
+static Vector3f gyroBias(float temperature)
+{
+    return Vector3f(0.01f, -0.02f, 0.015f) + Vector3f(0.5f, -0.3f, 0.4f) * (0.001f * (temperature - 25));
+}
+
+// A 1 kHz capture of a headset whose temperature moves linearly between two values, while it
+// alternates between 5 seconds of rest and 5 seconds of smooth head motion, or only moves.
+class ThermalCapture
+{
+public:
+    ThermalCapture(float startTemperature, float endTemperature, int sampleCount, bool rests)
+      : StartTemperature(startTemperature), EndTemperature(endTemperature),
+        SampleCount(sampleCount), Rests(rests), Index(0)
+    {
+        srand(1);
+    }
+
+    bool  IsDone() const        { return Index >= SampleCount; }
+    bool  IsResting() const     { return Rests && (Index / 5000) % 2 == 0; }
+    float GetTemperature() const
+    {
+        return StartTemperature + (EndTemperature - StartTemperature) * Index / SampleCount;
+    }
+    const Quatf& GetTruth() const { return Truth; }
+
+    // Produces the next sample and advances the true orientation past it.
+    MessageBodyFrame Next()
+    {
+        float    t = Index * 0.001f;
+        Vector3f rate;
+        if (!IsResting())
+            rate = Vector3f(0.8f * sinf(t * 1.3f), 1.2f * sinf(t * 0.7f + 1), 0.5f * cosf(t * 2.1f));
+
+        float noise  = (rand() % 1000) / 1000.0f - 0.5f;
+        Quatf toBody = Truth.Inverted();
+
+        MessageBodyFrame msg(0);
+        msg.TimeDelta     = 0.001f;
+        msg.Temperature   = GetTemperature();
+        msg.RotationRate  = rate + gyroBias(msg.Temperature) + Vector3f(noise, -noise, noise) * 0.01f;
+        msg.Acceleration  = toBody.Rotate(Vector3f(0, 9.8f, 0)) + Vector3f(noise, noise, -noise) * 0.05f;
+        msg.MagneticField = toBody.Rotate(Vector3f(0.2f, -0.4f, 0.1f));
+
+        // Renormalized, so that rounding doesn't show up as an orientation error
+        if (rate.LengthSq() > 0)
+            Truth = (Truth * Quatf(rate, rate.Length() * 0.001f)).Normalized();
+        Index++;
+        return msg;
+    }
+
+private:
+    float StartTemperature, EndTemperature;
+    int   SampleCount;
+    bool  Rests;
+    int   Index;
+    Quatf Truth;
+};
+
+static double angleBetween(const Quatf& a, const Quatf& b)
+{
+    Quatf error = (a.Inverted() * b).Normalized();
+    return 2 * acos(Alg::Min(fabs(error.w), 1.0f)) * Mathd::RadToDegreeFactor;
+}
+
+struct DriftResult
+{
+    double MeanErrorDegrees;
+    double FinalErrorDegrees;
+    int    RestSamples, RestDetected;
+    int    MotionSamples, MotionDetected;
+};
+
+static DriftResult runCapture(SensorFusion& fusion, ThermalCapture& capture)
+{
+    DriftResult result = { 0, 0, 0, 0, 0, 0 };
+    int         count  = 0;
+
+    while (!capture.IsDone())
+    {
+        bool resting = capture.IsResting();
+        fusion.OnMessage(capture.Next());
+
+        if (resting)
+        {
+            result.RestSamples++;
+            result.RestDetected += fusion.IsStationary();
+        }
+        else
+        {
+            result.MotionSamples++;
+            result.MotionDetected += fusion.IsStationary();
+        }
+
+        result.FinalErrorDegrees = angleBetween(fusion.GetOrientation(), capture.GetTruth());
+        result.MeanErrorDegrees += result.FinalErrorDegrees;
+        count++;
+    }
+
+    result.MeanErrorDegrees /= count;
+    return result;
+}
+
+// Warming up from 25 to 45 degrees over 400 seconds, rest is detected despite the offset,
+// the table learns the bias at every temperature, and the orientation drifts far less
+// than with a single learned offset.
+static void testWarmUp(UByte* state, int* stateSize)
+{
+    const int sampleCount = 400000;
+
+    SensorFusion   fusion;
+    ThermalCapture capture(25, 45, sampleCount, true);
+    DriftResult    on = runCapture(fusion, capture);
+
+    SensorFusion   uncompensated;
+    ThermalCapture sameCapture(25, 45, sampleCount, true);
+    uncompensated.SetGyroTempCompensationEnabled(false);
+    DriftResult    off = runCapture(uncompensated, sameCapture);
+
+    printf("Warm-up 25 to 45 C: mean error %.2f deg compensated, %.2f deg uncompensated\n",
+           on.MeanErrorDegrees, off.MeanErrorDegrees);
+    printf("  rest detected on %.1f%% of rest samples and %.2f%% of motion samples\n",
+           100.0 * on.RestDetected / on.RestSamples, 100.0 * on.MotionDetected / on.MotionSamples);
+
+    check(fusion.IsAligned(), "the fusion aligns despite the gyro offset");
+    check(on.RestDetected > on.RestSamples * 9 / 10, "rest is detected despite the gyro offset");
+    check(on.MotionDetected < on.MotionSamples / 100, "motion is not taken for rest");
+    check(on.MeanErrorDegrees < off.MeanErrorDegrees / 2, "compensation at least halves the drift");
+
+    const GyroTempCalibration& table = fusion.GetGyroTempCalibration();
+    double maxBiasError = 0;
+    for (float temperature = 26.25f; temperature < 45; temperature += table.GetBinWidth())
+    {
+        Vector3f bias;
+        check(table.GetBias(temperature, &bias), "the table has a bias at every temperature");
+        maxBiasError = Alg::Max(maxBiasError, (double)(bias - gyroBias(temperature)).Length());
+    }
+    printf("  largest error of the learned bias %.2f mrad/s\n", maxBiasError * 1000);
+    check(maxBiasError < 0.0015, "the learned bias is within 1.5 mrad/s of the model");
+
+    *stateSize = fusion.SaveState(state, *stateSize);
+}
+
+// After a restart, the table learned during the warm-up keeps the bias right while the
+// headset cools down from 45 to 30 degrees without ever coming to rest again.
+static void testRestart(const UByte* state, int stateSize)
+{
+    const int sampleCount = 200000;
+
+    // One second at rest to align, so both start from the same orientation and offset
+    SensorFusion   restored;
+    check(restored.RestoreState(state, stateSize), "the learned state restores");
+    ThermalCapture settle(45, 45, 1000, true);
+    runCapture(restored, settle);
+    ThermalCapture capture(45, 30, sampleCount, false);
+    DriftResult    warm = runCapture(restored, capture);
+
+    SensorFusion   fresh;
+    ThermalCapture freshSettle(45, 45, 1000, true);
+    runCapture(fresh, freshSettle);
+    ThermalCapture sameCapture(45, 30, sampleCount, false);
+    DriftResult    cold = runCapture(fresh, sameCapture);
+
+    printf("Cool-down 45 to 30 C in motion: final error %.2f deg with the restored table, %.2f deg without\n",
+           warm.FinalErrorDegrees, cold.FinalErrorDegrees);
+    check(restored.IsAligned() && fresh.IsAligned(), "both align in the first second");
+    check(warm.FinalErrorDegrees < cold.FinalErrorDegrees / 2, "the restored table at least halves the drift");
+}
+
+int main()
+{
+    System::Init();
+
+    UByte state[4096];
+    int   stateSize = sizeof(state);
+    testWarmUp(state, &stateSize);
+    check(stateSize <= (int)sizeof(state), "the state fits in 4 KB");
+    if (stateSize <= (int)sizeof(state))
+        testRestart(state, stateSize);
+
+    System::Destroy();
+
+    printf("%s\n", Failures ? "Test_GyroTempDrift failed" : "Test_GyroTempDrift passed");
+    return Failures ? 1 : 0;
+}
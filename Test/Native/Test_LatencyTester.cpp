@@ -0,0 +1,167 @@
+/************************************************************************************
+
+Filename    :   Test_LatencyTester.cpp
+Content     :   Drives Util::LatencyTest with a simulated Latency Tester
+Created     :   October 19, 2026
+Authors     :   Stefanos Apostolopoulos
+
+Copyright   :   Copyright 2013 Oculus VR, Inc. All Rights reserved.
+
+Licensed under the Oculus VR SDK License Version 2.0 (the "License");
+you may not use the Oculus VR SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR.h"
+#include "Util/Util_LatencyTest.h"
+#include "Util/Util_LatencyTestMock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace OVR;
+using namespace OVR::Util;
+
+static int Failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        printf("FAILED: %s\n", what);
+        Failures++;
+    }
+}
+
+// Renders one frame per frameMicroS of simulated time until the test stops or the
+// time runs out.
+static void runFrames(LatencyTestDeviceMock* device, LatencyTest& test, UInt64 microS, UInt32 frameMicroS)
+{
+    UInt64 end = device->GetTicks() + microS;
+    while (device->GetTicks() < end && test.IsTestRunning())
+    {
+        device->Advance(frameMicroS);
+        test.ProcessInputs();
+
+        Color color;
+        if (test.DisplayScreenColor(color))
+            device->SetScreenColor(color);
+    }
+}
+
+// A button press runs one test to completion; a 40 ms display behind a 1 ms USB link
+// measures 41 ms from the color change to the report.
+static void testSingle()
+{
+    Ptr<LatencyTestDeviceMock> device = *new LatencyTestDeviceMock();
+    device->SetLatency(40000, 1000);
+    LatencyTest test(device);
+    test.SetTimeSource(LatencyTestDeviceMock::TimeSource, device);
+
+    device->PressButton();
+    device->Advance(2000);
+    check(test.IsTestRunning(), "the button starts a test");
+
+    runFrames(device, test, 60000000, 1000);
+    check(!test.IsTestRunning(), "a single test finishes");
+    check(test.GetResultsString() != NULL, "a single test reports results");
+    check(test.GetTestCount() == 1 && test.GetTimeoutCount() == 0, "a single test counts one test");
+    check(device->GetDisplay().Value == 41, "the device displays the result");
+
+    LatencyStats total, usb;
+    test.GetStats(Latency_Total, &total);
+    test.GetStats(Latency_USBRoundTrip, &usb);
+    check(total.Count > 0 && fabs(total.MeanMilliS - 41.0f) < 0.5f, "total latency is 41 ms");
+    check(fabs(total.MinMilliS - total.MaxMilliS) < 0.5f, "a fixed latency doesn't vary");
+    check(fabs(usb.MeanMilliS - 2.0f) < 0.5f, "the USB round trip is 2 ms");
+}
+
+// In continuous mode, start commands the device drops are counted as timeouts and the
+// run carries on.
+static void testContinuous()
+{
+    Ptr<LatencyTestDeviceMock> device = *new LatencyTestDeviceMock();
+    device->SetLatency(30000, 500, 20000);
+    LatencyTest test(device);
+    test.SetTimeSource(LatencyTestDeviceMock::TimeSource, device);
+    test.SetContinuous(true);
+    test.BeginTest();
+
+    runFrames(device, test, 5000000, 1000);
+    device->DropStartTests(3);
+    runFrames(device, test, 60000000, 1000);
+    check(test.IsTestRunning(), "a continuous test keeps running");
+    check(test.GetTimeoutCount() == 3, "dropped start commands are counted as timeouts");
+
+    LatencyStats total;
+    test.GetStats(Latency_Total, &total);
+    check(total.MinMilliS >= 30.5f && total.MaxMilliS <= 51.0f, "latencies stay within the jitter");
+    check(total.P50MilliS <= total.P90MilliS && total.P90MilliS <= total.P99MilliS,
+          "percentiles are ordered");
+
+    test.EndTest();
+    check(!test.IsTestRunning(), "EndTest stops a continuous test");
+}
+
+static int compareUInt32(const void* a, const void* b)
+{
+    UInt32 x = *(const UInt32*)a, y = *(const UInt32*)b;
+    return (x < y) ? -1 : (x > y);
+}
+
+// Percentiles are within the histogram's 0.8% precision of the exact ones.
+static void testHistogram()
+{
+    const int count = 100000;
+    UInt32*   values = (UInt32*)OVR_ALLOC(count * sizeof(UInt32));
+
+    LatencyHistogram histogram;
+    srand(3);
+    for (int i = 0; i < count; i++)
+    {
+        values[i] = (UInt32)(rand() % 200000) + ((i % 10 == 0) ? rand() % 2000000 : 0);
+        histogram.Record(values[i]);
+    }
+    qsort(values, count, sizeof(UInt32), compareUInt32);
+
+    const float percents[] = { 50, 90, 99, 99.9f, 100 };
+    for (int i = 0; i < 5; i++)
+    {
+        UInt32 exact = values[(int)ceil(percents[i] / 100 * count) - 1];
+        double error = fabs((double)histogram.GetPercentile(percents[i]) - exact) / exact;
+        check(error < 0.008, "histogram percentiles are within 0.8%");
+    }
+    check(histogram.GetMax() == values[count - 1], "the histogram maximum is exact");
+
+    LatencyHistogram small;
+    for (UInt32 v = 0; v < 300; v++)
+        small.Record(v);
+    check(small.GetPercentile(50) == 149, "small values are recorded exactly");
+
+    OVR_FREE(values);
+}
+
+int main()
+{
+    System::Init();
+    testSingle();
+    testContinuous();
+    testHistogram();
+    System::Destroy();
+
+    printf("%s\n", Failures ? "Test_LatencyTester failed" : "Test_LatencyTester passed");
+    return Failures ? 1 : 0;
+}